@@ -160,10 +160,10 @@ function toggleJammer() {
 }
 
 // Change frequency
-function changeFrequency(direction) {
-    const newIndex = appState.frequencyIndex + direction;
+function changeFrequency(steps) {
+    const newIndex = Math.max(0, Math.min(FREQUENCIES.length - 1, appState.frequencyIndex + steps));
     
-    if (newIndex >= 0 && newIndex < FREQUENCIES.length) {
+    if (newIndex !== appState.frequencyIndex) {
         appState.frequencyIndex = newIndex;
         updateFrequencyDisplay();
         Notification.vibrate(50); // Haptic feedback
@@ -195,18 +195,17 @@ function cleanup() {
     }
 }
 
+// Encoder turn: step the frequency by input.delta while idle
+function onEncoderTurn() {
+    if (!appState.isJamming) {
+        changeFrequency(input.delta);
+    }
+}
+
 // Event handlers
 function setupEventHandlers() {
-    // Encoder rotation
-    System.onEncoder((direction) => {
-        if (!appState.isJamming) {
-            if (direction === 'CW') {
-                changeFrequency(1);
-            } else if (direction === 'CCW') {
-                changeFrequency(-1);
-            }
-        }
-    });
+    // Encoder rotation for frequency
+    System.onEncoder('onEncoderTurn');
     
     // Encoder press for toggle
     System.onButton('ENCODER', () => {
@@ -108,16 +108,15 @@ function createStatusBar() {
     ui.setStyle(statusLabel, 'text_font', 'small');
 }
 
+// Encoder turn: move the selection by input.delta steps
+function onEncoderTurn() {
+    navigateBy(input.delta);
+}
+
 // Set up input event handlers
 function setupInputHandlers() {
     // Encoder rotation for navigation
-    input.onEncoder((direction) => {
-        if (direction === 'CW') {
-            navigateDown();
-        } else if (direction === 'CCW') {
-            navigateUp();
-        }
-    });
+    input.onEncoder('onEncoderTurn');
     
     // Encoder press for selection
     input.onButton('ENCODER', () => {
@@ -137,20 +136,12 @@ function setupInputHandlers() {
     });
 }
 
-// Navigate menu up
-function navigateUp() {
-    let currentIndex = ui.getListSelectedIndex(menuList);
-    if (currentIndex > 0) {
-        ui.setListSelectedIndex(menuList, currentIndex - 1);
-        notify.vibrate(50); // Haptic feedback
-    }
-}
-
-// Navigate menu down  
-function navigateDown() {
-    let currentIndex = ui.getListSelectedIndex(menuList);
-    if (currentIndex < MENU_ITEMS.length - 1) {
-        ui.setListSelectedIndex(menuList, currentIndex + 1);
+// Move the menu selection, stopping at either end
+function navigateBy(steps) {
+    const currentIndex = ui.getListSelectedIndex(menuList);
+    const newIndex = Math.max(0, Math.min(MENU_ITEMS.length - 1, currentIndex + steps));
+    if (newIndex !== currentIndex) {
+        ui.setListSelectedIndex(menuList, newIndex);
         notify.vibrate(50); // Haptic feedback
     }
 }
@@ -128,18 +128,17 @@ function setupRFModule() {
     updateFrequencyDisplay();
 }
 
+// Encoder turn: step the frequency by input.delta while not scanning
+function onEncoderTurn() {
+    if (!scannerState.isScanning) {
+        changeFrequency(input.delta);
+    }
+}
+
 // Set up input handlers
 function setupScannerInput() {
     // Encoder for frequency selection
-    System.onEncoder((direction) => {
-        if (!scannerState.isScanning) {
-            if (direction === 'CW') {
-                changeFrequency(1);
-            } else if (direction === 'CCW') {
-                changeFrequency(-1);
-            }
-        }
-    });
+    System.onEncoder('onEncoderTurn');
     
     // Encoder press to start/stop scanning
     System.onButton('ENCODER', () => {
@@ -165,10 +164,10 @@ function setupScannerInput() {
 }
 
 // Change frequency selection
-function changeFrequency(direction) {
-    const newIndex = scannerState.currentFreqIndex + direction;
+function changeFrequency(steps) {
+    const newIndex = Math.max(0, Math.min(SCAN_FREQUENCIES.length - 1, scannerState.currentFreqIndex + steps));
     
-    if (newIndex >= 0 && newIndex < SCAN_FREQUENCIES.length) {
+    if (newIndex !== scannerState.currentFreqIndex) {
         scannerState.currentFreqIndex = newIndex;
         const newFreq = SCAN_FREQUENCIES[newIndex];
         
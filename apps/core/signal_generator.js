@@ -169,10 +169,10 @@ function transmitSignal() {
 }
 
 // Change frequency
-function changeFrequency(direction) {
-    const newIndex = appState.frequencyIndex + direction;
+function changeFrequency(steps) {
+    const newIndex = Math.max(0, Math.min(FREQUENCIES.length - 1, appState.frequencyIndex + steps));
     
-    if (newIndex >= 0 && newIndex < FREQUENCIES.length) {
+    if (newIndex !== appState.frequencyIndex) {
         appState.frequencyIndex = newIndex;
         updateFrequencyDisplay();
         Notification.vibrate(50); // Haptic feedback
@@ -200,18 +200,17 @@ function cleanup() {
     console.log("Cleaning up Signal Generator App...");
 }
 
+// Encoder turn: step the preset by input.delta, a fast spin sweeps several
+function onEncoderTurn() {
+    if (!appState.isTransmitting) {
+        changeFrequency(input.delta);
+    }
+}
+
 // Event handlers
 function setupEventHandlers() {
     // Encoder rotation for frequency
-    System.onEncoder((direction) => {
-        if (!appState.isTransmitting) {
-            if (direction === 'CW') {
-                changeFrequency(1);
-            } else if (direction === 'CCW') {
-                changeFrequency(-1);
-            }
-        }
-    });
+    System.onEncoder('onEncoderTurn');
     
     // Encoder press for transmit
     System.onButton('ENCODER', () => {
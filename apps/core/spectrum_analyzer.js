@@ -10,7 +10,8 @@ let appState = {
     stepSizeIndex: 1, // Default to 100 kHz
     currentFrequency: 433920000,
     maxRSSI: -100,
-    maxFrequency: 433920000
+    maxFrequency: 433920000,
+    spectrumBins: 0
 };
 
 // Predefined frequency ranges
@@ -29,6 +30,10 @@ const STEP_SIZES = [
     { size: 500000, name: "500 kHz" }
 ];
 
+// Native spectrum widget views
+const SPECTRUM_MODE_WATERFALL = 2;
+const SPECTRUM_MAX_BINS = 256;
+
 // UI elements
 let ui = {};
 
@@ -83,7 +88,7 @@ function createUI() {
     });
     
     // Current frequency display
-    ui.currentFreqLabel = UI.createLabel(screen, `Freq: 433.92 MHz`);
+    ui.currentFreqLabel = UI.createValueLabel(screen, `Freq: 433.92 MHz`);
     UI.setPosition(ui.currentFreqLabel, 10, 80);
     UI.setLabelStyle(ui.currentFreqLabel, { 
         text_color: '#FFFFFF',
@@ -91,7 +96,7 @@ function createUI() {
     });
     
     // RSSI display
-    ui.rssiLabel = UI.createLabel(screen, `RSSI: --- dBm`);
+    ui.rssiLabel = UI.createValueLabel(screen, `RSSI: --- dBm`);
     UI.setPosition(ui.rssiLabel, 10, 105);
     UI.setLabelStyle(ui.rssiLabel, { 
         text_color: '#00FFFF',
@@ -115,14 +120,11 @@ function createUI() {
         font_weight: 'bold'
     });
     
-    // Spectrum bar (simplified visualization)
-    ui.spectrumBar = UI.createLabel(screen, "[                    ]");
-    UI.setPosition(ui.spectrumBar, 10, 190);
-    UI.setLabelStyle(ui.spectrumBar, { 
-        text_color: '#00FF00',
-        font_size: 14,
-        font_family: 'monospace'
-    });
+    // Native spectrum widget, drawn straight from the RF sweep buffer
+    ui.spectrum = UI.createSpectrum(screen, 150, 80);
+    UI.setPosition(ui.spectrum, 10, 190);
+    UI.setSpectrumRange(ui.spectrum, -100, -40);
+    UI.setSpectrumMode(ui.spectrum, SPECTRUM_MODE_WATERFALL);
     
     // Status bar
     const statusBar = UI.createContainer(screen);
@@ -229,13 +231,15 @@ function scanLoop() {
                 `Max: ${appState.maxRSSI} dBm @ ${formatFrequency(appState.maxFrequency)}`);
         }
         
-        // Update spectrum bar visualization (simplified)
-        const barLength = 20;
-        const rssiRange = 50; // -100 to -50 dBm
-        const normalizedRSSI = Math.max(0, Math.min(1, (rssi + 100) / rssiRange));
-        const filledLength = Math.floor(normalizedRSSI * barLength);
-        const bar = "[" + "=".repeat(filledLength) + " ".repeat(barLength - filledLength) + "]";
-        UI.setLabelText(ui.spectrumBar, bar);
+        // Sweep the whole range into the native buffer; the widget keeps a
+        // reference to it, so only the first sweep needs to attach it
+        const bins = Math.min(SPECTRUM_MAX_BINS, Math.floor((range.stop - range.start) / step.size) + 1);
+        const buffer = RF.sweepSpectrum(range.start, step.size, bins);
+        if (appState.spectrumBins !== bins) {
+            UI.setSpectrumBuffer(ui.spectrum, buffer, bins);
+            appState.spectrumBins = bins;
+        }
+        UI.refreshSpectrum(ui.spectrum);
         
         // Move to next frequency
         appState.currentFrequency += step.size;
@@ -264,10 +268,10 @@ function toggleAnalysis() {
 }
 
 // Change frequency range
-function changeFrequencyRange(direction) {
-    const newIndex = appState.frequencyRangeIndex + direction;
+function changeFrequencyRange(steps) {
+    const newIndex = Math.max(0, Math.min(FREQUENCY_RANGES.length - 1, appState.frequencyRangeIndex + steps));
     
-    if (newIndex >= 0 && newIndex < FREQUENCY_RANGES.length) {
+    if (newIndex !== appState.frequencyRangeIndex) {
         appState.frequencyRangeIndex = newIndex;
         updateFrequencyRangeDisplay();
         Notification.vibrate(50); // Haptic feedback
@@ -298,18 +302,17 @@ function cleanup() {
     }
 }
 
+// Encoder turn: shift the range by input.delta while stopped
+function onEncoderTurn() {
+    if (!appState.isAnalyzing) {
+        changeFrequencyRange(input.delta);
+    }
+}
+
 // Event handlers
 function setupEventHandlers() {
     // Encoder rotation for frequency range
-    System.onEncoder((direction) => {
-        if (!appState.isAnalyzing) {
-            if (direction === 'CW') {
-                changeFrequencyRange(1);
-            } else if (direction === 'CCW') {
-                changeFrequencyRange(-1);
-            }
-        }
-    });
+    System.onEncoder('onEncoderTurn');
     
     // Encoder press for toggle
     System.onButton('ENCODER', () => {
@@ -275,20 +275,19 @@ function createSettingControl(parent, setting) {
     }
 }
 
+// Encoder turn: edit or navigate by input.delta
+function onEncoderTurn() {
+    if (settingsState.isEditMode) {
+        editCurrentSetting(input.delta);
+    } else {
+        navigateBy(input.delta);
+    }
+}
+
 // Set up input handlers
 function setupSettingsInput() {
     // Encoder for navigation
-    input.onEncoder((direction) => {
-        if (settingsState.isEditMode) {
-            editCurrentSetting(direction);
-        } else {
-            if (direction === 'CW') {
-                navigateDown();
-            } else if (direction === 'CCW') {
-                navigateUp();
-            }
-        }
-    });
+    input.onEncoder('onEncoderTurn');
     
     // Encoder press for selection/edit
     input.onButton('ENCODER', () => {
@@ -316,19 +315,13 @@ function setupSettingsInput() {
     });
 }
 
-// Navigate settings up
-function navigateUp() {
+// Move the settings selection, stopping at either end
+function navigateBy(steps) {
     const category = SETTINGS_CATEGORIES[settingsState.currentCategory];
-    if (settingsState.currentSetting > 0) {
-        updateSettingHighlight(settingsState.currentSetting - 1);
-    }
-}
-
-// Navigate settings down
-function navigateDown() {
-    const category = SETTINGS_CATEGORIES[settingsState.currentCategory];
-    if (settingsState.currentSetting < category.settings.length - 1) {
-        updateSettingHighlight(settingsState.currentSetting + 1);
+    const newIndex = Math.max(0, Math.min(category.settings.length - 1,
+                                          settingsState.currentSetting + steps));
+    if (newIndex !== settingsState.currentSetting) {
+        updateSettingHighlight(newIndex);
     }
 }
 
@@ -368,29 +361,30 @@ function exitEditMode() {
 }
 
 // Edit current setting value
-function editCurrentSetting(direction) {
+function editCurrentSetting(steps) {
     const category = SETTINGS_CATEGORIES[settingsState.currentCategory];
     const setting = category.settings[settingsState.currentSetting];
     
     switch (setting.type) {
         case 'toggle':
-            setting.value = !setting.value;
+            // An odd number of steps flips the toggle
+            if (steps % 2 !== 0) {
+                setting.value = !setting.value;
+            }
             ui.setText(setting.control, setting.value ? 'ON' : 'OFF');
             ui.setStyle(setting.control, 'text_color', setting.value ? '#00FF00' : '#FF0000');
             break;
             
         case 'slider':
-            const delta = direction === 'CW' ? 1 : -1;
-            const newValue = Math.max(setting.min, Math.min(setting.max, setting.value + delta));
+            const newValue = Math.max(setting.min, Math.min(setting.max, setting.value + steps));
             setting.value = newValue;
             ui.setText(setting.control, newValue.toString());
             break;
             
         case 'select':
             const currentIndex = setting.options.indexOf(setting.value);
-            const newIndex = direction === 'CW' ? 
-                (currentIndex + 1) % setting.options.length :
-                (currentIndex - 1 + setting.options.length) % setting.options.length;
+            const count = setting.options.length;
+            const newIndex = ((currentIndex + steps) % count + count) % count;
             setting.value = setting.options[newIndex];
             ui.setText(setting.control, setting.value);
             break;
@@ -517,28 +517,22 @@ function handleMenuSelection() {
     }
 }
 
+// Encoder turn: move the main menu selection by input.delta
+function onEncoderTurn() {
+    if (wifiState.currentScreen === 'main') {
+        const currentIndex = UI.getListSelectedIndex(ui.mainMenu);
+        const newIndex = Math.max(0, Math.min(4, currentIndex + input.delta)); // 5 menu items (0-4)
+        if (newIndex !== currentIndex) {
+            UI.setListSelectedIndex(ui.mainMenu, newIndex);
+            Notification.vibrate(50); // Haptic feedback
+        }
+    }
+}
+
 // Set up input event handlers
 function setupInputHandlers() {
     // Encoder rotation for navigation
-    System.onEncoder((direction) => {
-        if (wifiState.currentScreen === 'main') {
-            if (direction === 'CW') {
-                // Navigate down in main menu
-                let currentIndex = UI.getListSelectedIndex(ui.mainMenu);
-                if (currentIndex < 4) { // 5 menu items (0-4)
-                    UI.setListSelectedIndex(ui.mainMenu, currentIndex + 1);
-                    Notification.vibrate(50); // Haptic feedback
-                }
-            } else if (direction === 'CCW') {
-                // Navigate up in main menu
-                let currentIndex = UI.getListSelectedIndex(ui.mainMenu);
-                if (currentIndex > 0) {
-                    UI.setListSelectedIndex(ui.mainMenu, currentIndex - 1);
-                    Notification.vibrate(50); // Haptic feedback
-                }
-            }
-        }
-    });
+    System.onEncoder('onEncoderTurn');
     
     // Encoder press for selection
     System.onButton('ENCODER', () => {
@@ -12,6 +12,11 @@
 
 static const char *TAG = "APP_INSTALLER";
 
+static size_t package_file_read(void *buffer, size_t size, void *ctx)
+{
+    return fread(buffer, 1, size, (FILE *)ctx);
+}
+
 esp_err_t app_installer_extract_package(const char *package_path, const char *extract_path)
 {
     if (!package_path || !extract_path) {
@@ -20,56 +25,24 @@ esp_err_t app_installer_extract_package(const char *package_path, const char *ex
     
     ESP_LOGI(TAG, "Extracting package %s to %s", package_path, extract_path);
     
-    // Create extraction directory
-    if (mkdir(extract_path, 0755) != 0) {
-        ESP_LOGE(TAG, "Failed to create extraction directory");
-        return ESP_FAIL;
-    }
-    
-    // For simplicity, assume package is already extracted or copy files
-    // In real implementation, this would handle ZIP/TAR archives
-    
-    FILE *src = fopen(package_path, "r");
-    if (!src) {
+    FILE *package = fopen(package_path, "rb");
+    if (!package) {
         ESP_LOGE(TAG, "Failed to open package file");
         return ESP_ERR_NOT_FOUND;
     }
     
-    char dst_path[256];
-    snprintf(dst_path, sizeof(dst_path), "%s/index.js", extract_path);
-    
-    FILE *dst = fopen(dst_path, "w");
-    if (!dst) {
-        fclose(src);
-        ESP_LOGE(TAG, "Failed to create destination file");
-        return ESP_FAIL;
-    }
-    
-    // Copy file content
-    char buffer[512];
-    size_t bytes;
-    while ((bytes = fread(buffer, 1, sizeof(buffer), src)) > 0) {
-        fwrite(buffer, 1, bytes, dst);
-    }
-    
-    fclose(src);
-    fclose(dst);
+    // One pass: files are checked and written as they are read
+    app_package_info_t info;
+    esp_err_t ret = app_package_install(package_file_read, package, extract_path, &info);
+    fclose(package);
     
-    // Create basic manifest if not exists
-    snprintf(dst_path, sizeof(dst_path), "%s/manifest.json", extract_path);
-    FILE *manifest = fopen(dst_path, "w");
-    if (manifest) {
-        fprintf(manifest, "{\n");
-        fprintf(manifest, "  \"name\": \"Sample App\",\n");
-        fprintf(manifest, "  \"version\": \"1.0.0\",\n");
-        fprintf(manifest, "  \"author\": \"Unknown\",\n");
-        fprintf(manifest, "  \"entry_point\": \"index.js\",\n");
-        fprintf(manifest, "  \"permissions\": \"rf.receive,ui.create\"\n");
-        fprintf(manifest, "}\n");
-        fclose(manifest);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to install package: %s", esp_err_to_name(ret));
+        return ret;
     }
     
-    ESP_LOGI(TAG, "Package extracted successfully");
+    ESP_LOGI(TAG, "Package extracted successfully (%u files, peak %u bytes of RAM)",
+             (unsigned)info.files, (unsigned)info.peak_memory);
     return ESP_OK;
 }
 
@@ -79,30 +52,12 @@ esp_err_t app_installer_validate_manifest(const char *manifest_path)
         return ESP_ERR_INVALID_ARG;
     }
     
-    FILE *file = fopen(manifest_path, "r");
-    if (!file) {
-        ESP_LOGE(TAG, "Manifest file not found: %s", manifest_path);
-        return ESP_ERR_NOT_FOUND;
-    }
-    
-    // Basic validation - check if file contains required fields
-    char buffer[1024];
-    size_t read_size = fread(buffer, 1, sizeof(buffer) - 1, file);
-    fclose(file);
-    
-    if (read_size == 0) {
-        ESP_LOGE(TAG, "Empty manifest file");
-        return ESP_FAIL;
-    }
-    
-    buffer[read_size] = '\0';
-    
-    // Check for required fields
-    if (!strstr(buffer, "\"name\"") || 
-        !strstr(buffer, "\"version\"") ||
-        !strstr(buffer, "\"entry_point\"")) {
-        ESP_LOGE(TAG, "Invalid manifest - missing required fields");
-        return ESP_FAIL;
+    // Same schema the app manager loads with: types, lengths and required fields
+    js_app_manifest_t manifest;
+    esp_err_t ret = mjs_engine_load_manifest(manifest_path, &manifest);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Invalid manifest %s: %s", manifest_path, esp_err_to_name(ret));
+        return ret;
     }
     
     ESP_LOGI(TAG, "Manifest validation passed");
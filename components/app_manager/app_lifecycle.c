@@ -0,0 +1,261 @@
+/**
+ * @file app_lifecycle.c
+ * @brief Started apps: foreground and background scheduling, CPU quotas, eviction
+ */
+
+#include "app_manager.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <string.h>
+#include <stdio.h>
+
+static const char *TAG = "APP_LIFECYCLE";
+
+// Until measured, an operation is assumed to take the whole quota
+#define OP_COST_INITIAL_US  APP_BACKGROUND_QUOTA_US
+
+// Runtime state of a started app; installed apps live in the registry
+typedef struct {
+    char id[32];
+    app_state_t state;
+    js_context_t *js_context;
+    uint32_t left_foreground_ms;    // LRU key for eviction
+    int32_t credit_us;              // CPU left this period, negative after an overrun
+    uint32_t op_cost_us;            // Running average per interpreter operation
+    uint32_t memory_usage;
+    uint64_t cpu_us;
+} app_runtime_t;
+
+static app_runtime_t s_running[MAX_RUNNING_APPS];
+static app_runtime_t *s_foreground;
+static size_t s_first_background;   // Rotates so no app always runs last
+
+static app_runtime_t *find_runtime(const char *app_id)
+{
+    for (int i = 0; i < MAX_RUNNING_APPS; i++) {
+        if (s_running[i].id[0] && strcmp(s_running[i].id, app_id) == 0) {
+            return &s_running[i];
+        }
+    }
+    return NULL;
+}
+
+static void bring_forward(app_runtime_t *runtime, uint32_t now_ms)
+{
+    if (s_foreground == runtime) {
+        return;
+    }
+    if (s_foreground) {
+        s_foreground->state = APP_STATE_BACKGROUND;
+        s_foreground->left_foreground_ms = now_ms;
+        s_foreground->credit_us = 0;
+    }
+    runtime->state = APP_STATE_RUNNING;
+    s_foreground = runtime;
+}
+
+static uint32_t run_slice(app_runtime_t *runtime, uint32_t now_ms, uint32_t budget, uint32_t *elapsed_us)
+{
+    int64_t start = esp_timer_get_time();
+    uint32_t ops = mjs_engine_run_timers(runtime->js_context, now_ms, budget);
+    *elapsed_us = (uint32_t)(esp_timer_get_time() - start);
+
+    runtime->cpu_us += *elapsed_us;
+    runtime->memory_usage = mjs_engine_get_memory_usage(runtime->js_context);
+    return ops;
+}
+
+static void run_background(app_runtime_t *runtime, uint32_t now_ms)
+{
+    // Quota is not banked across idle periods; an overrun is paid back first
+    runtime->credit_us += APP_BACKGROUND_QUOTA_US;
+    if (runtime->credit_us > APP_BACKGROUND_QUOTA_US) {
+        runtime->credit_us = APP_BACKGROUND_QUOTA_US;
+    }
+    if (runtime->credit_us <= 0) {
+        return;
+    }
+
+    uint32_t budget = (uint32_t)runtime->credit_us / runtime->op_cost_us;
+    if (budget == 0) {
+        budget = 1;
+    }
+
+    uint32_t elapsed_us;
+    uint32_t ops = run_slice(runtime, now_ms, budget, &elapsed_us);
+    runtime->credit_us -= (int32_t)elapsed_us;
+
+    if (ops) {
+        uint32_t cost = elapsed_us / ops;
+        runtime->op_cost_us = (runtime->op_cost_us * 3 + (cost ? cost : 1)) / 4;
+        if (runtime->op_cost_us == 0) {
+            runtime->op_cost_us = 1;
+        }
+    }
+}
+
+esp_err_t app_lifecycle_add(const char *app_id, js_context_t *js_context, uint32_t now_ms)
+{
+    if (!app_id || !js_context || strlen(app_id) >= sizeof(s_running[0].id)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (find_runtime(app_id)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    app_runtime_t *runtime = NULL;
+    for (int i = 0; !runtime && i < MAX_RUNNING_APPS; i++) {
+        if (!s_running[i].id[0]) {
+            runtime = &s_running[i];
+        }
+    }
+    if (!runtime) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    memset(runtime, 0, sizeof(*runtime));
+    snprintf(runtime->id, sizeof(runtime->id), "%s", app_id);
+    runtime->js_context = js_context;
+    runtime->op_cost_us = OP_COST_INITIAL_US;
+    runtime->memory_usage = mjs_engine_get_memory_usage(js_context);
+    bring_forward(runtime, now_ms);
+    return ESP_OK;
+}
+
+esp_err_t app_lifecycle_remove(const char *app_id)
+{
+    if (!app_id) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    app_runtime_t *runtime = find_runtime(app_id);
+    if (!runtime) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (s_foreground == runtime) {
+        s_foreground = NULL;
+    }
+    memset(runtime, 0, sizeof(*runtime));
+    return ESP_OK;
+}
+
+esp_err_t app_lifecycle_set_foreground(const char *app_id, uint32_t now_ms)
+{
+    if (!app_id) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    app_runtime_t *runtime = find_runtime(app_id);
+    if (!runtime) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    bring_forward(runtime, now_ms);
+    return ESP_OK;
+}
+
+esp_err_t app_lifecycle_pause(const char *app_id)
+{
+    if (!app_id) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    app_runtime_t *runtime = find_runtime(app_id);
+    if (!runtime) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (runtime == s_foreground) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    runtime->state = APP_STATE_PAUSED;
+    return ESP_OK;
+}
+
+esp_err_t app_lifecycle_resume(const char *app_id)
+{
+    if (!app_id) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    app_runtime_t *runtime = find_runtime(app_id);
+    if (!runtime) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (runtime->state == APP_STATE_PAUSED) {
+        runtime->state = APP_STATE_BACKGROUND;
+        runtime->credit_us = 0;
+    }
+    return ESP_OK;
+}
+
+bool app_lifecycle_get(const char *app_id, app_info_t *info)
+{
+    const app_runtime_t *runtime = app_id ? find_runtime(app_id) : NULL;
+    if (!runtime || !info) {
+        return false;
+    }
+
+    info->state = runtime->state;
+    info->js_context = runtime->js_context;
+    info->memory_usage = runtime->memory_usage;
+    info->cpu_time = (uint32_t)(runtime->cpu_us / 1000);
+    return true;
+}
+
+const char *app_lifecycle_get_foreground(void)
+{
+    return s_foreground ? s_foreground->id : NULL;
+}
+
+size_t app_lifecycle_count(void)
+{
+    size_t count = 0;
+    for (int i = 0; i < MAX_RUNNING_APPS; i++) {
+        if (s_running[i].id[0]) {
+            count++;
+        }
+    }
+    return count;
+}
+
+const char *app_lifecycle_get_lru(void)
+{
+    const app_runtime_t *lru = NULL;
+    for (int i = 0; i < MAX_RUNNING_APPS; i++) {
+        const app_runtime_t *runtime = &s_running[i];
+        if (!runtime->id[0] || runtime == s_foreground) {
+            continue;
+        }
+        if (!lru || (int32_t)(runtime->left_foreground_ms - lru->left_foreground_ms) < 0) {
+            lru = runtime;
+        }
+    }
+    return lru ? lru->id : NULL;
+}
+
+void app_lifecycle_run(uint32_t now_ms, uint32_t free_heap, app_lifecycle_evict_t evict, void *ctx)
+{
+    if (free_heap < APP_HEAP_LOW_WATER && evict) {
+        const char *lru = app_lifecycle_get_lru();
+        if (lru) {
+            char app_id[sizeof(s_running[0].id)];
+            snprintf(app_id, sizeof(app_id), "%s", lru);
+            ESP_LOGW(TAG, "Free heap %u below %u, evicting %s",
+                     (unsigned)free_heap, (unsigned)APP_HEAP_LOW_WATER, app_id);
+            evict(app_id, ctx);
+        }
+    }
+
+    // The foreground app is never throttled; background quotas bound what follows it
+    if (s_foreground) {
+        uint32_t elapsed_us;
+        run_slice(s_foreground, now_ms, 0, &elapsed_us);
+    }
+
+    for (size_t n = 0; n < MAX_RUNNING_APPS; n++) {
+        app_runtime_t *runtime = &s_running[(s_first_background + n) % MAX_RUNNING_APPS];
+        if (runtime->id[0] && runtime->state == APP_STATE_BACKGROUND) {
+            run_background(runtime, now_ms);
+        }
+    }
+    s_first_background = (s_first_background + 1) % MAX_RUNNING_APPS;
+}
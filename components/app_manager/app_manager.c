@@ -4,22 +4,104 @@
  */
 
 #include "app_manager.h"
+#include "js_api.h"
+#include "lvgl_port.h"
 #include "esp_log.h"
+#include "esp_system.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "freertos/task.h"
 #include <string.h>
 #include <stdio.h>
 
 static const char *TAG = "APP_MGR";
 
-// App registry
-static app_info_t s_installed_apps[MAX_INSTALLED_APPS];
-static size_t s_num_installed_apps = 0;
 static SemaphoreHandle_t s_app_mutex = NULL;
-static char s_current_app_id[32] = {0};
 
 static bool s_initialized = false;
 
+static uint32_t now_ms(void)
+{
+    return xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+static void fill_app_info(const app_registry_entry_t *entry, app_info_t *info)
+{
+    memset(info, 0, sizeof(*info));
+    snprintf(info->id, sizeof(info->id), "%s", entry->id);
+    snprintf(info->name, sizeof(info->name), "%s", entry->name);
+    snprintf(info->version, sizeof(info->version), "%s", entry->version);
+    snprintf(info->author, sizeof(info->author), "%s", entry->author);
+    snprintf(info->entry_point, sizeof(info->entry_point), "%s", entry->entry_point);
+    snprintf(info->install_path, sizeof(info->install_path), "%s", entry->install_path);
+    info->is_system_app = entry->is_system_app;
+    info->permissions = entry->permissions;
+    info->state = APP_STATE_STOPPED;
+    app_lifecycle_get(entry->id, info);
+}
+
+// Stops a started app; called with s_app_mutex held
+static esp_err_t stop_app_locked(const char *app_id)
+{
+    app_info_t info;
+    if (!app_lifecycle_get(app_id, &info)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    // Keep what the app last showed for an instant relaunch; a background
+    // app's snapshot was taken when it left the foreground
+    if (info.state == APP_STATE_RUNNING) {
+        lvgl_port_screen_cache_store(app_id);
+    }
+    
+    // Stop JavaScript execution
+    if (info.js_context) {
+        mjs_engine_stop(info.js_context);
+        app_sandbox_destroy(app_id);
+    }
+    
+    app_lifecycle_remove(app_id);
+    return ESP_OK;
+}
+
+// Stops every started app, background ones first; called with s_app_mutex held
+static void stop_all_locked(void)
+{
+    const char *app_id;
+    while ((app_id = app_lifecycle_get_lru()) != NULL ||
+           (app_id = app_lifecycle_get_foreground()) != NULL) {
+        char id[32];
+        snprintf(id, sizeof(id), "%s", app_id);
+        stop_app_locked(id);
+    }
+}
+
+static void evict_app(const char *app_id, void *ctx)
+{
+    stop_app_locked(app_id);
+}
+
+// FNV-1a of the entry source, so a bytecode cache can tell it is current
+static uint32_t hash_file(const char *path)
+{
+    uint32_t h = 2166136261u;
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return 0;
+    }
+
+    uint8_t buffer[512];
+    size_t bytes;
+    while ((bytes = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        for (size_t i = 0; i < bytes; i++) {
+            h ^= buffer[i];
+            h *= 16777619u;
+        }
+    }
+    fclose(file);
+    return h;
+}
+
 esp_err_t app_manager_init(void)
 {
     if (s_initialized) {
@@ -35,15 +117,16 @@ esp_err_t app_manager_init(void)
         return ESP_ERR_NO_MEM;
     }
     
-    // Clear app registry
-    memset(s_installed_apps, 0, sizeof(s_installed_apps));
-    s_num_installed_apps = 0;
-    
     // Load installed apps from storage
-    // TODO: Implement persistent app registry
+    esp_err_t ret = app_registry_load(APP_REGISTRY_PATH);
+    if (ret == ESP_ERR_NOT_FOUND) {
+        ESP_LOGI(TAG, "No app registry yet");
+    } else if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "App registry unusable, starting empty");
+    }
     
     s_initialized = true;
-    ESP_LOGI(TAG, "App manager initialized");
+    ESP_LOGI(TAG, "App manager initialized with %u apps", (unsigned)app_registry_count());
     
     return ESP_OK;
 }
@@ -56,12 +139,12 @@ esp_err_t app_manager_deinit(void)
     
     ESP_LOGI(TAG, "Deinitializing app manager");
     
-    // Stop all running apps
-    for (size_t i = 0; i < s_num_installed_apps; i++) {
-        if (s_installed_apps[i].state == APP_STATE_RUNNING) {
-            app_manager_stop_app(s_installed_apps[i].id);
-        }
-    }
+    // Stop all started apps
+    xSemaphoreTake(s_app_mutex, portMAX_DELAY);
+    stop_all_locked();
+    xSemaphoreGive(s_app_mutex);
+    
+    app_registry_clear();
     
     // Delete mutex
     if (s_app_mutex) {
@@ -85,14 +168,10 @@ esp_err_t app_manager_install(const char *package_path, char *app_id)
     
     xSemaphoreTake(s_app_mutex, portMAX_DELAY);
     
-    if (s_num_installed_apps >= MAX_INSTALLED_APPS) {
-        xSemaphoreGive(s_app_mutex);
-        ESP_LOGE(TAG, "Maximum number of apps reached");
-        return ESP_ERR_NO_MEM;
-    }
-    
     // Generate unique app ID
-    snprintf(app_id, 32, "app_%08x", esp_random());
+    do {
+        snprintf(app_id, 32, "app_%08x", (unsigned)esp_random());
+    } while (app_registry_find(app_id, NULL));
     
     // Create app install directory
     char install_path[MAX_APP_PATH_LEN];
@@ -116,29 +195,78 @@ esp_err_t app_manager_install(const char *package_path, char *app_id)
         return ret;
     }
     
-    // Create app info
-    app_info_t *app = &s_installed_apps[s_num_installed_apps];
-    strcpy(app->id, app_id);
-    strcpy(app->name, manifest.name);
-    strcpy(app->version, manifest.version);
-    strcpy(app->author, manifest.author);
-    strcpy(app->entry_point, manifest.entry_point);
-    strcpy(app->install_path, install_path);
-    app->state = APP_STATE_STOPPED;
-    app->js_context = NULL;
-    app->memory_usage = 0;
-    app->cpu_time = 0;
-    app->is_system_app = false;
+    // Register app
+    char entry_file[MAX_APP_PATH_LEN];
+    snprintf(entry_file, sizeof(entry_file), "%s/%s", install_path, manifest.entry_point);
+    
+    app_registry_entry_t entry = {
+        .id = app_id,
+        .name = manifest.name,
+        .version = manifest.version,
+        .author = manifest.author,
+        .entry_point = manifest.entry_point,
+        .install_path = install_path,
+        .permissions = app_permissions_parse_string(manifest.permissions),
+        .code_hash = hash_file(entry_file),
+        .is_system_app = false,
+    };
+    
+    ret = app_registry_add(&entry);
+    if (ret == ESP_OK) {
+        ret = app_registry_save(APP_REGISTRY_PATH);
+        if (ret != ESP_OK) {
+            app_registry_remove(app_id);
+        }
+    }
+    
+    xSemaphoreGive(s_app_mutex);
+    
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register app %s: %s", app_id, esp_err_to_name(ret));
+        return ret;
+    }
+    
+    ESP_LOGI(TAG, "Installed app: %s (%s) by %s", manifest.name, app_id, manifest.author);
+    
+    return ESP_OK;
+}
+
+esp_err_t app_manager_uninstall(const char *app_id)
+{
+    if (!app_id) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    app_manager_stop_app(app_id);
     
-    // Parse and set permissions
-    app->permissions = app_permissions_parse_string(manifest.permissions);
+    xSemaphoreTake(s_app_mutex, portMAX_DELAY);
+    
+    // The entry's strings belong to the registry and go with it
+    app_registry_entry_t entry;
+    char install_path[MAX_APP_PATH_LEN] = "";
+    if (app_registry_find(app_id, &entry)) {
+        snprintf(install_path, sizeof(install_path), "%s", entry.install_path);
+    }
     
-    s_num_installed_apps++;
+    esp_err_t ret = app_registry_remove(app_id);
+    if (ret == ESP_OK) {
+        ret = app_registry_save(APP_REGISTRY_PATH);
+    }
+    
+    // Files go only once the saved registry no longer points at them; a
+    // removal cut short leaves an orphan, never an entry without its app
+    if (ret == ESP_OK && install_path[0] && app_package_remove(install_path) != ESP_OK) {
+        ESP_LOGW(TAG, "Files of %s left in %s", app_id, install_path);
+    }
     
     xSemaphoreGive(s_app_mutex);
     
-    ESP_LOGI(TAG, "Installed app: %s (%s) by %s", app->name, app_id, app->author);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to uninstall app %s: %s", app_id, esp_err_to_name(ret));
+        return ret;
+    }
     
+    ESP_LOGI(TAG, "Uninstalled app: %s", app_id);
     return ESP_OK;
 }
 
@@ -153,29 +281,56 @@ esp_err_t app_manager_start_app(const char *app_id)
     xSemaphoreTake(s_app_mutex, portMAX_DELAY);
     
     // Find app
-    app_info_t *app = NULL;
-    for (size_t i = 0; i < s_num_installed_apps; i++) {
-        if (strcmp(s_installed_apps[i].id, app_id) == 0) {
-            app = &s_installed_apps[i];
-            break;
-        }
-    }
-    
-    if (!app) {
+    app_registry_entry_t entry;
+    if (!app_registry_find(app_id, &entry)) {
         xSemaphoreGive(s_app_mutex);
         ESP_LOGE(TAG, "App not found: %s", app_id);
         return ESP_ERR_NOT_FOUND;
     }
     
-    if (app->state == APP_STATE_RUNNING) {
+    app_info_t started;
+    bool is_started = app_lifecycle_get(app_id, &started);
+    if (is_started && started.state == APP_STATE_RUNNING) {
         xSemaphoreGive(s_app_mutex);
         ESP_LOGW(TAG, "App already running: %s", app_id);
         return ESP_OK;
     }
     
+    // Snapshot the foreground app's screen before it is replaced
+    const char *foreground = app_lifecycle_get_foreground();
+    if (foreground) {
+        lvgl_port_screen_cache_store(foreground);
+    }
+    
+    if (is_started) {
+        lvgl_port_launch_begin(app_id);
+        app_lifecycle_set_foreground(app_id, now_ms());
+        xSemaphoreGive(s_app_mutex);
+        ESP_LOGI(TAG, "Switched to app: %s", entry.name);
+        return ESP_OK;
+    }
+    
+    if (app_lifecycle_count() >= MAX_RUNNING_APPS) {
+        const char *lru = app_lifecycle_get_lru();
+        if (!lru) {
+            xSemaphoreGive(s_app_mutex);
+            ESP_LOGE(TAG, "Too many running apps to start %s", app_id);
+            return ESP_ERR_NO_MEM;
+        }
+        char evicted[32];
+        snprintf(evicted, sizeof(evicted), "%s", lru);
+        ESP_LOGI(TAG, "Stopping %s to make room for %s", evicted, app_id);
+        stop_app_locked(evicted);
+    }
+    
+    // Show the app's last screen while it builds the live one
+    lvgl_port_launch_begin(app_id);
+    
     // Create sandbox environment
-    esp_err_t ret = app_sandbox_create(app_id, &app->js_context);
+    js_context_t *js_context = NULL;
+    esp_err_t ret = app_sandbox_create(app_id, entry.permissions, &js_context);
     if (ret != ESP_OK) {
+        lvgl_port_launch_abort();
         xSemaphoreGive(s_app_mutex);
         ESP_LOGE(TAG, "Failed to create sandbox for app: %s", app_id);
         return ret;
@@ -183,36 +338,50 @@ esp_err_t app_manager_start_app(const char *app_id)
     
     // Load and execute app
     char entry_file[MAX_APP_PATH_LEN];
-    snprintf(entry_file, sizeof(entry_file), "%s/%s", app->install_path, app->entry_point);
+    snprintf(entry_file, sizeof(entry_file), "%s/%s", entry.install_path, entry.entry_point);
     
-    ret = mjs_engine_load_file(app->js_context, entry_file);
+    ret = mjs_engine_load_file(js_context, entry_file);
     if (ret != ESP_OK) {
         app_sandbox_destroy(app_id);
-        app->js_context = NULL;
+        lvgl_port_launch_abort();
         xSemaphoreGive(s_app_mutex);
         ESP_LOGE(TAG, "Failed to load app file: %s", entry_file);
         return ret;
     }
     
-    js_exec_result_t exec_result = mjs_engine_execute(app->js_context);
+    js_exec_result_t exec_result = mjs_engine_execute(js_context);
     if (exec_result != JS_EXEC_OK) {
         app_sandbox_destroy(app_id);
-        app->js_context = NULL;
+        lvgl_port_launch_abort();
         xSemaphoreGive(s_app_mutex);
         ESP_LOGE(TAG, "Failed to execute app: %s", app_id);
         return ESP_FAIL;
     }
     
-    app->state = APP_STATE_RUNNING;
-    strcpy(s_current_app_id, app_id);
+    // Room was made above, so this cannot fail
+    app_lifecycle_add(app_id, js_context, now_ms());
     
     xSemaphoreGive(s_app_mutex);
     
-    ESP_LOGI(TAG, "Started app: %s", app->name);
+    ESP_LOGI(TAG, "Started app: %s", entry.name);
     
     return ESP_OK;
 }
 
+esp_err_t app_manager_stop_all(void)
+{
+    if (!s_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    xSemaphoreTake(s_app_mutex, portMAX_DELAY);
+    stop_all_locked();
+    xSemaphoreGive(s_app_mutex);
+    
+    ESP_LOGI(TAG, "All apps stopped");
+    return ESP_OK;
+}
+
 esp_err_t app_manager_stop_app(const char *app_id)
 {
     if (!app_id) {
@@ -223,44 +392,21 @@ esp_err_t app_manager_stop_app(const char *app_id)
     
     xSemaphoreTake(s_app_mutex, portMAX_DELAY);
     
-    // Find app
-    app_info_t *app = NULL;
-    for (size_t i = 0; i < s_num_installed_apps; i++) {
-        if (strcmp(s_installed_apps[i].id, app_id) == 0) {
-            app = &s_installed_apps[i];
-            break;
-        }
-    }
-    
-    if (!app) {
+    if (!app_registry_find(app_id, NULL)) {
         xSemaphoreGive(s_app_mutex);
         ESP_LOGE(TAG, "App not found: %s", app_id);
         return ESP_ERR_NOT_FOUND;
     }
     
-    if (app->state != APP_STATE_RUNNING) {
+    if (stop_app_locked(app_id) != ESP_OK) {
         xSemaphoreGive(s_app_mutex);
         ESP_LOGW(TAG, "App not running: %s", app_id);
         return ESP_OK;
     }
     
-    // Stop JavaScript execution
-    if (app->js_context) {
-        mjs_engine_stop(app->js_context);
-        app_sandbox_destroy(app_id);
-        app->js_context = NULL;
-    }
-    
-    app->state = APP_STATE_STOPPED;
-    
-    // Clear current app if it's this one
-    if (strcmp(s_current_app_id, app_id) == 0) {
-        s_current_app_id[0] = '\0';
-    }
-    
     xSemaphoreGive(s_app_mutex);
     
-    ESP_LOGI(TAG, "Stopped app: %s", app->name);
+    ESP_LOGI(TAG, "Stopped app: %s", app_id);
     
     return ESP_OK;
 }
@@ -273,8 +419,15 @@ esp_err_t app_manager_list_apps(app_info_t *apps, size_t max_apps, size_t *num_a
     
     xSemaphoreTake(s_app_mutex, portMAX_DELAY);
     
-    size_t count = s_num_installed_apps > max_apps ? max_apps : s_num_installed_apps;
-    memcpy(apps, s_installed_apps, count * sizeof(app_info_t));
+    size_t count = app_registry_count();
+    if (count > max_apps) {
+        count = max_apps;
+    }
+    for (size_t i = 0; i < count; i++) {
+        app_registry_entry_t entry;
+        app_registry_get(i, &entry);
+        fill_app_info(&entry, &apps[i]);
+    }
     *num_apps = count;
     
     xSemaphoreGive(s_app_mutex);
@@ -282,6 +435,25 @@ esp_err_t app_manager_list_apps(app_info_t *apps, size_t max_apps, size_t *num_a
     return ESP_OK;
 }
 
+esp_err_t app_manager_get_app_info(const char *app_id, app_info_t *app_info)
+{
+    if (!app_id || !app_info) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(s_app_mutex, portMAX_DELAY);
+    
+    app_registry_entry_t entry;
+    bool found = app_registry_find(app_id, &entry);
+    if (found) {
+        fill_app_info(&entry, app_info);
+    }
+    
+    xSemaphoreGive(s_app_mutex);
+    
+    return found ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
 bool app_manager_check_permission(const char *app_id, uint32_t permission)
 {
     if (!app_id) {
@@ -290,19 +462,82 @@ bool app_manager_check_permission(const char *app_id, uint32_t permission)
     
     xSemaphoreTake(s_app_mutex, portMAX_DELAY);
     
-    for (size_t i = 0; i < s_num_installed_apps; i++) {
-        if (strcmp(s_installed_apps[i].id, app_id) == 0) {
-            bool has_permission = (s_installed_apps[i].permissions & permission) != 0;
-            xSemaphoreGive(s_app_mutex);
-            return has_permission;
-        }
+    app_registry_entry_t entry;
+    bool has_permission = app_registry_find(app_id, &entry) && (entry.permissions & permission) != 0;
+    
+    xSemaphoreGive(s_app_mutex);
+    return has_permission;
+}
+
+esp_err_t app_manager_set_permissions(const char *app_id, uint32_t permissions)
+{
+    if (!app_id) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(s_app_mutex, portMAX_DELAY);
+    
+    esp_err_t ret = app_registry_set_permissions(app_id, permissions);
+    if (ret == ESP_OK) {
+        ret = app_registry_save(APP_REGISTRY_PATH);
     }
     
     xSemaphoreGive(s_app_mutex);
-    return false;
+    
+    return ret;
 }
 
 const char* app_manager_get_current_app(void)
 {
-    return s_current_app_id[0] ? s_current_app_id : NULL;
+    return app_lifecycle_get_foreground();
+}
+
+esp_err_t app_manager_pause_app(const char *app_id)
+{
+    if (!app_id) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(s_app_mutex, portMAX_DELAY);
+    esp_err_t ret = app_lifecycle_pause(app_id);
+    xSemaphoreGive(s_app_mutex);
+    
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Paused app: %s", app_id);
+    }
+    return ret;
+}
+
+esp_err_t app_manager_resume_app(const char *app_id)
+{
+    if (!app_id) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(s_app_mutex, portMAX_DELAY);
+    esp_err_t ret = app_lifecycle_resume(app_id);
+    xSemaphoreGive(s_app_mutex);
+    
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Resumed app: %s", app_id);
+    }
+    return ret;
+}
+
+void app_manager_schedule(void)
+{
+    if (!s_initialized) {
+        return;
+    }
+    
+    xSemaphoreTake(s_app_mutex, portMAX_DELAY);
+    
+    // Input goes to the foreground app only, ahead of its timers
+    app_info_t foreground;
+    const char *foreground_id = app_lifecycle_get_foreground();
+    bool has_foreground = foreground_id && app_lifecycle_get(foreground_id, &foreground);
+    js_input_api_deliver(has_foreground ? foreground.js_context : NULL);
+    
+    app_lifecycle_run(now_ms(), esp_get_free_heap_size(), evict_app, NULL);
+    xSemaphoreGive(s_app_mutex);
 }
\ No newline at end of file
@@ -0,0 +1,753 @@
+/**
+ * @file app_package.c
+ * @brief Streaming installer for app packages
+ *
+ * The package is read front to back exactly once. The manifest and file
+ * table come first and are checked before anything is written; each file
+ * is then copied or inflated straight into the app directory while its
+ * CRC is computed. Inflation keeps only the deflate window the packer
+ * declared (4 KB by default), so installing a large app costs no more RAM
+ * than installing a small one.
+ *
+ * /apps is SPIFFS, which has no directories: "app_1/lib/util.js" is one
+ * flat name, mkdir and rmdir fail and directories cannot be renamed. So
+ * every file is staged under install_path + ".tmp/", renamed into place
+ * one by one, and a commit marker written last tells a finished install
+ * from one cut short while moving.
+ */
+
+#include "app_manager.h"
+#include "esp_log.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char *TAG = "APP_PACKAGE";
+
+#define PACKAGE_READ_CHUNK      512
+#define PACKAGE_TMP_SUFFIX      ".tmp"
+#define PACKAGE_MANIFEST_NAME   "manifest.json"
+#define PACKAGE_COMMIT_NAME     ".installed"
+#define PACKAGE_FILE_PATH_LEN   (MAX_APP_PATH_LEN + APP_PACKAGE_PATH_MAX + 2)
+
+// Deflate (RFC 1951) code limits
+#define MAX_BITS                15
+#define MAX_LCODES              286
+#define MAX_DCODES              30
+#define FIX_LCODES              288
+
+typedef struct {
+    int16_t count[MAX_BITS + 1];    // Codes of each length
+    int16_t symbol[FIX_LCODES];     // Symbols ordered by code
+} huffman_t;
+
+typedef struct {
+    // Input
+    app_package_read_t read;
+    void *ctx;
+    uint8_t in[PACKAGE_READ_CHUNK];
+    size_t in_pos;
+    size_t in_len;
+    uint32_t blob_left;             // Package bytes left in the current file
+    uint32_t bit_buf;
+    int bit_count;
+
+    // Output of the current file
+    FILE *out;
+    uint32_t out_size;              // Bytes produced
+    uint32_t out_limit;             // Size from the file table
+    uint32_t crc;
+    bool write_failed;
+
+    // Deflate history, flushed to the file whenever it fills
+    uint8_t *window;
+    uint32_t window_mask;
+    uint32_t window_flushed;        // out_size at the last flush
+
+    huffman_t lencode;
+    huffman_t distcode;
+
+    app_package_info_t info;
+} package_state_t;
+
+static const uint16_t s_len_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t s_len_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t s_dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t s_dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t len)
+{
+    static uint32_t table[256];
+    if (!table[1]) {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) {
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[n] = c;
+        }
+    }
+
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static bool refill(package_state_t *s)
+{
+    s->in_len = s->read(s->in, sizeof(s->in), s->ctx);
+    s->in_pos = 0;
+    s->info.package_bytes += s->in_len;
+    return s->in_len > 0;
+}
+
+// Header, manifest and table bytes, outside any file
+static bool read_exact(package_state_t *s, void *dst, size_t len)
+{
+    uint8_t *p = dst;
+    while (len) {
+        if (s->in_pos == s->in_len && !refill(s)) {
+            return false;
+        }
+        size_t n = s->in_len - s->in_pos < len ? s->in_len - s->in_pos : len;
+        memcpy(p, s->in + s->in_pos, n);
+        s->in_pos += n;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+// Next byte of the current file, -1 past its end
+static int blob_byte(package_state_t *s)
+{
+    if (s->blob_left == 0 || (s->in_pos == s->in_len && !refill(s))) {
+        return -1;
+    }
+    s->blob_left--;
+    return s->in[s->in_pos++];
+}
+
+static int bits(package_state_t *s, int need)
+{
+    while (s->bit_count < need) {
+        int byte = blob_byte(s);
+        if (byte < 0) {
+            return -1;
+        }
+        s->bit_buf |= (uint32_t)byte << s->bit_count;
+        s->bit_count += 8;
+    }
+    int value = (int)(s->bit_buf & ((1u << need) - 1));
+    s->bit_buf >>= need;
+    s->bit_count -= need;
+    return value;
+}
+
+static void write_out(package_state_t *s, const uint8_t *data, size_t len)
+{
+    s->crc = crc32_update(s->crc, data, len);
+    if (fwrite(data, 1, len, s->out) != len) {
+        s->write_failed = true;
+    }
+}
+
+static void window_flush(package_state_t *s)
+{
+    uint32_t pending = s->out_size - s->window_flushed;
+    if (pending) {
+        write_out(s, s->window + (s->window_flushed & s->window_mask), pending);
+        s->window_flushed = s->out_size;
+    }
+}
+
+static bool put_byte(package_state_t *s, uint8_t byte)
+{
+    if (s->out_size == s->out_limit) {
+        return false;   // More than the table says
+    }
+    s->window[s->out_size++ & s->window_mask] = byte;
+    if (s->out_size - s->window_flushed > s->window_mask) {
+        window_flush(s);
+    }
+    return true;
+}
+
+static int huffman_decode(package_state_t *s, const huffman_t *h)
+{
+    int code = 0, first = 0, index = 0;
+    for (int len = 1; len <= MAX_BITS; len++) {
+        int bit = bits(s, 1);
+        if (bit < 0) {
+            return -1;
+        }
+        code |= bit;
+        int count = h->count[len];
+        if (code - count < first) {
+            return h->symbol[index + (code - first)];
+        }
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+// Canonical code from lengths; 0 if complete, > 0 if incomplete, < 0 if over-subscribed
+static int huffman_build(huffman_t *h, const uint8_t *lengths, int n)
+{
+    int16_t offsets[MAX_BITS + 1];
+
+    memset(h->count, 0, sizeof(h->count));
+    for (int symbol = 0; symbol < n; symbol++) {
+        h->count[lengths[symbol]]++;
+    }
+    if (h->count[0] == n) {
+        return 0;
+    }
+
+    int left = 1;
+    for (int len = 1; len <= MAX_BITS; len++) {
+        left <<= 1;
+        left -= h->count[len];
+        if (left < 0) {
+            return left;
+        }
+    }
+
+    offsets[1] = 0;
+    for (int len = 1; len < MAX_BITS; len++) {
+        offsets[len + 1] = offsets[len] + h->count[len];
+    }
+    for (int symbol = 0; symbol < n; symbol++) {
+        if (lengths[symbol]) {
+            h->symbol[offsets[lengths[symbol]]++] = symbol;
+        }
+    }
+    return left;
+}
+
+static bool inflate_stored(package_state_t *s)
+{
+    s->bit_buf = 0;
+    s->bit_count = 0;
+
+    int lo = bits(s, 16);
+    int nlo = bits(s, 16);
+    if (lo < 0 || nlo < 0 || (lo ^ 0xFFFF) != nlo) {
+        return false;
+    }
+    while (lo--) {
+        int byte = blob_byte(s);
+        if (byte < 0 || !put_byte(s, (uint8_t)byte)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool inflate_codes(package_state_t *s)
+{
+    for (;;) {
+        int symbol = huffman_decode(s, &s->lencode);
+        if (symbol < 0) {
+            return false;
+        }
+        if (symbol < 256) {
+            if (!put_byte(s, (uint8_t)symbol)) {
+                return false;
+            }
+            continue;
+        }
+        if (symbol == 256) {
+            return true;
+        }
+
+        symbol -= 257;
+        if (symbol >= 29) {
+            return false;
+        }
+        int extra = bits(s, s_len_extra[symbol]);
+        int dsymbol = extra < 0 ? -1 : huffman_decode(s, &s->distcode);
+        if (dsymbol < 0 || dsymbol >= 30) {
+            return false;
+        }
+        int dextra = bits(s, s_dist_extra[dsymbol]);
+        if (dextra < 0) {
+            return false;
+        }
+
+        uint32_t len = s_len_base[symbol] + extra;
+        uint32_t dist = s_dist_base[dsymbol] + dextra;
+        if (dist > s->out_size || dist > s->window_mask + 1) {
+            return false;   // Before the file or outside the declared window
+        }
+        while (len--) {
+            if (!put_byte(s, s->window[(s->out_size - dist) & s->window_mask])) {
+                return false;
+            }
+        }
+    }
+}
+
+static bool inflate_fixed(package_state_t *s)
+{
+    uint8_t lengths[FIX_LCODES];
+    int symbol = 0;
+    for (; symbol < 144; symbol++) lengths[symbol] = 8;
+    for (; symbol < 256; symbol++) lengths[symbol] = 9;
+    for (; symbol < 280; symbol++) lengths[symbol] = 7;
+    for (; symbol < FIX_LCODES; symbol++) lengths[symbol] = 8;
+    huffman_build(&s->lencode, lengths, FIX_LCODES);
+
+    memset(lengths, 5, MAX_DCODES);
+    huffman_build(&s->distcode, lengths, MAX_DCODES);
+    return inflate_codes(s);
+}
+
+static bool inflate_dynamic(package_state_t *s)
+{
+    static const uint8_t order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+    uint8_t lengths[MAX_LCODES + MAX_DCODES];
+
+    int nlen = bits(s, 5);
+    int ndist = bits(s, 5);
+    int ncode = bits(s, 4);
+    if (nlen < 0 || ndist < 0 || ncode < 0) {
+        return false;
+    }
+    nlen += 257;
+    ndist += 1;
+    ncode += 4;
+    if (nlen > MAX_LCODES || ndist > MAX_DCODES) {
+        return false;
+    }
+
+    memset(lengths, 0, 19);
+    for (int i = 0; i < ncode; i++) {
+        int len = bits(s, 3);
+        if (len < 0) {
+            return false;
+        }
+        lengths[order[i]] = (uint8_t)len;
+    }
+    if (huffman_build(&s->lencode, lengths, 19) != 0) {
+        return false;
+    }
+
+    for (int index = 0; index < nlen + ndist;) {
+        int symbol = huffman_decode(s, &s->lencode);
+        if (symbol < 0) {
+            return false;
+        }
+        if (symbol < 16) {
+            lengths[index++] = (uint8_t)symbol;
+            continue;
+        }
+
+        int len = 0, repeat;
+        if (symbol == 16) {
+            if (index == 0) {
+                return false;
+            }
+            len = lengths[index - 1];
+            repeat = bits(s, 2);
+            repeat = repeat < 0 ? -1 : 3 + repeat;
+        } else if (symbol == 17) {
+            repeat = bits(s, 3);
+            repeat = repeat < 0 ? -1 : 3 + repeat;
+        } else {
+            repeat = bits(s, 7);
+            repeat = repeat < 0 ? -1 : 11 + repeat;
+        }
+        if (repeat < 0 || index + repeat > nlen + ndist) {
+            return false;
+        }
+        while (repeat--) {
+            lengths[index++] = (uint8_t)len;
+        }
+    }
+    if (lengths[256] == 0) {
+        return false;   // No end-of-block code
+    }
+
+    // Incomplete codes are only allowed for a single length code
+    int err = huffman_build(&s->lencode, lengths, nlen);
+    if (err < 0 || (err > 0 && nlen - s->lencode.count[0] != 1)) {
+        return false;
+    }
+    err = huffman_build(&s->distcode, lengths + nlen, ndist);
+    if (err < 0 || (err > 0 && ndist - s->distcode.count[0] != 1)) {
+        return false;
+    }
+    return inflate_codes(s);
+}
+
+static bool inflate_file(package_state_t *s)
+{
+    s->bit_buf = 0;
+    s->bit_count = 0;
+    s->window_flushed = 0;
+
+    int last;
+    do {
+        last = bits(s, 1);
+        int type = bits(s, 2);
+        bool ok = false;
+        if (last < 0 || type < 0) {
+            return false;
+        }
+        switch (type) {
+        case 0: ok = inflate_stored(s); break;
+        case 1: ok = inflate_fixed(s); break;
+        case 2: ok = inflate_dynamic(s); break;
+        default: break;
+        }
+        if (!ok) {
+            return false;
+        }
+    } while (!last);
+
+    window_flush(s);
+    return true;
+}
+
+static bool copy_file(package_state_t *s)
+{
+    while (s->blob_left) {
+        if (s->in_pos == s->in_len && !refill(s)) {
+            return false;
+        }
+        size_t n = s->in_len - s->in_pos;
+        if (n > s->blob_left) {
+            n = s->blob_left;
+        }
+        if (s->out_size + n > s->out_limit) {
+            return false;
+        }
+        write_out(s, s->in + s->in_pos, n);
+        s->in_pos += n;
+        s->blob_left -= n;
+        s->out_size += n;
+    }
+    return true;
+}
+
+// Relative, no "..", no empty components, not the manifest or the commit
+// marker, not seen before
+static bool path_is_safe(const app_package_file_t *table, uint32_t index)
+{
+    const char *path = table[index].path;
+    size_t len = strnlen(path, APP_PACKAGE_PATH_MAX);
+    if (len == 0 || len == APP_PACKAGE_PATH_MAX || path[0] == '/' || path[len - 1] == '/' ||
+        strcmp(path, PACKAGE_MANIFEST_NAME) == 0 || strcmp(path, PACKAGE_COMMIT_NAME) == 0) {
+        return false;
+    }
+
+    for (const char *c = path; *c; c++) {
+        if ((unsigned char)*c < 0x20 || *c == '\\' || *c == 0x7F || (c[0] == '/' && c[1] == '/')) {
+            return false;
+        }
+        if ((c == path || c[-1] == '/') && c[0] == '.' &&
+            (c[1] == '/' || c[1] == '\0' || (c[1] == '.' && (c[2] == '/' || c[2] == '\0')))) {
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < index; i++) {
+        if (strncmp(table[i].path, path, APP_PACKAGE_PATH_MAX) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Creates the directories above root/path where the file system has them.
+// On SPIFFS mkdir fails and the name needs none, so failures are left to
+// the fopen or rename that follows.
+static void make_parents(const char *root, const char *path)
+{
+    char dir[PACKAGE_FILE_PATH_LEN];
+    int root_len = snprintf(dir, sizeof(dir), "%s/%s", root, path);
+
+    for (char *c = dir + root_len - strlen(path); *c; c++) {
+        if (*c == '/') {
+            *c = '\0';
+            mkdir(dir, 0755);
+            *c = '/';
+        }
+    }
+}
+
+// SPIFFS lists every file under the prefix by its flat name, subpaths
+// included, and has no directories to remove, so rmdir failing is expected
+static void remove_tree(const char *path)
+{
+    DIR *dir = opendir(path);
+    if (dir) {
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+                continue;
+            }
+            char child[PACKAGE_FILE_PATH_LEN];
+            if (snprintf(child, sizeof(child), "%s/%s", path, entry->d_name) >= (int)sizeof(child)) {
+                continue;
+            }
+            if (entry->d_type == DT_DIR) {
+                remove_tree(child);
+            } else {
+                remove(child);
+            }
+        }
+        closedir(dir);
+    }
+    rmdir(path);
+}
+
+static esp_err_t write_file(const char *root, const char *name, const void *data, uint32_t size)
+{
+    char path[PACKAGE_FILE_PATH_LEN];
+    snprintf(path, sizeof(path), "%s/%s", root, name);
+
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        return ESP_FAIL;
+    }
+    bool ok = fwrite(data, 1, size, file) == size;
+    ok = fclose(file) == 0 && ok;
+    return ok ? ESP_OK : ESP_FAIL;
+}
+
+static bool move_file(const char *from_root, const char *to_root, const char *name)
+{
+    char from[PACKAGE_FILE_PATH_LEN];
+    char to[PACKAGE_FILE_PATH_LEN];
+    snprintf(from, sizeof(from), "%s/%.*s", from_root, APP_PACKAGE_PATH_MAX, name);
+    snprintf(to, sizeof(to), "%s/%.*s", to_root, APP_PACKAGE_PATH_MAX, name);
+
+    make_parents(to_root, name);
+    if (rename(from, to) != 0) {
+        ESP_LOGE(TAG, "Failed to move %s into place", to);
+        return false;
+    }
+    return true;
+}
+
+// Every staged file is renamed into install_path, then the marker is
+// written; without it the files are the leftovers of an interrupted move
+static esp_err_t commit_files(const char *tmp_path, const char *install_path,
+                              const app_package_file_t *table, uint32_t count)
+{
+    mkdir(install_path, 0755);
+    if (!move_file(tmp_path, install_path, PACKAGE_MANIFEST_NAME)) {
+        return ESP_FAIL;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (!move_file(tmp_path, install_path, table[i].path)) {
+            return ESP_FAIL;
+        }
+    }
+    remove_tree(tmp_path);
+    return write_file(install_path, PACKAGE_COMMIT_NAME, "", 0);
+}
+
+static esp_err_t install_file(package_state_t *s, const char *root, const app_package_file_t *file)
+{
+    char path[PACKAGE_FILE_PATH_LEN];
+    snprintf(path, sizeof(path), "%s/%.*s", root, APP_PACKAGE_PATH_MAX, file->path);
+
+    make_parents(root, file->path);
+    if (!(s->out = fopen(path, "wb"))) {
+        ESP_LOGE(TAG, "Failed to create %s", path);
+        return ESP_FAIL;
+    }
+
+    s->blob_left = file->stored_size;
+    s->out_size = 0;
+    s->out_limit = file->size;
+    s->crc = 0;
+    s->write_failed = false;
+
+    bool ok = file->method == APP_PACKAGE_DEFLATE ? inflate_file(s) : copy_file(s);
+    bool closed = fclose(s->out) == 0;
+    s->out = NULL;
+
+    if (s->write_failed || !closed) {
+        ESP_LOGE(TAG, "Failed to write %s", path);
+        return ESP_FAIL;
+    }
+    if (!ok && s->in_len == 0) {
+        ESP_LOGE(TAG, "Package ends inside %s", file->path);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (!ok || s->blob_left || s->out_size != file->size || s->crc != file->crc32) {
+        ESP_LOGE(TAG, "%s is corrupt", file->path);
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    s->info.installed_bytes += file->size;
+    s->info.files++;
+    return ESP_OK;
+}
+
+static esp_err_t read_index(package_state_t *s, app_package_header_t *header, char **manifest,
+                            app_package_file_t **table)
+{
+    if (!read_exact(s, header, sizeof(*header))) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (header->magic != APP_PACKAGE_MAGIC) {
+        ESP_LOGE(TAG, "Not an app package");
+        return ESP_ERR_INVALID_VERSION;
+    }
+    if (header->version != APP_PACKAGE_VERSION) {
+        ESP_LOGE(TAG, "Package version %u, expected %u", (unsigned)header->version,
+                 (unsigned)APP_PACKAGE_VERSION);
+        return ESP_ERR_INVALID_VERSION;
+    }
+    if (header->manifest_size == 0 || header->manifest_size > APP_PACKAGE_MAX_MANIFEST ||
+        header->file_count > APP_PACKAGE_MAX_FILES ||
+        (header->window_bits && (header->window_bits < APP_PACKAGE_MIN_WINDOW_BITS ||
+                                 header->window_bits > APP_PACKAGE_MAX_WINDOW_BITS))) {
+        ESP_LOGE(TAG, "Package header out of range");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t table_size = header->file_count * sizeof(app_package_file_t);
+    *manifest = malloc(header->manifest_size);
+    *table = malloc(table_size ? table_size : 1);
+    if (!*manifest || !*table) {
+        return ESP_ERR_NO_MEM;
+    }
+    s->info.peak_memory += header->manifest_size + table_size;
+
+    if (!read_exact(s, *manifest, header->manifest_size) || !read_exact(s, *table, table_size)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    uint32_t crc = crc32_update(0, (const uint8_t *)*manifest, header->manifest_size);
+    if (crc32_update(crc, (const uint8_t *)*table, table_size) != header->crc32) {
+        ESP_LOGE(TAG, "Package index is corrupt");
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    for (uint32_t i = 0; i < header->file_count; i++) {
+        const app_package_file_t *file = &(*table)[i];
+        if (!path_is_safe(*table, i) || file->method > APP_PACKAGE_DEFLATE ||
+            (file->method == APP_PACKAGE_STORED && file->stored_size != file->size) ||
+            (file->method == APP_PACKAGE_DEFLATE && !header->window_bits)) {
+            ESP_LOGE(TAG, "Bad file table entry %u", (unsigned)i);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t app_package_install(app_package_read_t read, void *ctx, const char *install_path,
+                              app_package_info_t *info)
+{
+    if (!read || !install_path || strlen(install_path) + sizeof(PACKAGE_TMP_SUFFIX) > MAX_APP_PATH_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    package_state_t *s = calloc(1, sizeof(package_state_t));
+    if (!s) {
+        return ESP_ERR_NO_MEM;
+    }
+    s->read = read;
+    s->ctx = ctx;
+    s->info.peak_memory = sizeof(package_state_t);
+
+    app_package_header_t header;
+    char *manifest = NULL;
+    app_package_file_t *table = NULL;
+    char tmp_path[MAX_APP_PATH_LEN];
+    snprintf(tmp_path, sizeof(tmp_path), "%s" PACKAGE_TMP_SUFFIX, install_path);
+    char marker[PACKAGE_FILE_PATH_LEN];
+    snprintf(marker, sizeof(marker), "%s/" PACKAGE_COMMIT_NAME, install_path);
+    bool started = false;
+
+    esp_err_t ret = read_index(s, &header, &manifest, &table);
+    if (ret == ESP_OK && header.window_bits) {
+        s->window = malloc(1u << header.window_bits);
+        s->window_mask = (1u << header.window_bits) - 1;
+        s->info.peak_memory += 1u << header.window_bits;
+        ret = s->window ? ESP_OK : ESP_ERR_NO_MEM;
+    }
+
+    // An installed app is never overwritten; leftovers of an interrupted
+    // install, staged or half moved, are discarded
+    struct stat st;
+    if (ret == ESP_OK && stat(marker, &st) == 0) {
+        ESP_LOGE(TAG, "%s is already installed", install_path);
+        ret = ESP_FAIL;
+    }
+    if (ret == ESP_OK) {
+        started = true;
+        remove_tree(tmp_path);
+        remove_tree(install_path);
+        mkdir(tmp_path, 0755);
+        ret = write_file(tmp_path, PACKAGE_MANIFEST_NAME, manifest, header.manifest_size);
+    }
+    for (uint32_t i = 0; ret == ESP_OK && i < header.file_count; i++) {
+        ret = install_file(s, tmp_path, &table[i]);
+    }
+    if (ret == ESP_OK) {
+        ret = commit_files(tmp_path, install_path, table, header.file_count);
+    }
+
+    if (ret != ESP_OK && started) {
+        remove_tree(tmp_path);
+        remove_tree(install_path);
+    }
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Installed %u files (%u bytes) from %u package bytes", (unsigned)s->info.files,
+                 (unsigned)s->info.installed_bytes, (unsigned)s->info.package_bytes);
+    }
+    if (info) {
+        *info = s->info;
+    }
+
+    free(s->window);
+    free(manifest);
+    free(table);
+    free(s);
+    return ret;
+}
+
+esp_err_t app_package_remove(const char *install_path)
+{
+    if (!install_path || strlen(install_path) + sizeof(PACKAGE_TMP_SUFFIX) > MAX_APP_PATH_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    char marker[PACKAGE_FILE_PATH_LEN];
+    snprintf(marker, sizeof(marker), "%s/" PACKAGE_COMMIT_NAME, install_path);
+    struct stat st;
+    if (remove(marker) != 0 && stat(marker, &st) == 0) {
+        ESP_LOGE(TAG, "Failed to remove %s", marker);
+        return ESP_FAIL;
+    }
+
+    char tmp_path[MAX_APP_PATH_LEN];
+    snprintf(tmp_path, sizeof(tmp_path), "%s" PACKAGE_TMP_SUFFIX, install_path);
+    remove_tree(install_path);
+    remove_tree(tmp_path);
+    return ESP_OK;
+}
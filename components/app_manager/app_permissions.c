@@ -18,15 +18,9 @@ static const struct {
     const char *name;
     uint32_t flag;
 } permission_map[] = {
-    {"rf.receive", APP_PERM_RF_RECEIVE},
-    {"rf.transmit", APP_PERM_RF_TRANSMIT},
-    {"gpio.read", APP_PERM_GPIO_READ},
-    {"gpio.write", APP_PERM_GPIO_WRITE},
-    {"storage.read", APP_PERM_STORAGE_READ},
-    {"storage.write", APP_PERM_STORAGE_WRITE},
-    {"ui.create", APP_PERM_UI_CREATE},
-    {"network", APP_PERM_NETWORK},
-    {"system", APP_PERM_SYSTEM},
+#define PERMISSION_ENTRY(id, name) {name, JS_PERM_##id},
+    JS_PERMISSION_LIST(PERMISSION_ENTRY)
+#undef PERMISSION_ENTRY
 };
 
 #define PERMISSION_COUNT (sizeof(permission_map) / sizeof(permission_map[0]))
@@ -0,0 +1,501 @@
+/**
+ * @file app_registry.c
+ * @brief Persistent, indexed registry of installed apps
+ *
+ * The registry is one versioned binary file: a header, a table of
+ * fixed-size records and a pool of the records' strings. Boot reads it
+ * sequentially into memory as-is, so listing apps needs no directory scan
+ * and no manifest parsing. Records are found by ID through an open
+ * addressing hash index rebuilt from the stored ID hashes.
+ *
+ * Saving writes a complete new file next to the old one and swaps it in,
+ * so a power cut leaves either the old or the new registry.
+ */
+
+#include "app_manager.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char *TAG = "APP_REGISTRY";
+
+#define REGISTRY_MAGIC          0x47525041  // "APRG"
+#define REGISTRY_MIN_CAPACITY   16
+#define REGISTRY_SUFFIX_NEW     ".new"
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t count;
+    uint32_t strings_size;
+    uint32_t checksum;          // FNV-1a of the records and strings
+} registry_header_t;
+
+enum { FIELD_ID, FIELD_NAME, FIELD_VERSION, FIELD_AUTHOR, FIELD_ENTRY_POINT, FIELD_INSTALL_PATH, FIELD_COUNT };
+
+#define RECORD_FLAG_SYSTEM      (1 << 0)
+
+typedef struct {
+    uint32_t id_hash;
+    uint32_t strings[FIELD_COUNT];  // Offsets into the string pool
+    uint32_t permissions;
+    uint32_t code_hash;
+    uint32_t flags;
+} registry_record_t;
+
+// Longest string of each field, including the terminator (fits app_info_t)
+static const uint32_t s_field_max[FIELD_COUNT] = {
+    [FIELD_ID] = 32,
+    [FIELD_NAME] = MAX_APP_NAME_LEN,
+    [FIELD_VERSION] = 16,
+    [FIELD_AUTHOR] = 32,
+    [FIELD_ENTRY_POINT] = 64,
+    [FIELD_INSTALL_PATH] = MAX_APP_PATH_LEN,
+};
+
+static registry_record_t *s_records = NULL;
+static uint32_t s_count = 0;
+static uint32_t s_capacity = 0;
+
+static char *s_strings = NULL;
+static uint32_t s_strings_used = 0;
+static uint32_t s_strings_capacity = 0;
+static uint32_t s_strings_garbage = 0;     // Bytes of removed or replaced strings
+
+static uint32_t *s_index = NULL;            // Record index + 1, 0 is empty
+static uint32_t s_index_size = 0;           // Power of two
+
+static uint32_t fnv1a(uint32_t h, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    while (len--) {
+        h ^= *p++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static uint32_t id_hash(const char *id)
+{
+    return fnv1a(2166136261u, id, strlen(id));
+}
+
+static const char* record_string(const registry_record_t *record, int field)
+{
+    return s_strings + record->strings[field];
+}
+
+static void fill_entry(const registry_record_t *record, app_registry_entry_t *entry)
+{
+    entry->id = record_string(record, FIELD_ID);
+    entry->name = record_string(record, FIELD_NAME);
+    entry->version = record_string(record, FIELD_VERSION);
+    entry->author = record_string(record, FIELD_AUTHOR);
+    entry->entry_point = record_string(record, FIELD_ENTRY_POINT);
+    entry->install_path = record_string(record, FIELD_INSTALL_PATH);
+    entry->permissions = record->permissions;
+    entry->code_hash = record->code_hash;
+    entry->is_system_app = (record->flags & RECORD_FLAG_SYSTEM) != 0;
+}
+
+static uint32_t record_strings_size(const registry_record_t *record)
+{
+    uint32_t size = 0;
+    for (int f = 0; f < FIELD_COUNT; f++) {
+        size += strlen(record_string(record, f)) + 1;
+    }
+    return size;
+}
+
+static void index_insert(uint32_t record)
+{
+    uint32_t mask = s_index_size - 1;
+    uint32_t slot = s_records[record].id_hash & mask;
+    while (s_index[slot]) {
+        slot = (slot + 1) & mask;
+    }
+    s_index[slot] = record + 1;
+}
+
+// Sized for a load factor of at most one half; never shrinks
+static esp_err_t index_rebuild(void)
+{
+    uint32_t size = REGISTRY_MIN_CAPACITY * 2;
+    while (size < s_count * 2) {
+        size *= 2;
+    }
+
+    if (size > s_index_size) {
+        uint32_t *index = realloc(s_index, size * sizeof(uint32_t));
+        if (!index) {
+            return ESP_ERR_NO_MEM;
+        }
+        s_index = index;
+        s_index_size = size;
+    }
+
+    memset(s_index, 0, s_index_size * sizeof(uint32_t));
+    for (uint32_t i = 0; i < s_count; i++) {
+        index_insert(i);
+    }
+    return ESP_OK;
+}
+
+static int index_lookup(const char *id)
+{
+    if (!s_index_size) {
+        return -1;
+    }
+
+    uint32_t hash = id_hash(id);
+    uint32_t mask = s_index_size - 1;
+    for (uint32_t slot = hash & mask; s_index[slot]; slot = (slot + 1) & mask) {
+        const registry_record_t *record = &s_records[s_index[slot] - 1];
+        if (record->id_hash == hash && strcmp(record_string(record, FIELD_ID), id) == 0) {
+            return (int)(s_index[slot] - 1);
+        }
+    }
+    return -1;
+}
+
+static esp_err_t reserve(uint32_t records, uint32_t strings)
+{
+    if (records > s_capacity) {
+        uint32_t capacity = s_capacity ? s_capacity : REGISTRY_MIN_CAPACITY;
+        while (capacity < records) {
+            capacity *= 2;
+        }
+        registry_record_t *grown = realloc(s_records, capacity * sizeof(registry_record_t));
+        if (!grown) {
+            return ESP_ERR_NO_MEM;
+        }
+        s_records = grown;
+        s_capacity = capacity;
+    }
+
+    if (strings > s_strings_capacity) {
+        uint32_t capacity = s_strings_capacity ? s_strings_capacity : 1024;
+        while (capacity < strings) {
+            capacity *= 2;
+        }
+        char *grown = realloc(s_strings, capacity);
+        if (!grown) {
+            return ESP_ERR_NO_MEM;
+        }
+        s_strings = grown;
+        s_strings_capacity = capacity;
+    }
+    return ESP_OK;
+}
+
+// Drop the strings of removed entries once they are half the pool
+static void maybe_compact(void)
+{
+    if (s_strings_garbage == 0 || s_strings_garbage < s_strings_used / 2) {
+        return;
+    }
+
+    char *pool = malloc(s_strings_capacity);
+    if (!pool) {
+        return;     // Try again on the next removal
+    }
+
+    uint32_t used = 0;
+    for (uint32_t i = 0; i < s_count; i++) {
+        for (int f = 0; f < FIELD_COUNT; f++) {
+            const char *str = record_string(&s_records[i], f);
+            size_t len = strlen(str) + 1;
+            memcpy(pool + used, str, len);
+            s_records[i].strings[f] = used;
+            used += len;
+        }
+    }
+
+    free(s_strings);
+    s_strings = pool;
+    s_strings_used = used;
+    s_strings_garbage = 0;
+}
+
+void app_registry_clear(void)
+{
+    free(s_records);
+    free(s_strings);
+    free(s_index);
+    s_records = NULL;
+    s_strings = NULL;
+    s_index = NULL;
+    s_count = s_capacity = 0;
+    s_strings_used = s_strings_capacity = s_strings_garbage = 0;
+    s_index_size = 0;
+}
+
+esp_err_t app_registry_add(const app_registry_entry_t *entry)
+{
+    if (!entry) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const char *fields[FIELD_COUNT] = {
+        entry->id, entry->name, entry->version, entry->author, entry->entry_point, entry->install_path,
+    };
+
+    // Staged first: the entry may point into the pool that is about to grow
+    char staged[32 + MAX_APP_NAME_LEN + 16 + 32 + 64 + MAX_APP_PATH_LEN];
+    uint32_t offsets[FIELD_COUNT];
+    uint32_t size = 0;
+    for (int f = 0; f < FIELD_COUNT; f++) {
+        size_t len = fields[f] ? strlen(fields[f]) + 1 : 0;
+        if (!fields[f] || len > s_field_max[f] || (f == FIELD_ID && len == 1)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        memcpy(staged + size, fields[f], len);
+        offsets[f] = size;
+        size += len;
+    }
+
+    int existing = index_lookup(entry->id);
+    uint32_t records = existing < 0 ? s_count + 1 : s_count;
+    esp_err_t ret = reserve(records, s_strings_used + size);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    registry_record_t *record;
+    if (existing >= 0) {
+        record = &s_records[existing];
+        s_strings_garbage += record_strings_size(record);
+    } else {
+        record = &s_records[s_count];
+    }
+
+    memcpy(s_strings + s_strings_used, staged, size);
+    for (int f = 0; f < FIELD_COUNT; f++) {
+        record->strings[f] = s_strings_used + offsets[f];
+    }
+    s_strings_used += size;
+
+    record->id_hash = id_hash(record_string(record, FIELD_ID));
+    record->permissions = entry->permissions;
+    record->code_hash = entry->code_hash;
+    record->flags = entry->is_system_app ? RECORD_FLAG_SYSTEM : 0;
+
+    if (existing >= 0) {
+        maybe_compact();
+        return ESP_OK;
+    }
+
+    s_count++;
+    if (s_count * 2 > s_index_size) {
+        ret = index_rebuild();
+        if (ret != ESP_OK) {
+            s_count--;
+            return ret;
+        }
+    } else {
+        index_insert(s_count - 1);
+    }
+    return ESP_OK;
+}
+
+esp_err_t app_registry_remove(const char *id)
+{
+    int i = id ? index_lookup(id) : -1;
+    if (i < 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // The last record fills the gap, so enumeration order is not kept
+    s_strings_garbage += record_strings_size(&s_records[i]);
+    s_records[i] = s_records[--s_count];
+    index_rebuild();    // Never grows, so cannot fail
+    maybe_compact();
+    return ESP_OK;
+}
+
+bool app_registry_find(const char *id, app_registry_entry_t *entry)
+{
+    int i = id ? index_lookup(id) : -1;
+    if (i < 0) {
+        return false;
+    }
+    if (entry) {
+        fill_entry(&s_records[i], entry);
+    }
+    return true;
+}
+
+bool app_registry_get(size_t index, app_registry_entry_t *entry)
+{
+    if (index >= s_count || !entry) {
+        return false;
+    }
+    fill_entry(&s_records[index], entry);
+    return true;
+}
+
+size_t app_registry_count(void)
+{
+    return s_count;
+}
+
+esp_err_t app_registry_set_permissions(const char *id, uint32_t permissions)
+{
+    int i = id ? index_lookup(id) : -1;
+    if (i < 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    s_records[i].permissions = permissions;
+    return ESP_OK;
+}
+
+static uint32_t checksum(const registry_record_t *records, uint32_t count, const char *strings,
+                         uint32_t strings_size)
+{
+    uint32_t h = fnv1a(2166136261u, records, count * sizeof(registry_record_t));
+    return fnv1a(h, strings, strings_size);
+}
+
+static esp_err_t load_file(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    registry_header_t header;
+    if (size < (long)sizeof(header) || fread(&header, sizeof(header), 1, file) != 1 ||
+        header.magic != REGISTRY_MAGIC) {
+        fclose(file);
+        return ESP_ERR_INVALID_CRC;
+    }
+    if (header.version != APP_REGISTRY_VERSION || header.record_size != sizeof(registry_record_t)) {
+        fclose(file);
+        ESP_LOGW(TAG, "%s has version %u, expected %u", path, (unsigned)header.version,
+                 (unsigned)APP_REGISTRY_VERSION);
+        return ESP_ERR_INVALID_VERSION;
+    }
+    if ((uint64_t)size != sizeof(header) + (uint64_t)header.count * sizeof(registry_record_t) +
+                          header.strings_size) {
+        fclose(file);
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    // Read straight into the table and pool the registry keeps
+    uint32_t capacity = header.count > REGISTRY_MIN_CAPACITY ? header.count : REGISTRY_MIN_CAPACITY;
+    registry_record_t *records = malloc(capacity * sizeof(registry_record_t));
+    char *strings = malloc(header.strings_size ? header.strings_size : 1);
+    bool ok = records && strings &&
+              fread(records, sizeof(registry_record_t), header.count, file) == header.count &&
+              fread(strings, 1, header.strings_size, file) == header.strings_size;
+    fclose(file);
+
+    if (ok) {
+        ok = checksum(records, header.count, strings, header.strings_size) == header.checksum &&
+             (header.count == 0 || strings[header.strings_size - 1] == '\0');
+    }
+    for (uint32_t i = 0; ok && i < header.count; i++) {
+        for (int f = 0; f < FIELD_COUNT; f++) {
+            ok = ok && records[i].strings[f] < header.strings_size;
+        }
+    }
+    if (!ok) {
+        free(records);
+        free(strings);
+        return records && strings ? ESP_ERR_INVALID_CRC : ESP_ERR_NO_MEM;
+    }
+
+    app_registry_clear();
+    s_records = records;
+    s_count = header.count;
+    s_capacity = capacity;
+    s_strings = strings;
+    s_strings_used = header.strings_size;
+    s_strings_capacity = header.strings_size ? header.strings_size : 1;
+    return index_rebuild();
+}
+
+esp_err_t app_registry_load(const char *path)
+{
+    if (!path) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // A complete pending registry is newer than the file it was meant to replace
+    char pending[MAX_APP_PATH_LEN];
+    snprintf(pending, sizeof(pending), "%s" REGISTRY_SUFFIX_NEW, path);
+    esp_err_t ret = load_file(pending);
+    if (ret == ESP_OK) {
+        ESP_LOGW(TAG, "Completing interrupted registry save");
+        remove(path);
+        rename(pending, path);
+    } else {
+        if (ret != ESP_ERR_NOT_FOUND) {
+            remove(pending);    // Torn write, the old registry is intact
+        }
+        ret = load_file(path);
+    }
+
+    if (ret != ESP_OK) {
+        app_registry_clear();
+        if (ret != ESP_ERR_NOT_FOUND) {
+            ESP_LOGE(TAG, "Unusable registry %s: %s", path, esp_err_to_name(ret));
+        }
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "Loaded %u apps from %s", (unsigned)s_count, path);
+    return ESP_OK;
+}
+
+esp_err_t app_registry_save(const char *path)
+{
+    if (!path) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    char pending[MAX_APP_PATH_LEN];
+    snprintf(pending, sizeof(pending), "%s" REGISTRY_SUFFIX_NEW, path);
+
+    FILE *file = fopen(pending, "wb");
+    if (!file) {
+        ESP_LOGE(TAG, "Failed to create %s", pending);
+        return ESP_FAIL;
+    }
+
+    registry_header_t header = {
+        .magic = REGISTRY_MAGIC,
+        .version = APP_REGISTRY_VERSION,
+        .record_size = sizeof(registry_record_t),
+        .count = s_count,
+        .strings_size = s_strings_used,
+        .checksum = checksum(s_records, s_count, s_strings, s_strings_used),
+    };
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(s_records, sizeof(registry_record_t), s_count, file) == s_count &&
+              fwrite(s_strings, 1, s_strings_used, file) == s_strings_used &&
+              fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok = fclose(file) == 0 && ok;
+
+    if (!ok) {
+        remove(pending);
+        ESP_LOGE(TAG, "Failed to write %s", pending);
+        return ESP_FAIL;
+    }
+
+    // SPIFFS cannot rename over an existing file; if power fails before the
+    // rename, load finds the complete registry under its pending name
+    remove(path);
+    if (rename(pending, path) != 0) {
+        ESP_LOGE(TAG, "Failed to swap in %s", path);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
@@ -20,6 +20,7 @@ typedef struct {
     uint32_t memory_limit;
     uint32_t time_limit;
     uint32_t start_time;
+    uint32_t permissions;
     bool active;
 } sandbox_t;
 
@@ -36,7 +37,7 @@ static sandbox_t* find_sandbox(const char *app_id)
     return NULL;
 }
 
-esp_err_t app_sandbox_create(const char *app_id, js_context_t **context)
+esp_err_t app_sandbox_create(const char *app_id, uint32_t permissions, js_context_t **context)
 {
     if (!app_id || !context) {
         return ESP_ERR_INVALID_ARG;
@@ -65,7 +66,8 @@ esp_err_t app_sandbox_create(const char *app_id, js_context_t **context)
         return ESP_ERR_NO_MEM;
     }
     
-    // Register API functions with permission checking
+    // Bind API functions; denied ones are bound to stubs that throw
+    js_ctx->permissions = permissions;
     esp_err_t ret = js_api_register_all(js_ctx);
     if (ret != ESP_OK) {
         mjs_engine_destroy_context(js_ctx);
@@ -79,12 +81,14 @@ esp_err_t app_sandbox_create(const char *app_id, js_context_t **context)
     sandbox->memory_limit = 65536;
     sandbox->time_limit = 5000; // 5 seconds
     sandbox->start_time = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    sandbox->permissions = permissions;
     sandbox->active = true;
     
     *context = js_ctx;
     s_sandbox_count++;
     
-    ESP_LOGI(TAG, "Sandbox created for app: %s", app_id);
+    ESP_LOGI(TAG, "Sandbox created for app: %s (permissions %s)", app_id,
+             app_permissions_to_string(permissions));
     return ESP_OK;
 }
 
@@ -155,12 +159,12 @@ bool app_sandbox_check_access(const char *app_id, const char *resource)
     
     // Check resource access permissions
     // This is a simplified implementation
-    if (strstr(resource, "/system/") && !app_manager_check_permission(app_id, APP_PERM_SYSTEM)) {
+    if (strstr(resource, "/system/") && !(sandbox->permissions & APP_PERM_SYSTEM)) {
         ESP_LOGW(TAG, "App %s denied access to system resource: %s", app_id, resource);
         return false;
     }
     
-    if (strstr(resource, "rf.") && !app_manager_check_permission(app_id, APP_PERM_RF_RECEIVE | APP_PERM_RF_TRANSMIT)) {
+    if (strstr(resource, "rf.") && !(sandbox->permissions & (APP_PERM_RF_RECEIVE | APP_PERM_RF_TRANSMIT))) {
         ESP_LOGW(TAG, "App %s denied access to RF resource: %s", app_id, resource);
         return false;
     }
@@ -10,21 +10,29 @@
 #include "mjs_engine.h"
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#define MAX_INSTALLED_APPS 16
+#define MAX_RUNNING_APPS 4
 #define MAX_APP_NAME_LEN 32
 #define MAX_APP_PATH_LEN 128
 
+// Scheduling: each period the foreground app runs all its due timers,
+// then every background app runs within its CPU quota
+#define APP_SCHEDULER_PERIOD_MS     20
+#define APP_BACKGROUND_QUOTA_US     2000            // Per background app and period
+#define APP_HEAP_LOW_WATER          (48 * 1024)     // Free heap below which background apps are evicted
+
 // App states
 typedef enum {
     APP_STATE_STOPPED,
-    APP_STATE_RUNNING,
-    APP_STATE_PAUSED,
-    APP_STATE_ERROR
+    APP_STATE_RUNNING,          // In the foreground
+    APP_STATE_PAUSED,           // Started, gets no CPU
+    APP_STATE_ERROR,
+    APP_STATE_BACKGROUND        // Started, runs within its quota
 } app_state_t;
 
 // App info structure
@@ -37,22 +45,40 @@ typedef struct {
     char install_path[MAX_APP_PATH_LEN];
     app_state_t state;
     js_context_t *js_context;
-    uint32_t memory_usage;
-    uint32_t cpu_time;
+    uint32_t memory_usage;      // Bytes held by the app's context
+    uint32_t cpu_time;          // Milliseconds spent running its timers
     bool is_system_app;
     uint32_t permissions;
 } app_info_t;
 
-// Permission flags
-#define APP_PERM_RF_RECEIVE     (1 << 0)
-#define APP_PERM_RF_TRANSMIT    (1 << 1)
-#define APP_PERM_GPIO_READ      (1 << 2)
-#define APP_PERM_GPIO_WRITE     (1 << 3)
-#define APP_PERM_STORAGE_READ   (1 << 4)
-#define APP_PERM_STORAGE_WRITE  (1 << 5)
-#define APP_PERM_UI_CREATE      (1 << 6)
-#define APP_PERM_NETWORK        (1 << 7)
-#define APP_PERM_SYSTEM         (1 << 8)
+// Permission flags, shared with the JS bindings (JS_PERMISSION_LIST)
+#define APP_PERM_RF_RECEIVE     JS_PERM_RF_RECEIVE
+#define APP_PERM_RF_TRANSMIT    JS_PERM_RF_TRANSMIT
+#define APP_PERM_GPIO_READ      JS_PERM_GPIO_READ
+#define APP_PERM_GPIO_WRITE     JS_PERM_GPIO_WRITE
+#define APP_PERM_STORAGE_READ   JS_PERM_STORAGE_READ
+#define APP_PERM_STORAGE_WRITE  JS_PERM_STORAGE_WRITE
+#define APP_PERM_UI_CREATE      JS_PERM_UI_CREATE
+#define APP_PERM_NETWORK        JS_PERM_NETWORK
+#define APP_PERM_SYSTEM         JS_PERM_SYSTEM
+
+// Persistent registry of installed apps
+#define APP_REGISTRY_PATH       "/apps/registry.bin"
+#define APP_REGISTRY_VERSION    1
+
+// Registry entry; the strings point into the registry and stay valid
+// until the next add, remove or load
+typedef struct {
+    const char *id;
+    const char *name;
+    const char *version;
+    const char *author;
+    const char *entry_point;
+    const char *install_path;
+    uint32_t permissions;
+    uint32_t code_hash;         // Hash of the entry source, keys its bytecode cache
+    bool is_system_app;
+} app_registry_entry_t;
 
 /**
  * @brief Initialize app manager
@@ -76,13 +102,19 @@ esp_err_t app_manager_install(const char *package_path, char *app_id);
 
 /**
  * @brief Uninstall app
+ *
+ * The registry entry is removed and saved first, then the app's files.
  * @param app_id App ID to uninstall
  * @return ESP_OK on success
  */
 esp_err_t app_manager_uninstall(const char *app_id);
 
 /**
- * @brief Start app
+ * @brief Start app, or bring it to the foreground if it is already started
+ *
+ * The previous foreground app keeps running in the background. With
+ * MAX_RUNNING_APPS started, the least recently used background app is
+ * stopped to make room.
  * @param app_id App ID to start
  * @return ESP_OK on success
  */
@@ -95,6 +127,14 @@ esp_err_t app_manager_start_app(const char *app_id);
  */
 esp_err_t app_manager_stop_app(const char *app_id);
 
+/**
+ * @brief Stop every started app and drop its JS runtime
+ *
+ * Must not be called while an app's script is running.
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE before app_manager_init()
+ */
+esp_err_t app_manager_stop_all(void);
+
 /**
  * @brief Get list of installed apps
  * @param apps Array to store app info
@@ -129,32 +169,296 @@ bool app_manager_check_permission(const char *app_id, uint32_t permission);
 esp_err_t app_manager_set_permissions(const char *app_id, uint32_t permissions);
 
 /**
- * @brief Get currently running app
+ * @brief Get the foreground app
  * @return App ID or NULL if none
  */
 const char* app_manager_get_current_app(void);
 
 /**
- * @brief Pause app execution
+ * @brief Pause a background app; its timers wait until it is resumed
  * @param app_id App ID to pause
- * @return ESP_OK on success
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if it is not started,
+ *         ESP_ERR_INVALID_STATE for the foreground app
  */
 esp_err_t app_manager_pause_app(const char *app_id);
 
 /**
- * @brief Resume app execution
+ * @brief Resume a paused app in the background
  * @param app_id App ID to resume
- * @return ESP_OK on success
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if it is not started
  */
 esp_err_t app_manager_resume_app(const char *app_id);
 
+/**
+ * @brief Run one scheduling period of the started apps
+ *
+ * Call every APP_SCHEDULER_PERIOD_MS from the JS engine task.
+ */
+void app_manager_schedule(void);
+
+// App package (.tapk): header, manifest, file table, then the file
+// contents in table order, each stored or raw-deflated. Little-endian.
+#define APP_PACKAGE_MAGIC           0x4B504154  // "TAPK"
+#define APP_PACKAGE_VERSION         1
+#define APP_PACKAGE_MAX_FILES       64
+#define APP_PACKAGE_MAX_MANIFEST    4096
+#define APP_PACKAGE_PATH_MAX        48
+#define APP_PACKAGE_MIN_WINDOW_BITS 9
+#define APP_PACKAGE_MAX_WINDOW_BITS 15
+
+typedef enum {
+    APP_PACKAGE_STORED,
+    APP_PACKAGE_DEFLATE             // Raw deflate, window size from the header
+} app_package_method_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint8_t window_bits;            // Largest deflate window used, 0 if nothing is compressed
+    uint8_t reserved;
+    uint32_t manifest_size;
+    uint32_t file_count;
+    uint32_t crc32;                 // Of the manifest and the file table
+} app_package_header_t;
+
+typedef struct {
+    char path[APP_PACKAGE_PATH_MAX];    // Relative to the app directory, NUL padded
+    uint32_t size;
+    uint32_t stored_size;           // Bytes in the package
+    uint32_t crc32;                 // Of the file contents
+    uint8_t method;                 // app_package_method_t
+    uint8_t reserved[3];
+} app_package_file_t;
+
+typedef struct {
+    uint32_t files;
+    uint32_t package_bytes;         // Read from the package
+    uint32_t installed_bytes;       // Written to the app directory
+    uint32_t peak_memory;           // Most bytes the installer had allocated
+} app_package_info_t;
+
+/**
+ * @brief Package source for app_package_install()
+ * @param buffer Buffer to fill
+ * @param size Bytes wanted
+ * @param ctx Context
+ * @return Bytes read, less than size only at the end of the package
+ */
+typedef size_t (*app_package_read_t)(void *buffer, size_t size, void *ctx);
+
+/**
+ * @brief Install a package in one streaming pass
+ *
+ * Files are inflated, checked and written under install_path + ".tmp/".
+ * Once every file matched its size and CRC they are renamed into
+ * install_path one at a time, and install_path + "/.installed" is written
+ * last. File by file so it works on SPIFFS, which has no directories.
+ * RAM use is bounded by the deflate window, not the package size.
+ *
+ * @param read Package source
+ * @param ctx Context for read
+ * @param install_path App directory to create; files there without the
+ *        marker are an interrupted install and are replaced
+ * @param info Receives what was installed, may be NULL
+ * @return ESP_OK, ESP_ERR_INVALID_VERSION for an unknown format,
+ *         ESP_ERR_INVALID_CRC for corrupt contents, ESP_ERR_INVALID_SIZE for
+ *         a truncated package, ESP_ERR_INVALID_ARG for an unsafe file table,
+ *         ESP_ERR_NO_MEM, ESP_FAIL if writing failed
+ */
+esp_err_t app_package_install(app_package_read_t read, void *ctx, const char *install_path,
+                              app_package_info_t *info);
+
+/**
+ * @brief Delete an installed app's files
+ *
+ * The commit marker goes first, so a removal cut short is left looking
+ * like an interrupted install, and the next install to the path clears it.
+ * @param install_path App directory
+ * @return ESP_OK, ESP_FAIL if the marker could not be removed
+ */
+esp_err_t app_package_remove(const char *install_path);
+
+// App registry functions (callers serialise access)
+
+/**
+ * @brief Load the registry in one sequential read, replacing what is in memory
+ *
+ * A registry left as path + ".new" by an interrupted save is used if the
+ * file itself is missing or damaged.
+ *
+ * @param path Registry file
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if there is no registry (it is left empty),
+ *         ESP_ERR_INVALID_VERSION or ESP_ERR_INVALID_CRC for an unusable file
+ */
+esp_err_t app_registry_load(const char *path);
+
+/**
+ * @brief Write the registry to path + ".new", then swap it in
+ * @param path Registry file
+ * @return ESP_OK on success; the previous file is kept on failure
+ */
+esp_err_t app_registry_save(const char *path);
+
+/**
+ * @brief Remove every entry and free the registry memory
+ */
+void app_registry_clear(void);
+
+/**
+ * @brief Add an app, replacing an entry with the same ID
+ * @param entry Entry; the strings are copied
+ * @return ESP_OK, ESP_ERR_INVALID_ARG for a missing or over-long field, ESP_ERR_NO_MEM
+ */
+esp_err_t app_registry_add(const app_registry_entry_t *entry);
+
+/**
+ * @brief Remove an app
+ * @param id App ID
+ * @return ESP_OK, ESP_ERR_NOT_FOUND
+ */
+esp_err_t app_registry_remove(const char *id);
+
+/**
+ * @brief Look up an app by ID (hashed)
+ * @param id App ID
+ * @param entry Receives the entry, may be NULL
+ * @return true if found
+ */
+bool app_registry_find(const char *id, app_registry_entry_t *entry);
+
+/**
+ * @brief Get an app by position, for enumeration
+ * @param index 0 to app_registry_count() - 1
+ * @param entry Receives the entry
+ * @return true if index is valid
+ */
+bool app_registry_get(size_t index, app_registry_entry_t *entry);
+
+/**
+ * @brief Get the number of registered apps
+ * @return App count
+ */
+size_t app_registry_count(void);
+
+/**
+ * @brief Change the permissions of an app in memory
+ * @param id App ID
+ * @param permissions Permission flags
+ * @return ESP_OK, ESP_ERR_NOT_FOUND
+ */
+esp_err_t app_registry_set_permissions(const char *id, uint32_t permissions);
+
+// App lifecycle functions (callers serialise access)
+
+/**
+ * @brief Stops an app chosen for eviction
+ *
+ * Must remove the app with app_lifecycle_remove().
+ * @param app_id App to stop
+ * @param ctx Context passed to app_lifecycle_run()
+ */
+typedef void (*app_lifecycle_evict_t)(const char *app_id, void *ctx);
+
+/**
+ * @brief Track a started app; it becomes the foreground app
+ * @param app_id App ID
+ * @param js_context The app's context
+ * @param now_ms Current time
+ * @return ESP_OK, ESP_ERR_INVALID_STATE if already tracked,
+ *         ESP_ERR_NO_MEM with MAX_RUNNING_APPS tracked
+ */
+esp_err_t app_lifecycle_add(const char *app_id, js_context_t *js_context, uint32_t now_ms);
+
+/**
+ * @brief Stop tracking an app
+ * @param app_id App ID
+ * @return ESP_OK, ESP_ERR_NOT_FOUND
+ */
+esp_err_t app_lifecycle_remove(const char *app_id);
+
+/**
+ * @brief Make an app the foreground app; the previous one goes to the background
+ * @param app_id App ID, may be paused
+ * @param now_ms Current time
+ * @return ESP_OK, ESP_ERR_NOT_FOUND
+ */
+esp_err_t app_lifecycle_set_foreground(const char *app_id, uint32_t now_ms);
+
+/**
+ * @brief Stop giving a background app CPU
+ * @param app_id App ID
+ * @return ESP_OK, ESP_ERR_NOT_FOUND, ESP_ERR_INVALID_STATE for the foreground app
+ */
+esp_err_t app_lifecycle_pause(const char *app_id);
+
+/**
+ * @brief Return a paused app to the background
+ * @param app_id App ID
+ * @return ESP_OK, ESP_ERR_NOT_FOUND
+ */
+esp_err_t app_lifecycle_resume(const char *app_id);
+
+/**
+ * @brief Get the runtime part of an app's info
+ * @param app_id App ID
+ * @param info Receives state, js_context, memory_usage and cpu_time
+ * @return true if the app is tracked
+ */
+bool app_lifecycle_get(const char *app_id, app_info_t *info);
+
+/**
+ * @brief Get the foreground app
+ * @return App ID or NULL
+ */
+const char *app_lifecycle_get_foreground(void);
+
+/**
+ * @brief Get the number of tracked apps
+ * @return App count
+ */
+size_t app_lifecycle_count(void);
+
+/**
+ * @brief Get the app that left the foreground longest ago
+ * @return App ID, NULL if no app but the foreground one is tracked
+ */
+const char *app_lifecycle_get_lru(void);
+
+/**
+ * @brief Run one scheduling period
+ *
+ * Under APP_HEAP_LOW_WATER free heap, the least recently used background
+ * app is evicted first (one per period, so the next reading sees the
+ * memory it freed). The foreground app then runs all its due timers.
+ * Each background app earns APP_BACKGROUND_QUOTA_US of CPU per period,
+ * turned into an interpreter operation budget from its measured cost per
+ * operation; time used past the quota is paid back before it runs again.
+ * @param now_ms Current time
+ * @param free_heap Free heap in bytes
+ * @param evict Stops an evicted app
+ * @param ctx Context for evict
+ */
+void app_lifecycle_run(uint32_t now_ms, uint32_t free_heap, app_lifecycle_evict_t evict, void *ctx);
+
 // App installer functions
 esp_err_t app_installer_extract_package(const char *package_path, const char *extract_path);
 esp_err_t app_installer_validate_manifest(const char *manifest_path);
 esp_err_t app_installer_copy_files(const char *src_path, const char *dst_path);
 
 // Sandbox functions
-esp_err_t app_sandbox_create(const char *app_id, js_context_t **context);
+
+/**
+ * @brief Create an app's JavaScript context with its natives bound
+ *
+ * Permissions are resolved while the natives are bound: allowed APIs run
+ * unchecked, denied ones throw. Changing an app's permissions takes
+ * effect the next time it starts.
+ * @param app_id App identifier
+ * @param permissions APP_PERM_* granted to the app
+ * @param context Created context
+ * @return ESP_OK on success
+ */
+esp_err_t app_sandbox_create(const char *app_id, uint32_t permissions, js_context_t **context);
 esp_err_t app_sandbox_destroy(const char *app_id);
 esp_err_t app_sandbox_set_limits(const char *app_id, uint32_t memory_limit, uint32_t time_limit);
 bool app_sandbox_check_access(const char *app_id, const char *resource);
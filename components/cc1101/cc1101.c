@@ -4,6 +4,10 @@
  */
 
 #include "cc1101.h"
+#include "metrics.h"
+#include "trace.h"
+#include "dlog.h"
+#include "event_bus.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -21,6 +25,9 @@ static cc1101_tx_callback_t s_tx_callback = NULL;
 static void *s_rx_user_data = NULL;
 static void *s_tx_user_data = NULL;
 
+METRIC_COUNTER_DEFINE(s_rx_packets, "rf.rx_packets", "pkt");
+METRIC_COUNTER_DEFINE(s_rx_dropped, "rf.rx_dropped", "pkt");
+
 // Forward declarations
 extern esp_err_t cc1101_spi_init(spi_device_handle_t spi_device);
 extern esp_err_t cc1101_spi_write_reg(uint8_t reg, uint8_t value);
@@ -195,7 +202,9 @@ esp_err_t cc1101_set_frequency(uint32_t frequency_hz)
 
     s_config.frequency_hz = frequency_hz;
     
-    ESP_LOGI(TAG, "Frequency set to %u Hz", frequency_hz);
+    // Called on every step of a sweep, so this is traced rather than logged
+    TRACE(TRACE_RF_SET_FREQUENCY, frequency_hz, 0);
+    DLOGD(TAG, "Frequency set to %u Hz", frequency_hz);
     return ESP_OK;
 }
 
@@ -250,7 +259,7 @@ esp_err_t cc1101_start_receive(void)
     // Enter RX mode
     ESP_ERROR_CHECK(cc1101_spi_strobe(CC1101_SRX));
     
-    ESP_LOGI(TAG, "Entered RX mode");
+    DLOGI(TAG, "Entered RX mode");
     return ESP_OK;
 }
 
@@ -263,7 +272,7 @@ esp_err_t cc1101_stop_receive(void)
     // Enter idle mode
     ESP_ERROR_CHECK(cc1101_spi_strobe(CC1101_SIDLE));
     
-    ESP_LOGI(TAG, "Exited RX mode");
+    DLOGI(TAG, "Exited RX mode");
     return ESP_OK;
 }
 
@@ -288,7 +297,15 @@ esp_err_t cc1101_transmit(const uint8_t *data, uint8_t length)
     // Enter TX mode
     ESP_ERROR_CHECK(cc1101_spi_strobe(CC1101_STX));
     
-    ESP_LOGI(TAG, "Transmitting %d bytes", length);
+    TRACE(TRACE_RF_TX, length, 0);
+    DLOGI(TAG, "Transmitting %d bytes", length);
+
+    event_rf_tx_t tx = { .frequency = s_config.frequency_hz, .length = length };
+    event_publish_rf_tx(&tx, EVENT_PRIO_NORMAL);
+
+    if (s_tx_callback) {
+        s_tx_callback(true, s_tx_user_data);
+    }
     return ESP_OK;
 }
 
@@ -302,6 +319,10 @@ esp_err_t cc1101_read_signal(cc1101_signal_t *signal)
     uint8_t rxbytes;
     ESP_ERROR_CHECK(cc1101_spi_read_reg(CC1101_RXBYTES, &rxbytes));
     
+    if (rxbytes & 0x80) {
+        // RX FIFO overflowed, whatever did not fit is lost
+        metric_inc(&s_rx_dropped);
+    }
     if ((rxbytes & 0x7F) == 0) {
         return ESP_ERR_NOT_FOUND; // No data available
     }
@@ -332,6 +353,22 @@ esp_err_t cc1101_read_signal(cc1101_signal_t *signal)
     signal->length = length;
     signal->timestamp = xTaskGetTickCount() * portTICK_PERIOD_MS;
 
+    metric_inc(&s_rx_packets);
+    TRACE(TRACE_RF_RX_PACKET, length, signal->rssi);
+
+    event_rf_rx_t rx = {
+        .frequency = signal->frequency,
+        .rssi = signal->rssi,
+        .lqi = signal->lqi,
+        .length = signal->length,
+        .timestamp = signal->timestamp,
+    };
+    memcpy(rx.data, signal->data, length < EVENT_RF_DATA_MAX ? length : EVENT_RF_DATA_MAX);
+    event_publish_rf_rx(&rx, EVENT_PRIO_NORMAL);
+
+    if (s_rx_callback) {
+        s_rx_callback(signal, s_rx_user_data);
+    }
     return ESP_OK;
 }
 
@@ -4,6 +4,7 @@
  */
 
 #include "cc1101.h"
+#include "metrics.h"
 #include "esp_log.h"
 #include "driver/spi_master.h"
 #include "freertos/FreeRTOS.h"
@@ -13,6 +14,14 @@ static const char *TAG = "CC1101_SPI";
 
 static spi_device_handle_t s_spi_device = NULL;
 
+METRIC_COUNTER_DEFINE(s_spi_transactions, "rf.spi_transactions", "trans");
+
+static esp_err_t spi_transmit(spi_transaction_t *trans)
+{
+    metric_inc(&s_spi_transactions);
+    return spi_device_transmit(s_spi_device, trans);
+}
+
 esp_err_t cc1101_spi_init(spi_device_handle_t spi_device)
 {
     if (!spi_device) {
@@ -37,7 +46,7 @@ esp_err_t cc1101_spi_write_reg(uint8_t reg, uint8_t value)
         .flags = SPI_TRANS_USE_TXDATA
     };
 
-    esp_err_t ret = spi_device_transmit(s_spi_device, &trans);
+    esp_err_t ret = spi_transmit(&trans);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to write register 0x%02X", reg);
     }
@@ -61,7 +70,7 @@ esp_err_t cc1101_spi_read_reg(uint8_t reg, uint8_t *value)
         .flags = SPI_TRANS_USE_TXDATA | SPI_TRANS_USE_RXDATA
     };
 
-    esp_err_t ret = spi_device_transmit(s_spi_device, &trans);
+    esp_err_t ret = spi_transmit(&trans);
     if (ret == ESP_OK) {
         *value = trans.rx_data[1];
     } else {
@@ -96,7 +105,7 @@ esp_err_t cc1101_spi_write_burst_reg(uint8_t reg, const uint8_t *data, uint8_t l
     memcpy(&tx_buf[1], data, length);
     trans.tx_buffer = tx_buf;
 
-    esp_err_t ret = spi_device_transmit(s_spi_device, &trans);
+    esp_err_t ret = spi_transmit(&trans);
     
     free(tx_buf);
     
@@ -139,7 +148,7 @@ esp_err_t cc1101_spi_read_burst_reg(uint8_t reg, uint8_t *data, uint8_t length)
     trans.tx_buffer = tx_buf;
     trans.rx_buffer = rx_buf;
 
-    esp_err_t ret = spi_device_transmit(s_spi_device, &trans);
+    esp_err_t ret = spi_transmit(&trans);
     
     if (ret == ESP_OK) {
         memcpy(data, &rx_buf[1], length);
@@ -165,7 +174,7 @@ esp_err_t cc1101_spi_strobe(uint8_t strobe)
         .flags = SPI_TRANS_USE_TXDATA
     };
 
-    esp_err_t ret = spi_device_transmit(s_spi_device, &trans);
+    esp_err_t ret = spi_transmit(&trans);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to send strobe 0x%02X", strobe);
     }
@@ -196,7 +205,7 @@ esp_err_t cc1101_spi_write_fifo(const uint8_t *data, uint8_t length)
     memcpy(&tx_buf[1], data, length);
     trans.tx_buffer = tx_buf;
 
-    esp_err_t ret = spi_device_transmit(s_spi_device, &trans);
+    esp_err_t ret = spi_transmit(&trans);
     
     free(tx_buf);
     
@@ -238,7 +247,7 @@ esp_err_t cc1101_spi_read_fifo(uint8_t *data, uint8_t length)
     trans.tx_buffer = tx_buf;
     trans.rx_buffer = rx_buf;
 
-    esp_err_t ret = spi_device_transmit(s_spi_device, &trans);
+    esp_err_t ret = spi_transmit(&trans);
     
     if (ret == ESP_OK) {
         memcpy(data, &rx_buf[1], length);
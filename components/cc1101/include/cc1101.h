@@ -238,14 +238,19 @@ int16_t cc1101_get_rssi(void);
 cc1101_state_t cc1101_get_state(void);
 
 /**
- * @brief Set RX callback
+ * @brief Set RX callback (single subscriber; EVENT_RF_RX on the event bus reaches any number)
+ *
+ * Called by cc1101_read_signal() for each packet read, on the caller's task.
  * @param callback Callback function
  * @param user_data User data
  */
 void cc1101_set_rx_callback(cc1101_rx_callback_t callback, void *user_data);
 
 /**
- * @brief Set TX callback
+ * @brief Set TX callback (single subscriber; EVENT_RF_TX on the event bus reaches any number)
+ *
+ * Called by cc1101_transmit() once the packet is in the FIFO and TX has
+ * started, on the caller's task.
  * @param callback Callback function
  * @param user_data User data
  */
@@ -0,0 +1,420 @@
+/**
+ * @file dlog.c
+ * @brief Deferred log ring, module table and formatter
+ */
+
+#include "dlog.h"
+#include "metrics.h"
+#include <stdio.h>
+#include <string.h>
+
+#define RING_MASK       (DLOG_RING_LEN - 1)
+
+_Static_assert((DLOG_RING_LEN & RING_MASK) == 0, "DLOG_RING_LEN must be a power of two");
+
+typedef struct {
+    atomic_uint seq;            // Position + 1 once the entry is complete
+    uint32_t timestamp_ms;
+    dlog_module_t *module;
+    const char *format;
+    uint8_t level;
+    uint8_t nargs;
+    uint8_t kinds[DLOG_MAX_ARGS];
+    uint8_t sizes[DLOG_MAX_ARGS];
+    uint64_t values[DLOG_MAX_ARGS];     // Strings hold an offset into strings[]
+    char strings[DLOG_STR_BYTES];
+} dlog_entry_t;
+
+static dlog_entry_t s_ring[DLOG_RING_LEN];
+static atomic_uint s_head = 0;
+static atomic_uint s_tail = 0;
+static atomic_flag s_flushing = ATOMIC_FLAG_INIT;
+
+static dlog_module_t s_modules[DLOG_MAX_MODULES];
+static atomic_uint s_module_count = 0;
+static dlog_module_t s_fallback = { .tag = "DLOG", .level = DLOG_DEFAULT_LEVEL };
+static atomic_int s_default_level = DLOG_DEFAULT_LEVEL;
+static atomic_uint s_default_rate = DLOG_DEFAULT_RATE;
+
+static dlog_sink_t s_sink = NULL;
+
+static atomic_uint s_written = 0;
+static atomic_uint s_printed = 0;
+static atomic_uint s_dropped = 0;
+static atomic_uint s_suppressed = 0;
+static atomic_uint s_max_depth = 0;
+
+METRIC_COUNTER_DEFINE(s_dropped_metric, "log.dropped", "msgs");
+METRIC_COUNTER_DEFINE(s_suppressed_metric, "log.suppressed", "msgs");
+
+static void module_init(dlog_module_t *module, const char *tag)
+{
+    uint32_t rate = atomic_load(&s_default_rate);
+
+    atomic_store(&module->level, atomic_load(&s_default_level));
+    atomic_store(&module->rate, rate);
+    atomic_store(&module->tokens, rate);
+    atomic_store(&module->refill_ms, esp_log_timestamp());
+    atomic_store(&module->suppressed, 0);
+    module->tag = tag;
+}
+
+dlog_module_t* dlog_get_module(const char *tag)
+{
+    if (!tag) {
+        return &s_fallback;
+    }
+
+    uint32_t count = atomic_load_explicit(&s_module_count, memory_order_acquire);
+    for (uint32_t i = 0; i < count && i < DLOG_MAX_MODULES; i++) {
+        const char *t = s_modules[i].tag;
+        if (t && (t == tag || strcmp(t, tag) == 0)) {
+            return &s_modules[i];
+        }
+    }
+
+    // Two call sites racing on a new tag may both add it; level and rate
+    // changes apply to every entry with the tag, so that is harmless
+    uint32_t index = atomic_fetch_add(&s_module_count, 1);
+    if (index >= DLOG_MAX_MODULES) {
+        return &s_fallback;
+    }
+    module_init(&s_modules[index], tag);
+    return &s_modules[index];
+}
+
+// Token bucket refilled from elapsed time; races between writers only
+// blur the limit slightly
+static bool rate_allow(dlog_module_t *module, uint32_t now_ms)
+{
+    uint32_t rate = atomic_load_explicit(&module->rate, memory_order_relaxed);
+    if (rate == 0) {
+        return true;
+    }
+
+    uint32_t last = atomic_load_explicit(&module->refill_ms, memory_order_relaxed);
+    uint32_t add = (now_ms - last) * rate / 1000;
+    if (add && atomic_compare_exchange_strong(&module->refill_ms, &last, last + add * 1000 / rate)) {
+        uint32_t tokens = atomic_load(&module->tokens) + add;
+        atomic_store(&module->tokens, tokens < rate ? tokens : rate);
+    }
+
+    uint32_t tokens = atomic_load_explicit(&module->tokens, memory_order_relaxed);
+    while (tokens) {
+        if (atomic_compare_exchange_weak(&module->tokens, &tokens, tokens - 1)) {
+            return true;
+        }
+    }
+
+    atomic_fetch_add_explicit(&module->suppressed, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s_suppressed, 1, memory_order_relaxed);
+    metric_inc(&s_suppressed_metric);
+    return false;
+}
+
+bool dlog_write(dlog_module_t *module, esp_log_level_t level, const char *format,
+                const dlog_arg_t *args, size_t nargs)
+{
+    uint32_t now = esp_log_timestamp();
+
+    if (!rate_allow(module, now)) {
+        return false;
+    }
+
+    // Claim an entry; a full ring drops the message rather than wait
+    uint32_t head = atomic_load_explicit(&s_head, memory_order_relaxed);
+    uint32_t depth;
+    do {
+        depth = head - atomic_load_explicit(&s_tail, memory_order_acquire);
+        if (depth >= DLOG_RING_LEN) {
+            atomic_fetch_add_explicit(&s_dropped, 1, memory_order_relaxed);
+            metric_inc(&s_dropped_metric);
+            return false;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&s_head, &head, head + 1,
+                                                    memory_order_relaxed,
+                                                    memory_order_relaxed));
+
+    dlog_entry_t *entry = &s_ring[head & RING_MASK];
+    entry->timestamp_ms = now;
+    entry->module = module;
+    entry->format = format;
+    entry->level = (uint8_t)level;
+    entry->nargs = (uint8_t)(nargs < DLOG_MAX_ARGS ? nargs : DLOG_MAX_ARGS);
+
+    size_t used = 0;
+    for (uint8_t i = 0; i < entry->nargs; i++) {
+        entry->kinds[i] = args[i].kind;
+        entry->sizes[i] = args[i].size;
+        if (args[i].kind != DLOG_ARG_STR) {
+            entry->values[i] = args[i].u;
+            continue;
+        }
+
+        // Copy what fits; a string that does not fit at all prints empty
+        const char *s = args[i].s ? args[i].s : "(null)";
+        entry->values[i] = used < DLOG_STR_BYTES ? used : DLOG_STR_BYTES - 1;
+        while (*s && used < DLOG_STR_BYTES - 1) {
+            entry->strings[used++] = *s++;
+        }
+        if (used < DLOG_STR_BYTES) {
+            entry->strings[used++] = '\0';
+        }
+    }
+    entry->strings[DLOG_STR_BYTES - 1] = '\0';
+
+    atomic_store_explicit(&entry->seq, head + 1, memory_order_release);
+
+    atomic_fetch_add_explicit(&s_written, 1, memory_order_relaxed);
+    if (depth + 1 > atomic_load_explicit(&s_max_depth, memory_order_relaxed)) {
+        atomic_store_explicit(&s_max_depth, depth + 1, memory_order_relaxed);
+    }
+    return true;
+}
+
+// Reformat one conversion with a 64-bit length modifier and its value
+static int format_arg(char *buf, size_t len, const char *spec, size_t spec_len, char conv,
+                      const dlog_arg_t *arg)
+{
+    char f[24];
+
+    // Flags, width and precision are kept; length modifiers are replaced
+    size_t n = 0;
+    for (size_t i = 0; i < spec_len && n < sizeof(f) - 4; i++) {
+        char c = spec[i];
+        if (c != 'h' && c != 'l' && c != 'L' && c != 'z' && c != 'j' && c != 't' && c != 'q') {
+            f[n++] = c;
+        }
+    }
+
+    switch (conv) {
+    case 'd':
+    case 'i':
+    case 'u':
+    case 'o':
+    case 'x':
+    case 'X': {
+        if (arg->kind == DLOG_ARG_DOUBLE) {
+            f[n++] = 'f';
+            f[n] = '\0';
+            return snprintf(buf, len, f, arg->d);
+        }
+        f[n++] = 'l';
+        f[n++] = 'l';
+        f[n++] = conv;
+        f[n] = '\0';
+
+        uint64_t u = arg->u;
+        if (arg->kind == DLOG_ARG_PTR) {
+            u = (uintptr_t)arg->p;
+        } else if (arg->size && arg->size < 8) {
+            // Unsigned conversions see the argument at its own width
+            u &= (1ULL << (arg->size * 8)) - 1;
+        }
+        if ((conv == 'd' || conv == 'i') && arg->kind == DLOG_ARG_INT) {
+            return snprintf(buf, len, f, (long long)arg->i);
+        }
+        if (conv == 'd' || conv == 'i') {
+            return snprintf(buf, len, f, (long long)u);
+        }
+        return snprintf(buf, len, f, (unsigned long long)u);
+    }
+    case 'c':
+        f[n++] = 'c';
+        f[n] = '\0';
+        return snprintf(buf, len, f, (int)arg->i);
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+        f[n++] = conv;
+        f[n] = '\0';
+        return snprintf(buf, len, f, arg->kind == DLOG_ARG_DOUBLE ? arg->d : (double)arg->i);
+    case 's':
+        f[n++] = 's';
+        f[n] = '\0';
+        return snprintf(buf, len, f, arg->kind == DLOG_ARG_STR ? arg->s : "?");
+    case 'p':
+        f[n++] = 'p';
+        f[n] = '\0';
+        return snprintf(buf, len, f, arg->p);
+    default:
+        return snprintf(buf, len, "%%%c", conv);
+    }
+}
+
+int dlog_format(char *buf, size_t len, const char *format, const dlog_arg_t *args, size_t nargs)
+{
+    size_t pos = 0;
+    size_t next = 0;
+
+    if (!buf || len == 0) {
+        return 0;
+    }
+
+    for (const char *p = format; *p && pos < len - 1; p++) {
+        if (*p != '%') {
+            buf[pos++] = *p;
+            continue;
+        }
+        if (p[1] == '%') {
+            buf[pos++] = '%';
+            p++;
+            continue;
+        }
+
+        // Find the conversion character
+        const char *spec = p;
+        p++;
+        while (*p && strchr("-+ #0123456789.hlLzjtq", *p)) {
+            p++;
+        }
+        if (!*p) {
+            break;
+        }
+
+        int w;
+        if (next < nargs) {
+            w = format_arg(buf + pos, len - pos, spec, (size_t)(p - spec), *p, &args[next++]);
+        } else {
+            w = snprintf(buf + pos, len - pos, "<?>");
+        }
+        if (w > 0) {
+            pos += (size_t)w < len - pos ? (size_t)w : len - pos - 1;
+        }
+    }
+
+    buf[pos] = '\0';
+    return (int)pos;
+}
+
+static void default_sink(esp_log_level_t level, const char *tag, uint32_t timestamp_ms,
+                         const char *message)
+{
+    static const char letters[] = { 'N', 'E', 'W', 'I', 'D', 'V' };
+    char letter = level < sizeof(letters) ? letters[level] : '?';
+
+    esp_log_write(level, tag, "%c (%u) %s: %s\n", letter, (unsigned)timestamp_ms, tag, message);
+}
+
+uint32_t dlog_flush(void)
+{
+    // One formatter at a time; a second caller leaves the work to it
+    if (atomic_flag_test_and_set(&s_flushing)) {
+        return 0;
+    }
+
+    dlog_sink_t sink = s_sink ? s_sink : default_sink;
+    uint32_t printed = 0;
+    char line[DLOG_LINE_MAX];
+    dlog_arg_t args[DLOG_MAX_ARGS];
+
+    uint32_t tail = atomic_load_explicit(&s_tail, memory_order_relaxed);
+    while (1) {
+        dlog_entry_t *entry = &s_ring[tail & RING_MASK];
+
+        // Stop at an entry that is claimed but not written yet
+        if (atomic_load_explicit(&entry->seq, memory_order_acquire) != tail + 1) {
+            break;
+        }
+
+        for (uint8_t i = 0; i < entry->nargs; i++) {
+            args[i].kind = entry->kinds[i];
+            args[i].size = entry->sizes[i];
+            if (entry->kinds[i] == DLOG_ARG_STR) {
+                args[i].s = &entry->strings[entry->values[i]];
+            } else {
+                args[i].u = entry->values[i];
+            }
+        }
+        dlog_format(line, sizeof(line), entry->format, args, entry->nargs);
+
+        dlog_module_t *module = entry->module;
+        esp_log_level_t level = (esp_log_level_t)entry->level;
+        uint32_t timestamp = entry->timestamp_ms;
+
+        // The entry is copied out; let writers reuse it before printing
+        tail++;
+        atomic_store_explicit(&s_tail, tail, memory_order_release);
+
+        sink(level, module->tag, timestamp, line);
+        printed++;
+
+        uint32_t suppressed = atomic_exchange(&module->suppressed, 0);
+        if (suppressed) {
+            snprintf(line, sizeof(line), "%u messages suppressed by rate limit", (unsigned)suppressed);
+            sink(ESP_LOG_WARN, module->tag, timestamp, line);
+        }
+    }
+
+    atomic_fetch_add_explicit(&s_printed, printed, memory_order_relaxed);
+    atomic_flag_clear(&s_flushing);
+    return printed;
+}
+
+void dlog_set_level(const char *tag, esp_log_level_t level)
+{
+    if (!tag) {
+        return;
+    }
+
+    bool all = strcmp(tag, "*") == 0;
+    if (all) {
+        atomic_store(&s_default_level, level);
+        atomic_store(&s_fallback.level, level);
+    } else {
+        dlog_get_module(tag);
+    }
+
+    uint32_t count = atomic_load(&s_module_count);
+    for (uint32_t i = 0; i < count && i < DLOG_MAX_MODULES; i++) {
+        if (s_modules[i].tag && (all || strcmp(s_modules[i].tag, tag) == 0)) {
+            atomic_store(&s_modules[i].level, level);
+        }
+    }
+}
+
+void dlog_set_rate(const char *tag, uint32_t per_second)
+{
+    if (!tag) {
+        return;
+    }
+
+    bool all = strcmp(tag, "*") == 0;
+    if (all) {
+        atomic_store(&s_default_rate, per_second);
+    } else {
+        dlog_get_module(tag);
+    }
+
+    uint32_t count = atomic_load(&s_module_count);
+    for (uint32_t i = 0; i < count && i < DLOG_MAX_MODULES; i++) {
+        if (s_modules[i].tag && (all || strcmp(s_modules[i].tag, tag) == 0)) {
+            atomic_store(&s_modules[i].rate, per_second);
+            atomic_store(&s_modules[i].tokens, per_second);
+            atomic_store(&s_modules[i].refill_ms, esp_log_timestamp());
+        }
+    }
+}
+
+void dlog_set_sink(dlog_sink_t sink)
+{
+    s_sink = sink;
+}
+
+void dlog_get_stats(dlog_stats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+
+    stats->written = atomic_load(&s_written);
+    stats->printed = atomic_load(&s_printed);
+    stats->dropped = atomic_load(&s_dropped);
+    stats->suppressed = atomic_load(&s_suppressed);
+    stats->max_depth = atomic_load(&s_max_depth);
+}
@@ -0,0 +1,236 @@
+/**
+ * @file dlog.h
+ * @brief Deferred logging for hot paths
+ *
+ * DLOGI(TAG, fmt, ...) and friends look like ESP_LOGI but do not format:
+ * the call stores the format pointer, the timestamp and the raw arguments
+ * in a lock-free ring, and a low-priority task formats and prints them
+ * later with dlog_flush(). String arguments are copied, so stack buffers
+ * are safe to pass. Each module (tag) has a runtime level and an optional
+ * rate limit; a call below the level costs a load and a compare.
+ *
+ * Formats must be string literals. Supported conversions are d i u o x X
+ * c s p f e g with flags, width and precision; '*' is not supported.
+ */
+
+#ifndef DLOG_H
+#define DLOG_H
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DLOG_RING_LEN           64      // Entries, power of two
+#define DLOG_MAX_ARGS           8
+#define DLOG_STR_BYTES          64      // Copied string bytes per entry
+#define DLOG_MAX_MODULES        32
+#define DLOG_LINE_MAX           192     // Formatted message length
+#define DLOG_DEFAULT_LEVEL      ESP_LOG_INFO
+#define DLOG_DEFAULT_RATE       20      // Messages per second per module, 0 = unlimited
+#define DLOG_FLUSH_PERIOD_MS    20      // Formatter task wake-up period
+
+typedef enum {
+    DLOG_ARG_INT,
+    DLOG_ARG_UINT,
+    DLOG_ARG_DOUBLE,
+    DLOG_ARG_PTR,
+    DLOG_ARG_STR
+} dlog_arg_kind_t;
+
+typedef struct {
+    uint8_t kind;               // dlog_arg_kind_t
+    uint8_t size;               // Bytes of the integer argument
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+        const void *p;
+        const char *s;
+    };
+} dlog_arg_t;
+
+typedef struct {
+    const char *tag;
+    atomic_int level;           // esp_log_level_t
+    atomic_uint rate;           // Messages per second, 0 = unlimited
+    atomic_uint tokens;
+    atomic_uint refill_ms;
+    atomic_uint suppressed;     // Dropped by the rate limit since last reported
+} dlog_module_t;
+
+typedef struct {
+    uint32_t written;           // Entries queued
+    uint32_t printed;           // Entries formatted
+    uint32_t dropped;           // Lost because the ring was full
+    uint32_t suppressed;        // Lost to rate limits
+    uint32_t max_depth;
+} dlog_stats_t;
+
+/**
+ * @brief Output for formatted lines (default: esp_log_write)
+ * @param level Message level
+ * @param tag Module tag
+ * @param timestamp_ms Time the message was logged
+ * @param message Formatted message, no newline
+ */
+typedef void (*dlog_sink_t)(esp_log_level_t level, const char *tag, uint32_t timestamp_ms,
+                            const char *message);
+
+static inline dlog_arg_t dlog_arg_int(int64_t v, size_t size)
+{
+    dlog_arg_t a = { .kind = DLOG_ARG_INT, .size = (uint8_t)size, .i = v };
+    return a;
+}
+
+static inline dlog_arg_t dlog_arg_uint(uint64_t v, size_t size)
+{
+    dlog_arg_t a = { .kind = DLOG_ARG_UINT, .size = (uint8_t)size, .u = v };
+    return a;
+}
+
+static inline dlog_arg_t dlog_arg_double(double v, size_t size)
+{
+    dlog_arg_t a = { .kind = DLOG_ARG_DOUBLE, .size = (uint8_t)size, .d = v };
+    return a;
+}
+
+static inline dlog_arg_t dlog_arg_ptr(const void *v, size_t size)
+{
+    dlog_arg_t a = { .kind = DLOG_ARG_PTR, .size = (uint8_t)size, .p = v };
+    return a;
+}
+
+static inline dlog_arg_t dlog_arg_str(const char *v, size_t size)
+{
+    dlog_arg_t a = { .kind = DLOG_ARG_STR, .size = 0, .s = v };
+    (void)size;
+    return a;
+}
+
+// Capture one argument by its static type
+#define DLOG_ARG(x) _Generic((x), \
+    char: dlog_arg_int, \
+    signed char: dlog_arg_int, \
+    short: dlog_arg_int, \
+    int: dlog_arg_int, \
+    long: dlog_arg_int, \
+    long long: dlog_arg_int, \
+    unsigned char: dlog_arg_uint, \
+    unsigned short: dlog_arg_uint, \
+    unsigned int: dlog_arg_uint, \
+    unsigned long: dlog_arg_uint, \
+    unsigned long long: dlog_arg_uint, \
+    _Bool: dlog_arg_uint, \
+    float: dlog_arg_double, \
+    double: dlog_arg_double, \
+    char *: dlog_arg_str, \
+    const char *: dlog_arg_str, \
+    default: dlog_arg_ptr)((x), sizeof(x))
+
+#define DLOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+#define DLOG_NARGS(...) DLOG_NARGS_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+
+#define DLOG_MAP_0()
+#define DLOG_MAP_1(a) DLOG_ARG(a)
+#define DLOG_MAP_2(a, ...) DLOG_ARG(a), DLOG_MAP_1(__VA_ARGS__)
+#define DLOG_MAP_3(a, ...) DLOG_ARG(a), DLOG_MAP_2(__VA_ARGS__)
+#define DLOG_MAP_4(a, ...) DLOG_ARG(a), DLOG_MAP_3(__VA_ARGS__)
+#define DLOG_MAP_5(a, ...) DLOG_ARG(a), DLOG_MAP_4(__VA_ARGS__)
+#define DLOG_MAP_6(a, ...) DLOG_ARG(a), DLOG_MAP_5(__VA_ARGS__)
+#define DLOG_MAP_7(a, ...) DLOG_ARG(a), DLOG_MAP_6(__VA_ARGS__)
+#define DLOG_MAP_8(a, ...) DLOG_ARG(a), DLOG_MAP_7(__VA_ARGS__)
+#define DLOG_MAP_N_(n) DLOG_MAP_##n
+#define DLOG_MAP_N(n) DLOG_MAP_N_(n)
+
+#define DLOG_LEVEL(log_level, tag, format, ...) do { \
+        static dlog_module_t *dlog_module_; \
+        if (!dlog_module_) { \
+            dlog_module_ = dlog_get_module(tag); \
+        } \
+        if ((log_level) <= atomic_load_explicit(&dlog_module_->level, memory_order_relaxed)) { \
+            const dlog_arg_t dlog_args_[DLOG_NARGS(__VA_ARGS__) + 1] = { \
+                DLOG_MAP_N(DLOG_NARGS(__VA_ARGS__))(__VA_ARGS__) }; \
+            dlog_write(dlog_module_, (log_level), format, dlog_args_, DLOG_NARGS(__VA_ARGS__)); \
+        } \
+    } while (0)
+
+#define DLOGE(tag, format, ...) DLOG_LEVEL(ESP_LOG_ERROR, tag, format, ##__VA_ARGS__)
+#define DLOGW(tag, format, ...) DLOG_LEVEL(ESP_LOG_WARN, tag, format, ##__VA_ARGS__)
+#define DLOGI(tag, format, ...) DLOG_LEVEL(ESP_LOG_INFO, tag, format, ##__VA_ARGS__)
+#define DLOGD(tag, format, ...) DLOG_LEVEL(ESP_LOG_DEBUG, tag, format, ##__VA_ARGS__)
+#define DLOGV(tag, format, ...) DLOG_LEVEL(ESP_LOG_VERBOSE, tag, format, ##__VA_ARGS__)
+
+/**
+ * @brief Find or add the module of a tag (done once per call site)
+ * @param tag Module tag
+ * @return Module; a shared fallback when the table is full
+ */
+dlog_module_t* dlog_get_module(const char *tag);
+
+/**
+ * @brief Queue a message (use the DLOGx macros)
+ * @param module Module
+ * @param level Message level
+ * @param format printf format, must outlive the ring
+ * @param args Captured arguments
+ * @param nargs Number of arguments
+ * @return true if queued, false if rate limited or the ring was full
+ */
+bool dlog_write(dlog_module_t *module, esp_log_level_t level, const char *format,
+                const dlog_arg_t *args, size_t nargs);
+
+/**
+ * @brief Set the runtime level of a module
+ * @param tag Module tag, "*" for every module and the default
+ * @param level Highest level that is queued
+ */
+void dlog_set_level(const char *tag, esp_log_level_t level);
+
+/**
+ * @brief Set the rate limit of a module
+ * @param tag Module tag, "*" for every module and the default
+ * @param per_second Messages per second (also the burst), 0 = unlimited
+ */
+void dlog_set_rate(const char *tag, uint32_t per_second);
+
+/**
+ * @brief Replace the output of formatted lines
+ * @param sink Sink, NULL restores esp_log_write
+ */
+void dlog_set_sink(dlog_sink_t sink);
+
+/**
+ * @brief Format and print every queued message (formatter task)
+ * @return Number of messages printed
+ */
+uint32_t dlog_flush(void);
+
+/**
+ * @brief Format one argument list the way dlog_flush() does
+ * @param buf Output buffer
+ * @param len Buffer size
+ * @param format printf format
+ * @param args Arguments
+ * @param nargs Number of arguments
+ * @return Length written, truncated to len - 1
+ */
+int dlog_format(char *buf, size_t len, const char *format, const dlog_arg_t *args, size_t nargs);
+
+/**
+ * @brief Get queue statistics
+ * @param stats Statistics to fill
+ */
+void dlog_get_stats(dlog_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DLOG_H
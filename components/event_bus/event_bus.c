@@ -0,0 +1,430 @@
+/**
+ * @file event_bus.c
+ * @brief Subscriber table, per-subscriber lanes and delivery
+ *
+ * Lanes are multi-producer, single-consumer rings: publishers claim a slot
+ * with a compare-and-swap and mark it written with a per-slot sequence
+ * number, the subscriber reads in claim order. A full lane drops the new
+ * event for that subscriber only.
+ *
+ * The subscriber table is read by publishers without a lock. Changes are
+ * made to a second copy which is then swapped in; the copy is not reused
+ * until every publisher that entered it has left.
+ */
+
+#include "event_bus.h"
+#include "metrics.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include <string.h>
+
+#if CONFIG_IDF_TARGET_LINUX
+#include <sched.h>
+#include <time.h>
+#else
+#include "freertos/task.h"
+#include "esp_timer.h"
+#endif
+
+static const char *TAG = "EVENT_BUS";
+
+#define LANE_URGENT     0
+#define LANE_NORMAL     1
+
+_Static_assert(EVENT_TOPIC_COUNT <= 32, "topic masks are 32 bits");
+_Static_assert((EVENT_URGENT_DEPTH & (EVENT_URGENT_DEPTH - 1)) == 0,
+               "EVENT_URGENT_DEPTH must be a power of two");
+
+typedef struct {
+    atomic_uint readers;        // Publishers walking this copy
+    uint32_t count;
+    event_subscriber_t *subs[EVENT_BUS_MAX_SUBSCRIBERS];   // Highest priority first
+} sub_table_t;
+
+static sub_table_t s_tables[2];
+static _Atomic(sub_table_t *) s_current = &s_tables[0];
+static atomic_flag s_table_lock = ATOMIC_FLAG_INIT;
+
+static atomic_uint s_seq = 0;
+static atomic_uint s_published = 0;
+static atomic_uint s_queued = 0;
+static atomic_uint s_dropped = 0;
+static atomic_uint s_unheard = 0;
+
+METRIC_COUNTER_DEFINE(s_published_metric, "bus.published", "evt");
+METRIC_COUNTER_DEFINE(s_dropped_metric, "bus.dropped", "evt");
+
+static const char *const s_topic_names[EVENT_TOPIC_COUNT] = {
+    // Names skip the "EVENT_" prefix
+#define EVENT_TOPIC_NAME(id, type, member) [id] = #id + 6,
+    EVENT_TOPIC_LIST(EVENT_TOPIC_NAME)
+#undef EVENT_TOPIC_NAME
+};
+
+static inline uint32_t IRAM_ATTR now_us(void)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+#else
+    return (uint32_t)esp_timer_get_time();
+#endif
+}
+
+// Let a preempted publisher run while waiting for it
+static void relax(void)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    sched_yield();
+#else
+    vTaskDelay(1);
+#endif
+}
+
+static void table_lock(void)
+{
+    while (atomic_flag_test_and_set_explicit(&s_table_lock, memory_order_acquire)) {
+        relax();
+    }
+}
+
+static void table_unlock(void)
+{
+    atomic_flag_clear_explicit(&s_table_lock, memory_order_release);
+}
+
+static inline sub_table_t* IRAM_ATTR table_enter(void)
+{
+    while (1) {
+        sub_table_t *table = atomic_load(&s_current);
+        atomic_fetch_add(&table->readers, 1);
+        // Entered before a swap made it the spare copy: try the new one
+        if (table == atomic_load(&s_current)) {
+            return table;
+        }
+        atomic_fetch_sub(&table->readers, 1);
+    }
+}
+
+static inline void IRAM_ATTR table_leave(sub_table_t *table)
+{
+    atomic_fetch_sub_explicit(&table->readers, 1, memory_order_release);
+}
+
+// Fill the spare copy from the current one; the caller holds the lock
+static sub_table_t* table_begin_update(void)
+{
+    sub_table_t *current = atomic_load(&s_current);
+    sub_table_t *next = current == &s_tables[0] ? &s_tables[1] : &s_tables[0];
+
+    while (atomic_load(&next->readers)) {
+        relax();
+    }
+    next->count = current->count;
+    memcpy(next->subs, current->subs, sizeof(next->subs));
+    return next;
+}
+
+// Swap in the updated copy and wait for publishers still in the old one
+static void table_commit(sub_table_t *next)
+{
+    sub_table_t *old = atomic_exchange(&s_current, next);
+    while (atomic_load(&old->readers)) {
+        relax();
+    }
+}
+
+static void lane_init(event_lane_t *lane, event_slot_t *slots, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++) {
+        atomic_store_explicit(&slots[i].seq, 0, memory_order_relaxed);
+    }
+    lane->slots = slots;
+    lane->mask = len - 1;
+    atomic_store(&lane->head, 0);
+    atomic_store(&lane->tail, 0);
+}
+
+static bool IRAM_ATTR lane_push(event_lane_t *lane, const event_t *event, uint32_t *depth)
+{
+    uint32_t head = atomic_load_explicit(&lane->head, memory_order_relaxed);
+    uint32_t used;
+
+    do {
+        used = head - atomic_load_explicit(&lane->tail, memory_order_acquire);
+        if (used > lane->mask) {
+            return false;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&lane->head, &head, head + 1,
+                                                    memory_order_relaxed,
+                                                    memory_order_relaxed));
+
+    event_slot_t *slot = &lane->slots[head & lane->mask];
+    slot->event = *event;
+    atomic_store_explicit(&slot->seq, head + 1, memory_order_release);
+    *depth = used + 1;
+    return true;
+}
+
+static bool lane_pop(event_lane_t *lane, event_t *event)
+{
+    uint32_t tail = atomic_load_explicit(&lane->tail, memory_order_relaxed);
+    event_slot_t *slot = &lane->slots[tail & lane->mask];
+
+    // Not written yet: wait for it to keep claim order
+    if (atomic_load_explicit(&slot->seq, memory_order_acquire) != tail + 1) {
+        return false;
+    }
+
+    *event = slot->event;
+    atomic_store_explicit(&lane->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+esp_err_t event_bus_subscribe(event_subscriber_t *sub)
+{
+    if (!sub || !sub->storage || sub->depth == 0 || (sub->depth & (sub->depth - 1))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    table_lock();
+
+    if (sub->subscribed) {
+        table_unlock();
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    sub_table_t *next = table_begin_update();
+    if (next->count >= EVENT_BUS_MAX_SUBSCRIBERS) {
+        table_unlock();
+        ESP_LOGE(TAG, "Subscriber table full, %s not added", sub->name ? sub->name : "?");
+        return ESP_ERR_NO_MEM;
+    }
+
+    lane_init(&sub->lanes[LANE_URGENT], sub->storage, EVENT_URGENT_DEPTH);
+    lane_init(&sub->lanes[LANE_NORMAL], sub->storage + EVENT_URGENT_DEPTH, sub->depth);
+    atomic_store(&sub->received, 0);
+    atomic_store(&sub->dropped, 0);
+    atomic_store(&sub->max_depth, 0);
+#if !CONFIG_IDF_TARGET_LINUX
+    if (!sub->wake) {
+        sub->wake = xSemaphoreCreateBinaryStatic(&sub->wake_buffer);
+    }
+#endif
+
+    // Keep priority order; equal priorities in subscription order
+    uint32_t pos = next->count;
+    while (pos > 0 && next->subs[pos - 1]->priority < sub->priority) {
+        next->subs[pos] = next->subs[pos - 1];
+        pos--;
+    }
+    next->subs[pos] = sub;
+    next->count++;
+    sub->subscribed = true;
+
+    table_commit(next);
+    table_unlock();
+
+    ESP_LOGI(TAG, "%s subscribed (topics 0x%02x, priority %u, depth %u)",
+             sub->name ? sub->name : "?", (unsigned)sub->topics, (unsigned)sub->priority,
+             (unsigned)sub->depth);
+    return ESP_OK;
+}
+
+esp_err_t event_bus_unsubscribe(event_subscriber_t *sub)
+{
+    if (!sub) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    table_lock();
+
+    if (!sub->subscribed) {
+        table_unlock();
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    sub_table_t *next = table_begin_update();
+    uint32_t out = 0;
+    for (uint32_t i = 0; i < next->count; i++) {
+        if (next->subs[i] != sub) {
+            next->subs[out++] = next->subs[i];
+        }
+    }
+    next->count = out;
+    sub->subscribed = false;
+
+    // No publisher can reach the queues once the old copy has drained
+    table_commit(next);
+    table_unlock();
+    return ESP_OK;
+}
+
+uint32_t IRAM_ATTR event_bus_publish(const event_t *event)
+{
+    if (!event || event->topic >= EVENT_TOPIC_COUNT) {
+        return 0;
+    }
+
+    event_t stamped;
+    bool stamped_ready = false;
+
+    const uint32_t bit = EVENT_TOPIC_BIT(event->topic);
+    const int lane = event->priority == EVENT_PRIO_URGENT ? LANE_URGENT : LANE_NORMAL;
+    uint32_t queued = 0;
+    uint32_t dropped = 0;
+#if !CONFIG_IDF_TARGET_LINUX
+    const bool in_isr = xPortInIsrContext();
+    BaseType_t woken = pdFALSE;
+#endif
+
+    sub_table_t *table = table_enter();
+    for (uint32_t i = 0; i < table->count; i++) {
+        event_subscriber_t *sub = table->subs[i];
+        if (!(sub->topics & bit)) {
+            continue;
+        }
+
+        // Events nobody wants are not copied or timestamped
+        if (!stamped_ready) {
+            stamped = *event;
+            stamped.seq = atomic_fetch_add_explicit(&s_seq, 1, memory_order_relaxed);
+            stamped.timestamp_us = now_us();
+            stamped_ready = true;
+        }
+
+        uint32_t depth;
+        if (!lane_push(&sub->lanes[lane], &stamped, &depth)) {
+            atomic_fetch_add_explicit(&sub->dropped, 1, memory_order_relaxed);
+            dropped++;
+            continue;
+        }
+        queued++;
+        if (depth > atomic_load_explicit(&sub->max_depth, memory_order_relaxed)) {
+            atomic_store_explicit(&sub->max_depth, depth, memory_order_relaxed);
+        }
+
+#if !CONFIG_IDF_TARGET_LINUX
+        if (in_isr) {
+            xSemaphoreGiveFromISR(sub->wake, &woken);
+        } else {
+            xSemaphoreGive(sub->wake);
+        }
+#endif
+    }
+    table_leave(table);
+
+    atomic_fetch_add_explicit(&s_published, 1, memory_order_relaxed);
+    metric_inc(&s_published_metric);
+    if (queued) {
+        atomic_fetch_add_explicit(&s_queued, queued, memory_order_relaxed);
+    } else if (!dropped) {
+        atomic_fetch_add_explicit(&s_unheard, 1, memory_order_relaxed);
+    }
+    if (dropped) {
+        atomic_fetch_add_explicit(&s_dropped, dropped, memory_order_relaxed);
+        metric_add(&s_dropped_metric, dropped);
+    }
+
+#if !CONFIG_IDF_TARGET_LINUX
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+#endif
+    return queued;
+}
+
+static bool take(event_subscriber_t *sub, event_t *event)
+{
+    if (lane_pop(&sub->lanes[LANE_URGENT], event) || lane_pop(&sub->lanes[LANE_NORMAL], event)) {
+        atomic_fetch_add_explicit(&sub->received, 1, memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+bool event_bus_receive(event_subscriber_t *sub, event_t *event, uint32_t timeout_ms)
+{
+    if (!sub || !event || !sub->subscribed) {
+        return false;
+    }
+
+#if CONFIG_IDF_TARGET_LINUX
+    const struct timespec tick = { .tv_sec = 0, .tv_nsec = 1000000 };
+    for (uint32_t waited = 0; ; waited++) {
+        if (take(sub, event)) {
+            return true;
+        }
+        if (waited >= timeout_ms) {
+            return false;
+        }
+        nanosleep(&tick, NULL);
+    }
+#else
+    const TickType_t start = xTaskGetTickCount();
+    TickType_t ticks = pdMS_TO_TICKS(timeout_ms);
+    if (timeout_ms && !ticks) {
+        ticks = 1;
+    }
+
+    while (1) {
+        if (take(sub, event)) {
+            return true;
+        }
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= ticks) {
+            return false;
+        }
+        // A give left over from an event already taken only costs a loop
+        xSemaphoreTake(sub->wake, ticks - elapsed);
+    }
+#endif
+}
+
+uint32_t event_bus_dispatch(event_subscriber_t *sub, event_handler_t handler, void *user_data)
+{
+    uint32_t count = 0;
+    event_t event;
+
+    if (!sub || !handler || !sub->subscribed) {
+        return 0;
+    }
+
+    while (take(sub, &event)) {
+        handler(&event, user_data);
+        count++;
+    }
+    return count;
+}
+
+uint32_t event_bus_pending(const event_subscriber_t *sub)
+{
+    uint32_t pending = 0;
+
+    if (!sub || !sub->subscribed) {
+        return 0;
+    }
+    for (int i = 0; i < 2; i++) {
+        pending += atomic_load(&sub->lanes[i].head) - atomic_load(&sub->lanes[i].tail);
+    }
+    return pending;
+}
+
+void event_bus_get_stats(event_bus_stats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+
+    stats->published = atomic_load(&s_published);
+    stats->queued = atomic_load(&s_queued);
+    stats->dropped = atomic_load(&s_dropped);
+    stats->unheard = atomic_load(&s_unheard);
+    stats->subscribers = atomic_load(&s_current)->count;
+}
+
+const char* event_topic_name(event_topic_t topic)
+{
+    return (unsigned)topic < EVENT_TOPIC_COUNT ? s_topic_names[topic] : "?";
+}
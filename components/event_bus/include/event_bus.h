@@ -0,0 +1,237 @@
+/**
+ * @file event_bus.h
+ * @brief Typed publish/subscribe bus with per-subscriber queues
+ *
+ * Publishers post fixed-size events by topic; every subscriber whose topic
+ * mask includes the topic gets its own copy in its own bounded queue, so a
+ * slow consumer only loses its own events. Nothing is allocated: events
+ * are copied into queue slots that the subscriber brings along
+ * (EVENT_SUBSCRIBER_DEFINE). Publishing is lock-free and safe from ISRs.
+ *
+ * Each subscriber has an urgent lane next to its normal queue; urgent
+ * events are received first. Subscribers with a higher priority are
+ * queued to and woken first.
+ */
+
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if !CONFIG_IDF_TARGET_LINUX
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EVENT_BUS_MAX_SUBSCRIBERS   16
+#define EVENT_URGENT_DEPTH          4       // Urgent lane slots per subscriber
+#define EVENT_RF_DATA_MAX           64
+
+// Topic, payload type, payload member of event_t
+#define EVENT_TOPIC_LIST(X) \
+    X(EVENT_SYSTEM_STATE, event_system_state_t, system_state) \
+    X(EVENT_WIFI_STATUS, event_wifi_status_t, wifi_status) \
+    X(EVENT_RF_RX, event_rf_rx_t, rf_rx) \
+    X(EVENT_RF_TX, event_rf_tx_t, rf_tx) \
+    X(EVENT_INPUT, event_input_t, input)
+
+typedef enum {
+#define EVENT_TOPIC_ENUM(id, type, member) id,
+    EVENT_TOPIC_LIST(EVENT_TOPIC_ENUM)
+#undef EVENT_TOPIC_ENUM
+    EVENT_TOPIC_COUNT
+} event_topic_t;
+
+#define EVENT_TOPIC_BIT(topic)      (1UL << (topic))
+#define EVENT_TOPIC_ALL             ((1UL << EVENT_TOPIC_COUNT) - 1)
+
+typedef enum {
+    EVENT_PRIO_NORMAL,
+    EVENT_PRIO_URGENT
+} event_priority_t;
+
+typedef struct {
+    uint32_t state;             // system_state_t
+} event_system_state_t;
+
+typedef struct {
+    uint32_t status;            // wifi_status_t
+} event_wifi_status_t;
+
+typedef struct {
+    uint32_t frequency;
+    int16_t rssi;
+    uint8_t lqi;
+    uint8_t length;
+    uint32_t timestamp;         // Milliseconds
+    uint8_t data[EVENT_RF_DATA_MAX];
+} event_rf_rx_t;
+
+typedef struct {
+    uint32_t frequency;
+    uint8_t length;
+} event_rf_tx_t;
+
+typedef struct {
+    uint8_t type;               // input_type_t
+    uint8_t event;              // input_event_t
+    uint8_t key_id;
+    int16_t delta;
+    uint16_t count;
+    uint32_t timestamp;         // Milliseconds
+    uint16_t id;                // input_data_t id, tags latency traces
+} event_input_t;
+
+typedef struct {
+    uint16_t topic;             // event_topic_t
+    uint8_t priority;           // event_priority_t
+    uint32_t seq;               // Bus-wide number, counts events that had a subscriber
+    uint32_t timestamp_us;      // Low 32 bits of the microsecond clock
+    union {
+#define EVENT_TOPIC_MEMBER(id, type, member) type member;
+        EVENT_TOPIC_LIST(EVENT_TOPIC_MEMBER)
+#undef EVENT_TOPIC_MEMBER
+    };
+} event_t;
+
+typedef struct {
+    atomic_uint seq;            // Claim position + 1 once the event is written
+    event_t event;
+} event_slot_t;
+
+typedef struct {
+    atomic_uint head;           // Next slot to claim (publishers)
+    atomic_uint tail;           // Next slot to read (the subscriber)
+    uint32_t mask;
+    event_slot_t *slots;
+} event_lane_t;
+
+typedef struct {
+    const char *name;
+    uint32_t topics;            // EVENT_TOPIC_BIT mask
+    uint8_t priority;           // Higher is queued and woken first
+    uint16_t depth;             // Normal queue slots, power of two
+    event_slot_t *storage;      // depth + EVENT_URGENT_DEPTH slots
+
+    // Owned by the bus
+    event_lane_t lanes[2];      // Urgent, normal
+    atomic_uint received;
+    atomic_uint dropped;
+    atomic_uint max_depth;
+    bool subscribed;
+#if !CONFIG_IDF_TARGET_LINUX
+    SemaphoreHandle_t wake;
+    StaticSemaphore_t wake_buffer;
+#endif
+} event_subscriber_t;
+
+typedef struct {
+    uint32_t published;
+    uint32_t queued;            // Copies put in subscriber queues
+    uint32_t dropped;           // Copies lost to full queues
+    uint32_t unheard;           // Events no subscriber wanted
+    uint32_t subscribers;
+} event_bus_stats_t;
+
+/**
+ * @brief Handler for event_bus_dispatch()
+ * @param event Event
+ * @param user_data User data
+ */
+typedef void (*event_handler_t)(const event_t *event, void *user_data);
+
+// Subscriber with static queue storage, for event_bus_subscribe(&sym)
+#define EVENT_SUBSCRIBER_DEFINE(sym, sub_name, topic_mask, sub_priority, queue_depth) \
+    static event_slot_t sym##_storage_[(queue_depth) + EVENT_URGENT_DEPTH]; \
+    static event_subscriber_t sym = { \
+        .name = (sub_name), \
+        .topics = (topic_mask), \
+        .priority = (sub_priority), \
+        .depth = (queue_depth), \
+        .storage = sym##_storage_, \
+    }
+
+/**
+ * @brief Add a subscriber; its queues start empty
+ * @param sub Subscriber with name, topics, priority, depth and storage set
+ * @return ESP_OK, ESP_ERR_INVALID_ARG for a bad depth, ESP_ERR_NO_MEM if the table is full
+ */
+esp_err_t event_bus_subscribe(event_subscriber_t *sub);
+
+/**
+ * @brief Remove a subscriber; queued events are discarded
+ * @param sub Subscriber
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if not subscribed
+ */
+esp_err_t event_bus_unsubscribe(event_subscriber_t *sub);
+
+/**
+ * @brief Queue a copy of an event for every interested subscriber (ISR safe)
+ * @param event Event with topic, priority and payload set
+ * @return Number of subscribers it was queued for
+ */
+uint32_t event_bus_publish(const event_t *event);
+
+// Typed publishers: event_publish_rf_rx(&payload, EVENT_PRIO_NORMAL) etc.
+#define EVENT_TOPIC_PUBLISH(id, type, member) \
+    static inline uint32_t event_publish_##member(const type *data, event_priority_t priority) \
+    { \
+        event_t event = { .topic = id, .priority = (uint8_t)priority }; \
+        event.member = *data; \
+        return event_bus_publish(&event); \
+    }
+EVENT_TOPIC_LIST(EVENT_TOPIC_PUBLISH)
+#undef EVENT_TOPIC_PUBLISH
+
+/**
+ * @brief Take the next event, urgent lane first
+ * @param sub Subscriber
+ * @param event Receives the event
+ * @param timeout_ms Time to wait for one, 0 to return at once
+ * @return true if an event was taken
+ */
+bool event_bus_receive(event_subscriber_t *sub, event_t *event, uint32_t timeout_ms);
+
+/**
+ * @brief Pass every queued event to a handler, urgent lane first
+ * @param sub Subscriber
+ * @param handler Handler
+ * @param user_data User data
+ * @return Number of events handled
+ */
+uint32_t event_bus_dispatch(event_subscriber_t *sub, event_handler_t handler, void *user_data);
+
+/**
+ * @brief Count queued events of a subscriber
+ * @param sub Subscriber
+ * @return Events in both lanes
+ */
+uint32_t event_bus_pending(const event_subscriber_t *sub);
+
+/**
+ * @brief Get bus statistics
+ * @param stats Statistics to fill
+ */
+void event_bus_get_stats(event_bus_stats_t *stats);
+
+/**
+ * @brief Get the name of a topic
+ * @param topic Topic
+ * @return Name without the "EVENT_" prefix, "?" if unknown
+ */
+const char* event_topic_name(event_topic_t topic);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EVENT_BUS_H
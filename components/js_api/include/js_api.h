@@ -8,11 +8,23 @@
 
 #include "esp_err.h"
 #include "mjs_engine.h"
+#include "mjs.h"
+#include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define RF_SWEEP_MAX_POINTS     256     // Bins held by the rf.sweepSpectrum() buffer
+
+// A native and the permissions that unlock it: any one of them; 0 = always bound
+typedef struct {
+    const char *name;
+    mjs_func_ptr_t func;
+    uint32_t permissions;       // JS_PERM_*
+} js_api_binding_t;
+
 /**
  * @brief Initialize all JavaScript API modules
  * @return ESP_OK on success
@@ -32,6 +44,38 @@ esp_err_t js_api_deinit(void);
  */
 esp_err_t js_api_register_all(js_context_t *ctx);
 
+/**
+ * @brief Bind natives into a context, resolving permissions now
+ *
+ * A native the context's permissions allow is bound as is and runs with
+ * no per-call check. Any other native is bound to a stub that throws
+ * "Permission denied", so apps see the name but cannot use it. Grants
+ * that change later take effect in the next context.
+ * @param ctx JavaScript context, with permissions set
+ * @param bindings Natives to bind
+ * @param count Number of natives
+ * @return ESP_OK on success
+ */
+esp_err_t js_api_bind(js_context_t *ctx, const js_api_binding_t *bindings, size_t count);
+
+/**
+ * @brief Get the buffer rf.sweepSpectrum() measures into
+ * @return RF_SWEEP_MAX_POINTS RSSI values in dBm
+ */
+const int8_t *js_rf_get_sweep_buffer(void);
+
+/**
+ * @brief Deliver queued encoder steps to a context's handler (JS task)
+ *
+ * Every encoder event published on the bus (EVENT_INPUT) since the last
+ * call is summed into one call of the handler registered with
+ * input.onEncoder(). Call once per scheduler period for the foreground
+ * app; steps are discarded if no handler is registered.
+ * @param ctx Foreground context, NULL to discard the steps
+ * @return Detents delivered
+ */
+uint32_t js_input_api_deliver(js_context_t *ctx);
+
 // Module initialization functions
 esp_err_t js_rf_api_init(void);
 esp_err_t js_gpio_api_init(void);
@@ -39,6 +83,8 @@ esp_err_t js_ui_api_init(void);
 esp_err_t js_storage_api_init(void);
 esp_err_t js_notification_api_init(void);
 esp_err_t js_wifi_api_init(void);
+esp_err_t js_metrics_api_init(void);
+esp_err_t js_input_api_init(void);
 
 // Module registration functions
 esp_err_t js_rf_api_register(js_context_t *ctx);
@@ -47,6 +93,8 @@ esp_err_t js_ui_api_register(js_context_t *ctx);
 esp_err_t js_storage_api_register(js_context_t *ctx);
 esp_err_t js_notification_api_register(js_context_t *ctx);
 esp_err_t js_wifi_api_register(js_context_t *ctx);
+esp_err_t js_metrics_api_register(js_context_t *ctx);
+esp_err_t js_input_api_register(js_context_t *ctx);
 
 // Utility functions for type conversion
 mjs_val_t js_make_error(struct mjs *mjs, const char *message);
@@ -0,0 +1,51 @@
+/**
+ * @file js_api_bind.c
+ * @brief Permission-resolved binding of natives into JavaScript contexts
+ */
+
+#include "js_api.h"
+#include "mjs.h"
+#include "esp_log.h"
+
+static const char *TAG = "JS_API_BIND";
+
+// One throwing stub per permission, so the message names what is missing
+#define DENIED_STUB(id, name) \
+    static mjs_val_t denied_##id(struct mjs *mjs) \
+    { \
+        return mjs_throw(mjs, "Permission denied: requires " name); \
+    }
+JS_PERMISSION_LIST(DENIED_STUB)
+#undef DENIED_STUB
+
+static const mjs_func_ptr_t s_denied[JS_PERM_BIT_COUNT] = {
+#define DENIED_ENTRY(id, name) denied_##id,
+    JS_PERMISSION_LIST(DENIED_ENTRY)
+#undef DENIED_ENTRY
+};
+
+esp_err_t js_api_bind(js_context_t *ctx, const js_api_binding_t *bindings, size_t count)
+{
+    if (!ctx || !ctx->mjs || (!bindings && count)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    unsigned denied = 0;
+    for (size_t i = 0; i < count; i++) {
+        const js_api_binding_t *binding = &bindings[i];
+        uint32_t needed = binding->permissions;
+        
+        if (needed == 0 || (needed & ctx->permissions) != 0) {
+            mjs_set_ffi_func(ctx->mjs, binding->name, binding->func);
+        } else {
+            mjs_set_ffi_func(ctx->mjs, binding->name, s_denied[__builtin_ctz(needed)]);
+            denied++;
+        }
+    }
+    
+    if (denied) {
+        ESP_LOGD(TAG, "%u of %u natives denied (permissions 0x%08x)",
+                 denied, (unsigned)count, (unsigned)ctx->permissions);
+    }
+    return ESP_OK;
+}
@@ -95,17 +95,22 @@ esp_err_t js_gpio_api_init(void)
     return ESP_OK;
 }
 
+static const js_api_binding_t s_gpio_bindings[] = {
+    {"gpio.setup", js_gpio_setup, JS_PERM_GPIO_READ | JS_PERM_GPIO_WRITE},
+    {"gpio.write", js_gpio_write, JS_PERM_GPIO_WRITE},
+    {"gpio.read", js_gpio_read,   JS_PERM_GPIO_READ},
+};
+
 esp_err_t js_gpio_api_register(js_context_t *ctx)
 {
     if (!ctx || !ctx->mjs) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    struct mjs *mjs = ctx->mjs;
-    
-    mjs_set_ffi_func(mjs, "gpio.setup", js_gpio_setup);
-    mjs_set_ffi_func(mjs, "gpio.write", js_gpio_write);
-    mjs_set_ffi_func(mjs, "gpio.read", js_gpio_read);
+    esp_err_t ret = js_api_bind(ctx, s_gpio_bindings, sizeof(s_gpio_bindings) / sizeof(s_gpio_bindings[0]));
+    if (ret != ESP_OK) {
+        return ret;
+    }
     
     ESP_LOGI(TAG, "GPIO API functions registered");
     return ESP_OK;
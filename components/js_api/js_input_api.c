@@ -0,0 +1,121 @@
+/**
+ * @file js_input_api.c
+ * @brief JavaScript Input API Implementation
+ *
+ * The input task already folds a spin into one event per frame carrying
+ * the accelerated delta (input_events_dispatch) and publishes it on the
+ * event bus. Each scheduler period the JS task drains those events and
+ * hands their summed delta to the foreground app in one call.
+ */
+
+#include "js_api.h"
+#include "event_bus.h"
+#include "lvgl_port.h"
+#include "mjs.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "JS_INPUT_API";
+
+// Input is published on the urgent lane, so its EVENT_URGENT_DEPTH slots
+// hold about four frames; a JS task that stalls longer loses the oldest
+// steps (counted in the bus dropped statistics). The normal queue stays
+// empty.
+EVENT_SUBSCRIBER_DEFINE(s_bus, "js_input", EVENT_TOPIC_BIT(EVENT_INPUT), 0, 1);
+
+typedef struct {
+    int32_t delta;
+    uint32_t count;
+    uint16_t ids[EVENT_URGENT_DEPTH];   // Events to stamp around the handler call
+    uint8_t traced;
+} encoder_steps_t;
+
+static void add_input_event(const event_t *event, void *user_data)
+{
+    encoder_steps_t *steps = user_data;
+    if (event->topic == EVENT_INPUT && event->input.type == INPUT_TYPE_ENCODER) {
+        steps->delta += event->input.delta;
+        steps->count += event->input.count;
+        if (steps->traced < EVENT_URGENT_DEPTH) {
+            steps->ids[steps->traced++] = event->input.id;
+        }
+    }
+}
+
+/**
+ * input.onEncoder(name), System.onEncoder(name)
+ * Call the global function name once per batch of encoder steps, with
+ * input.delta (summed accelerated steps), input.count (detents turned)
+ * and input.direction ("CW"/"CCW") set
+ */
+static mjs_val_t js_input_on_encoder(struct mjs *mjs)
+{
+    char handler[32];
+
+    if (js_get_string_arg(mjs, 0, handler, sizeof(handler)) != ESP_OK) {
+        return js_make_error(mjs, "Invalid handler parameter");
+    }
+
+    js_context_t *ctx = mjs_engine_find_context(mjs);
+    if (!ctx) {
+        return js_make_error(mjs, "No context");
+    }
+
+    snprintf(ctx->encoder_handler, sizeof(ctx->encoder_handler), "%s", handler);
+    return MJS_UNDEFINED;
+}
+
+uint32_t js_input_api_deliver(js_context_t *ctx)
+{
+    encoder_steps_t steps = {0};
+    event_bus_dispatch(&s_bus, add_input_event, &steps);
+
+    if (!ctx || !ctx->mjs || !ctx->encoder_handler[0] || steps.delta == 0) {
+        return 0;
+    }
+
+    // The interpreter calls handlers without arguments, so they are
+    // published as globals just before it
+    const char *direction = steps.delta > 0 ? "CW" : "CCW";
+    mjs_set_global(ctx->mjs, "input.direction", mjs_mk_string(ctx->mjs, direction, -1));
+    mjs_set_global(ctx->mjs, "input.delta", mjs_mk_number(ctx->mjs, steps.delta));
+    mjs_set_global(ctx->mjs, "input.count", mjs_mk_number(ctx->mjs, steps.count));
+
+    // Every event in the batch is handled by this one call
+    for (uint8_t i = 0; i < steps.traced; i++) {
+        lvgl_latency_mark(steps.ids[i], LVGL_LATENCY_HANDLER_ENTER);
+    }
+    mjs_call_ffi(ctx->mjs, ctx->encoder_handler);
+    for (uint8_t i = 0; i < steps.traced; i++) {
+        lvgl_latency_mark(steps.ids[i], LVGL_LATENCY_HANDLER_EXIT);
+    }
+
+    return steps.count;
+}
+
+esp_err_t js_input_api_init(void)
+{
+    ESP_LOGI(TAG, "Initializing Input API");
+    return event_bus_subscribe(&s_bus);
+}
+
+static const js_api_binding_t s_input_bindings[] = {
+    {"input.onEncoder", js_input_on_encoder,  0},
+    {"System.onEncoder", js_input_on_encoder, 0},
+};
+
+esp_err_t js_input_api_register(js_context_t *ctx)
+{
+    if (!ctx || !ctx->mjs) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = js_api_bind(ctx, s_input_bindings, sizeof(s_input_bindings) / sizeof(s_input_bindings[0]));
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "Input API functions registered");
+    return ESP_OK;
+}
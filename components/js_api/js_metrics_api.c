@@ -0,0 +1,86 @@
+/**
+ * @file js_metrics_api.c
+ * @brief JavaScript Metrics API Implementation
+ */
+
+#include "js_api.h"
+#include "metrics.h"
+#include "mjs.h"
+#include "esp_log.h"
+
+static const char *TAG = "JS_METRICS_API";
+
+// Scripts run on the JS task only, so one buffer serves every context
+static char s_json[METRICS_JSON_MAX];
+
+/**
+ * metrics.get(name)
+ * Counter total, gauge value or histogram p50 of one metric
+ */
+static mjs_val_t js_metrics_get(struct mjs *mjs)
+{
+    char name[48];
+    
+    if (js_get_string_arg(mjs, 0, name, sizeof(name)) != ESP_OK) {
+        return js_make_error(mjs, "Invalid name parameter");
+    }
+    
+    metric_t *metric = metrics_find(name);
+    if (!metric) {
+        return MJS_UNDEFINED;
+    }
+    
+    metric_value_t value;
+    metrics_read(metric, &value);
+    
+    switch (value.type) {
+    case METRIC_COUNTER:
+        return mjs_mk_number(mjs, (double)value.count);
+    case METRIC_GAUGE:
+        return mjs_mk_number(mjs, value.value);
+    case METRIC_HISTOGRAM:
+        return mjs_mk_number(mjs, value.hist.p50);
+    }
+    return MJS_UNDEFINED;
+}
+
+/**
+ * metrics.snapshot()
+ * Every metric as a JSON string
+ */
+static mjs_val_t js_metrics_snapshot(struct mjs *mjs)
+{
+    int len = metrics_format_json(s_json, sizeof(s_json));
+    if (len >= (int)sizeof(s_json)) {
+        ESP_LOGW(TAG, "Snapshot truncated: %d bytes", len);
+        return js_make_error(mjs, "Snapshot too large");
+    }
+    
+    return mjs_mk_string(mjs, s_json, len);
+}
+
+esp_err_t js_metrics_api_init(void)
+{
+    ESP_LOGI(TAG, "Initializing Metrics API");
+    return ESP_OK;
+}
+
+static const js_api_binding_t s_metrics_bindings[] = {
+    {"metrics.get", js_metrics_get,           0},
+    {"metrics.snapshot", js_metrics_snapshot, 0},
+};
+
+esp_err_t js_metrics_api_register(js_context_t *ctx)
+{
+    if (!ctx || !ctx->mjs) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    esp_err_t ret = js_api_bind(ctx, s_metrics_bindings, sizeof(s_metrics_bindings) / sizeof(s_metrics_bindings[0]));
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    ESP_LOGI(TAG, "Metrics API functions registered");
+    return ESP_OK;
+}
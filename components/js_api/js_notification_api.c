@@ -146,19 +146,24 @@ esp_err_t js_notification_api_init(void)
     return ESP_OK;
 }
 
+static const js_api_binding_t s_notification_bindings[] = {
+    {"notify.show", js_notify_show,       0},
+    {"notify.led", js_notify_led,         0},
+    {"notify.beep", js_notify_beep,       0},
+    {"notify.vibrate", js_notify_vibrate, 0},
+    {"notify.flash", js_notify_flash,     0},
+};
+
 esp_err_t js_notification_api_register(js_context_t *ctx)
 {
     if (!ctx || !ctx->mjs) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    struct mjs *mjs = ctx->mjs;
-    
-    mjs_set_ffi_func(mjs, "notify.show", js_notify_show);
-    mjs_set_ffi_func(mjs, "notify.led", js_notify_led);
-    mjs_set_ffi_func(mjs, "notify.beep", js_notify_beep);
-    mjs_set_ffi_func(mjs, "notify.vibrate", js_notify_vibrate);
-    mjs_set_ffi_func(mjs, "notify.flash", js_notify_flash);
+    esp_err_t ret = js_api_bind(ctx, s_notification_bindings, sizeof(s_notification_bindings) / sizeof(s_notification_bindings[0]));
+    if (ret != ESP_OK) {
+        return ret;
+    }
     
     ESP_LOGI(TAG, "Notification API functions registered");
     return ESP_OK;
@@ -6,11 +6,15 @@
 #include "js_api.h"
 #include "cc1101.h"
 #include "mjs.h"
+#include "dlog.h"
 #include "esp_log.h"
 #include <string.h>
 
 static const char *TAG = "JS_RF_API";
 
+// Sweep results shared with UI spectrum widgets by reference
+static int8_t s_sweep_rssi[RF_SWEEP_MAX_POINTS];
+
 // JavaScript RF API functions
 
 /**
@@ -29,7 +33,7 @@ static mjs_val_t js_rf_set_frequency(struct mjs *mjs)
         return js_make_error(mjs, "Failed to set frequency");
     }
     
-    ESP_LOGI(TAG, "Set frequency to %.0f Hz", frequency);
+    DLOGI(TAG, "Set frequency to %.0f Hz", frequency);
     return MJS_UNDEFINED;
 }
 
@@ -72,7 +76,7 @@ static mjs_val_t js_rf_set_modulation(struct mjs *mjs)
         return js_make_error(mjs, "Failed to set modulation");
     }
     
-    ESP_LOGI(TAG, "Set modulation to %s", modulation_str);
+    DLOGI(TAG, "Set modulation to %s", modulation_str);
     return MJS_UNDEFINED;
 }
 
@@ -87,7 +91,7 @@ static mjs_val_t js_rf_start_receive(struct mjs *mjs)
         return js_make_error(mjs, "Failed to start receive");
     }
     
-    ESP_LOGI(TAG, "Started RF receive mode");
+    DLOGI(TAG, "Started RF receive mode");
     return MJS_UNDEFINED;
 }
 
@@ -102,7 +106,7 @@ static mjs_val_t js_rf_stop_receive(struct mjs *mjs)
         return js_make_error(mjs, "Failed to stop receive");
     }
     
-    ESP_LOGI(TAG, "Stopped RF receive mode");
+    DLOGI(TAG, "Stopped RF receive mode");
     return MJS_UNDEFINED;
 }
 
@@ -120,7 +124,7 @@ static mjs_val_t js_rf_transmit(struct mjs *mjs)
         return js_make_error(mjs, "Failed to transmit data");
     }
     
-    ESP_LOGI(TAG, "Transmitted %d bytes", sizeof(test_data));
+    DLOGI(TAG, "Transmitted %d bytes", sizeof(test_data));
     return MJS_UNDEFINED;
 }
 
@@ -143,7 +147,7 @@ static mjs_val_t js_rf_read_signal(struct mjs *mjs)
     
     // Create JavaScript object with signal data (simplified)
     // In real implementation, this would create a proper object with properties
-    ESP_LOGI(TAG, "Read signal: freq=%u, rssi=%d, length=%d", 
+    DLOGI(TAG, "Read signal: freq=%u, rssi=%d, length=%d", 
              signal.frequency, signal.rssi, signal.length);
     
     return mjs_mk_number(mjs, signal.rssi);
@@ -200,7 +204,7 @@ static mjs_val_t js_rf_load_preset(struct mjs *mjs)
         return js_make_error(mjs, "Failed to load preset");
     }
     
-    ESP_LOGI(TAG, "Loaded preset: %s", preset_name);
+    DLOGI(TAG, "Loaded preset: %s", preset_name);
     return MJS_UNDEFINED;
 }
 
@@ -220,7 +224,7 @@ static mjs_val_t js_rf_start_jammer(struct mjs *mjs)
         return js_make_error(mjs, "Failed to start jammer");
     }
     
-    ESP_LOGI(TAG, "Started jammer at %.0f Hz", frequency);
+    DLOGI(TAG, "Started jammer at %.0f Hz", frequency);
     return MJS_UNDEFINED;
 }
 
@@ -235,7 +239,7 @@ static mjs_val_t js_rf_stop_jammer(struct mjs *mjs)
         return js_make_error(mjs, "Failed to stop jammer");
     }
     
-    ESP_LOGI(TAG, "Stopped jammer");
+    DLOGI(TAG, "Stopped jammer");
     return MJS_UNDEFINED;
 }
 
@@ -258,7 +262,7 @@ static mjs_val_t js_rf_start_spectrum_analyzer(struct mjs *mjs)
         return js_make_error(mjs, "Failed to start spectrum analyzer");
     }
     
-    ESP_LOGI(TAG, "Started spectrum analyzer: %.0f-%.0f Hz, step %.0f Hz", 
+    DLOGI(TAG, "Started spectrum analyzer: %.0f-%.0f Hz, step %.0f Hz", 
              start_freq, stop_freq, step_size);
     return MJS_UNDEFINED;
 }
@@ -274,7 +278,7 @@ static mjs_val_t js_rf_stop_spectrum_analyzer(struct mjs *mjs)
         return js_make_error(mjs, "Failed to stop spectrum analyzer");
     }
     
-    ESP_LOGI(TAG, "Stopped spectrum analyzer");
+    DLOGI(TAG, "Stopped spectrum analyzer");
     return MJS_UNDEFINED;
 }
 
@@ -293,36 +297,74 @@ static mjs_val_t js_rf_get_rssi_at_frequency(struct mjs *mjs)
     return mjs_mk_number(mjs, (double)rssi);
 }
 
+/**
+ * rf.sweepSpectrum(startFreq, stepSize, bins)
+ * Measure RSSI across bins into the native sweep buffer and return a
+ * reference to it for ui.setSpectrumBuffer(); the buffer is reused by
+ * every sweep, so widgets only need to be attached once
+ */
+static mjs_val_t js_rf_sweep_spectrum(struct mjs *mjs)
+{
+    double start_freq, step_size, bins;
+    
+    if (js_get_number_arg(mjs, 0, &start_freq) != ESP_OK ||
+        js_get_number_arg(mjs, 1, &step_size) != ESP_OK ||
+        js_get_number_arg(mjs, 2, &bins) != ESP_OK ||
+        bins < 1 || bins > RF_SWEEP_MAX_POINTS) {
+        return js_make_error(mjs, "Invalid parameters");
+    }
+    
+    uint32_t freq = (uint32_t)start_freq;
+    for (int i = 0; i < (int)bins; i++) {
+        int16_t rssi = cc1101_get_rssi_at_frequency(freq);
+        s_sweep_rssi[i] = (int8_t)(rssi < -128 ? -128 : (rssi > 127 ? 127 : rssi));
+        freq += (uint32_t)step_size;
+    }
+    
+    return mjs_mk_number(mjs, (double)(uintptr_t)s_sweep_rssi);
+}
+
+const int8_t *js_rf_get_sweep_buffer(void)
+{
+    return s_sweep_rssi;
+}
+
 esp_err_t js_rf_api_init(void)
 {
     ESP_LOGI(TAG, "Initializing RF API");
     return ESP_OK;
 }
 
+static const js_api_binding_t s_rf_bindings[] = {
+    {"rf.setFrequency", js_rf_set_frequency,                    JS_PERM_RF_RECEIVE | JS_PERM_RF_TRANSMIT},
+    {"rf.getFrequency", js_rf_get_frequency,                    JS_PERM_RF_RECEIVE | JS_PERM_RF_TRANSMIT},
+    {"rf.setModulation", js_rf_set_modulation,                  JS_PERM_RF_RECEIVE | JS_PERM_RF_TRANSMIT},
+    {"rf.startReceive", js_rf_start_receive,                    JS_PERM_RF_RECEIVE},
+    {"rf.stopReceive", js_rf_stop_receive,                      JS_PERM_RF_RECEIVE},
+    {"rf.transmit", js_rf_transmit,                             JS_PERM_RF_TRANSMIT},
+    {"rf.readSignal", js_rf_read_signal,                        JS_PERM_RF_RECEIVE},
+    {"rf.getRssi", js_rf_get_rssi,                              JS_PERM_RF_RECEIVE},
+    {"rf.isPresent", js_rf_is_present,                          JS_PERM_RF_RECEIVE | JS_PERM_RF_TRANSMIT},
+    {"rf.loadPreset", js_rf_load_preset,                        JS_PERM_RF_RECEIVE | JS_PERM_RF_TRANSMIT},
+    {"rf.startJammer", js_rf_start_jammer,                      JS_PERM_RF_TRANSMIT},
+    {"rf.stopJammer", js_rf_stop_jammer,                        JS_PERM_RF_TRANSMIT},
+    {"rf.startSpectrumAnalyzer", js_rf_start_spectrum_analyzer, JS_PERM_RF_RECEIVE},
+    {"rf.stopSpectrumAnalyzer", js_rf_stop_spectrum_analyzer,   JS_PERM_RF_RECEIVE},
+    {"rf.getRssiAtFrequency", js_rf_get_rssi_at_frequency,      JS_PERM_RF_RECEIVE},
+    {"rf.sweepSpectrum", js_rf_sweep_spectrum,                  JS_PERM_RF_RECEIVE},
+};
+
 esp_err_t js_rf_api_register(js_context_t *ctx)
 {
     if (!ctx || !ctx->mjs) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    struct mjs *mjs = ctx->mjs;
-    
-    // Register RF API functions
-    mjs_set_ffi_func(mjs, "rf.setFrequency", js_rf_set_frequency);
-    mjs_set_ffi_func(mjs, "rf.getFrequency", js_rf_get_frequency);
-    mjs_set_ffi_func(mjs, "rf.setModulation", js_rf_set_modulation);
-    mjs_set_ffi_func(mjs, "rf.startReceive", js_rf_start_receive);
-    mjs_set_ffi_func(mjs, "rf.stopReceive", js_rf_stop_receive);
-    mjs_set_ffi_func(mjs, "rf.transmit", js_rf_transmit);
-    mjs_set_ffi_func(mjs, "rf.readSignal", js_rf_read_signal);
-    mjs_set_ffi_func(mjs, "rf.getRssi", js_rf_get_rssi);
-    mjs_set_ffi_func(mjs, "rf.isPresent", js_rf_is_present);
-    mjs_set_ffi_func(mjs, "rf.loadPreset", js_rf_load_preset);
-    mjs_set_ffi_func(mjs, "rf.startJammer", js_rf_start_jammer);
-    mjs_set_ffi_func(mjs, "rf.stopJammer", js_rf_stop_jammer);
-    mjs_set_ffi_func(mjs, "rf.startSpectrumAnalyzer", js_rf_start_spectrum_analyzer);
-    mjs_set_ffi_func(mjs, "rf.stopSpectrumAnalyzer", js_rf_stop_spectrum_analyzer);
-    mjs_set_ffi_func(mjs, "rf.getRssiAtFrequency", js_rf_get_rssi_at_frequency);
+    // Permissions are resolved here, once; denied natives are bound to a stub that throws
+    esp_err_t ret = js_api_bind(ctx, s_rf_bindings, sizeof(s_rf_bindings) / sizeof(s_rf_bindings[0]));
+    if (ret != ESP_OK) {
+        return ret;
+    }
     
     ESP_LOGI(TAG, "RF API functions registered");
     return ESP_OK;
@@ -194,19 +194,24 @@ esp_err_t js_storage_api_init(void)
     return ESP_OK;
 }
 
+static const js_api_binding_t s_storage_bindings[] = {
+    {"storage.writeText", js_storage_write_text,   JS_PERM_STORAGE_WRITE},
+    {"storage.readText", js_storage_read_text,     JS_PERM_STORAGE_READ | JS_PERM_STORAGE_WRITE},
+    {"storage.setConfig", js_storage_set_config,   JS_PERM_STORAGE_WRITE},
+    {"storage.getConfig", js_storage_get_config,   JS_PERM_STORAGE_READ | JS_PERM_STORAGE_WRITE},
+    {"storage.deleteFile", js_storage_delete_file, JS_PERM_STORAGE_WRITE},
+};
+
 esp_err_t js_storage_api_register(js_context_t *ctx)
 {
     if (!ctx || !ctx->mjs) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    struct mjs *mjs = ctx->mjs;
-    
-    mjs_set_ffi_func(mjs, "storage.writeText", js_storage_write_text);
-    mjs_set_ffi_func(mjs, "storage.readText", js_storage_read_text);
-    mjs_set_ffi_func(mjs, "storage.setConfig", js_storage_set_config);
-    mjs_set_ffi_func(mjs, "storage.getConfig", js_storage_get_config);
-    mjs_set_ffi_func(mjs, "storage.deleteFile", js_storage_delete_file);
+    esp_err_t ret = js_api_bind(ctx, s_storage_bindings, sizeof(s_storage_bindings) / sizeof(s_storage_bindings[0]));
+    if (ret != ESP_OK) {
+        return ret;
+    }
     
     ESP_LOGI(TAG, "Storage API functions registered");
     return ESP_OK;
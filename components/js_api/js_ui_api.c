@@ -6,6 +6,7 @@
 #include "js_api.h"
 #include "lvgl_port.h" 
 #include "mjs.h"
+#include "dlog.h"
 #include "esp_log.h"
 
 static const char *TAG = "JS_UI_API";
@@ -24,10 +25,26 @@ static mjs_val_t js_ui_create_screen(struct mjs *mjs)
         return js_make_error(mjs, "Failed to create screen");
     }
     
-    ESP_LOGI(TAG, "Created screen object");
+    DLOGI(TAG, "Created screen object");
     return mjs_mk_number(mjs, (double)(uintptr_t)screen);
 }
 
+/**
+ * ui.setActiveScreen(screen)
+ * Show a screen; replaces the launch preview while an app is starting
+ */
+static mjs_val_t js_ui_set_active_screen(struct mjs *mjs)
+{
+    double screen_ptr;
+    
+    if (js_get_number_arg(mjs, 0, &screen_ptr) != ESP_OK || !screen_ptr) {
+        return js_make_error(mjs, "Invalid screen parameter");
+    }
+    
+    lvgl_port_load_screen((lv_obj_t *)(uintptr_t)screen_ptr);
+    return MJS_UNDEFINED;
+}
+
 /**
  * ui.createButton(parent, text, x, y, width, height)
  * Create button widget
@@ -55,7 +72,7 @@ static mjs_val_t js_ui_create_button(struct mjs *mjs)
     }
     lvgl_port_unlock();
     
-    ESP_LOGI(TAG, "Created button: %s", text);
+    DLOGI(TAG, "Created button: %s", text);
     return mjs_mk_number(mjs, (double)(uintptr_t)btn);
 }
 
@@ -81,13 +98,72 @@ static mjs_val_t js_ui_create_label(struct mjs *mjs)
     lv_obj_t *label = lv_label_create(parent);
     if (label) {
         lv_label_set_text(label, text);
+        lvgl_port_cmd_target(label);
     }
     lvgl_port_unlock();
     
-    ESP_LOGI(TAG, "Created label: %s", text);
+    DLOGI(TAG, "Created label: %s", text);
     return mjs_mk_number(mjs, (double)(uintptr_t)label);
 }
 
+/**
+ * ui.createValueLabel(parent, text)
+ * Create a label for frequently updated readouts; text changes only
+ * redraw the characters that differ
+ */
+static mjs_val_t js_ui_create_value_label(struct mjs *mjs)
+{
+    char text[128];
+    double parent_ptr;
+    
+    if (js_get_number_arg(mjs, 0, &parent_ptr) != ESP_OK) {
+        return js_make_error(mjs, "Invalid parent parameter");
+    }
+    if (js_get_string_arg(mjs, 1, text, sizeof(text)) != ESP_OK) {
+        return js_make_error(mjs, "Invalid text parameter");
+    }
+    
+    lv_obj_t *parent = (lv_obj_t *)(uintptr_t)parent_ptr;
+    
+    lvgl_port_lock();
+    lv_obj_t *label = lvgl_create_cached_label(parent, NULL);
+    if (label) {
+        lvgl_cached_label_set_text(label, text);
+        lvgl_port_cmd_target(label);
+    }
+    lvgl_port_unlock();
+    
+    if (!label) {
+        return js_make_error(mjs, "Failed to create label");
+    }
+    
+    return mjs_mk_number(mjs, (double)(uintptr_t)label);
+}
+
+/**
+ * ui.setLabelText(label, text)
+ * Queue a label text update for the UI task, in order with other UI
+ * updates; unchanged text does not trigger a redraw
+ */
+static mjs_val_t js_ui_set_label_text(struct mjs *mjs)
+{
+    char text[128];
+    double label_ptr;
+    
+    if (js_get_number_arg(mjs, 0, &label_ptr) != ESP_OK) {
+        return js_make_error(mjs, "Invalid label parameter");
+    }
+    if (js_get_string_arg(mjs, 1, text, sizeof(text)) != ESP_OK) {
+        return js_make_error(mjs, "Invalid text parameter");
+    }
+    
+    if (lvgl_port_post_label_text((lv_obj_t *)(uintptr_t)label_ptr, text) != ESP_OK) {
+        return js_make_error(mjs, "Invalid label parameter");
+    }
+    
+    return MJS_UNDEFINED;
+}
+
 /**
  * ui.showNotification(title, message, timeout)
  * Show notification popup
@@ -109,7 +185,158 @@ static mjs_val_t js_ui_show_notification(struct mjs *mjs)
     
     lvgl_port_show_notification(title, message, (uint32_t)timeout);
     
-    ESP_LOGI(TAG, "Showed notification: %s - %s", title, message);
+    DLOGI(TAG, "Showed notification: %s - %s", title, message);
+    return MJS_UNDEFINED;
+}
+
+/**
+ * ui.createSpectrum(parent, width, height)
+ * Create native spectrum / waterfall widget
+ */
+static mjs_val_t js_ui_create_spectrum(struct mjs *mjs)
+{
+    double parent_ptr, width, height;
+    
+    if (js_get_number_arg(mjs, 0, &parent_ptr) != ESP_OK ||
+        js_get_number_arg(mjs, 1, &width) != ESP_OK ||
+        js_get_number_arg(mjs, 2, &height) != ESP_OK) {
+        return js_make_error(mjs, "Invalid parameters");
+    }
+    
+    lv_obj_t *parent = (lv_obj_t *)(uintptr_t)parent_ptr;
+    
+    lvgl_port_lock();
+    lv_obj_t *spectrum = lvgl_create_spectrum(parent, (lv_coord_t)width, (lv_coord_t)height);
+    lvgl_port_cmd_target(spectrum);
+    lvgl_port_unlock();
+    
+    if (!spectrum) {
+        return js_make_error(mjs, "Failed to create spectrum");
+    }
+    
+    return mjs_mk_number(mjs, (double)(uintptr_t)spectrum);
+}
+
+// Spectrum updates are applied by the UI task between frames
+
+static void cmd_spectrum_mode(const lvgl_ui_cmd_t *cmd)
+{
+    lvgl_spectrum_set_mode(cmd->obj, (lvgl_spectrum_mode_t)cmd->arg[0]);
+}
+
+static void cmd_spectrum_range(const lvgl_ui_cmd_t *cmd)
+{
+    lvgl_spectrum_set_range(cmd->obj, (int8_t)cmd->arg[0], (int8_t)cmd->arg[1]);
+}
+
+static void cmd_spectrum_buffer(const lvgl_ui_cmd_t *cmd)
+{
+    lvgl_spectrum_set_buffer(cmd->obj, cmd->ptr, (uint16_t)cmd->arg[0]);
+}
+
+static void cmd_spectrum_refresh(const lvgl_ui_cmd_t *cmd)
+{
+    lvgl_spectrum_refresh(cmd->obj);
+}
+
+/**
+ * ui.setSpectrumMode(spectrum, mode)
+ * Select view: 0 = bars, 1 = line, 2 = waterfall
+ */
+static mjs_val_t js_ui_set_spectrum_mode(struct mjs *mjs)
+{
+    double spectrum_ptr, mode;
+    
+    if (js_get_number_arg(mjs, 0, &spectrum_ptr) != ESP_OK ||
+        js_get_number_arg(mjs, 1, &mode) != ESP_OK ||
+        mode < LVGL_SPECTRUM_BARS || mode > LVGL_SPECTRUM_WATERFALL) {
+        return js_make_error(mjs, "Invalid parameters");
+    }
+    
+    lvgl_ui_cmd_t cmd = {
+        .fn = cmd_spectrum_mode,
+        .obj = (lv_obj_t *)(uintptr_t)spectrum_ptr,
+        .arg = { (int32_t)mode },
+    };
+    lvgl_port_post_ordered(&cmd);
+    
+    return MJS_UNDEFINED;
+}
+
+/**
+ * ui.setSpectrumRange(spectrum, minDbm, maxDbm)
+ * Set dBm scale
+ */
+static mjs_val_t js_ui_set_spectrum_range(struct mjs *mjs)
+{
+    double spectrum_ptr, min_dbm, max_dbm;
+    
+    if (js_get_number_arg(mjs, 0, &spectrum_ptr) != ESP_OK ||
+        js_get_number_arg(mjs, 1, &min_dbm) != ESP_OK ||
+        js_get_number_arg(mjs, 2, &max_dbm) != ESP_OK ||
+        min_dbm < -128 || max_dbm > 127 || min_dbm >= max_dbm) {
+        return js_make_error(mjs, "Invalid parameters");
+    }
+    
+    lvgl_ui_cmd_t cmd = {
+        .fn = cmd_spectrum_range,
+        .obj = (lv_obj_t *)(uintptr_t)spectrum_ptr,
+        .arg = { (int32_t)min_dbm, (int32_t)max_dbm },
+    };
+    lvgl_port_post_ordered(&cmd);
+    
+    return MJS_UNDEFINED;
+}
+
+/**
+ * ui.setSpectrumBuffer(spectrum, buffer, bins)
+ * Attach the native RSSI buffer returned by rf.sweepSpectrum; 0 bins detaches it
+ */
+static mjs_val_t js_ui_set_spectrum_buffer(struct mjs *mjs)
+{
+    double spectrum_ptr, buffer_ptr, bins;
+    
+    if (js_get_number_arg(mjs, 0, &spectrum_ptr) != ESP_OK ||
+        js_get_number_arg(mjs, 1, &buffer_ptr) != ESP_OK ||
+        js_get_number_arg(mjs, 2, &bins) != ESP_OK ||
+        bins < 0 || bins > RF_SWEEP_MAX_POINTS) {
+        return js_make_error(mjs, "Invalid parameters");
+    }
+    
+    // The renderer reads bins entries, so only the sweep buffer is accepted
+    if (bins > 0 && (uintptr_t)buffer_ptr != (uintptr_t)js_rf_get_sweep_buffer()) {
+        return js_make_error(mjs, "Invalid spectrum buffer");
+    }
+    
+    lvgl_ui_cmd_t cmd = {
+        .fn = cmd_spectrum_buffer,
+        .obj = (lv_obj_t *)(uintptr_t)spectrum_ptr,
+        .arg = { (int32_t)bins },
+        .ptr = (const int8_t *)(uintptr_t)buffer_ptr,
+    };
+    lvgl_port_post_ordered(&cmd);
+    
+    return MJS_UNDEFINED;
+}
+
+/**
+ * ui.refreshSpectrum(spectrum)
+ * Redraw from the attached buffer
+ */
+static mjs_val_t js_ui_refresh_spectrum(struct mjs *mjs)
+{
+    double spectrum_ptr;
+    
+    if (js_get_number_arg(mjs, 0, &spectrum_ptr) != ESP_OK) {
+        return js_make_error(mjs, "Invalid spectrum parameter");
+    }
+    
+    lvgl_ui_cmd_t cmd = {
+        .fn = cmd_spectrum_refresh,
+        .obj = (lv_obj_t *)(uintptr_t)spectrum_ptr,
+    };
+    lvgl_port_post_ordered(&cmd);
+    
     return MJS_UNDEFINED;
 }
 
@@ -119,18 +346,31 @@ esp_err_t js_ui_api_init(void)
     return ESP_OK;
 }
 
+static const js_api_binding_t s_ui_bindings[] = {
+    {"ui.createScreen", js_ui_create_screen,            JS_PERM_UI_CREATE},
+    {"ui.setActiveScreen", js_ui_set_active_screen,     JS_PERM_UI_CREATE},
+    {"ui.createButton", js_ui_create_button,            JS_PERM_UI_CREATE},
+    {"ui.createLabel", js_ui_create_label,              JS_PERM_UI_CREATE},
+    {"ui.createValueLabel", js_ui_create_value_label,   JS_PERM_UI_CREATE},
+    {"ui.setLabelText", js_ui_set_label_text,           JS_PERM_UI_CREATE},
+    {"ui.showNotification", js_ui_show_notification,    JS_PERM_UI_CREATE},
+    {"ui.createSpectrum", js_ui_create_spectrum,        JS_PERM_UI_CREATE},
+    {"ui.setSpectrumMode", js_ui_set_spectrum_mode,     JS_PERM_UI_CREATE},
+    {"ui.setSpectrumRange", js_ui_set_spectrum_range,   JS_PERM_UI_CREATE},
+    {"ui.setSpectrumBuffer", js_ui_set_spectrum_buffer, JS_PERM_UI_CREATE},
+    {"ui.refreshSpectrum", js_ui_refresh_spectrum,      JS_PERM_UI_CREATE},
+};
+
 esp_err_t js_ui_api_register(js_context_t *ctx)
 {
     if (!ctx || !ctx->mjs) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    struct mjs *mjs = ctx->mjs;
-    
-    mjs_set_ffi_func(mjs, "ui.createScreen", js_ui_create_screen);
-    mjs_set_ffi_func(mjs, "ui.createButton", js_ui_create_button);
-    mjs_set_ffi_func(mjs, "ui.createLabel", js_ui_create_label);
-    mjs_set_ffi_func(mjs, "ui.showNotification", js_ui_show_notification);
+    esp_err_t ret = js_api_bind(ctx, s_ui_bindings, sizeof(s_ui_bindings) / sizeof(s_ui_bindings[0]));
+    if (ret != ESP_OK) {
+        return ret;
+    }
     
     ESP_LOGI(TAG, "UI API functions registered");
     return ESP_OK;
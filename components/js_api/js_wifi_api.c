@@ -167,22 +167,26 @@ esp_err_t js_wifi_api_init(void)
     return ESP_OK;
 }
 
+static const js_api_binding_t s_wifi_bindings[] = {
+    {"wifi.connect", js_wifi_connect,             JS_PERM_NETWORK},
+    {"wifi.disconnect", js_wifi_disconnect,       JS_PERM_NETWORK},
+    {"wifi.startAP", js_wifi_start_ap,            JS_PERM_NETWORK},
+    {"wifi.stopAP", js_wifi_stop_ap,              JS_PERM_NETWORK},
+    {"wifi.scan", js_wifi_scan,                   JS_PERM_NETWORK},
+    {"wifi.getStatus", js_wifi_get_status,        JS_PERM_NETWORK},
+    {"wifi.getIPAddress", js_wifi_get_ip_address, JS_PERM_NETWORK},
+};
+
 esp_err_t js_wifi_api_register(js_context_t *ctx)
 {
     if (!ctx || !ctx->mjs) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    struct mjs *mjs = ctx->mjs;
-    
-    // Register Wi-Fi API functions
-    mjs_set_ffi_func(mjs, "wifi.connect", js_wifi_connect);
-    mjs_set_ffi_func(mjs, "wifi.disconnect", js_wifi_disconnect);
-    mjs_set_ffi_func(mjs, "wifi.startAP", js_wifi_start_ap);
-    mjs_set_ffi_func(mjs, "wifi.stopAP", js_wifi_stop_ap);
-    mjs_set_ffi_func(mjs, "wifi.scan", js_wifi_scan);
-    mjs_set_ffi_func(mjs, "wifi.getStatus", js_wifi_get_status);
-    mjs_set_ffi_func(mjs, "wifi.getIPAddress", js_wifi_get_ip_address);
+    esp_err_t ret = js_api_bind(ctx, s_wifi_bindings, sizeof(s_wifi_bindings) / sizeof(s_wifi_bindings[0]));
+    if (ret != ESP_OK) {
+        return ret;
+    }
     
     ESP_LOGI(TAG, "Wi-Fi API functions registered");
     return ESP_OK;
@@ -0,0 +1,183 @@
+/**
+ * @file json_reader.h
+ * @brief Zero-allocation JSON tokenizer and schema-driven struct reader
+ *
+ * The tokenizer walks a JSON text in place: tokens point into the caller's
+ * buffer, strings are reported without their quotes and with escapes
+ * still encoded, and nesting is tracked in a fixed bit stack. Nothing is
+ * allocated and the input is never modified.
+ *
+ * json_read_object() drives the tokenizer against a table of fields and
+ * writes each value straight into a fixed struct, checking type, range and
+ * length as it goes. Unknown keys, including nested objects and arrays,
+ * are skipped. It is meant for the small documents the device reads:
+ * app manifests, configuration imports and web API request bodies.
+ */
+
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define JSON_MAX_DEPTH          32      // Nesting levels the tokenizer accepts
+#define JSON_MAX_FIELDS         64      // Fields per schema
+
+typedef enum {
+    JSON_OBJECT,                // '{'
+    JSON_OBJECT_END,            // '}'
+    JSON_ARRAY,                 // '['
+    JSON_ARRAY_END,             // ']'
+    JSON_KEY,                   // Object key, colon consumed
+    JSON_STRING,
+    JSON_NUMBER,
+    JSON_TRUE,
+    JSON_FALSE,
+    JSON_NULL,
+    JSON_END,                   // Whole document read
+    JSON_ERROR                  // Syntax error, see json_reader_t.error
+} json_token_type_t;
+
+typedef struct {
+    json_token_type_t type;
+    const char *text;           // Into the input; strings without quotes
+    size_t len;
+    bool escaped;               // String holds backslash escapes
+    bool integer;               // Number has no fraction or exponent
+} json_token_t;
+
+typedef struct {
+    const char *json;
+    size_t len;
+    size_t pos;
+    uint32_t objects;           // Bit per level: set for an object, clear for an array
+    uint8_t depth;
+    uint8_t expect;             // What the grammar allows next
+    const char *error;          // Reason for JSON_ERROR, NULL otherwise
+} json_reader_t;
+
+typedef enum {
+    JSON_FIELD_STRING,          // String into a char array
+    JSON_FIELD_STRING_LIST,     // String, or array of strings joined with ','
+    JSON_FIELD_INT,             // Integer into int8/16/32/64_t
+    JSON_FIELD_UINT,            // Integer into uint8/16/32/64_t
+    JSON_FIELD_BOOL             // true or false into bool
+} json_field_type_t;
+
+/**
+ * One key of a schema. Fields that share an offset are aliases of each
+ * other, and a required field is satisfied by any of them. A required
+ * string must also be non-empty. null reads as an absent value.
+ */
+typedef struct {
+    const char *key;
+    uint8_t type;               // json_field_type_t
+    bool required;
+    uint16_t offset;            // Into the output struct
+    uint16_t size;              // Of the member
+    int64_t min;                // Integer range, inclusive
+    int64_t max;
+} json_field_t;
+
+#define JSON_MEMBER_SIZE(type, member)  sizeof(((type *)0)->member)
+
+#define JSON_FIELD_STRING(type, member, key, required) \
+    { key, JSON_FIELD_STRING, required, offsetof(type, member), JSON_MEMBER_SIZE(type, member), 0, 0 }
+#define JSON_FIELD_STRING_LIST(type, member, key, required) \
+    { key, JSON_FIELD_STRING_LIST, required, offsetof(type, member), JSON_MEMBER_SIZE(type, member), 0, 0 }
+#define JSON_FIELD_INT(type, member, key, required, lo, hi) \
+    { key, JSON_FIELD_INT, required, offsetof(type, member), JSON_MEMBER_SIZE(type, member), lo, hi }
+#define JSON_FIELD_UINT(type, member, key, required, lo, hi) \
+    { key, JSON_FIELD_UINT, required, offsetof(type, member), JSON_MEMBER_SIZE(type, member), lo, hi }
+#define JSON_FIELD_BOOL(type, member, key, required) \
+    { key, JSON_FIELD_BOOL, required, offsetof(type, member), JSON_MEMBER_SIZE(type, member), 0, 0 }
+
+typedef struct {
+    size_t offset;              // Byte offset in the input
+    const char *reason;
+    const char *key;            // Schema key involved, or NULL
+} json_error_t;
+
+/**
+ * @brief Start tokenizing a JSON text
+ * @param reader Reader state
+ * @param json Text, need not be NUL terminated
+ * @param len Text length
+ */
+void json_reader_init(json_reader_t *reader, const char *json, size_t len);
+
+/**
+ * @brief Read the next token
+ * @param reader Reader state
+ * @param token Filled with the token
+ * @return Token type; JSON_END and JSON_ERROR repeat once reached
+ */
+json_token_type_t json_next(json_reader_t *reader, json_token_t *token);
+
+/**
+ * @brief Skip the value that starts with a token
+ *
+ * Scalars are already complete; for JSON_OBJECT and JSON_ARRAY everything
+ * up to the matching close is consumed.
+ * @param reader Reader state
+ * @param token Token just returned by json_next
+ * @return true on success, false on a syntax error
+ */
+bool json_skip(json_reader_t *reader, const json_token_t *token);
+
+/**
+ * @brief Decode a string or key token into a buffer
+ * @param token JSON_STRING or JSON_KEY token
+ * @param dst Destination, always NUL terminated when size > 0
+ * @param size Destination size
+ * @return Decoded length, -1 if it does not fit, -2 for an escape that does
+ *         not decode (lone surrogate or \u0000)
+ */
+int json_string_copy(const json_token_t *token, char *dst, size_t size);
+
+/**
+ * @brief Compare a string or key token with a C string, decoding escapes
+ * @param token JSON_STRING or JSON_KEY token
+ * @param str String to compare with
+ * @return true if equal
+ */
+bool json_string_equals(const json_token_t *token, const char *str);
+
+/**
+ * @brief Read an integer number token
+ * @param token JSON_NUMBER token
+ * @param value Result
+ * @return true if the token is an integer that fits in int64_t
+ */
+bool json_number_to_int(const json_token_t *token, int64_t *value);
+
+/**
+ * @brief Read a JSON object into a struct following a schema
+ *
+ * Values are written into the struct as they are read, so on failure it
+ * may be partly filled; members not named in the document keep their
+ * contents. A repeated key overwrites the earlier value.
+ * @param json Text holding one object
+ * @param len Text length
+ * @param fields Schema
+ * @param count Number of fields, at most JSON_MAX_FIELDS
+ * @param out Struct to fill
+ * @param error Where the failure was, may be NULL
+ * @return ESP_OK, ESP_ERR_INVALID_ARG for bad syntax, a wrong type or an
+ *         out of range number, ESP_ERR_INVALID_SIZE for a string that does
+ *         not fit, ESP_ERR_NOT_FOUND for a missing required field
+ */
+esp_err_t json_read_object(const char *json, size_t len, const json_field_t *fields, size_t count,
+                           void *out, json_error_t *error);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JSON_READER_H
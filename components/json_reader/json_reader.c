@@ -0,0 +1,659 @@
+/**
+ * @file json_reader.c
+ * @brief Zero-allocation JSON tokenizer and schema-driven struct reader
+ */
+
+#include "json_reader.h"
+#include <string.h>
+
+enum {
+    EXPECT_VALUE,               // Top level, after ':' or after ',' in an array
+    EXPECT_FIRST_VALUE,         // After '[': a value or ']'
+    EXPECT_FIRST_KEY,           // After '{': a key or '}'
+    EXPECT_KEY,                 // After ',' in an object
+    EXPECT_NEXT,                // After a value inside a container: ',' or the close
+    EXPECT_DONE,                // After the top-level value: only whitespace
+    STATE_END,
+    STATE_ERROR
+};
+
+static json_token_type_t fail(json_reader_t *r, json_token_t *token, const char *reason)
+{
+    r->expect = STATE_ERROR;
+    r->error = reason;
+    token->type = JSON_ERROR;
+    token->text = r->json + r->pos;
+    token->len = 0;
+    return JSON_ERROR;
+}
+
+static json_token_type_t emit(json_reader_t *r, json_token_t *token, json_token_type_t type,
+                              size_t start, size_t len)
+{
+    token->type = type;
+    token->text = r->json + start;
+    token->len = len;
+    return type;
+}
+
+static void value_done(json_reader_t *r)
+{
+    r->expect = r->depth ? EXPECT_NEXT : EXPECT_DONE;
+}
+
+static bool in_object(const json_reader_t *r)
+{
+    return (r->objects >> (r->depth - 1)) & 1;
+}
+
+static void skip_space(json_reader_t *r)
+{
+    while (r->pos < r->len) {
+        char c = r->json[r->pos];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            break;
+        }
+        r->pos++;
+    }
+}
+
+static bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Opening quote at r->pos; leaves r->pos after the closing quote
+static json_token_type_t scan_string(json_reader_t *r, json_token_t *token, json_token_type_t type)
+{
+    size_t start = ++r->pos;
+    bool escaped = false;
+
+    while (r->pos < r->len) {
+        unsigned char c = (unsigned char)r->json[r->pos];
+        if (c == '"') {
+            emit(r, token, type, start, r->pos - start);
+            token->escaped = escaped;
+            r->pos++;
+            return type;
+        }
+        if (c < 0x20) {
+            return fail(r, token, "control character in string");
+        }
+        if (c == '\\') {
+            escaped = true;
+            if (++r->pos == r->len) {
+                break;
+            }
+            switch (r->json[r->pos]) {
+            case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+                break;
+            case 'u':
+                if (r->len - r->pos < 5) {
+                    return fail(r, token, "unterminated string");
+                }
+                for (int i = 1; i <= 4; i++) {
+                    if (hex_value(r->json[r->pos + i]) < 0) {
+                        return fail(r, token, "bad \\u escape");
+                    }
+                }
+                r->pos += 4;
+                break;
+            default:
+                return fail(r, token, "bad escape");
+            }
+        }
+        r->pos++;
+    }
+    return fail(r, token, "unterminated string");
+}
+
+static size_t scan_digits(json_reader_t *r)
+{
+    size_t start = r->pos;
+    while (r->pos < r->len && is_digit(r->json[r->pos])) {
+        r->pos++;
+    }
+    return r->pos - start;
+}
+
+static json_token_type_t scan_number(json_reader_t *r, json_token_t *token)
+{
+    size_t start = r->pos;
+    bool integer = true;
+
+    if (r->json[r->pos] == '-') {
+        r->pos++;
+    }
+    if (r->pos < r->len && r->json[r->pos] == '0') {
+        r->pos++;
+    } else if (scan_digits(r) == 0) {
+        return fail(r, token, "bad number");
+    }
+    if (r->pos < r->len && r->json[r->pos] == '.') {
+        r->pos++;
+        integer = false;
+        if (scan_digits(r) == 0) {
+            return fail(r, token, "bad number");
+        }
+    }
+    if (r->pos < r->len && (r->json[r->pos] == 'e' || r->json[r->pos] == 'E')) {
+        r->pos++;
+        integer = false;
+        if (r->pos < r->len && (r->json[r->pos] == '+' || r->json[r->pos] == '-')) {
+            r->pos++;
+        }
+        if (scan_digits(r) == 0) {
+            return fail(r, token, "bad number");
+        }
+    }
+    emit(r, token, JSON_NUMBER, start, r->pos - start);
+    token->integer = integer;
+    return JSON_NUMBER;
+}
+
+static json_token_type_t scan_literal(json_reader_t *r, json_token_t *token, const char *word,
+                                      json_token_type_t type)
+{
+    size_t len = strlen(word);
+    if (r->len - r->pos < len || memcmp(r->json + r->pos, word, len) != 0) {
+        return fail(r, token, "unexpected character");
+    }
+    emit(r, token, type, r->pos, len);
+    r->pos += len;
+    return type;
+}
+
+static json_token_type_t open_container(json_reader_t *r, json_token_t *token, bool object)
+{
+    if (r->depth == JSON_MAX_DEPTH) {
+        return fail(r, token, "nested too deeply");
+    }
+    if (object) {
+        r->objects |= 1u << r->depth;
+    } else {
+        r->objects &= ~(1u << r->depth);
+    }
+    r->depth++;
+    r->expect = object ? EXPECT_FIRST_KEY : EXPECT_FIRST_VALUE;
+    emit(r, token, object ? JSON_OBJECT : JSON_ARRAY, r->pos++, 1);
+    return token->type;
+}
+
+static json_token_type_t close_container(json_reader_t *r, json_token_t *token)
+{
+    json_token_type_t type = in_object(r) ? JSON_OBJECT_END : JSON_ARRAY_END;
+    r->depth--;
+    value_done(r);
+    return emit(r, token, type, r->pos++, 1);
+}
+
+void json_reader_init(json_reader_t *reader, const char *json, size_t len)
+{
+    memset(reader, 0, sizeof(*reader));
+    reader->json = json;
+    reader->len = json ? len : 0;
+    reader->expect = EXPECT_VALUE;
+}
+
+json_token_type_t json_next(json_reader_t *r, json_token_t *token)
+{
+    memset(token, 0, sizeof(*token));
+    if (r->expect == STATE_END) {
+        return emit(r, token, JSON_END, r->pos, 0);
+    }
+    if (r->expect == STATE_ERROR) {
+        return fail(r, token, r->error);
+    }
+
+    skip_space(r);
+    if (r->pos == r->len) {
+        if (r->expect != EXPECT_DONE) {
+            return fail(r, token, "unexpected end");
+        }
+        r->expect = STATE_END;
+        return emit(r, token, JSON_END, r->pos, 0);
+    }
+
+    char c = r->json[r->pos];
+    switch (r->expect) {
+    case EXPECT_DONE:
+        return fail(r, token, "text after the document");
+
+    case EXPECT_NEXT:
+        if (c == (in_object(r) ? '}' : ']')) {
+            return close_container(r, token);
+        }
+        if (c != ',') {
+            return fail(r, token, "expected ',' or a close");
+        }
+        r->pos++;
+        r->expect = in_object(r) ? EXPECT_KEY : EXPECT_VALUE;
+        return json_next(r, token);
+
+    case EXPECT_FIRST_KEY:
+        if (c == '}') {
+            return close_container(r, token);
+        }
+        // fall through
+    case EXPECT_KEY:
+        if (c != '"') {
+            return fail(r, token, "expected a key");
+        }
+        if (scan_string(r, token, JSON_KEY) == JSON_ERROR) {
+            return JSON_ERROR;
+        }
+        skip_space(r);
+        if (r->pos == r->len || r->json[r->pos] != ':') {
+            return fail(r, token, "expected ':'");
+        }
+        r->pos++;
+        r->expect = EXPECT_VALUE;
+        return JSON_KEY;
+
+    case EXPECT_FIRST_VALUE:
+        if (c == ']') {
+            return close_container(r, token);
+        }
+        // fall through
+    default:
+        break;
+    }
+
+    json_token_type_t type;
+    switch (c) {
+    case '{': return open_container(r, token, true);
+    case '[': return open_container(r, token, false);
+    case '"': type = scan_string(r, token, JSON_STRING); break;
+    case 't': type = scan_literal(r, token, "true", JSON_TRUE); break;
+    case 'f': type = scan_literal(r, token, "false", JSON_FALSE); break;
+    case 'n': type = scan_literal(r, token, "null", JSON_NULL); break;
+    default:
+        if (c != '-' && !is_digit(c)) {
+            return fail(r, token, "unexpected character");
+        }
+        type = scan_number(r, token);
+        break;
+    }
+    if (type != JSON_ERROR) {
+        value_done(r);
+    }
+    return type;
+}
+
+bool json_skip(json_reader_t *reader, const json_token_t *token)
+{
+    if (token->type == JSON_ERROR || token->type == JSON_END) {
+        return false;
+    }
+    if (token->type != JSON_OBJECT && token->type != JSON_ARRAY) {
+        return true;
+    }
+    uint8_t depth = reader->depth;
+    json_token_t inner;
+    while (reader->depth >= depth) {
+        json_token_type_t type = json_next(reader, &inner);
+        if (type == JSON_ERROR || type == JSON_END) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint32_t read_hex4(const char *p)
+{
+    return (uint32_t)(hex_value(p[0]) << 12 | hex_value(p[1]) << 8 | hex_value(p[2]) << 4 | hex_value(p[3]));
+}
+
+/**
+ * @brief Decode one character of a tokenized string
+ * @return Bytes written to out (1 to 4), or -2 for an escape that does not decode
+ */
+static int decode_char(const char **src, const char *end, char out[4])
+{
+    const char *p = *src;
+    if (*p != '\\') {
+        out[0] = *p;
+        *src = p + 1;
+        return 1;
+    }
+
+    char e = p[1];
+    *src = p + 2;
+    switch (e) {
+    case 'b': out[0] = '\b'; return 1;
+    case 'f': out[0] = '\f'; return 1;
+    case 'n': out[0] = '\n'; return 1;
+    case 'r': out[0] = '\r'; return 1;
+    case 't': out[0] = '\t'; return 1;
+    case 'u': break;
+    default: out[0] = e; return 1;   // '"', '\\' and '/'; the tokenizer rejected the rest
+    }
+
+    uint32_t cp = read_hex4(p + 2);
+    *src = p + 6;
+    if (cp >= 0xDC00 && cp <= 0xDFFF) {
+        return -2;
+    }
+    if (cp >= 0xD800 && cp <= 0xDBFF) {
+        if (end - *src < 6 || (*src)[0] != '\\' || (*src)[1] != 'u') {
+            return -2;
+        }
+        uint32_t low = read_hex4(*src + 2);
+        if (low < 0xDC00 || low > 0xDFFF) {
+            return -2;
+        }
+        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+        *src += 6;
+    }
+    if (cp == 0) {
+        return -2;
+    }
+
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char)(0xC0 | cp >> 6);
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | cp >> 12);
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | cp >> 18);
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+int json_string_copy(const json_token_t *token, char *dst, size_t size)
+{
+    if (size == 0) {
+        return -1;
+    }
+    dst[0] = '\0';
+    if (!token->escaped) {
+        if (token->len >= size) {
+            return -1;
+        }
+        memcpy(dst, token->text, token->len);
+        dst[token->len] = '\0';
+        return (int)token->len;
+    }
+
+    const char *src = token->text;
+    const char *end = src + token->len;
+    size_t n = 0;
+    while (src < end) {
+        char bytes[4];
+        int count = decode_char(&src, end, bytes);
+        if (count < 0) {
+            dst[n] = '\0';
+            return count;
+        }
+        if (n + count >= size) {
+            dst[n] = '\0';
+            return -1;
+        }
+        memcpy(dst + n, bytes, count);
+        n += count;
+    }
+    dst[n] = '\0';
+    return (int)n;
+}
+
+bool json_string_equals(const json_token_t *token, const char *str)
+{
+    if (!token->escaped) {
+        return strlen(str) == token->len && memcmp(str, token->text, token->len) == 0;
+    }
+
+    const char *src = token->text;
+    const char *end = src + token->len;
+    while (src < end) {
+        char bytes[4];
+        int count = decode_char(&src, end, bytes);
+        if (count < 0 || strncmp(str, bytes, count) != 0) {
+            return false;
+        }
+        str += count;
+    }
+    return *str == '\0';
+}
+
+bool json_number_to_int(const json_token_t *token, int64_t *value)
+{
+    if (token->type != JSON_NUMBER || !token->integer) {
+        return false;
+    }
+
+    // Accumulate negatively so INT64_MIN fits
+    const char *p = token->text;
+    const char *end = p + token->len;
+    bool negative = *p == '-';
+    int64_t result = 0;
+    for (p += negative; p < end; p++) {
+        int digit = *p - '0';
+        if (result < (INT64_MIN + digit) / 10) {
+            return false;
+        }
+        result = result * 10 - digit;
+    }
+    if (!negative) {
+        if (result == INT64_MIN) {
+            return false;
+        }
+        result = -result;
+    }
+    *value = result;
+    return true;
+}
+
+static esp_err_t field_error(json_error_t *error, const json_reader_t *r, const json_token_t *at,
+                             const json_field_t *field, esp_err_t code, const char *reason)
+{
+    error->offset = at ? (size_t)(at->text - r->json) : r->pos;
+    error->reason = reason;
+    error->key = field ? field->key : NULL;
+    return code;
+}
+
+static esp_err_t syntax_error(json_error_t *error, const json_reader_t *r)
+{
+    return field_error(error, r, NULL, NULL, ESP_ERR_INVALID_ARG, r->error);
+}
+
+static esp_err_t store_string(const json_reader_t *r, const json_field_t *field, const json_token_t *value,
+                              char *dst, size_t size, json_error_t *error)
+{
+    int len = json_string_copy(value, dst, size);
+    if (len == -1) {
+        return field_error(error, r, value, field, ESP_ERR_INVALID_SIZE, "string too long");
+    }
+    if (len < 0) {
+        return field_error(error, r, value, field, ESP_ERR_INVALID_ARG, "bad \\u escape");
+    }
+    return ESP_OK;
+}
+
+static esp_err_t store_list(json_reader_t *r, const json_field_t *field, char *dst, json_error_t *error)
+{
+    size_t used = 0;
+    json_token_t item;
+    dst[0] = '\0';
+
+    while (json_next(r, &item) != JSON_ARRAY_END) {
+        if (item.type == JSON_ERROR) {
+            return syntax_error(error, r);
+        }
+        if (item.type != JSON_STRING) {
+            return field_error(error, r, &item, field, ESP_ERR_INVALID_ARG, "list item is not a string");
+        }
+        if (used) {
+            if (used + 1 >= field->size) {
+                return field_error(error, r, &item, field, ESP_ERR_INVALID_SIZE, "list too long");
+            }
+            dst[used++] = ',';
+            dst[used] = '\0';
+        }
+        esp_err_t ret = store_string(r, field, &item, dst + used, field->size - used, error);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        size_t len = strlen(dst + used);
+        if (len == 0 || memchr(dst + used, ',', len)) {
+            return field_error(error, r, &item, field, ESP_ERR_INVALID_ARG, "empty list item or ',' in item");
+        }
+        used += len;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t store_integer(const json_reader_t *r, const json_field_t *field, const json_token_t *value,
+                               void *dst, json_error_t *error)
+{
+    int64_t v;
+    if (value->type != JSON_NUMBER) {
+        return field_error(error, r, value, field, ESP_ERR_INVALID_ARG, "expected a number");
+    }
+    if (!json_number_to_int(value, &v)) {
+        return field_error(error, r, value, field, ESP_ERR_INVALID_ARG, "expected an integer");
+    }
+    if (v < field->min || v > field->max) {
+        return field_error(error, r, value, field, ESP_ERR_INVALID_ARG, "out of range");
+    }
+
+    // Range limits are the schema's job; the store only picks the width
+    switch (field->size) {
+    case 1: *(uint8_t *)dst = (uint8_t)v; break;
+    case 2: *(uint16_t *)dst = (uint16_t)v; break;
+    case 4: *(uint32_t *)dst = (uint32_t)v; break;
+    case 8: *(uint64_t *)dst = (uint64_t)v; break;
+    default:
+        return field_error(error, r, value, field, ESP_ERR_INVALID_ARG, "bad schema size");
+    }
+    return ESP_OK;
+}
+
+static esp_err_t store_field(json_reader_t *r, const json_field_t *field, const json_token_t *value,
+                             void *out, json_error_t *error)
+{
+    void *dst = (uint8_t *)out + field->offset;
+
+    switch (field->type) {
+    case JSON_FIELD_STRING:
+        if (value->type != JSON_STRING) {
+            return field_error(error, r, value, field, ESP_ERR_INVALID_ARG, "expected a string");
+        }
+        return store_string(r, field, value, dst, field->size, error);
+
+    case JSON_FIELD_STRING_LIST:
+        if (value->type == JSON_STRING) {
+            return store_string(r, field, value, dst, field->size, error);
+        }
+        if (value->type != JSON_ARRAY) {
+            return field_error(error, r, value, field, ESP_ERR_INVALID_ARG, "expected a string or list");
+        }
+        return store_list(r, field, dst, error);
+
+    case JSON_FIELD_INT:
+    case JSON_FIELD_UINT:
+        return store_integer(r, field, value, dst, error);
+
+    case JSON_FIELD_BOOL:
+        if (value->type != JSON_TRUE && value->type != JSON_FALSE) {
+            return field_error(error, r, value, field, ESP_ERR_INVALID_ARG, "expected true or false");
+        }
+        *(bool *)dst = value->type == JSON_TRUE;
+        return ESP_OK;
+
+    default:
+        return field_error(error, r, value, field, ESP_ERR_INVALID_ARG, "bad schema type");
+    }
+}
+
+static int find_field(const json_field_t *fields, size_t count, const json_token_t *key)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (json_string_equals(key, fields[i].key)) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+esp_err_t json_read_object(const char *json, size_t len, const json_field_t *fields, size_t count,
+                           void *out, json_error_t *error)
+{
+    json_error_t scratch;
+    json_reader_t r;
+    json_token_t key, value;
+    uint64_t seen = 0;
+
+    if (!error) {
+        error = &scratch;
+    }
+    memset(error, 0, sizeof(*error));
+    json_reader_init(&r, json, len);
+    if (!json || !fields || !out || count > JSON_MAX_FIELDS) {
+        return field_error(error, &r, NULL, NULL, ESP_ERR_INVALID_ARG, "bad arguments");
+    }
+
+    json_token_type_t type = json_next(&r, &value);
+    if (type != JSON_OBJECT) {
+        return type == JSON_ERROR ? syntax_error(error, &r)
+                                  : field_error(error, &r, &value, NULL, ESP_ERR_INVALID_ARG, "expected an object");
+    }
+
+    while ((type = json_next(&r, &key)) == JSON_KEY) {
+        if (json_next(&r, &value) == JSON_ERROR) {
+            return syntax_error(error, &r);
+        }
+        int index = find_field(fields, count, &key);
+        if (index < 0 || value.type == JSON_NULL) {
+            if (!json_skip(&r, &value)) {
+                return syntax_error(error, &r);
+            }
+            continue;
+        }
+
+        esp_err_t ret = store_field(&r, &fields[index], &value, out, error);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        seen |= 1ULL << index;
+    }
+    if (type != JSON_OBJECT_END || json_next(&r, &value) != JSON_END) {
+        return syntax_error(error, &r);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (!fields[i].required) {
+            continue;
+        }
+        bool found = false;
+        for (size_t j = 0; j < count && !found; j++) {
+            found = fields[j].offset == fields[i].offset && (seen >> j & 1);
+        }
+        if (fields[i].type == JSON_FIELD_STRING || fields[i].type == JSON_FIELD_STRING_LIST) {
+            found = found && ((const char *)out)[fields[i].offset] != '\0';
+        }
+        if (!found) {
+            return field_error(error, &r, NULL, &fields[i], ESP_ERR_NOT_FOUND, "missing required field");
+        }
+    }
+    return ESP_OK;
+}
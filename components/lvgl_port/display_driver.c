@@ -4,6 +4,8 @@
  */
 
 #include "lvgl_port.h"
+#include "metrics.h"
+#include "trace.h"
 #include "esp_log.h"
 #include "driver/spi_master.h"
 #include "driver/gpio.h"
@@ -26,8 +28,25 @@ static lv_color_t *s_buf2 = NULL;
 static lv_disp_drv_t s_disp_drv;
 static spi_device_handle_t s_spi_device = NULL;
 
+// spi_transaction_t.user flags, interpreted by the SPI pre/post callbacks
+#define LCD_TRANS_DC_DATA   (1U << 0)   // Drive DC high (data) for this transaction
+#define LCD_TRANS_FLUSH     (1U << 1)   // Last transaction of a flush
+
+#define LCD_TRANS_USER(flags)   ((void *)(uintptr_t)(flags))
+
+// Transaction chain for one flush: CASET, x0/x1, RASET, y0/y1, RAMWR, pixels
+#define LCD_FLUSH_TRANS_COUNT   6
+
+// Chain queued by the last flush. LVGL renders into the other buffer while
+// this one streams out; the post-transfer callback marks the flush as done.
+static spi_transaction_t s_flush_trans[LCD_FLUSH_TRANS_COUNT];
+static uint8_t s_trans_in_flight = 0;
+
+METRIC_COUNTER_DEFINE(s_spi_transactions, "display.spi_transactions", "trans");
+
 // ST7789 Commands
 #define ST7789_SWRESET     0x01
+#define ST7789_SLPIN       0x10
 #define ST7789_SLPOUT      0x11
 #define ST7789_COLMOD      0x3A
 #define ST7789_MADCTL      0x36
@@ -50,62 +69,89 @@ static const uint8_t st7789_init_sequence[] = {
 
 static void lcd_cmd(uint8_t cmd)
 {
-    gpio_set_level(TEMBED_LCD_DC, 0); // Command mode
-    
     spi_transaction_t trans = {
         .length = 8,
         .tx_data = {cmd, 0, 0, 0},
-        .flags = SPI_TRANS_USE_TXDATA
+        .flags = SPI_TRANS_USE_TXDATA,
+        .user = LCD_TRANS_USER(0)
     };
     
     spi_device_transmit(s_spi_device, &trans);
 }
 
-static void lcd_data(uint8_t data)
+static void lcd_data(const uint8_t *data, size_t len)
 {
-    gpio_set_level(TEMBED_LCD_DC, 1); // Data mode
+    if (len == 0) return;
     
     spi_transaction_t trans = {
-        .length = 8,
-        .tx_data = {data, 0, 0, 0},
-        .flags = SPI_TRANS_USE_TXDATA
+        .length = len * 8,
+        .tx_buffer = data,
+        .user = LCD_TRANS_USER(LCD_TRANS_DC_DATA)
     };
     
     spi_device_transmit(s_spi_device, &trans);
 }
 
-static void lcd_data_buf(const uint8_t *data, size_t len)
+static void lcd_wait_trans_done(void)
 {
-    if (len == 0) return;
-    
-    gpio_set_level(TEMBED_LCD_DC, 1); // Data mode
-    
-    spi_transaction_t trans = {
-        .length = len * 8,
-        .tx_buffer = data
-    };
-    
-    spi_device_transmit(s_spi_device, &trans);
+    // Collect finished transactions so their queue slots are released before
+    // the bus is used again
+    while (s_trans_in_flight > 0) {
+        spi_transaction_t *done = NULL;
+        spi_device_get_trans_result(s_spi_device, &done, portMAX_DELAY);
+        s_trans_in_flight--;
+    }
+}
+
+static void lcd_set_cmd_trans(spi_transaction_t *trans, uint8_t cmd)
+{
+    trans->length = 8;
+    trans->flags = SPI_TRANS_USE_TXDATA;
+    trans->tx_data[0] = cmd;
+    trans->user = LCD_TRANS_USER(0);
+}
+
+static void lcd_set_range_trans(spi_transaction_t *trans, uint16_t start, uint16_t end)
+{
+    trans->length = 32;
+    trans->flags = SPI_TRANS_USE_TXDATA;
+    trans->tx_data[0] = start >> 8;
+    trans->tx_data[1] = start & 0xFF;
+    trans->tx_data[2] = end >> 8;
+    trans->tx_data[3] = end & 0xFF;
+    trans->user = LCD_TRANS_USER(LCD_TRANS_DC_DATA);
 }
 
-static void lcd_set_addr_window(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1)
+static void lcd_queue_flush(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1,
+                            const uint8_t *pixels, size_t len)
 {
-    // Column address set
-    lcd_cmd(ST7789_CASET);
-    lcd_data(x0 >> 8);
-    lcd_data(x0 & 0xFF);
-    lcd_data(x1 >> 8);
-    lcd_data(x1 & 0xFF);
-    
-    // Row address set
-    lcd_cmd(ST7789_RASET);
-    lcd_data(y0 >> 8);
-    lcd_data(y0 & 0xFF);
-    lcd_data(y1 >> 8);
-    lcd_data(y1 & 0xFF);
-    
-    // Memory write
-    lcd_cmd(ST7789_RAMWR);
+    spi_transaction_t *trans = s_flush_trans;
+    memset(s_flush_trans, 0, sizeof(s_flush_trans));
+    
+    // Address window: each command byte and its 4-byte parameter block is
+    // one transaction, DC is switched in the pre-transfer callback
+    lcd_set_cmd_trans(&trans[0], ST7789_CASET);
+    lcd_set_range_trans(&trans[1], x0, x1);
+    lcd_set_cmd_trans(&trans[2], ST7789_RASET);
+    lcd_set_range_trans(&trans[3], y0, y1);
+    lcd_set_cmd_trans(&trans[4], ST7789_RAMWR);
+    
+    // Pixel push
+    trans[5].length = len * 8;
+    trans[5].tx_buffer = pixels;
+    trans[5].user = LCD_TRANS_USER(LCD_TRANS_DC_DATA | LCD_TRANS_FLUSH);
+    
+    for (int i = 0; i < LCD_FLUSH_TRANS_COUNT; i++) {
+        if (spi_device_queue_trans(s_spi_device, &trans[i], portMAX_DELAY) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to queue flush transaction %d", i);
+            lcd_wait_trans_done();
+            lvgl_latency_flush_done();
+            lv_disp_flush_ready(&s_disp_drv);
+            return;
+        }
+        s_trans_in_flight++;
+        metric_inc(&s_spi_transactions);
+    }
 }
 
 static void lcd_init(void)
@@ -125,9 +171,8 @@ static void lcd_init(void)
         uint8_t argc = *cmd++;
         
         lcd_cmd(command);
-        for (int i = 0; i < argc; i++) {
-            lcd_data(*cmd++);
-        }
+        lcd_data(cmd, argc);
+        cmd += argc;
         
         // Some commands need delay
         if (command == ST7789_SWRESET || command == ST7789_SLPOUT) {
@@ -138,6 +183,33 @@ static void lcd_init(void)
     ESP_LOGI(TAG, "LCD initialized");
 }
 
+void IRAM_ATTR display_driver_spi_pre_cb(spi_transaction_t *trans)
+{
+    uint32_t flags = (uint32_t)(uintptr_t)trans->user;
+    gpio_set_level(TEMBED_LCD_DC, (flags & LCD_TRANS_DC_DATA) ? 1 : 0);
+}
+
+void IRAM_ATTR display_driver_spi_post_cb(spi_transaction_t *trans)
+{
+    // Runs in ISR context once a transaction has left the bus
+    uint32_t flags = (uint32_t)(uintptr_t)trans->user;
+    if (flags & LCD_TRANS_FLUSH) {
+        TRACE(TRACE_UI_FLUSH_DONE, 0, 0);
+        lvgl_latency_flush_done();
+        lv_disp_flush_ready(&s_disp_drv);
+    }
+}
+
+static void disp_rounder_cb(lv_disp_drv_t *disp_drv, lv_area_t *area)
+{
+    bool swapped = disp_drv->rotated == LV_DISP_ROT_90 || disp_drv->rotated == LV_DISP_ROT_270;
+    lv_coord_t max_x = (swapped ? disp_drv->ver_res : disp_drv->hor_res) - 1;
+    lv_coord_t max_y = (swapped ? disp_drv->hor_res : disp_drv->ver_res) - 1;
+    
+    lvgl_dirty_align(area, max_x, max_y);
+    lvgl_latency_invalidate();
+}
+
 static void disp_flush_cb(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p)
 {
     int32_t x1 = area->x1;
@@ -145,17 +217,35 @@ static void disp_flush_cb(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_col
     int32_t y1 = area->y1;
     int32_t y2 = area->y2;
     
-    // Set address window
-    lcd_set_addr_window(x1, y1, x2, y2);
+    // LVGL only calls us once the previous flush is ready, so this just
+    // reaps the completed chain before its descriptors are reused
+    lcd_wait_trans_done();
     
     // Calculate data size
     size_t size = (x2 - x1 + 1) * (y2 - y1 + 1) * 2; // 2 bytes per pixel (RGB565)
+    lvgl_dirty_account_flush(size / 2);
+    lvgl_screen_cache_account_flush(area, color_p);
+    lvgl_latency_flush_start(disp_drv);
+    TRACE(TRACE_UI_FLUSH_START, size / 2, 0);
+    
+    // Queue window setup and pixel data as one pipeline; flush-ready is
+    // signalled from display_driver_spi_post_cb
+    lcd_queue_flush(x1, y1, x2, y2, (const uint8_t*)color_p, size);
+}
+
+void display_driver_set_sleep(bool sleep)
+{
+    if (!s_spi_device) {
+        return;
+    }
     
-    // Send pixel data
-    lcd_data_buf((uint8_t*)color_p, size);
+    // The command shares the bus with queued pixel transfers
+    lcd_wait_trans_done();
+    lcd_cmd(sleep ? ST7789_SLPIN : ST7789_SLPOUT);
     
-    // Inform LVGL that flushing is done
-    lv_disp_flush_ready(disp_drv);
+    // Frame memory survives sleep; the panel needs 5 ms before the next
+    // command either way
+    vTaskDelay(pdMS_TO_TICKS(5));
 }
 
 esp_err_t display_driver_init(lv_disp_t **disp)
@@ -180,7 +270,7 @@ esp_err_t display_driver_init(lv_disp_t **disp)
     lcd_init();
     
     // Allocate display buffers
-    size_t buf_size = LCD_WIDTH * LCD_HEIGHT / 10; // 1/10 of screen size
+    size_t buf_size = LCD_DRAW_BUF_PIXELS;
     
     s_buf1 = heap_caps_malloc(buf_size * sizeof(lv_color_t), MALLOC_CAP_DMA);
     if (!s_buf1) {
@@ -203,6 +293,7 @@ esp_err_t display_driver_init(lv_disp_t **disp)
     s_disp_drv.hor_res = LCD_WIDTH;
     s_disp_drv.ver_res = LCD_HEIGHT;
     s_disp_drv.flush_cb = disp_flush_cb;
+    s_disp_drv.rounder_cb = disp_rounder_cb;
     s_disp_drv.draw_buf = &s_disp_buf;
     s_disp_drv.rotated = LCD_ROTATION;
     
@@ -221,6 +312,11 @@ void display_driver_deinit(void)
 {
     ESP_LOGI(TAG, "Deinitializing display driver");
     
+    // Make sure DMA is no longer reading from the buffers
+    if (s_spi_device) {
+        lcd_wait_trans_done();
+    }
+    
     // Free buffers
     if (s_buf1) {
         free(s_buf1);
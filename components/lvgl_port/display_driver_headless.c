@@ -0,0 +1,349 @@
+/**
+ * @file display_driver_headless.c
+ * @brief In-memory RGB565 display backend for host (linux target) builds
+ *
+ * Replaces display_driver.c when there is no ST7789 on the bus. LVGL flushes
+ * into a framebuffer in RAM, and every frame rendered through
+ * lvgl_headless_render_frame() is timed so UI changes can be benchmarked
+ * without hardware.
+ */
+
+#include "lvgl_port.h"
+#include "trace.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const char *TAG = "DISP_HEADLESS";
+
+static lv_disp_draw_buf_t s_disp_buf;
+static lv_color_t *s_buf1 = NULL;
+static lv_color_t *s_buf2 = NULL;
+static lv_disp_drv_t s_disp_drv;
+static lv_disp_t *s_disp = NULL;
+
+static uint16_t *s_framebuffer = NULL;
+static lv_coord_t s_fb_width = 0;
+static lv_coord_t s_fb_height = 0;
+
+// Accumulated by the flush callback while a frame is being rendered
+static uint32_t s_frame_px = 0;
+static uint16_t s_frame_flushes = 0;
+static uint32_t s_frame_count = 0;
+static char s_dump_dir[128] = {0};
+static bool s_panel_asleep = false;
+
+void display_driver_deinit(void);
+extern void input_driver_step(void);
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static void disp_rounder_cb(lv_disp_drv_t *disp_drv, lv_area_t *area)
+{
+    // Same alignment as the ST7789 driver so flushed areas match hardware
+    lvgl_dirty_align(area, s_fb_width - 1, s_fb_height - 1);
+    lvgl_latency_invalidate();
+}
+
+static void disp_flush_cb(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    lv_coord_t w = area->x2 - area->x1 + 1;
+
+    lvgl_screen_cache_account_flush(area, color_p);
+    lvgl_latency_flush_start(disp_drv);
+    TRACE(TRACE_UI_FLUSH_START, (uint32_t)w * (area->y2 - area->y1 + 1), 0);
+
+    for (lv_coord_t y = area->y1; y <= area->y2; y++) {
+        uint16_t *dst = &s_framebuffer[y * s_fb_width + area->x1];
+        for (lv_coord_t x = 0; x < w; x++) {
+            dst[x] = color_p->full;
+            color_p++;
+        }
+    }
+
+    uint32_t px = (uint32_t)w * (area->y2 - area->y1 + 1);
+    s_frame_px += px;
+    s_frame_flushes++;
+    lvgl_dirty_account_flush(px);
+
+    TRACE(TRACE_UI_FLUSH_DONE, 0, 0);
+    lvgl_latency_flush_done();
+    lv_disp_flush_ready(disp_drv);
+}
+
+esp_err_t display_driver_init(lv_disp_t **disp)
+{
+    if (!disp) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ESP_LOGI(TAG, "Initializing headless display driver");
+
+    // Same draw buffer geometry as the hardware driver
+    size_t buf_size = LCD_DRAW_BUF_PIXELS;
+    s_buf1 = malloc(buf_size * sizeof(lv_color_t));
+    s_buf2 = malloc(buf_size * sizeof(lv_color_t));
+    s_framebuffer = calloc(LCD_WIDTH * LCD_HEIGHT, sizeof(uint16_t));
+    if (!s_buf1 || !s_buf2 || !s_framebuffer) {
+        ESP_LOGE(TAG, "Failed to allocate framebuffer");
+        display_driver_deinit();
+        return ESP_ERR_NO_MEM;
+    }
+
+    lv_disp_draw_buf_init(&s_disp_buf, s_buf1, s_buf2, buf_size);
+
+    lv_disp_drv_init(&s_disp_drv);
+    s_disp_drv.hor_res = LCD_WIDTH;
+    s_disp_drv.ver_res = LCD_HEIGHT;
+    s_disp_drv.flush_cb = disp_flush_cb;
+    s_disp_drv.rounder_cb = disp_rounder_cb;
+    s_disp_drv.draw_buf = &s_disp_buf;
+    s_disp_drv.rotated = LCD_ROTATION;
+
+    // The panel rotates in hardware, so LVGL works in rotated coordinates
+    bool swapped = LCD_ROTATION == LV_DISP_ROT_90 || LCD_ROTATION == LV_DISP_ROT_270;
+    s_fb_width = swapped ? LCD_HEIGHT : LCD_WIDTH;
+    s_fb_height = swapped ? LCD_WIDTH : LCD_HEIGHT;
+
+    s_disp = lv_disp_drv_register(&s_disp_drv);
+    if (!s_disp) {
+        ESP_LOGE(TAG, "Failed to register display driver");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_frame_count = 0;
+    *disp = s_disp;
+
+    ESP_LOGI(TAG, "Headless display %dx%d ready", s_fb_width, s_fb_height);
+    return ESP_OK;
+}
+
+void display_driver_deinit(void)
+{
+    free(s_buf1);
+    free(s_buf2);
+    free(s_framebuffer);
+    s_buf1 = NULL;
+    s_buf2 = NULL;
+    s_framebuffer = NULL;
+    s_disp = NULL;
+}
+
+void display_driver_set_sleep(bool sleep)
+{
+    s_panel_asleep = sleep;
+}
+
+bool lvgl_headless_panel_asleep(void)
+{
+    return s_panel_asleep;
+}
+
+const uint16_t* lvgl_headless_get_framebuffer(lv_coord_t *width, lv_coord_t *height)
+{
+    if (width) *width = s_fb_width;
+    if (height) *height = s_fb_height;
+    return s_framebuffer;
+}
+
+void lvgl_headless_set_dump_dir(const char *dir)
+{
+    if (dir) {
+        snprintf(s_dump_dir, sizeof(s_dump_dir), "%s", dir);
+    } else {
+        s_dump_dir[0] = '\0';
+    }
+}
+
+esp_err_t lvgl_headless_render_frame(uint32_t elapsed_ms, lvgl_headless_frame_t *frame)
+{
+    if (!s_disp) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_frame_px = 0;
+    s_frame_flushes = 0;
+
+    // Advance LVGL time deterministically, run timers/input, then force the
+    // refresh so the measured time covers layout, drawing and flushing
+    uint64_t start = now_us();
+    lvgl_port_lock();
+    lv_tick_inc(elapsed_ms);
+    lvgl_frame_profile_t profile = lvgl_port_get_screen_frame_profile(lv_scr_act());
+    lvgl_power_step(lv_tick_get(), profile == LVGL_FRAME_PROFILE_SPECTRUM);
+    lvgl_latency_collect();
+    if (lvgl_port_get_power_state() == LVGL_POWER_SLEEP) {
+        // Rendering is stopped; only input is still polled so it can wake us
+        lv_indev_read_timer_cb(lvgl_port_get_input_device()->driver->read_timer);
+        lvgl_port_unlock();
+        input_driver_step();
+        if (frame) {
+            memset(frame, 0, sizeof(*frame));
+            frame->frame = s_frame_count;
+        }
+        return ESP_OK;
+    }
+    lvgl_port_apply_commands();
+    lvgl_dirty_merge_display(s_disp);
+    lv_timer_handler();
+    lvgl_preload_run(LVGL_PRELOAD_BUDGET_US);
+    lv_refr_now(s_disp);
+    // Flushes complete synchronously here, so their traces can close now
+    lvgl_latency_collect();
+    lvgl_port_unlock();
+    uint64_t end = now_us();
+    input_driver_step();
+
+    s_frame_count++;
+    lvgl_frame_account(start, (uint32_t)(end - start), s_frame_px > 0, profile);
+
+    if (frame) {
+        frame->frame = s_frame_count;
+        frame->render_us = (uint32_t)(end - start);
+        frame->flushed_px = s_frame_px;
+        frame->flush_count = s_frame_flushes;
+    }
+
+    if (s_dump_dir[0] && s_frame_px > 0) {
+        char path[192];
+        snprintf(path, sizeof(path), "%s/frame_%05u.png", s_dump_dir, s_frame_count);
+        lvgl_headless_dump_png(path);
+    }
+
+    return ESP_OK;
+}
+
+// Minimal PNG writer: 8-bit RGB, zlib stream of stored (uncompressed) blocks
+
+static uint32_t png_crc(uint32_t crc, const uint8_t *data, size_t len)
+{
+    static uint32_t table[256];
+    if (!table[1]) {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320U ^ (c >> 1) : c >> 1;
+            }
+            table[n] = c;
+        }
+    }
+
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void put_be32(uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static void png_write_chunk(FILE *f, const char *type, const uint8_t *data, uint32_t len)
+{
+    uint8_t hdr[8];
+    put_be32(hdr, len);
+    memcpy(hdr + 4, type, 4);
+    fwrite(hdr, 1, 8, f);
+    if (len) {
+        fwrite(data, 1, len, f);
+    }
+
+    uint32_t crc = png_crc(0, hdr + 4, 4);
+    crc = png_crc(crc, data, len);
+    uint8_t crc_be[4];
+    put_be32(crc_be, crc);
+    fwrite(crc_be, 1, 4, f);
+}
+
+esp_err_t lvgl_headless_dump_png(const char *path)
+{
+    if (!s_framebuffer || !path) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Raw scanlines: filter byte + RGB888 per pixel
+    size_t row_len = 1 + (size_t)s_fb_width * 3;
+    size_t raw_len = row_len * s_fb_height;
+    size_t blocks = (raw_len + 65534) / 65535;
+    size_t z_len = 2 + raw_len + blocks * 5 + 4;
+
+    uint8_t *raw = malloc(raw_len);
+    uint8_t *z = malloc(z_len);
+    if (!raw || !z) {
+        free(raw);
+        free(z);
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint8_t *r = raw;
+    for (lv_coord_t y = 0; y < s_fb_height; y++) {
+        *r++ = 0;
+        for (lv_coord_t x = 0; x < s_fb_width; x++) {
+            uint16_t c = s_framebuffer[y * s_fb_width + x];
+            *r++ = ((c >> 11) & 0x1F) * 255 / 31;
+            *r++ = ((c >> 5) & 0x3F) * 255 / 63;
+            *r++ = (c & 0x1F) * 255 / 31;
+        }
+    }
+
+    uint8_t *zp = z;
+    *zp++ = 0x78;
+    *zp++ = 0x01;
+    uint32_t a = 1, b = 0;
+    for (size_t off = 0; off < raw_len; off += 65535) {
+        uint16_t n = (raw_len - off) > 65535 ? 65535 : (uint16_t)(raw_len - off);
+        *zp++ = (off + n == raw_len) ? 1 : 0;
+        *zp++ = n & 0xFF;
+        *zp++ = n >> 8;
+        *zp++ = ~n & 0xFF;
+        *zp++ = (~n >> 8) & 0xFF;
+        memcpy(zp, raw + off, n);
+        zp += n;
+        for (size_t i = 0; i < n; i++) {
+            a = (a + raw[off + i]) % 65521;
+            b = (b + a) % 65521;
+        }
+    }
+    put_be32(zp, (b << 16) | a);
+    zp += 4;
+
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        free(raw);
+        free(z);
+        ESP_LOGE(TAG, "Failed to open %s", path);
+        return ESP_FAIL;
+    }
+
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    fwrite(signature, 1, sizeof(signature), f);
+
+    uint8_t ihdr[13];
+    put_be32(ihdr, s_fb_width);
+    put_be32(ihdr + 4, s_fb_height);
+    ihdr[8] = 8;    // Bit depth
+    ihdr[9] = 2;    // Truecolor
+    ihdr[10] = 0;
+    ihdr[11] = 0;
+    ihdr[12] = 0;
+    png_write_chunk(f, "IHDR", ihdr, sizeof(ihdr));
+    png_write_chunk(f, "IDAT", z, (uint32_t)(zp - z));
+    png_write_chunk(f, "IEND", NULL, 0);
+
+    fclose(f);
+    free(raw);
+    free(z);
+    return ESP_OK;
+}
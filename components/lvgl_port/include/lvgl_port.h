@@ -6,9 +6,19 @@
 #ifndef LVGL_PORT_H
 #define LVGL_PORT_H
 
+#include "sdkconfig.h"
 #include "esp_err.h"
 #include "lvgl.h"
 
+// Host (linux target) builds swap the ST7789/GPIO drivers for an in-memory
+// framebuffer and scripted input
+#if CONFIG_IDF_TARGET_LINUX
+#define LVGL_PORT_HEADLESS  1
+#else
+#define LVGL_PORT_HEADLESS  0
+#include "driver/spi_master.h"
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -18,6 +28,10 @@ extern "C" {
 #define LCD_HEIGHT      320
 #define LCD_ROTATION    LV_DISP_ROT_90
 
+// Each of the two DMA draw buffers holds 1/10 of the screen
+#define LCD_DRAW_BUF_PIXELS     (LCD_WIDTH * LCD_HEIGHT / 10)
+#define LCD_DRAW_BUF_BYTES      (LCD_DRAW_BUF_PIXELS * 2)
+
 // Input configuration
 typedef enum {
     INPUT_TYPE_ENCODER,
@@ -28,16 +42,295 @@ typedef enum {
     INPUT_EVENT_PRESS,
     INPUT_EVENT_RELEASE,
     INPUT_EVENT_ENCODER_CW,
-    INPUT_EVENT_ENCODER_CCW
+    INPUT_EVENT_ENCODER_CCW,
+    INPUT_EVENT_CLICK,          // Released, no second click followed
+    INPUT_EVENT_DOUBLE_CLICK,
+    INPUT_EVENT_LONG_PRESS,     // Held for INPUT_LONG_PRESS_MS
+    INPUT_EVENT_REPEAT,         // Still held after a long press
+    INPUT_EVENT_CHORD           // Keys pressed together; key_id is a key bit mask
 } input_event_t;
 
 typedef struct {
     input_type_t type;
     input_event_t event;
     uint8_t key_id;
-    uint32_t timestamp;
+    uint32_t timestamp;     // Milliseconds
+    uint32_t time_us;       // Edge time, microseconds (wraps)
+    int16_t delta;          // Encoder: accelerated signed steps
+    uint16_t count;         // Encoder: detents folded into this event
+    uint16_t id;            // Assigned by the event ring, tags latency traces
 } input_data_t;
 
+// Input event ring: written by the encoder ISR and the button state
+// machine, read through one cursor per consumer
+#define INPUT_RING_LEN      128     // Events, power of two
+
+typedef enum {
+    INPUT_READER_LVGL,      // LVGL keypad device
+    INPUT_READER_APP,       // Registered input callback
+    INPUT_READER_MAX
+} input_reader_t;
+
+// Quadrature decoder state
+typedef struct {
+    uint8_t state;          // Last A/B levels, A in bit 1
+    int8_t count;           // Quarter steps since the last detent
+} input_quad_t;
+
+// Encoder acceleration: the multiplier ramps from 1 at the slow step
+// spacing to the maximum at the fast one
+#define INPUT_ACCEL_SLOW_US     50000   // 20 detents/s and slower: 1:1
+#define INPUT_ACCEL_FAST_US     8000    // 125 detents/s
+#define INPUT_ACCEL_MAX         10
+#define INPUT_DISPATCH_MS       (1000 / LVGL_FRAME_FPS_APP)     // App events at most once per frame
+
+typedef struct {
+    uint32_t last_us;       // Time of the previous step
+    uint32_t avg_us;        // Smoothed step spacing
+    int8_t dir;             // Direction of the previous step
+} input_accel_t;
+
+// Buttons: key 0 is the encoder key, 1 and 2 the side buttons
+#define INPUT_BUTTON_COUNT          3
+#define INPUT_DEBOUNCE_MS           15      // Level must hold this long to count
+#define INPUT_CHORD_MS              80      // Presses this close together form a chord
+#define INPUT_DOUBLE_CLICK_MS       300     // Second click within this of the first release
+#define INPUT_LONG_PRESS_MS         600
+#define INPUT_REPEAT_MS             150
+#define INPUT_BUTTONS_NO_DEADLINE   UINT32_MAX
+
+// The input task runs next to the RF service, off the UI/JS core
+#define INPUT_TASK_CORE             0
+
+typedef struct {
+    uint32_t events;                // Events written to the ring
+    uint32_t dropped;               // Lost because a reader fell a full ring behind
+    uint32_t invalid_transitions;   // Encoder edges that skipped a state
+    uint32_t max_depth;             // Deepest backlog of the slowest reader
+    uint32_t pending_lvgl;
+    uint32_t pending_app;
+    uint32_t app_events;            // Callbacks made after coalescing
+    uint32_t encoder_steps;         // Detents delivered to the app path
+    uint32_t max_coalesced;         // Most detents folded into one event
+    uint32_t button_edges;          // Raw edges seen by the button ISR
+    uint32_t bounces_filtered;      // Edges that never held for the debounce time
+} lvgl_input_stats_t;
+
+// Input-to-photon latency tracing
+typedef enum {
+    LVGL_LATENCY_ISR,               // Encoder detent or raw button edge
+    LVGL_LATENCY_DISPATCH,          // First reader took the event from the ring
+    LVGL_LATENCY_HANDLER_ENTER,     // App (JS) handler called
+    LVGL_LATENCY_HANDLER_EXIT,
+    LVGL_LATENCY_INVALIDATE,        // First invalidation after dispatch
+    LVGL_LATENCY_FLUSH_DONE,        // Last area of that refresh left the bus
+    LVGL_LATENCY_STAGE_MAX
+} lvgl_latency_stage_t;
+
+typedef enum {
+    LVGL_LATENCY_QUEUE,             // ISR to dispatch, includes debouncing
+    LVGL_LATENCY_HANDLER,           // Handler entry to exit
+    LVGL_LATENCY_UPDATE,            // Dispatch to invalidation
+    LVGL_LATENCY_RENDER,            // Invalidation to flush done
+    LVGL_LATENCY_TOTAL,             // ISR to flush done
+    LVGL_LATENCY_SEGMENT_MAX
+} lvgl_latency_segment_t;
+
+#define LVGL_LATENCY_SLOTS      32      // Events traced at once, power of two
+#define LVGL_LATENCY_EXPIRE_MS  1000    // Events that redraw nothing are dropped after this
+#define LVGL_LATENCY_BUCKETS    24      // Bucket i holds [2^(i-1), 2^i) us, the last is open
+
+typedef struct {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t buckets[LVGL_LATENCY_BUCKETS];
+} lvgl_latency_hist_t;
+
+typedef struct {
+    uint16_t id;
+    input_event_t event;
+    uint32_t us[LVGL_LATENCY_SEGMENT_MAX];      // Segments without both stamps are 0
+} lvgl_latency_record_t;
+
+typedef struct {
+    uint32_t traced;                // Events that started a trace
+    uint32_t completed;             // Traced up to flush done
+    uint32_t expired;               // Nothing was redrawn for them
+    uint32_t untraced;              // All slots busy
+    lvgl_latency_hist_t hist[LVGL_LATENCY_SEGMENT_MAX];
+    lvgl_latency_record_t last;     // Breakdown of the last completed event
+} lvgl_latency_stats_t;
+
+// Dirty-rectangle tracking
+#define LVGL_DIRTY_MAX_RECTS            8       // Areas kept per refresh
+#define LVGL_DIRTY_TILE_SIZE            4       // Alignment grid (power of two)
+#define LVGL_DIRTY_FLUSH_OVERHEAD_PX    128     // Window setup cost in pixels
+
+typedef struct {
+    lv_area_t rects[LVGL_DIRTY_MAX_RECTS];
+    uint8_t count;
+} lvgl_dirty_region_t;
+
+typedef struct {
+    uint32_t flushes;               // Flush callbacks issued
+    uint64_t pixels_pushed;         // Total pixels sent to the panel
+    uint32_t pixels_per_sec;        // Over the last full second, 0 once idle that long
+    uint32_t areas_invalidated;     // Areas LVGL recorded before merging
+    uint32_t areas_flushed;         // Areas left after merging
+    uint32_t updates_skipped;       // Widget updates dropped as unchanged
+} lvgl_refresh_stats_t;
+
+// Headless backend frame record
+typedef struct {
+    uint32_t frame;         // Frame number since init
+    uint32_t render_us;     // Timers, layout, drawing and flushing
+    uint32_t flushed_px;    // Pixels written to the framebuffer
+    uint16_t flush_count;   // Flush callbacks in this frame
+} lvgl_headless_frame_t;
+
+// Headless backend input script step
+typedef struct {
+    uint32_t at_ms;         // Offset from lvgl_headless_play_input()
+    input_type_t type;
+    input_event_t event;
+    uint8_t key_id;
+} lvgl_input_step_t;
+
+// Frame pacing: rate cap per screen type
+typedef enum {
+    LVGL_FRAME_PROFILE_MENU,        // Static lists and menus
+    LVGL_FRAME_PROFILE_APP,         // Default for app screens
+    LVGL_FRAME_PROFILE_SPECTRUM,    // Live spectrum / waterfall views
+    LVGL_FRAME_PROFILE_MAX
+} lvgl_frame_profile_t;
+
+#define LVGL_FRAME_FPS_MENU         15
+#define LVGL_FRAME_FPS_APP          30
+#define LVGL_FRAME_FPS_SPECTRUM     60
+#define LVGL_FRAME_IDLE_MAX_MS      1000    // Longest sleep with no timer pending
+#define LVGL_FRAME_WAIT_FOREVER     UINT32_MAX  // Display asleep: wait for a wake-up
+
+typedef struct {
+    uint32_t frames;            // Frames that flushed pixels
+    uint32_t idle_wakeups;      // Wake-ups with nothing to draw
+    uint32_t last_frame_us;     // Timers, rendering and flushing
+    uint32_t avg_frame_us;
+    uint32_t max_frame_us;
+    uint32_t jitter_us;         // Smoothed lateness against the scheduled wake-up
+    uint32_t missed_deadlines;  // Started half a period late or ran over a period
+    uint64_t slept_ms;          // Time the UI task spent waiting for a frame
+} lvgl_frame_stats_t;
+
+// Display idle manager
+typedef enum {
+    LVGL_POWER_ACTIVE,          // Full brightness, rendering
+    LVGL_POWER_DIMMED,          // Dim backlight, still rendering
+    LVGL_POWER_SLEEP,           // Backlight off, no rendering, panel in SLPIN
+    LVGL_POWER_STATE_MAX
+} lvgl_power_state_t;
+
+typedef enum {
+    LVGL_POWER_WAKE_INPUT = (1 << 0),
+    LVGL_POWER_WAKE_NOTIFICATION = (1 << 1),
+} lvgl_power_source_t;
+
+#define LVGL_POWER_DIM_MS           30000   // Idle time before dimming
+#define LVGL_POWER_SLEEP_MS         60000   // Idle time before the panel sleeps
+#define LVGL_POWER_DIM_LEVEL        24      // Dimmed backlight level
+#define LVGL_POWER_NO_DEADLINE      UINT32_MAX
+
+typedef struct {
+    lvgl_power_state_t state;
+    uint8_t brightness;                         // Backlight level applied now
+    uint64_t time_ms[LVGL_POWER_STATE_MAX];     // Residency per state
+    uint32_t dims;
+    uint32_t sleeps;
+    uint32_t wakes_input;                       // Woken from dim or sleep by input
+    uint32_t wakes_notification;
+} lvgl_power_stats_t;
+
+// UI command queue
+#define LVGL_CMD_QUEUE_LEN      64      // Slots, power of two
+#define LVGL_CMD_TEXT_MAX       128     // Inline text per command, as much as a JS string argument
+
+typedef struct lvgl_ui_cmd lvgl_ui_cmd_t;
+typedef void (*lvgl_ui_cmd_fn_t)(const lvgl_ui_cmd_t *cmd);
+
+// Operation applied by the UI task with LVGL locked
+struct lvgl_ui_cmd {
+    lvgl_ui_cmd_fn_t fn;
+    lv_obj_t *obj;
+    int32_t arg[2];
+    const void *ptr;
+    char text[LVGL_CMD_TEXT_MAX];
+};
+
+typedef struct {
+    uint32_t lock_acquisitions;
+    uint32_t lock_contended;        // Acquisitions that had to wait
+    uint64_t lock_wait_total_us;
+    uint32_t lock_wait_max_us;
+    uint64_t lock_hold_total_us;
+    uint32_t lock_hold_max_us;
+    uint32_t cmds_posted;
+    uint32_t cmds_applied;
+    uint32_t cmds_rejected;         // Posts refused because the queue was full
+    uint32_t cmds_stale;            // Dropped because their object was deleted while queued
+    uint32_t cmd_queue_max_depth;
+} lvgl_lock_stats_t;
+
+// Text-render cache
+#define LVGL_CACHED_LABEL_MAX_CHARS     48
+
+typedef struct {
+    uint32_t glyph_hits;
+    uint32_t glyph_misses;          // Glyphs rasterised to A8
+    uint32_t glyph_evictions;
+    uint32_t glyph_bytes;           // A8 bytes currently cached
+    uint32_t layout_hits;
+    uint32_t layout_misses;         // Strings laid out from scratch
+    uint32_t glyphs_changed;        // Glyph cells invalidated by text updates
+    uint32_t glyphs_unchanged;      // Glyph cells left alone by text updates
+    uint32_t glyphs_drawn;
+    uint32_t glyphs_clipped;        // Skipped because outside the redraw area
+} lvgl_text_cache_stats_t;
+
+// App screen snapshots and launch previews
+#define LVGL_SCREEN_CACHE_SLOTS         4               // Apps with a kept snapshot
+#define LVGL_SCREEN_CACHE_BYTES         (64 * 1024)     // Budget for all snapshots
+#define LVGL_SCREEN_CACHE_MAX_BYTES     (32 * 1024)     // Larger snapshots are dropped
+#define LVGL_SCREEN_CACHE_ID_LEN        32
+#define LVGL_PRELOAD_MAX_JOBS           4
+#define LVGL_PRELOAD_BUDGET_US          4000            // Preload work per frame
+
+// Builds part of an off-screen screen; returns true once it is complete
+typedef bool (*lvgl_preload_step_t)(void *user_data);
+
+typedef struct {
+    uint32_t launches;
+    uint32_t snapshot_hits;         // Launches that showed a cached snapshot
+    uint32_t last_first_pixel_us;   // Launch request to first pixels flushed
+    uint32_t avg_first_pixel_us;
+    uint32_t max_first_pixel_us;
+    uint32_t last_ready_us;         // Launch request to live screen loaded
+    uint32_t avg_ready_us;
+    uint32_t snapshots;
+    uint32_t snapshot_bytes;
+    uint32_t snapshot_evictions;
+    uint32_t captures_failed;       // Too large to keep or out of memory
+    uint32_t preload_steps;
+    uint32_t preload_jobs_done;
+} lvgl_launch_stats_t;
+
+// Spectrum widget views
+typedef enum {
+    LVGL_SPECTRUM_BARS,
+    LVGL_SPECTRUM_LINE,
+    LVGL_SPECTRUM_WATERFALL
+} lvgl_spectrum_mode_t;
+
 // Callback types
 typedef void (*input_callback_t)(const input_data_t *input, void *user_data);
 
@@ -67,12 +360,233 @@ lv_indev_t* lvgl_port_get_input_device(void);
 
 /**
  * @brief Set display brightness (0-255)
+ *
+ * Sets the level used while the display is active; the idle manager dims
+ * and restores around it.
  * @param brightness Brightness level
  */
 void lvgl_port_set_brightness(uint8_t brightness);
 
 /**
- * @brief Register input callback
+ * @brief Report user-visible activity; wakes a dimmed or sleeping display
+ *
+ * Safe to call from any task.
+ * @param source What caused the activity
+ * @return true if the display was asleep
+ */
+bool lvgl_port_power_activity(lvgl_power_source_t source);
+
+/**
+ * @brief Set the idle timeouts
+ * @param dim_ms Idle time before dimming, 0 to never dim
+ * @param sleep_ms Idle time before sleeping, 0 to never sleep
+ */
+void lvgl_port_set_power_timeouts(uint32_t dim_ms, uint32_t sleep_ms);
+
+/**
+ * @brief Get the display power state
+ * @return Current state
+ */
+lvgl_power_state_t lvgl_port_get_power_state(void);
+
+/**
+ * @brief Get display power statistics
+ * @param stats Statistics structure to fill
+ */
+void lvgl_port_get_power_stats(lvgl_power_stats_t *stats);
+
+/**
+ * @brief Reset display power statistics
+ */
+void lvgl_port_reset_power_stats(void);
+
+/**
+ * @brief Restart the idle manager in the active state
+ * @param now_ms Current time
+ */
+void lvgl_power_reset(uint32_t now_ms);
+
+/**
+ * @brief Run the idle state machine (call with LVGL locked, from the UI task)
+ * @param now_ms Current time
+ * @param live_content The active screen shows live data and must not sleep
+ * @return Milliseconds until the next idle transition, LVGL_POWER_NO_DEADLINE if none
+ */
+uint32_t lvgl_power_step(uint32_t now_ms, bool live_content);
+
+/**
+ * @brief Set the active backlight level
+ * @param brightness Brightness level
+ */
+void lvgl_power_set_brightness(uint8_t brightness);
+
+/**
+ * @brief Get input event ring statistics
+ * @param stats Statistics structure to fill
+ */
+void lvgl_port_get_input_stats(lvgl_input_stats_t *stats);
+
+/**
+ * @brief Empty the input event ring and reset its statistics
+ */
+void input_events_reset(void);
+
+/**
+ * @brief Start decoding from the current channel levels
+ * @param quad Decoder state
+ * @param a Channel A level
+ * @param b Channel B level
+ */
+void input_quad_init(input_quad_t *quad, uint8_t a, uint8_t b);
+
+/**
+ * @brief Feed the channel levels after an edge on either channel
+ * @param quad Decoder state
+ * @param a Channel A level
+ * @param b Channel B level
+ * @return +1 for a clockwise detent, -1 for counter-clockwise, 0 otherwise
+ */
+int input_quad_update(input_quad_t *quad, uint8_t a, uint8_t b);
+
+/**
+ * @brief Restart the button state machines with every key released
+ * @param now_ms Current time
+ */
+void input_buttons_reset(uint32_t now_ms);
+
+/**
+ * @brief Record a raw button edge (ISR-safe, no debouncing here)
+ * @param key Key index below INPUT_BUTTON_COUNT
+ * @param pressed Level after the edge
+ * @param now_ms Edge time
+ */
+void input_buttons_raw(uint8_t key, bool pressed, uint32_t now_ms);
+
+/**
+ * @brief Advance the button state machines and push the events that are due
+ *
+ * Call from one task after raw edges and whenever the returned deadline
+ * expires.
+ * @param now_ms Current time
+ * @return Milliseconds until the next deadline, INPUT_BUTTONS_NO_DEADLINE if none
+ */
+uint32_t input_buttons_step(uint32_t now_ms);
+
+/**
+ * @brief Fill the button fields of the input statistics
+ * @param stats Statistics structure
+ */
+void input_buttons_get_stats(lvgl_input_stats_t *stats);
+
+/**
+ * @brief Append an event (any task or ISR)
+ * @param event Event to copy
+ * @return false if the slowest reader is a full ring behind and the event was dropped
+ */
+bool input_events_push(const input_data_t *event);
+
+/**
+ * @brief Take the next event for one reader
+ * @param reader Reader cursor to advance
+ * @param event Event to fill
+ * @return true if an event was taken
+ */
+bool input_events_pop(input_reader_t reader, input_data_t *event);
+
+/**
+ * @brief Get the number of events a reader has not taken yet
+ * @param reader Reader cursor
+ * @return Pending events
+ */
+uint32_t input_events_pending(input_reader_t reader);
+
+/**
+ * @brief Scale one encoder step by the current spin speed
+ * @param accel Acceleration state
+ * @param dir +1 or -1
+ * @param time_us Step time
+ * @return Signed step count to apply
+ */
+int input_accel_apply(input_accel_t *accel, int dir, uint32_t time_us);
+
+/**
+ * @brief Deliver the app cursor to a callback
+ *
+ * Consecutive steps in one direction are accelerated and folded into a
+ * single event carrying the summed delta and the detent count; buttons
+ * are passed through in order.
+ * @param callback Callback, may be NULL to discard
+ * @param user_data Passed to the callback
+ * @return Number of events delivered
+ */
+uint32_t input_events_dispatch(input_callback_t callback, void *user_data);
+
+/**
+ * @brief Start tracing an event taken from the ring (first reader wins)
+ * @param event Event just popped
+ */
+void lvgl_latency_begin(const input_data_t *event);
+
+/**
+ * @brief Stamp a stage of a traced event
+ * @param id Event id
+ * @param stage Stage reached
+ */
+void lvgl_latency_mark(uint16_t id, lvgl_latency_stage_t stage);
+
+/**
+ * @brief Stamp invalidation for dispatched events (LVGL locked, from the rounder)
+ */
+void lvgl_latency_invalidate(void);
+
+/**
+ * @brief Note a flush being started (LVGL locked, from flush_cb)
+ * @param disp_drv Display driver being flushed
+ */
+void lvgl_latency_flush_start(lv_disp_drv_t *disp_drv);
+
+/**
+ * @brief Note a flush leaving the bus (ISR-safe, next to lv_disp_flush_ready)
+ */
+void lvgl_latency_flush_done(void);
+
+/**
+ * @brief Record completed traces and drop expired ones (UI task, LVGL locked)
+ */
+void lvgl_latency_collect(void);
+
+/**
+ * @brief Get input-to-photon latency statistics
+ * @param stats Statistics structure to fill
+ */
+void lvgl_port_get_latency_stats(lvgl_latency_stats_t *stats);
+
+/**
+ * @brief Drop traces in flight and clear the latency statistics
+ */
+void lvgl_port_reset_latency_stats(void);
+
+/**
+ * @brief Upper bound of the bucket holding a percentile
+ * @param hist Histogram
+ * @param percent 0-100
+ * @return Latency in microseconds, 0 if the histogram is empty
+ */
+uint32_t lvgl_latency_percentile(const lvgl_latency_hist_t *hist, uint8_t percent);
+
+/**
+ * @brief Log the latency histograms, one line per segment
+ */
+void lvgl_port_log_latency_report(void);
+
+/**
+ * @brief Fill an LVGL keypad read from the LVGL cursor
+ * @param data Read data to fill
+ */
+void input_events_lvgl_read(lv_indev_data_t *data);
+
+/**
+ * @brief Register input callback (single subscriber; see EVENT_INPUT on the event bus)
  * @param callback Callback function
  * @param user_data User data
  */
@@ -89,9 +603,315 @@ void lvgl_port_lock(void);
 void lvgl_port_unlock(void);
 
 /**
- * @brief Update LVGL (should be called periodically)
+ * @brief Make an object a target for posted commands (with LVGL locked)
+ *
+ * Call once after creating it. When the object is deleted, the commands
+ * still queued for it are dropped before its memory can be reused.
+ * @param obj Object commands will be posted for
+ */
+void lvgl_port_cmd_target(lv_obj_t *obj);
+
+/**
+ * @brief Post an operation for the UI task to apply between frames
+ *
+ * Lock-free and safe from any task. Use it for updates; take the lock only
+ * for rare queries that need a result. A command's object must have been
+ * passed to lvgl_port_cmd_target().
+ * @param cmd Command to copy into the queue
+ * @return ESP_OK, or ESP_ERR_NO_MEM if the queue is full
+ */
+esp_err_t lvgl_port_post(const lvgl_ui_cmd_t *cmd);
+
+/**
+ * @brief Post an operation, making room if the queue is full
+ *
+ * When the queue is full the caller takes the lock and applies the
+ * commands ahead of this one itself, then posts again, so updates are
+ * never reordered or dropped. Call without LVGL locked.
+ * @param cmd Command to copy into the queue
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG
+ */
+esp_err_t lvgl_port_post_ordered(const lvgl_ui_cmd_t *cmd);
+
+/**
+ * @brief Post a label text update (see lvgl_port_set_label_text)
+ *
+ * Posted with lvgl_port_post_ordered(). Call without LVGL locked.
+ * @param label Label object
+ * @param text New text, shorter than LVGL_CMD_TEXT_MAX
+ * @return ESP_OK, ESP_ERR_INVALID_SIZE if the text is too long
  */
-void lvgl_port_task(void);
+esp_err_t lvgl_port_post_label_text(lv_obj_t *label, const char *text);
+
+/**
+ * @brief Apply posted commands (with LVGL locked)
+ *
+ * Commands dropped because their object was deleted are taken from the
+ * queue and counted, but not applied.
+ * @return Number of commands taken from the queue
+ */
+uint32_t lvgl_port_apply_commands(void);
+
+/**
+ * @brief Get LVGL lock and command queue statistics
+ * @param stats Statistics structure to fill
+ */
+void lvgl_port_get_lock_stats(lvgl_lock_stats_t *stats);
+
+/**
+ * @brief Reset LVGL lock and command queue statistics
+ */
+void lvgl_port_reset_lock_stats(void);
+
+/**
+ * @brief Empty the command queue and reset its statistics
+ */
+void lvgl_cmd_reset(void);
+
+/**
+ * @brief Reset command queue statistics only
+ */
+void lvgl_cmd_reset_stats(void);
+
+/**
+ * @brief Queue a command without waking the UI task
+ * @param cmd Command to copy
+ * @return ESP_OK, or ESP_ERR_NO_MEM if the queue is full
+ */
+esp_err_t lvgl_cmd_push(const lvgl_ui_cmd_t *cmd);
+
+/**
+ * @brief Take the oldest command (single consumer)
+ * @param cmd Command to fill
+ * @return true if a command was taken
+ */
+bool lvgl_cmd_pop(lvgl_ui_cmd_t *cmd);
+
+/**
+ * @brief Fill the command queue fields of the statistics
+ * @param stats Statistics structure
+ */
+void lvgl_cmd_get_stats(lvgl_lock_stats_t *stats);
+
+/**
+ * @brief Run one paced LVGL frame
+ * @return Milliseconds until the next frame is due
+ */
+uint32_t lvgl_port_task(void);
+
+/**
+ * @brief Sleep until the next frame is due or the UI is woken
+ * @param max_ms Value returned by lvgl_port_task(), LVGL_FRAME_WAIT_FOREVER
+ *               while the display is asleep
+ */
+void lvgl_port_wait_frame(uint32_t max_ms);
+
+/**
+ * @brief Wake the UI task early (input arrived or the screen was invalidated)
+ */
+void lvgl_port_wake(void);
+
+/**
+ * @brief Set the frame rate cap used while a screen is active
+ * @param screen Screen object
+ * @param profile Frame profile
+ */
+void lvgl_port_set_screen_frame_profile(lv_obj_t *screen, lvgl_frame_profile_t profile);
+
+/**
+ * @brief Get the frame profile of a screen
+ * @param screen Screen object
+ * @return Frame profile (LVGL_FRAME_PROFILE_APP if none was set)
+ */
+lvgl_frame_profile_t lvgl_port_get_screen_frame_profile(const lv_obj_t *screen);
+
+/**
+ * @brief Get frame pacing statistics
+ * @param stats Statistics structure to fill
+ */
+void lvgl_port_get_frame_stats(lvgl_frame_stats_t *stats);
+
+/**
+ * @brief Reset frame pacing statistics
+ */
+void lvgl_port_reset_frame_stats(void);
+
+/**
+ * @brief Get the frame period of a profile
+ * @param profile Frame profile
+ * @return Period in milliseconds
+ */
+uint32_t lvgl_frame_period_ms(lvgl_frame_profile_t profile);
+
+/**
+ * @brief Turn LVGL's next timer deadline into a sleep time
+ * @param now_us Current time
+ * @param timer_delay_ms Value returned by lv_timer_handler()
+ * @return Milliseconds to sleep
+ */
+uint32_t lvgl_frame_schedule(uint64_t now_us, uint32_t timer_delay_ms);
+
+/**
+ * @brief Account one wake-up of the UI task
+ * @param start_us Time the frame started
+ * @param frame_us Time spent in the frame
+ * @param rendered Whether the frame flushed any pixels
+ * @param profile Frame profile of the active screen
+ */
+void lvgl_frame_account(uint64_t start_us, uint32_t frame_us, bool rendered,
+                        lvgl_frame_profile_t profile);
+
+/**
+ * @brief Account time the UI task spent asleep
+ * @param slept_ms Milliseconds slept
+ */
+void lvgl_frame_account_sleep(uint32_t slept_ms);
+
+#if LVGL_PORT_HEADLESS
+/**
+ * @brief Advance LVGL time, then render and flush one frame
+ * @param elapsed_ms Milliseconds to add to the LVGL tick first
+ * @param frame Optional frame record to fill
+ * @return ESP_OK on success
+ */
+esp_err_t lvgl_headless_render_frame(uint32_t elapsed_ms, lvgl_headless_frame_t *frame);
+
+/**
+ * @brief Get the RGB565 framebuffer
+ * @param width Framebuffer width (may be NULL)
+ * @param height Framebuffer height (may be NULL)
+ * @return Framebuffer pointer
+ */
+const uint16_t* lvgl_headless_get_framebuffer(lv_coord_t *width, lv_coord_t *height);
+
+/**
+ * @brief Check whether the idle manager has put the panel to sleep
+ * @return true while the panel is in sleep mode
+ */
+bool lvgl_headless_panel_asleep(void);
+
+/**
+ * @brief Write the framebuffer to a PNG file
+ * @param path Output file path
+ * @return ESP_OK on success
+ */
+esp_err_t lvgl_headless_dump_png(const char *path);
+
+/**
+ * @brief Dump a PNG for every frame that flushed pixels
+ * @param dir Output directory, NULL to disable
+ */
+void lvgl_headless_set_dump_dir(const char *dir);
+
+/**
+ * @brief Replay an input script against LVGL time
+ * @param steps Script steps sorted by at_ms
+ * @param count Number of steps
+ * @return ESP_OK on success
+ */
+esp_err_t lvgl_headless_play_input(const lvgl_input_step_t *steps, size_t count);
+
+/**
+ * @brief Check whether the input script has been fully consumed
+ * @return true if all steps were delivered
+ */
+bool lvgl_headless_input_done(void);
+#else
+/**
+ * @brief LCD SPI pre-transfer callback, drives DC (installed by hw_init)
+ * @param trans Transaction about to start
+ */
+void display_driver_spi_pre_cb(spi_transaction_t *trans);
+
+/**
+ * @brief LCD SPI post-transfer callback, signals flush-ready (installed by hw_init)
+ * @param trans Completed transaction
+ */
+void display_driver_spi_post_cb(spi_transaction_t *trans);
+#endif
+
+/**
+ * @brief Snap an area outwards to the dirty tile grid and clip it
+ * @param area Area to align (modified in place)
+ * @param max_x Last visible column
+ * @param max_y Last visible row
+ */
+void lvgl_dirty_align(lv_area_t *area, lv_coord_t max_x, lv_coord_t max_y);
+
+/**
+ * @brief Clear a dirty region
+ * @param region Region to clear
+ */
+void lvgl_dirty_reset(lvgl_dirty_region_t *region);
+
+/**
+ * @brief Add an area, merging it with any rect it is cheaper to flush with
+ * @param region Dirty region
+ * @param area Invalidated area
+ */
+void lvgl_dirty_add(lvgl_dirty_region_t *region, const lv_area_t *area);
+
+/**
+ * @brief Get the number of pixels a region will push
+ * @param region Dirty region
+ * @return Pixel count
+ */
+uint32_t lvgl_dirty_pixels(const lvgl_dirty_region_t *region);
+
+/**
+ * @brief Merge the display's pending invalidations (call with LVGL locked)
+ * @param disp Display
+ */
+void lvgl_dirty_merge_display(lv_disp_t *disp);
+
+/**
+ * @brief Account one flushed area in the refresh statistics
+ * @param pixels Pixels pushed
+ */
+void lvgl_dirty_account_flush(uint32_t pixels);
+
+/**
+ * @brief Account one flushed area for launch timing and snapshot capture
+ * @param area Flushed area
+ * @param color_p Pixels of the area
+ */
+void lvgl_screen_cache_account_flush(const lv_area_t *area, const lv_color_t *color_p);
+
+/**
+ * @brief Run pending preload steps (call with LVGL locked, from the UI task)
+ * @param budget_us Time to spend
+ * @return true if preload work is left for the next frame
+ */
+bool lvgl_preload_run(uint32_t budget_us);
+
+/**
+ * @brief Drop every snapshot and preload job (call with LVGL locked)
+ */
+void lvgl_screen_cache_flush(void);
+
+/**
+ * @brief Account a widget update that was skipped because nothing changed
+ */
+void lvgl_dirty_account_skipped_update(void);
+
+/**
+ * @brief Get partial refresh statistics
+ * @param stats Statistics structure to fill
+ */
+void lvgl_port_get_refresh_stats(lvgl_refresh_stats_t *stats);
+
+/**
+ * @brief Reset partial refresh statistics
+ */
+void lvgl_port_reset_refresh_stats(void);
+
+/**
+ * @brief Set label text, skipping the invalidation if it is unchanged
+ * @param label Label object (call with LVGL locked)
+ * @param text New text
+ * @return true if the label was changed
+ */
+bool lvgl_port_set_label_text(lv_obj_t *label, const char *text);
 
 // Helper functions for UI components
 /**
@@ -136,6 +956,144 @@ void lvgl_port_show_loading(const char *message);
  */
 void lvgl_port_hide_loading(void);
 
+/**
+ * @brief Create a label that renders through the glyph and layout cache
+ *
+ * Meant for readouts updated many times a second: a text change only
+ * redraws the glyph cells that differ. Set its text with
+ * lvgl_port_set_label_text() like a normal label. Text font, colour and
+ * letter spacing come from its style, inherited like a label's.
+ * @param parent Parent object (call with LVGL locked)
+ * @param font Font set as a local style, NULL to inherit one
+ * @return Label object, NULL on failure
+ */
+lv_obj_t* lvgl_create_cached_label(lv_obj_t *parent, const lv_font_t *font);
+
+/**
+ * @brief Check whether an object is a cached label
+ * @param obj Object
+ * @return true for objects from lvgl_create_cached_label()
+ */
+bool lvgl_is_cached_label(lv_obj_t *obj);
+
+/**
+ * @brief Set cached label text
+ * @param obj Cached label (call with LVGL locked)
+ * @param text New text (at most LVGL_CACHED_LABEL_MAX_CHARS glyphs are shown)
+ * @return true if the text changed
+ */
+bool lvgl_cached_label_set_text(lv_obj_t *obj, const char *text);
+
+/**
+ * @brief Get text cache statistics
+ * @param stats Statistics structure to fill
+ */
+void lvgl_port_get_text_cache_stats(lvgl_text_cache_stats_t *stats);
+
+/**
+ * @brief Reset text cache statistics
+ */
+void lvgl_port_reset_text_cache_stats(void);
+
+/**
+ * @brief Drop every cached glyph and layout (call with LVGL locked)
+ */
+void lvgl_text_cache_flush(void);
+
+/**
+ * @brief Snapshot the active screen for the next launch of an app
+ *
+ * Redraws the screen once and keeps it run-length compressed. Call while
+ * the app's screen is still shown, e.g. when it is being closed.
+ * @param app_id App the screen belongs to
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if it compresses too poorly
+ */
+esp_err_t lvgl_port_screen_cache_store(const char *app_id);
+
+/**
+ * @brief Forget an app's snapshot (e.g. after it was updated)
+ * @param app_id App ID
+ */
+void lvgl_port_screen_cache_drop(const char *app_id);
+
+/**
+ * @brief Start timing an app launch and show its snapshot if one is cached
+ * @param app_id App being launched
+ * @return ESP_OK on success
+ */
+esp_err_t lvgl_port_launch_begin(const char *app_id);
+
+/**
+ * @brief Load a screen, replacing the launch preview if one is shown
+ * @param screen Screen built by the app
+ */
+void lvgl_port_load_screen(lv_obj_t *screen);
+
+/**
+ * @brief Give up on a launch and return to the screen it started from
+ */
+void lvgl_port_launch_abort(void);
+
+/**
+ * @brief Queue a screen to be built off-screen on the UI task
+ *
+ * The step is called repeatedly after each frame, sharing
+ * LVGL_PRELOAD_BUDGET_US with other jobs, until it returns true.
+ * @param step Build step, called with LVGL locked
+ * @param user_data Passed to the step
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if all job slots are busy
+ */
+esp_err_t lvgl_port_preload(lvgl_preload_step_t step, void *user_data);
+
+/**
+ * @brief Get launch and snapshot statistics
+ * @param stats Statistics structure to fill
+ */
+void lvgl_port_get_launch_stats(lvgl_launch_stats_t *stats);
+
+/**
+ * @brief Reset launch statistics
+ */
+void lvgl_port_reset_launch_stats(void);
+
+/**
+ * @brief Create a spectrum widget drawing straight from an int8 RSSI buffer
+ * @param parent Parent object (call with LVGL locked)
+ * @param width Width in pixels
+ * @param height Height in pixels
+ * @return Spectrum object, NULL on failure
+ */
+lv_obj_t* lvgl_create_spectrum(lv_obj_t *parent, lv_coord_t width, lv_coord_t height);
+
+/**
+ * @brief Select bar, line or waterfall view (clears the history)
+ * @param spectrum Spectrum object
+ * @param mode View mode
+ */
+void lvgl_spectrum_set_mode(lv_obj_t *spectrum, lvgl_spectrum_mode_t mode);
+
+/**
+ * @brief Set the dBm range mapped onto height and colour
+ * @param spectrum Spectrum object
+ * @param min_dbm Bottom of the scale
+ * @param max_dbm Top of the scale
+ */
+void lvgl_spectrum_set_range(lv_obj_t *spectrum, int8_t min_dbm, int8_t max_dbm);
+
+/**
+ * @brief Attach the RSSI buffer to draw from (not copied, must stay valid)
+ * @param spectrum Spectrum object
+ * @param rssi RSSI samples in dBm, one per bin
+ * @param bins Number of bins
+ */
+void lvgl_spectrum_set_buffer(lv_obj_t *spectrum, const int8_t *rssi, uint16_t bins);
+
+/**
+ * @brief Render the attached buffer; waterfall view adds one row
+ * @param spectrum Spectrum object (call with LVGL locked)
+ */
+void lvgl_spectrum_refresh(lv_obj_t *spectrum);
+
 #ifdef __cplusplus
 }
 #endif
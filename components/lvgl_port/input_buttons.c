@@ -0,0 +1,242 @@
+/**
+ * @file input_buttons.c
+ * @brief Button debounce and gesture recognition
+ *
+ * The button ISR only records the latest raw level of a key and when it
+ * changed. Everything else runs in one task from input_buttons_step(),
+ * which returns the time to its next deadline; the caller sleeps until
+ * then or until the next raw edge, so nothing polls.
+ *
+ * A level counts once it has held for INPUT_DEBOUNCE_MS and is reported
+ * as a press or release. On top of that, each key has a small state
+ * machine for click, double-click, long press and repeat, and keys pressed
+ * within INPUT_CHORD_MS of each other are reported once as a chord and
+ * then produce no clicks or long presses of their own. Time is passed in,
+ * so host tests drive it with a virtual clock.
+ */
+
+#include "lvgl_port.h"
+#include "esp_attr.h"
+#include <stdatomic.h>
+#include <string.h>
+
+// Raw level and edge time share one word so the task never sees a level
+// with the time of a different edge: (ms << 1) | pressed
+#define RAW_PACK(ms, pressed)   (((uint32_t)(ms) << 1) | ((pressed) ? 1u : 0u))
+#define RAW_PRESSED(raw)        ((raw) & 1u)
+#define RAW_AGE_MS(raw, now)    ((((uint32_t)(now) << 1) - ((raw) & ~1u)) >> 1)
+
+#define DUE(deadline, now)      ((int32_t)((now) - (deadline)) >= 0)
+
+typedef struct {
+    bool down;              // Debounced level
+    bool long_fired;        // Long press reported for this hold
+    bool chorded;           // Part of a chord: no clicks or long press
+    uint8_t clicks;         // Releases waiting out the double-click window
+    uint32_t edge_ms;       // Last debounced press or release
+    uint32_t repeat_ms;     // Next repeat while held after a long press
+} key_state_t;
+
+static atomic_uint s_raw[INPUT_BUTTON_COUNT];
+static key_state_t s_keys[INPUT_BUTTON_COUNT];
+
+static bool s_chord_open = false;
+static uint32_t s_chord_start_ms = 0;
+static uint8_t s_chord_mask = 0;            // Keys pressed inside the window
+
+static atomic_uint s_edges;
+static uint32_t s_transitions = 0;
+
+// Presses and releases carry the time of the raw edge, so latency traces
+// include the debounce wait; gestures carry the time they were decided
+static void emit_at(uint8_t key_id, input_event_t event, uint32_t now_ms, uint32_t edge_ms)
+{
+    input_data_t input = {
+        .type = INPUT_TYPE_BUTTON,
+        .event = event,
+        .key_id = key_id,
+        .timestamp = now_ms,
+        .time_us = edge_ms * 1000,
+    };
+    input_events_push(&input);
+}
+
+static void emit(uint8_t key_id, input_event_t event, uint32_t now_ms)
+{
+    emit_at(key_id, event, now_ms, now_ms);
+}
+
+void input_buttons_reset(uint32_t now_ms)
+{
+    for (int i = 0; i < INPUT_BUTTON_COUNT; i++) {
+        atomic_store(&s_raw[i], RAW_PACK(now_ms, false));
+    }
+    memset(s_keys, 0, sizeof(s_keys));
+    s_chord_open = false;
+    s_chord_mask = 0;
+    atomic_store(&s_edges, 0);
+    s_transitions = 0;
+}
+
+void IRAM_ATTR input_buttons_raw(uint8_t key, bool pressed, uint32_t now_ms)
+{
+    if (key >= INPUT_BUTTON_COUNT) {
+        return;
+    }
+    atomic_store_explicit(&s_raw[key], RAW_PACK(now_ms, pressed), memory_order_release);
+    atomic_fetch_add_explicit(&s_edges, 1, memory_order_relaxed);
+}
+
+static void key_pressed(uint8_t key, uint32_t now_ms, uint32_t raw_ms)
+{
+    key_state_t *k = &s_keys[key];
+
+    k->down = true;
+    k->long_fired = false;
+    k->chorded = false;
+    k->edge_ms = now_ms;
+    emit_at(key, INPUT_EVENT_PRESS, now_ms, raw_ms);
+
+    if (!s_chord_open) {
+        s_chord_open = true;
+        s_chord_start_ms = now_ms;
+        s_chord_mask = 0;
+    }
+    s_chord_mask |= (uint8_t)(1u << key);
+}
+
+static void key_released(uint8_t key, uint32_t now_ms, uint32_t raw_ms)
+{
+    key_state_t *k = &s_keys[key];
+
+    k->down = false;
+    k->edge_ms = now_ms;
+    emit_at(key, INPUT_EVENT_RELEASE, now_ms, raw_ms);
+
+    if (k->chorded || k->long_fired) {
+        k->clicks = 0;
+        return;
+    }
+
+    if (++k->clicks == 2) {
+        emit(key, INPUT_EVENT_DOUBLE_CLICK, now_ms);
+        k->clicks = 0;
+    }
+}
+
+// Close the chord window: two or more of its keys still down make a chord
+static void close_chord(uint32_t now_ms)
+{
+    uint8_t held = 0;
+    int count = 0;
+
+    for (uint8_t i = 0; i < INPUT_BUTTON_COUNT; i++) {
+        if ((s_chord_mask & (1u << i)) && s_keys[i].down) {
+            held |= (uint8_t)(1u << i);
+            count++;
+        }
+    }
+
+    if (count >= 2) {
+        for (uint8_t i = 0; i < INPUT_BUTTON_COUNT; i++) {
+            if (held & (1u << i)) {
+                s_keys[i].chorded = true;
+                s_keys[i].clicks = 0;
+            }
+        }
+        emit(held, INPUT_EVENT_CHORD, now_ms);
+    }
+    s_chord_open = false;
+}
+
+static void update_deadline(uint32_t *next, uint32_t deadline_ms, uint32_t now_ms)
+{
+    uint32_t wait = DUE(deadline_ms, now_ms) ? 0 : deadline_ms - now_ms;
+    if (wait < *next) {
+        *next = wait;
+    }
+}
+
+uint32_t input_buttons_step(uint32_t now_ms)
+{
+    uint32_t next = INPUT_BUTTONS_NO_DEADLINE;
+
+    // Debounce first so a chord window sees all the presses of this step
+    for (uint8_t i = 0; i < INPUT_BUTTON_COUNT; i++) {
+        uint32_t raw = atomic_load_explicit(&s_raw[i], memory_order_acquire);
+        bool pressed = RAW_PRESSED(raw);
+
+        if (pressed == s_keys[i].down) {
+            continue;
+        }
+
+        uint32_t age = RAW_AGE_MS(raw, now_ms);
+        if (age < INPUT_DEBOUNCE_MS) {
+            update_deadline(&next, now_ms + INPUT_DEBOUNCE_MS - age, now_ms);
+            continue;
+        }
+
+        s_transitions++;
+        if (pressed) {
+            key_pressed(i, now_ms, now_ms - age);
+        } else {
+            key_released(i, now_ms, now_ms - age);
+        }
+    }
+
+    if (s_chord_open) {
+        if (DUE(s_chord_start_ms + INPUT_CHORD_MS, now_ms)) {
+            close_chord(now_ms);
+        } else {
+            update_deadline(&next, s_chord_start_ms + INPUT_CHORD_MS, now_ms);
+        }
+    }
+
+    for (uint8_t i = 0; i < INPUT_BUTTON_COUNT; i++) {
+        key_state_t *k = &s_keys[i];
+
+        if (k->down && !k->chorded && !k->long_fired) {
+            // An open chord window decides first; its deadline wakes us
+            uint32_t long_ms = k->edge_ms + INPUT_LONG_PRESS_MS;
+            if (!DUE(long_ms, now_ms)) {
+                update_deadline(&next, long_ms, now_ms);
+            } else if (!s_chord_open) {
+                // A click just before the hold is not part of it
+                if (k->clicks) {
+                    emit(i, INPUT_EVENT_CLICK, now_ms);
+                    k->clicks = 0;
+                }
+                emit(i, INPUT_EVENT_LONG_PRESS, now_ms);
+                k->long_fired = true;
+                k->repeat_ms = long_ms + INPUT_REPEAT_MS;
+            }
+        }
+
+        if (k->down && k->long_fired) {
+            if (DUE(k->repeat_ms, now_ms)) {
+                emit(i, INPUT_EVENT_REPEAT, now_ms);
+                k->repeat_ms += INPUT_REPEAT_MS;
+            }
+            update_deadline(&next, k->repeat_ms, now_ms);
+        }
+
+        // One click and the window closed without a second one
+        if (!k->down && k->clicks) {
+            uint32_t click_ms = k->edge_ms + INPUT_DOUBLE_CLICK_MS;
+            if (DUE(click_ms, now_ms)) {
+                emit(i, INPUT_EVENT_CLICK, now_ms);
+                k->clicks = 0;
+            } else {
+                update_deadline(&next, click_ms, now_ms);
+            }
+        }
+    }
+
+    return next;
+}
+
+void input_buttons_get_stats(lvgl_input_stats_t *stats)
+{
+    stats->button_edges = atomic_load(&s_edges);
+    stats->bounces_filtered = stats->button_edges - s_transitions;
+}
@@ -8,7 +8,7 @@
 #include "driver/gpio.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
+#include "esp_timer.h"
 
 static const char *TAG = "INPUT_DRV";
 
@@ -20,121 +20,104 @@ extern const int TEMBED_BUTTON_1;
 extern const int TEMBED_BUTTON_2;
 
 static lv_indev_drv_t s_indev_drv;
-static QueueHandle_t s_input_queue = NULL;
 static TaskHandle_t s_input_task_handle = NULL;
+static input_quad_t s_quad;
 
-// Input state tracking
-typedef struct {
-    bool encoder_key_pressed;
-    bool button1_pressed;
-    bool button2_pressed;
-    int16_t encoder_diff;
-    uint32_t last_encoder_time;
-    uint8_t encoder_a_last;
-    uint8_t encoder_b_last;
-} input_state_t;
-
-static input_state_t s_input_state = {0};
 static input_callback_t s_callback = NULL;
 static void *s_callback_user_data = NULL;
 
-// Encoder interrupt handler
+static uint32_t now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static void IRAM_ATTR notify_input_task(void)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(s_input_task_handle, &xHigherPriorityTaskWoken);
+    if (xHigherPriorityTaskWoken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+// Encoder interrupt handler, on every edge of either channel
 static void IRAM_ATTR encoder_isr_handler(void *arg)
 {
-    uint32_t gpio_num = (uint32_t)arg;
-    
-    // Read current encoder state
     uint8_t a = gpio_get_level(TEMBED_ENCODER_A);
     uint8_t b = gpio_get_level(TEMBED_ENCODER_B);
-    
-    // Determine rotation direction using Gray code
-    if (gpio_num == TEMBED_ENCODER_A) {
-        if (a != s_input_state.encoder_a_last) {
-            if (a == b) {
-                s_input_state.encoder_diff++;
-            } else {
-                s_input_state.encoder_diff--;
-            }
-        }
-        s_input_state.encoder_a_last = a;
+
+    int step = input_quad_update(&s_quad, a, b);
+    if (!step) {
+        return;
     }
-    
-    s_input_state.last_encoder_time = xTaskGetTickCountFromISR();
+
+    int64_t now = esp_timer_get_time();
+    input_data_t input_data = {
+        .type = INPUT_TYPE_ENCODER,
+        .event = step > 0 ? INPUT_EVENT_ENCODER_CW : INPUT_EVENT_ENCODER_CCW,
+        .timestamp = (uint32_t)(now / 1000),
+        .time_us = (uint32_t)now,
+        .delta = (int16_t)step,
+        .count = 1,
+    };
+    input_events_push(&input_data);
+    notify_input_task();
 }
 
-// Button interrupt handler
+// Button interrupt handler: raw edges only, the input task debounces
 static void IRAM_ATTR button_isr_handler(void *arg)
 {
     uint32_t gpio_num = (uint32_t)arg;
-    input_data_t input_data = {0};
-    
-    input_data.timestamp = xTaskGetTickCountFromISR() * portTICK_PERIOD_MS;
-    input_data.type = INPUT_TYPE_BUTTON;
-    
-    // Determine which button and state
+    uint8_t key_id = 0;
+
     bool pressed = !gpio_get_level(gpio_num); // Active low
-    
-    if (gpio_num == TEMBED_ENCODER_KEY) {
-        input_data.key_id = 0;
-        s_input_state.encoder_key_pressed = pressed;
-    } else if (gpio_num == TEMBED_BUTTON_1) {
-        input_data.key_id = 1;
-        s_input_state.button1_pressed = pressed;
+
+    if (gpio_num == TEMBED_BUTTON_1) {
+        key_id = 1;
     } else if (gpio_num == TEMBED_BUTTON_2) {
-        input_data.key_id = 2;
-        s_input_state.button2_pressed = pressed;
-    }
-    
-    input_data.event = pressed ? INPUT_EVENT_PRESS : INPUT_EVENT_RELEASE;
-    
-    // Send to queue (from ISR)
-    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-    xQueueSendFromISR(s_input_queue, &input_data, &xHigherPriorityTaskWoken);
-    
-    if (xHigherPriorityTaskWoken) {
-        portYIELD_FROM_ISR();
+        key_id = 2;
     }
+
+    input_buttons_raw(key_id, pressed, (uint32_t)(esp_timer_get_time() / 1000));
+    notify_input_task();
 }
 
-// Input processing task
+// Input processing task: runs the button state machines and delivers the
+// app cursor of the event ring. It only wakes for ISR edges and for the
+// earliest button or delivery deadline.
 static void input_task(void *pvParameters)
 {
-    input_data_t input_data;
-    uint32_t last_encoder_check = 0;
-    
+    uint32_t last_dispatch = now_ms();
+    uint32_t wait_ms = INPUT_BUTTONS_NO_DEADLINE;
+
     ESP_LOGI(TAG, "Input task started");
-    
+
     while (1) {
-        // Check for encoder rotation
-        uint32_t current_time = xTaskGetTickCount();
-        if (current_time - last_encoder_check > pdMS_TO_TICKS(10)) {
-            last_encoder_check = current_time;
-            
-            if (s_input_state.encoder_diff != 0) {
-                input_data.type = INPUT_TYPE_ENCODER;
-                input_data.timestamp = current_time * portTICK_PERIOD_MS;
-                input_data.key_id = 0;
-                
-                if (s_input_state.encoder_diff > 0) {
-                    input_data.event = INPUT_EVENT_ENCODER_CW;
-                    s_input_state.encoder_diff--;
-                } else {
-                    input_data.event = INPUT_EVENT_ENCODER_CCW;
-                    s_input_state.encoder_diff++;
-                }
-                
-                // Send encoder event to callback
-                if (s_callback) {
-                    s_callback(&input_data, s_callback_user_data);
-                }
-            }
+        TickType_t ticks = wait_ms == INPUT_BUTTONS_NO_DEADLINE ? portMAX_DELAY :
+                           (wait_ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+        ulTaskNotifyTake(pdTRUE, ticks);
+
+        uint32_t now = now_ms();
+        wait_ms = input_buttons_step(now);
+
+        if (input_events_pending(INPUT_READER_APP) == 0) {
+            continue;
         }
-        
-        // Process button events from queue
-        if (xQueueReceive(s_input_queue, &input_data, pdMS_TO_TICKS(10))) {
-            if (s_callback) {
-                s_callback(&input_data, s_callback_user_data);
+
+        // Within a frame of the last delivery, let a spin gather until the
+        // frame is over so the app sees one event per frame
+        uint32_t since = now - last_dispatch;
+        if (since < INPUT_DISPATCH_MS) {
+            if (INPUT_DISPATCH_MS - since < wait_ms) {
+                wait_ms = INPUT_DISPATCH_MS - since;
             }
+            continue;
+        }
+        last_dispatch = now;
+
+        // Also brings the UI task round to read the LVGL cursor
+        if (input_events_dispatch(s_callback, s_callback_user_data)) {
+            lvgl_port_power_activity(LVGL_POWER_WAKE_INPUT);
         }
     }
 }
@@ -142,25 +125,7 @@ static void input_task(void *pvParameters)
 // LVGL input reading callback
 static void indev_read_cb(lv_indev_drv_t *indev_drv, lv_indev_data_t *data)
 {
-    static bool encoder_key_last = false;
-    
-    // Handle encoder key as the main input for LVGL
-    data->key = LV_KEY_ENTER;
-    data->state = s_input_state.encoder_key_pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
-    
-    // Handle encoder rotation for navigation
-    if (s_input_state.encoder_diff > 0) {
-        data->key = LV_KEY_RIGHT;
-        data->state = LV_INDEV_STATE_PRESSED;
-        s_input_state.encoder_diff--;
-    } else if (s_input_state.encoder_diff < 0) {
-        data->key = LV_KEY_LEFT;
-        data->state = LV_INDEV_STATE_PRESSED;
-        s_input_state.encoder_diff++;
-    }
-    
-    // Continue reading if there's more encoder movement
-    data->continue_reading = (s_input_state.encoder_diff != 0);
+    input_events_lvgl_read(data);
 }
 
 esp_err_t input_driver_init(lv_indev_t **indev)
@@ -171,13 +136,17 @@ esp_err_t input_driver_init(lv_indev_t **indev)
     
     ESP_LOGI(TAG, "Initializing input driver");
     
-    // Create input queue
-    s_input_queue = xQueueCreate(10, sizeof(input_data_t));
-    if (!s_input_queue) {
-        ESP_LOGE(TAG, "Failed to create input queue");
+    input_events_reset();
+    input_buttons_reset(now_ms());
+
+    // Create input processing task before the ISRs can notify it
+    BaseType_t ret = xTaskCreatePinnedToCore(input_task, "input_task", 2048, NULL, 10,
+                                             &s_input_task_handle, INPUT_TASK_CORE);
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create input task");
         return ESP_ERR_NO_MEM;
     }
-    
+
     // Configure encoder interrupts
     gpio_config_t encoder_cfg = {
         .pin_bit_mask = (1ULL << TEMBED_ENCODER_A) | (1ULL << TEMBED_ENCODER_B),
@@ -200,6 +169,9 @@ esp_err_t input_driver_init(lv_indev_t **indev)
     };
     ESP_ERROR_CHECK(gpio_config(&button_cfg));
     
+    // Initialize encoder state before edges start arriving
+    input_quad_init(&s_quad, gpio_get_level(TEMBED_ENCODER_A), gpio_get_level(TEMBED_ENCODER_B));
+
     // Install GPIO ISR service
     ESP_ERROR_CHECK(gpio_install_isr_service(0));
     
@@ -210,17 +182,6 @@ esp_err_t input_driver_init(lv_indev_t **indev)
     ESP_ERROR_CHECK(gpio_isr_handler_add(TEMBED_BUTTON_1, button_isr_handler, (void*)TEMBED_BUTTON_1));
     ESP_ERROR_CHECK(gpio_isr_handler_add(TEMBED_BUTTON_2, button_isr_handler, (void*)TEMBED_BUTTON_2));
     
-    // Initialize encoder state
-    s_input_state.encoder_a_last = gpio_get_level(TEMBED_ENCODER_A);
-    s_input_state.encoder_b_last = gpio_get_level(TEMBED_ENCODER_B);
-    
-    // Create input processing task
-    BaseType_t ret = xTaskCreate(input_task, "input_task", 2048, NULL, 10, &s_input_task_handle);
-    if (ret != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create input task");
-        return ESP_ERR_NO_MEM;
-    }
-    
     // Initialize LVGL input device driver
     lv_indev_drv_init(&s_indev_drv);
     s_indev_drv.type = LV_INDEV_TYPE_KEYPAD;
@@ -254,12 +215,6 @@ void input_driver_deinit(void)
         s_input_task_handle = NULL;
     }
     
-    // Delete queue
-    if (s_input_queue) {
-        vQueueDelete(s_input_queue);
-        s_input_queue = NULL;
-    }
-    
     // Clear callback
     s_callback = NULL;
     s_callback_user_data = NULL;
@@ -0,0 +1,141 @@
+/**
+ * @file input_driver_scripted.c
+ * @brief Scripted input backend for host (linux target) builds
+ *
+ * Replaces input_driver.c on the host. A script of timed encoder/button
+ * steps is replayed against LVGL time into the same input event ring and
+ * button state machines the GPIO ISRs feed, and read through the LVGL and
+ * app cursors like on the device.
+ */
+
+#include "lvgl_port.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "INPUT_SCRIPT";
+
+#define SCRIPT_MAX_STEPS    256
+
+static lv_indev_drv_t s_indev_drv;
+static lvgl_input_step_t s_script[SCRIPT_MAX_STEPS];
+static size_t s_script_len = 0;
+static size_t s_script_pos = 0;
+static uint32_t s_script_start_ms = 0;
+
+static input_callback_t s_callback = NULL;
+static void *s_callback_user_data = NULL;
+
+// Feed the steps that are due in as the GPIO ISRs would: encoder steps
+// straight into the event ring, button steps as raw edges
+static bool feed_due_steps(uint32_t now)
+{
+    bool any = false;
+
+    while (s_script_pos < s_script_len &&
+           now - s_script_start_ms >= s_script[s_script_pos].at_ms) {
+        const lvgl_input_step_t *step = &s_script[s_script_pos++];
+        any = true;
+
+        // The edge happened when the script says, not when it was polled,
+        // so latency traces include the wait for the next input read
+        uint32_t edge_ms = s_script_start_ms + step->at_ms;
+
+        if (step->type == INPUT_TYPE_BUTTON) {
+            input_buttons_raw(step->key_id, step->event == INPUT_EVENT_PRESS, edge_ms);
+            continue;
+        }
+
+        input_data_t input = {
+            .type = step->type,
+            .event = step->event,
+            .key_id = step->key_id,
+            .timestamp = edge_ms,
+            .time_us = edge_ms * 1000,
+            .delta = step->event == INPUT_EVENT_ENCODER_CW ? 1 : -1,
+            .count = 1,
+        };
+        input_events_push(&input);
+    }
+    return any;
+}
+
+static void indev_read_cb(lv_indev_drv_t *indev_drv, lv_indev_data_t *data)
+{
+    uint32_t now = lv_tick_get();
+
+    // A raw edge wakes the display even before it is debounced
+    if (feed_due_steps(now)) {
+        lvgl_port_power_activity(LVGL_POWER_WAKE_INPUT);
+    }
+
+    input_events_lvgl_read(data);
+}
+
+// No input task on the host: lvgl_headless_render_frame() stands in for
+// it once per frame, after releasing LVGL, so app callbacks run unlocked
+// as they do on the device
+void input_driver_step(void)
+{
+    input_buttons_step(lv_tick_get());
+    if (input_events_dispatch(s_callback, s_callback_user_data)) {
+        lvgl_port_power_activity(LVGL_POWER_WAKE_INPUT);
+    }
+}
+
+esp_err_t input_driver_init(lv_indev_t **indev)
+{
+    if (!indev) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ESP_LOGI(TAG, "Initializing scripted input driver");
+
+    s_script_len = 0;
+    s_script_pos = 0;
+    input_events_reset();
+    input_buttons_reset(lv_tick_get());
+
+    lv_indev_drv_init(&s_indev_drv);
+    s_indev_drv.type = LV_INDEV_TYPE_KEYPAD;
+    s_indev_drv.read_cb = indev_read_cb;
+
+    *indev = lv_indev_drv_register(&s_indev_drv);
+    if (!*indev) {
+        ESP_LOGE(TAG, "Failed to register input device");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    return ESP_OK;
+}
+
+void input_driver_deinit(void)
+{
+    s_script_len = 0;
+    s_script_pos = 0;
+    s_callback = NULL;
+    s_callback_user_data = NULL;
+}
+
+void input_driver_register_callback(input_callback_t callback, void *user_data)
+{
+    s_callback = callback;
+    s_callback_user_data = user_data;
+}
+
+esp_err_t lvgl_headless_play_input(const lvgl_input_step_t *steps, size_t count)
+{
+    if (!steps || count > SCRIPT_MAX_STEPS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memcpy(s_script, steps, count * sizeof(*steps));
+    s_script_len = count;
+    s_script_pos = 0;
+    s_script_start_ms = lv_tick_get();
+    return ESP_OK;
+}
+
+bool lvgl_headless_input_done(void)
+{
+    return s_script_pos >= s_script_len;
+}
@@ -0,0 +1,357 @@
+/**
+ * @file input_events.c
+ * @brief Quadrature decoding and the ISR-to-task input event ring
+ *
+ * The encoder is decoded from both edges of both channels with a 16-entry
+ * transition table. Quarter steps are summed and a detent step is emitted
+ * when the encoder settles back in its rest state, so contact bounce and
+ * aborted half-turns cancel out instead of producing steps.
+ *
+ * Steps and button events go into one ring with one read cursor per
+ * consumer. LVGL and the app callback path each see every event exactly
+ * once and never consume each other's. Producers (the encoder ISR and the
+ * button state machine in the input task, or the scripted driver on the
+ * host) claim slots with a compare-and-swap and publish them with a
+ * per-slot sequence number, so an ISR can push while the task is half way
+ * through its own push. New events are dropped rather than overwrite ones
+ * the slowest reader has not seen.
+ *
+ * LVGL gets every detent as a key press so focus moves one item per click.
+ * The app path is accelerated by spin speed and coalesced: a run of steps
+ * in one direction reaches the callback as one event with a summed delta,
+ * so handlers run once per dispatch however fast the knob turns.
+ *
+ * Each event is tagged with its claim position as an id, and both readers
+ * report when they take it and around the app callback for latency traces.
+ * App events are also published on the event bus after the callback.
+ */
+
+#include "lvgl_port.h"
+#include "trace.h"
+#include "event_bus.h"
+#include "esp_attr.h"
+#include <stdatomic.h>
+#include <string.h>
+
+#define RING_MASK           (INPUT_RING_LEN - 1)
+#define ENCODER_REST_STATE  0x3     // Both channels high (pull-ups) at a detent
+
+_Static_assert((INPUT_RING_LEN & RING_MASK) == 0, "ring length must be a power of two");
+
+// Quarter step for (previous AB << 2) | current AB; 0 for no change and for
+// jumps over a state, which a missed edge produces
+static const int8_t s_quad_table[16] = {
+     0, +1, -1,  0,
+    -1,  0,  0, +1,
+    +1,  0,  0, -1,
+     0, -1, +1,  0,
+};
+
+// Transitions where both channels changed at once
+#define QUAD_INVALID(prev, cur)     (((prev) ^ (cur)) == 0x3)
+
+typedef struct {
+    atomic_uint seq;        // Claim position + 1 once the event is written
+    input_data_t event;
+} input_slot_t;
+
+static input_slot_t s_ring[INPUT_RING_LEN];
+static atomic_uint s_head;                          // Next slot to claim (producers)
+static atomic_uint s_tail[INPUT_READER_MAX];        // Next slot per reader
+
+static atomic_uint s_pushed;
+static atomic_uint s_dropped;
+static atomic_uint s_invalid;
+static atomic_uint s_max_depth;
+
+// App side, only touched by the dispatching task
+static input_accel_t s_accel;
+static uint32_t s_app_events = 0;
+static uint32_t s_encoder_steps = 0;
+static uint32_t s_max_coalesced = 0;
+
+// LVGL side: a step reported pressed is released on the next read
+static uint32_t s_lvgl_step_key = 0;
+static bool s_lvgl_enter_pressed = false;
+
+void input_events_reset(void)
+{
+    for (int i = 0; i < INPUT_RING_LEN; i++) {
+        atomic_store_explicit(&s_ring[i].seq, 0, memory_order_relaxed);
+    }
+    atomic_store(&s_head, 0);
+    for (int i = 0; i < INPUT_READER_MAX; i++) {
+        atomic_store(&s_tail[i], 0);
+    }
+    atomic_store(&s_pushed, 0);
+    atomic_store(&s_dropped, 0);
+    atomic_store(&s_invalid, 0);
+    atomic_store(&s_max_depth, 0);
+    memset(&s_accel, 0, sizeof(s_accel));
+    s_app_events = 0;
+    s_encoder_steps = 0;
+    s_max_coalesced = 0;
+    s_lvgl_step_key = 0;
+    s_lvgl_enter_pressed = false;
+}
+
+void input_quad_init(input_quad_t *quad, uint8_t a, uint8_t b)
+{
+    quad->state = (uint8_t)((a ? 2 : 0) | (b ? 1 : 0));
+    quad->count = 0;
+}
+
+int IRAM_ATTR input_quad_update(input_quad_t *quad, uint8_t a, uint8_t b)
+{
+    uint8_t cur = (uint8_t)((a ? 2 : 0) | (b ? 1 : 0));
+    uint8_t prev = quad->state;
+
+    if (cur == prev) {
+        return 0;
+    }
+    quad->state = cur;
+
+    if (QUAD_INVALID(prev, cur)) {
+        atomic_fetch_add_explicit(&s_invalid, 1, memory_order_relaxed);
+    }
+    quad->count += s_quad_table[(prev << 2) | cur];
+
+    if (cur != ENCODER_REST_STATE) {
+        return 0;
+    }
+
+    // Back at a detent: a full cycle is four quarter steps, but accept two
+    // so one lost edge does not swallow the step
+    int step = 0;
+    if (quad->count >= 2) {
+        step = 1;
+    } else if (quad->count <= -2) {
+        step = -1;
+    }
+    quad->count = 0;
+    return step;
+}
+
+static uint32_t slowest_tail(uint32_t head)
+{
+    uint32_t depth = 0;
+    uint32_t tail = head;
+
+    for (int i = 0; i < INPUT_READER_MAX; i++) {
+        uint32_t t = atomic_load_explicit(&s_tail[i], memory_order_acquire);
+        if (head - t > depth) {
+            depth = head - t;
+            tail = t;
+        }
+    }
+    return tail;
+}
+
+bool IRAM_ATTR input_events_push(const input_data_t *event)
+{
+    uint32_t head = atomic_load_explicit(&s_head, memory_order_relaxed);
+    uint32_t depth;
+
+    // Claim a slot; an ISR may claim the next one before this is published
+    do {
+        depth = head - slowest_tail(head);
+        if (depth >= INPUT_RING_LEN) {
+            atomic_fetch_add_explicit(&s_dropped, 1, memory_order_relaxed);
+            return false;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&s_head, &head, head + 1,
+                                                    memory_order_relaxed,
+                                                    memory_order_relaxed));
+
+    input_slot_t *slot = &s_ring[head & RING_MASK];
+    slot->event = *event;
+    slot->event.id = (uint16_t)head;
+    atomic_store_explicit(&slot->seq, head + 1, memory_order_release);
+    TRACE(TRACE_INPUT_PUSH, event->event, (uint16_t)head);
+
+    atomic_fetch_add_explicit(&s_pushed, 1, memory_order_relaxed);
+    if (depth + 1 > atomic_load_explicit(&s_max_depth, memory_order_relaxed)) {
+        atomic_store_explicit(&s_max_depth, depth + 1, memory_order_relaxed);
+    }
+    return true;
+}
+
+bool input_events_pop(input_reader_t reader, input_data_t *event)
+{
+    uint32_t tail = atomic_load_explicit(&s_tail[reader], memory_order_relaxed);
+    input_slot_t *slot = &s_ring[tail & RING_MASK];
+
+    // Not published yet (or nothing claimed): readers wait in claim order
+    if (atomic_load_explicit(&slot->seq, memory_order_acquire) != tail + 1) {
+        return false;
+    }
+
+    *event = slot->event;
+
+    // Releasing the slot only after the copy keeps producers off it
+    atomic_store_explicit(&s_tail[reader], tail + 1, memory_order_release);
+    return true;
+}
+
+uint32_t input_events_pending(input_reader_t reader)
+{
+    return atomic_load_explicit(&s_head, memory_order_acquire) -
+           atomic_load_explicit(&s_tail[reader], memory_order_relaxed);
+}
+
+int input_accel_apply(input_accel_t *accel, int dir, uint32_t time_us)
+{
+    uint32_t gap = time_us - accel->last_us;
+
+    // A pause or a change of direction starts again at 1:1
+    if (dir != accel->dir || gap >= INPUT_ACCEL_SLOW_US) {
+        accel->avg_us = INPUT_ACCEL_SLOW_US;
+    } else {
+        accel->avg_us = (accel->avg_us * 3 + gap) / 4;
+    }
+    accel->last_us = time_us;
+    accel->dir = (int8_t)dir;
+
+    if (accel->avg_us >= INPUT_ACCEL_SLOW_US) {
+        return dir;
+    }
+    if (accel->avg_us <= INPUT_ACCEL_FAST_US) {
+        return dir * INPUT_ACCEL_MAX;
+    }
+
+    uint32_t span = INPUT_ACCEL_SLOW_US - INPUT_ACCEL_FAST_US;
+    uint32_t speed = INPUT_ACCEL_SLOW_US - accel->avg_us;
+    return dir * (int)(1 + (INPUT_ACCEL_MAX - 1) * speed / span);
+}
+
+static void deliver(const input_data_t *event, input_callback_t callback, void *user_data)
+{
+    if (callback) {
+        lvgl_latency_mark(event->id, LVGL_LATENCY_HANDLER_ENTER);
+        callback(event, user_data);
+        lvgl_latency_mark(event->id, LVGL_LATENCY_HANDLER_EXIT);
+    }
+
+    event_input_t input = {
+        .type = (uint8_t)event->type,
+        .event = (uint8_t)event->event,
+        .key_id = event->key_id,
+        .delta = event->delta,
+        .count = event->count,
+        .timestamp = event->timestamp,
+        .id = event->id,
+    };
+    event_publish_input(&input, EVENT_PRIO_URGENT);
+    s_app_events++;
+}
+
+uint32_t input_events_dispatch(input_callback_t callback, void *user_data)
+{
+    uint32_t before = s_app_events;
+    input_data_t event;
+    input_data_t rotation = {0};
+
+    while (input_events_pop(INPUT_READER_APP, &event)) {
+        lvgl_latency_begin(&event);
+
+        if (event.type != INPUT_TYPE_ENCODER) {
+            // Keep order: steps before a click are delivered before it
+            if (rotation.count) {
+                deliver(&rotation, callback, user_data);
+                rotation.count = 0;
+            }
+            deliver(&event, callback, user_data);
+            continue;
+        }
+
+        if (rotation.count && rotation.event != event.event) {
+            deliver(&rotation, callback, user_data);
+            rotation.count = 0;
+        }
+
+        int dir = event.event == INPUT_EVENT_ENCODER_CW ? 1 : -1;
+        int delta = input_accel_apply(&s_accel, dir, event.time_us);
+
+        // The run keeps the time of its first step, when the user started turning
+        if (!rotation.count) {
+            rotation = event;
+            rotation.delta = 0;
+            rotation.count = 0;
+        }
+        rotation.delta = (int16_t)(rotation.delta + delta);
+        rotation.count++;
+        s_encoder_steps++;
+        if (rotation.count > s_max_coalesced) {
+            s_max_coalesced = rotation.count;
+        }
+    }
+
+    if (rotation.count) {
+        deliver(&rotation, callback, user_data);
+    }
+    return s_app_events - before;
+}
+
+void input_events_lvgl_read(lv_indev_data_t *data)
+{
+    // Every step is its own press and release, so LVGL sends one key event
+    // per step instead of treating a run of steps as a held key
+    if (s_lvgl_step_key) {
+        data->key = s_lvgl_step_key;
+        data->state = LV_INDEV_STATE_RELEASED;
+        s_lvgl_step_key = 0;
+        data->continue_reading = input_events_pending(INPUT_READER_LVGL) > 0;
+        return;
+    }
+
+    data->key = LV_KEY_ENTER;
+    data->state = s_lvgl_enter_pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+    data->continue_reading = false;
+
+    input_data_t event;
+    if (!input_events_pop(INPUT_READER_LVGL, &event)) {
+        return;
+    }
+    lvgl_latency_begin(&event);
+
+    switch (event.event) {
+    case INPUT_EVENT_ENCODER_CW:
+    case INPUT_EVENT_ENCODER_CCW:
+        s_lvgl_step_key = event.event == INPUT_EVENT_ENCODER_CW ? LV_KEY_RIGHT : LV_KEY_LEFT;
+        data->key = s_lvgl_step_key;
+        data->state = LV_INDEV_STATE_PRESSED;
+        data->continue_reading = true;
+        return;
+    case INPUT_EVENT_PRESS:
+    case INPUT_EVENT_RELEASE:
+        // Only the encoder key drives LVGL; the side buttons go to apps
+        if (event.key_id == 0) {
+            s_lvgl_enter_pressed = event.event == INPUT_EVENT_PRESS;
+            data->state = s_lvgl_enter_pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+        }
+        break;
+    default:
+        // Gestures are for apps; LVGL works from the press and release
+        break;
+    }
+
+    data->continue_reading = input_events_pending(INPUT_READER_LVGL) > 0;
+}
+
+void lvgl_port_get_input_stats(lvgl_input_stats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+
+    stats->events = atomic_load(&s_pushed);
+    stats->dropped = atomic_load(&s_dropped);
+    stats->invalid_transitions = atomic_load(&s_invalid);
+    stats->max_depth = atomic_load(&s_max_depth);
+    stats->pending_lvgl = input_events_pending(INPUT_READER_LVGL);
+    stats->pending_app = input_events_pending(INPUT_READER_APP);
+    stats->app_events = s_app_events;
+    stats->encoder_steps = s_encoder_steps;
+    stats->max_coalesced = s_max_coalesced;
+    input_buttons_get_stats(stats);
+}
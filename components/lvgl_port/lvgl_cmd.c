@@ -0,0 +1,235 @@
+/**
+ * @file lvgl_cmd.c
+ * @brief UI command queue: lock-free submission of LVGL operations
+ *
+ * Tasks other than the UI task post fixed-size commands instead of taking
+ * the LVGL mutex. The UI task applies them in one batch per frame while it
+ * already holds the lock. The queue is a bounded multi-producer,
+ * single-consumer ring where each slot carries a sequence number, so
+ * producers only contend on one compare-and-swap and never block.
+ *
+ * Deleting a target object purges its queued commands from the delete
+ * event, so applying one never touches freed memory or a new object that
+ * reuses the address, and needs no lookup.
+ */
+
+#include "lvgl_port.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdatomic.h>
+#include <string.h>
+
+static const char *TAG = "LVGL_CMD";
+
+#define CMD_QUEUE_MASK  (LVGL_CMD_QUEUE_LEN - 1)
+
+_Static_assert((LVGL_CMD_QUEUE_LEN & CMD_QUEUE_MASK) == 0, "queue length must be a power of two");
+
+typedef struct {
+    atomic_uint seq;
+    lvgl_ui_cmd_t cmd;
+} cmd_slot_t;
+
+static cmd_slot_t s_slots[LVGL_CMD_QUEUE_LEN];
+static atomic_uint s_head;      // Next slot to claim (producers)
+static atomic_uint s_tail;      // Next slot to apply (UI task only writes)
+
+static atomic_uint s_posted;
+static atomic_uint s_rejected;
+static atomic_uint s_max_depth;
+static uint32_t s_applied = 0;
+static uint32_t s_stale = 0;
+
+void lvgl_cmd_reset(void)
+{
+    for (uint32_t i = 0; i < LVGL_CMD_QUEUE_LEN; i++) {
+        atomic_store_explicit(&s_slots[i].seq, i, memory_order_relaxed);
+    }
+    atomic_store(&s_head, 0);
+    atomic_store(&s_tail, 0);
+    lvgl_cmd_reset_stats();
+}
+
+void lvgl_cmd_reset_stats(void)
+{
+    atomic_store(&s_posted, 0);
+    atomic_store(&s_rejected, 0);
+    atomic_store(&s_max_depth, 0);
+    s_applied = 0;
+    s_stale = 0;
+}
+
+esp_err_t lvgl_cmd_push(const lvgl_ui_cmd_t *cmd)
+{
+    if (!cmd || !cmd->fn) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t pos = atomic_load_explicit(&s_head, memory_order_relaxed);
+    cmd_slot_t *slot;
+
+    for (;;) {
+        slot = &s_slots[pos & CMD_QUEUE_MASK];
+        uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        int32_t diff = (int32_t)(seq - pos);
+
+        if (diff == 0) {
+            // Slot is free for this lap: claim it
+            if (atomic_compare_exchange_weak_explicit(&s_head, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // The UI task has not applied this slot from the previous lap
+            atomic_fetch_add_explicit(&s_rejected, 1, memory_order_relaxed);
+            return ESP_ERR_NO_MEM;
+        } else {
+            pos = atomic_load_explicit(&s_head, memory_order_relaxed);
+        }
+    }
+
+    slot->cmd = *cmd;
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+
+    atomic_fetch_add_explicit(&s_posted, 1, memory_order_relaxed);
+    uint32_t depth = pos + 1 - atomic_load_explicit(&s_tail, memory_order_relaxed);
+    uint32_t max_depth = atomic_load_explicit(&s_max_depth, memory_order_relaxed);
+    while (depth > max_depth &&
+           !atomic_compare_exchange_weak_explicit(&s_max_depth, &max_depth, depth,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+    }
+
+    return ESP_OK;
+}
+
+bool lvgl_cmd_pop(lvgl_ui_cmd_t *cmd)
+{
+    uint32_t pos = atomic_load_explicit(&s_tail, memory_order_relaxed);
+    cmd_slot_t *slot = &s_slots[pos & CMD_QUEUE_MASK];
+    uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+
+    // Claimed but not yet written, or nothing posted
+    if ((int32_t)(seq - (pos + 1)) < 0) {
+        return false;
+    }
+
+    *cmd = slot->cmd;
+    atomic_store_explicit(&slot->seq, pos + LVGL_CMD_QUEUE_LEN, memory_order_release);
+    atomic_store_explicit(&s_tail, pos + 1, memory_order_relaxed);
+    return true;
+}
+
+uint32_t lvgl_port_apply_commands(void)
+{
+    lvgl_ui_cmd_t cmd;
+    uint32_t count = 0;
+
+    // Bounded so a flood of posts cannot stretch a frame indefinitely
+    while (count < LVGL_CMD_QUEUE_LEN && lvgl_cmd_pop(&cmd)) {
+        // Purged when its object was deleted
+        if (!cmd.fn) {
+            s_stale++;
+        } else {
+            cmd.fn(&cmd);
+        }
+        count++;
+    }
+
+    s_applied += count;
+    return count;
+}
+
+// Runs with LVGL locked, as does every consumer, so nothing is popped
+// meanwhile; posts that come after the deletion are the poster's bug
+static void lvgl_cmd_purge(const lv_obj_t *obj)
+{
+    uint32_t head = atomic_load_explicit(&s_head, memory_order_relaxed);
+
+    for (uint32_t pos = atomic_load_explicit(&s_tail, memory_order_relaxed); pos != head; pos++) {
+        cmd_slot_t *slot = &s_slots[pos & CMD_QUEUE_MASK];
+
+        // A producer preempted between claiming the slot and filling it
+        while ((int32_t)(atomic_load_explicit(&slot->seq, memory_order_acquire) - (pos + 1)) < 0) {
+            vTaskDelay(1);
+        }
+        if (slot->cmd.obj == obj) {
+            slot->cmd.fn = NULL;
+        }
+    }
+}
+
+static void cmd_target_delete_cb(lv_event_t *e)
+{
+    lvgl_cmd_purge(lv_event_get_target(e));
+}
+
+void lvgl_port_cmd_target(lv_obj_t *obj)
+{
+    if (obj) {
+        lv_obj_add_event_cb(obj, cmd_target_delete_cb, LV_EVENT_DELETE, NULL);
+    }
+}
+
+esp_err_t lvgl_port_post(const lvgl_ui_cmd_t *cmd)
+{
+    esp_err_t ret = lvgl_cmd_push(cmd);
+    if (ret == ESP_OK) {
+        lvgl_port_wake();
+    } else if (ret == ESP_ERR_NO_MEM) {
+        ESP_LOGD(TAG, "UI command queue full");
+    }
+    return ret;
+}
+
+esp_err_t lvgl_port_post_ordered(const lvgl_ui_cmd_t *cmd)
+{
+    esp_err_t ret;
+    while ((ret = lvgl_port_post(cmd)) == ESP_ERR_NO_MEM) {
+        // Apply what is queued ahead first so this command cannot overtake it
+        lvgl_port_lock();
+        uint32_t applied = lvgl_port_apply_commands();
+        lvgl_port_unlock();
+
+        if (!applied) {
+            // The oldest slot is still being written by a preempted producer
+            vTaskDelay(1);
+        }
+    }
+    return ret;
+}
+
+static void cmd_set_label_text(const lvgl_ui_cmd_t *cmd)
+{
+    lvgl_port_set_label_text(cmd->obj, cmd->text);
+}
+
+esp_err_t lvgl_port_post_label_text(lv_obj_t *label, const char *text)
+{
+    if (!label || !text) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t len = strlen(text);
+    if (len >= LVGL_CMD_TEXT_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    lvgl_ui_cmd_t cmd = {
+        .fn = cmd_set_label_text,
+        .obj = label,
+    };
+    memcpy(cmd.text, text, len + 1);
+    return lvgl_port_post_ordered(&cmd);
+}
+
+void lvgl_cmd_get_stats(lvgl_lock_stats_t *stats)
+{
+    stats->cmds_posted = atomic_load(&s_posted);
+    stats->cmds_applied = s_applied;
+    stats->cmds_rejected = atomic_load(&s_rejected);
+    stats->cmds_stale = s_stale;
+    stats->cmd_queue_max_depth = atomic_load(&s_max_depth);
+}
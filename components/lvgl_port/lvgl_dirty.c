@@ -0,0 +1,186 @@
+/**
+ * @file lvgl_dirty.c
+ * @brief Dirty-rectangle merging and partial refresh statistics
+ */
+
+#include "lvgl_port.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "LVGL_DIRTY";
+
+static lvgl_refresh_stats_t s_stats = {0};
+static uint32_t s_window_start_ms = 0;
+static uint32_t s_window_pixels = 0;
+
+static inline uint32_t area_size(const lv_area_t *a)
+{
+    return (uint32_t)(a->x2 - a->x1 + 1) * (uint32_t)(a->y2 - a->y1 + 1);
+}
+
+static inline void area_join(lv_area_t *out, const lv_area_t *a, const lv_area_t *b)
+{
+    out->x1 = LV_MIN(a->x1, b->x1);
+    out->y1 = LV_MIN(a->y1, b->y1);
+    out->x2 = LV_MAX(a->x2, b->x2);
+    out->y2 = LV_MAX(a->y2, b->y2);
+}
+
+static inline bool area_touches(const lv_area_t *a, const lv_area_t *b)
+{
+    return a->x1 <= b->x2 + 1 && b->x1 <= a->x2 + 1 &&
+           a->y1 <= b->y2 + 1 && b->y1 <= a->y2 + 1;
+}
+
+/**
+ * @brief Extra pixels a merge may add before two flushes are cheaper
+ *
+ * Merging always pays if the bounding box is no bigger than the two areas
+ * plus the cost of one window setup, expressed in pixel-transfer time.
+ */
+static inline int32_t merge_gain(const lv_area_t *a, const lv_area_t *b)
+{
+    lv_area_t joined;
+    area_join(&joined, a, b);
+    return (int32_t)(area_size(a) + area_size(b) + LVGL_DIRTY_FLUSH_OVERHEAD_PX) -
+           (int32_t)area_size(&joined);
+}
+
+void lvgl_dirty_align(lv_area_t *area, lv_coord_t max_x, lv_coord_t max_y)
+{
+    // Snap outwards to the tile grid, then clip back to the screen
+    area->x1 &= ~(LVGL_DIRTY_TILE_SIZE - 1);
+    area->y1 &= ~(LVGL_DIRTY_TILE_SIZE - 1);
+    area->x2 |= (LVGL_DIRTY_TILE_SIZE - 1);
+    area->y2 |= (LVGL_DIRTY_TILE_SIZE - 1);
+
+    if (area->x2 > max_x) area->x2 = max_x;
+    if (area->y2 > max_y) area->y2 = max_y;
+}
+
+void lvgl_dirty_reset(lvgl_dirty_region_t *region)
+{
+    region->count = 0;
+}
+
+void lvgl_dirty_add(lvgl_dirty_region_t *region, const lv_area_t *area)
+{
+    lv_area_t cur = *area;
+
+    // Fold in every rect that overlaps or is cheaper to flush together with
+    // this one. A merge grows the rect, so rescan until nothing qualifies.
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (uint8_t i = 0; i < region->count; i++) {
+            if (area_touches(&cur, &region->rects[i]) ||
+                merge_gain(&cur, &region->rects[i]) >= 0) {
+                area_join(&cur, &cur, &region->rects[i]);
+                region->rects[i] = region->rects[--region->count];
+                merged = true;
+                break;
+            }
+        }
+    }
+
+    if (region->count < LVGL_DIRTY_MAX_RECTS) {
+        region->rects[region->count++] = cur;
+        return;
+    }
+
+    // Full: merge with whichever rect wastes the fewest pixels
+    uint8_t best = 0;
+    int32_t best_gain = INT32_MIN;
+    for (uint8_t i = 0; i < region->count; i++) {
+        int32_t gain = merge_gain(&cur, &region->rects[i]);
+        if (gain > best_gain) {
+            best_gain = gain;
+            best = i;
+        }
+    }
+    area_join(&cur, &cur, &region->rects[best]);
+    region->rects[best] = region->rects[--region->count];
+    lvgl_dirty_add(region, &cur);
+}
+
+uint32_t lvgl_dirty_pixels(const lvgl_dirty_region_t *region)
+{
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < region->count; i++) {
+        total += area_size(&region->rects[i]);
+    }
+    return total;
+}
+
+void lvgl_dirty_merge_display(lv_disp_t *disp)
+{
+    if (!disp || disp->inv_p == 0) {
+        return;
+    }
+
+    lvgl_dirty_region_t region;
+    lvgl_dirty_reset(&region);
+
+    for (uint16_t i = 0; i < disp->inv_p; i++) {
+        if (!disp->inv_area_joined[i]) {
+            lvgl_dirty_add(&region, &disp->inv_areas[i]);
+        }
+    }
+
+    s_stats.areas_invalidated += disp->inv_p;
+    s_stats.areas_flushed += region.count;
+
+    // Hand the merged set back to LVGL's refresh
+    for (uint8_t i = 0; i < region.count; i++) {
+        disp->inv_areas[i] = region.rects[i];
+        disp->inv_area_joined[i] = 0;
+    }
+    disp->inv_p = region.count;
+}
+
+void lvgl_dirty_account_flush(uint32_t pixels)
+{
+    uint32_t now = lv_tick_get();
+
+    s_stats.flushes++;
+    s_stats.pixels_pushed += pixels;
+    s_window_pixels += pixels;
+
+    uint32_t elapsed = now - s_window_start_ms;
+    if (elapsed >= 1000) {
+        s_stats.pixels_per_sec = (uint32_t)((uint64_t)s_window_pixels * 1000 / elapsed);
+        s_window_pixels = 0;
+        s_window_start_ms = now;
+        ESP_LOGD(TAG, "%u px/s over %u flushes", (unsigned)s_stats.pixels_per_sec, (unsigned)s_stats.flushes);
+    }
+}
+
+void lvgl_dirty_account_skipped_update(void)
+{
+    s_stats.updates_skipped++;
+}
+
+void lvgl_port_get_refresh_stats(lvgl_refresh_stats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+    memcpy(stats, &s_stats, sizeof(*stats));
+
+    // The rate is only closed on a flush, and an idle display has none: a
+    // window open past a second is rated at read time, and one open past
+    // two saw no flush in the last full second at all
+    uint32_t elapsed = lv_tick_get() - s_window_start_ms;
+    if (elapsed >= 2000) {
+        stats->pixels_per_sec = 0;
+    } else if (elapsed >= 1000) {
+        stats->pixels_per_sec = (uint32_t)((uint64_t)s_window_pixels * 1000 / elapsed);
+    }
+}
+
+void lvgl_port_reset_refresh_stats(void)
+{
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_window_pixels = 0;
+    s_window_start_ms = lv_tick_get();
+}
@@ -0,0 +1,157 @@
+/**
+ * @file lvgl_frame.c
+ * @brief Frame pacing: per-screen frame rate caps and frame timing statistics
+ *
+ * The UI task renders a frame, then sleeps until LVGL's next timer deadline
+ * or until something invalidates the screen. This file decides how long
+ * that sleep is and keeps the timing statistics; it does not touch FreeRTOS
+ * so the same logic runs in host tests.
+ */
+
+#include "lvgl_port.h"
+#include "metrics.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "LVGL_FRAME";
+
+#define FRAME_SCREEN_SLOTS  8
+
+METRIC_HISTOGRAM_DEFINE(s_frame_metric, "display.frame_us", "us");
+
+typedef struct {
+    lv_obj_t *screen;
+    lvgl_frame_profile_t profile;
+} screen_profile_t;
+
+static const uint8_t s_profile_fps[LVGL_FRAME_PROFILE_MAX] = {
+    [LVGL_FRAME_PROFILE_MENU] = LVGL_FRAME_FPS_MENU,
+    [LVGL_FRAME_PROFILE_APP] = LVGL_FRAME_FPS_APP,
+    [LVGL_FRAME_PROFILE_SPECTRUM] = LVGL_FRAME_FPS_SPECTRUM,
+};
+
+static screen_profile_t s_screens[FRAME_SCREEN_SLOTS] = {0};
+static lvgl_frame_stats_t s_stats = {0};
+static uint64_t s_deadline_us = 0;      // Wake-up time set by the last schedule
+static uint64_t s_total_frame_us = 0;
+
+uint32_t lvgl_frame_period_ms(lvgl_frame_profile_t profile)
+{
+    if (profile >= LVGL_FRAME_PROFILE_MAX) {
+        profile = LVGL_FRAME_PROFILE_APP;
+    }
+    return 1000 / s_profile_fps[profile];
+}
+
+static void screen_delete_cb(lv_event_t *e)
+{
+    lv_obj_t *screen = lv_event_get_target(e);
+    for (int i = 0; i < FRAME_SCREEN_SLOTS; i++) {
+        if (s_screens[i].screen == screen) {
+            s_screens[i].screen = NULL;
+        }
+    }
+}
+
+void lvgl_port_set_screen_frame_profile(lv_obj_t *screen, lvgl_frame_profile_t profile)
+{
+    if (!screen || profile >= LVGL_FRAME_PROFILE_MAX) {
+        return;
+    }
+
+    int free_slot = -1;
+    for (int i = 0; i < FRAME_SCREEN_SLOTS; i++) {
+        if (s_screens[i].screen == screen) {
+            s_screens[i].profile = profile;
+            return;
+        }
+        if (!s_screens[i].screen && free_slot < 0) {
+            free_slot = i;
+        }
+    }
+
+    if (free_slot < 0) {
+        ESP_LOGW(TAG, "No free screen profile slot, screen stays at default rate");
+        return;
+    }
+
+    s_screens[free_slot].screen = screen;
+    s_screens[free_slot].profile = profile;
+    lv_obj_add_event_cb(screen, screen_delete_cb, LV_EVENT_DELETE, NULL);
+}
+
+lvgl_frame_profile_t lvgl_port_get_screen_frame_profile(const lv_obj_t *screen)
+{
+    for (int i = 0; screen && i < FRAME_SCREEN_SLOTS; i++) {
+        if (s_screens[i].screen == screen) {
+            return s_screens[i].profile;
+        }
+    }
+    return LVGL_FRAME_PROFILE_APP;
+}
+
+uint32_t lvgl_frame_schedule(uint64_t now_us, uint32_t timer_delay_ms)
+{
+    // LVGL reports LV_NO_TIMER_READY when every timer is paused
+    uint32_t wait_ms = timer_delay_ms;
+    if (wait_ms > LVGL_FRAME_IDLE_MAX_MS) {
+        wait_ms = LVGL_FRAME_IDLE_MAX_MS;
+    }
+
+    s_deadline_us = now_us + (uint64_t)wait_ms * 1000;
+    return wait_ms;
+}
+
+void lvgl_frame_account(uint64_t start_us, uint32_t frame_us, bool rendered,
+                        lvgl_frame_profile_t profile)
+{
+    if (!rendered) {
+        s_stats.idle_wakeups++;
+        return;
+    }
+
+    uint32_t period_us = lvgl_frame_period_ms(profile) * 1000;
+
+    // Lateness against the wake-up the scheduler asked for. Early wake-ups
+    // (input, invalidation) are on time by definition.
+    uint32_t late_us = 0;
+    if (s_deadline_us && start_us > s_deadline_us) {
+        late_us = (uint32_t)(start_us - s_deadline_us);
+    }
+
+    s_stats.frames++;
+    s_stats.last_frame_us = frame_us;
+    metric_record(&s_frame_metric, frame_us);
+    s_total_frame_us += frame_us;
+    s_stats.avg_frame_us = (uint32_t)(s_total_frame_us / s_stats.frames);
+    if (frame_us > s_stats.max_frame_us) {
+        s_stats.max_frame_us = frame_us;
+    }
+
+    // Running mean deviation, weighted 1/8 like a TCP RTT estimator
+    s_stats.jitter_us = s_stats.jitter_us - (s_stats.jitter_us >> 3) + (late_us >> 3);
+
+    if (late_us > period_us / 2 || frame_us > period_us) {
+        s_stats.missed_deadlines++;
+        ESP_LOGD(TAG, "Missed frame deadline: %u us late, %u us render", (unsigned)late_us, (unsigned)frame_us);
+    }
+}
+
+void lvgl_frame_account_sleep(uint32_t slept_ms)
+{
+    s_stats.slept_ms += slept_ms;
+}
+
+void lvgl_port_get_frame_stats(lvgl_frame_stats_t *stats)
+{
+    if (stats) {
+        memcpy(stats, &s_stats, sizeof(*stats));
+    }
+}
+
+void lvgl_port_reset_frame_stats(void)
+{
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_total_frame_us = 0;
+    s_deadline_us = 0;
+}
@@ -5,6 +5,7 @@
 
 #include "lvgl_port.h"
 #include "esp_log.h"
+#include <stdlib.h>
 
 static const char *TAG = "LVGL_HELPERS";
 
@@ -277,4 +278,284 @@ void lvgl_format_data_rate(uint32_t rate_bps, char *buffer, size_t buffer_size)
         // bps
         snprintf(buffer, buffer_size, "%u bps", rate_bps);
     }
-}
\ No newline at end of file
+}
+// Spectrum / waterfall widget
+
+typedef struct {
+    lvgl_spectrum_mode_t mode;
+    lv_coord_t width;
+    lv_coord_t height;
+    int8_t min_dbm;
+    int8_t max_dbm;
+    const int8_t *rssi;             // Caller-owned, read on every refresh
+    uint16_t bins;
+    uint16_t col_bin[LCD_HEIGHT];   // Column -> bin index
+    uint8_t level[256];             // (rssi + 128) -> bar height in px
+    lv_color_t lut[256];            // (rssi + 128) -> heat colour
+    lv_coord_t span_lo[LCD_HEIGHT]; // Per-column scratch for bars/line
+    lv_coord_t span_hi[LCD_HEIGHT];
+    lv_color_t *pixels;             // width * height, a row ring in waterfall mode
+    uint16_t head;                  // Newest waterfall row
+    lv_img_dsc_t img[2];            // Ring halves drawn as two blits
+} spectrum_t;
+
+#define SPECTRUM_BG_COLOR   lv_color_hex(0x000000)
+#define SPECTRUM_FG_COLOR   THEME_SECONDARY
+
+static lv_color_t spectrum_heat_color(uint8_t t)
+{
+    // Black -> blue -> cyan -> yellow -> red
+    static const uint8_t stops[5][3] = {
+        {0x00, 0x00, 0x00}, {0x00, 0x00, 0xFF}, {0x00, 0xFF, 0xFF},
+        {0xFF, 0xFF, 0x00}, {0xFF, 0x00, 0x00}
+    };
+    uint8_t seg = t / 64;
+    uint8_t frac = (t % 64) * 4;
+    if (seg >= 4) {
+        return lv_color_make(stops[4][0], stops[4][1], stops[4][2]);
+    }
+    const uint8_t *a = stops[seg];
+    const uint8_t *b = stops[seg + 1];
+    return lv_color_make(a[0] + ((b[0] - a[0]) * frac) / 255,
+                         a[1] + ((b[1] - a[1]) * frac) / 255,
+                         a[2] + ((b[2] - a[2]) * frac) / 255);
+}
+
+static void spectrum_build_lut(spectrum_t *s)
+{
+    int range = s->max_dbm - s->min_dbm;
+    for (int i = 0; i < 256; i++) {
+        int dbm = i - 128;
+        int t = (dbm - s->min_dbm) * 255 / range;
+        if (t < 0) t = 0;
+        if (t > 255) t = 255;
+        s->lut[i] = spectrum_heat_color((uint8_t)t);
+        s->level[i] = (uint8_t)(t * s->height / 255);
+    }
+}
+
+static void spectrum_build_columns(spectrum_t *s)
+{
+    for (lv_coord_t x = 0; x < s->width; x++) {
+        s->col_bin[x] = s->bins ? (uint16_t)((uint32_t)x * s->bins / s->width) : 0;
+    }
+}
+
+static void spectrum_clear(spectrum_t *s)
+{
+    for (uint32_t i = 0; i < (uint32_t)s->width * s->height; i++) {
+        s->pixels[i] = SPECTRUM_BG_COLOR;
+    }
+    s->head = 0;
+}
+
+static void spectrum_render_bars(spectrum_t *s)
+{
+    for (lv_coord_t x = 0; x < s->width; x++) {
+        uint8_t idx = (uint8_t)(s->rssi[s->col_bin[x]] + 128);
+        s->span_lo[x] = s->height - s->level[idx];
+    }
+
+    // Row-major fill so the buffer is written sequentially
+    lv_color_t *p = s->pixels;
+    for (lv_coord_t y = 0; y < s->height; y++) {
+        for (lv_coord_t x = 0; x < s->width; x++) {
+            *p++ = y >= s->span_lo[x] ? SPECTRUM_FG_COLOR : SPECTRUM_BG_COLOR;
+        }
+    }
+}
+
+static void spectrum_render_line(spectrum_t *s)
+{
+    lv_coord_t prev = -1;
+    for (lv_coord_t x = 0; x < s->width; x++) {
+        uint8_t idx = (uint8_t)(s->rssi[s->col_bin[x]] + 128);
+        lv_coord_t y = LV_MIN(s->height - 1, s->height - s->level[idx]);
+        if (prev < 0) prev = y;
+        // Cover the vertical run from the previous column so the trace is connected
+        s->span_lo[x] = LV_MIN(prev, y);
+        s->span_hi[x] = LV_MAX(prev, y);
+        prev = y;
+    }
+
+    lv_color_t *p = s->pixels;
+    for (lv_coord_t y = 0; y < s->height; y++) {
+        for (lv_coord_t x = 0; x < s->width; x++) {
+            *p++ = (y >= s->span_lo[x] && y <= s->span_hi[x]) ? SPECTRUM_FG_COLOR : SPECTRUM_BG_COLOR;
+        }
+    }
+}
+
+static void spectrum_render_waterfall_row(spectrum_t *s)
+{
+    // Older rows stay where they are; only the new row is converted
+    s->head = s->head ? s->head - 1 : s->height - 1;
+    lv_color_t *row = &s->pixels[(uint32_t)s->head * s->width];
+    for (lv_coord_t x = 0; x < s->width; x++) {
+        row[x] = s->lut[(uint8_t)(s->rssi[s->col_bin[x]] + 128)];
+    }
+}
+
+static void spectrum_blit(lv_draw_ctx_t *draw_ctx, const lv_draw_img_dsc_t *dsc,
+                          lv_img_dsc_t *img, const lv_color_t *src, lv_coord_t x, lv_coord_t y,
+                          lv_coord_t w, lv_coord_t rows)
+{
+    if (rows <= 0) {
+        return;
+    }
+
+    img->header.cf = LV_IMG_CF_TRUE_COLOR;
+    img->header.always_zero = 0;
+    img->header.w = w;
+    img->header.h = rows;
+    img->data_size = (uint32_t)w * rows * sizeof(lv_color_t);
+    img->data = (const uint8_t *)src;
+
+    // The descriptor is reused with new data every frame
+    lv_img_cache_invalidate_src(img);
+
+    lv_area_t area = { .x1 = x, .y1 = y, .x2 = x + w - 1, .y2 = y + rows - 1 };
+    lv_draw_img(draw_ctx, dsc, &area, img);
+}
+
+static void spectrum_event_cb(lv_event_t *e)
+{
+    lv_obj_t *obj = lv_event_get_target(e);
+    spectrum_t *s = lv_obj_get_user_data(obj);
+    if (!s) {
+        return;
+    }
+
+    if (lv_event_get_code(e) == LV_EVENT_DELETE) {
+        free(s->pixels);
+        free(s);
+        lv_obj_set_user_data(obj, NULL);
+        return;
+    }
+
+    lv_draw_ctx_t *draw_ctx = lv_event_get_draw_ctx(e);
+    lv_area_t coords;
+    lv_obj_get_coords(obj, &coords);
+
+    lv_draw_img_dsc_t dsc;
+    lv_draw_img_dsc_init(&dsc);
+
+    // Newest row first: [head, height) on top, then [0, head) below it
+    lv_coord_t top_rows = s->height - s->head;
+    spectrum_blit(draw_ctx, &dsc, &s->img[0], &s->pixels[(uint32_t)s->head * s->width],
+                  coords.x1, coords.y1, s->width, top_rows);
+    spectrum_blit(draw_ctx, &dsc, &s->img[1], s->pixels,
+                  coords.x1, coords.y1 + top_rows, s->width, s->head);
+}
+
+/**
+ * @brief Create a spectrum / waterfall widget
+ */
+lv_obj_t* lvgl_create_spectrum(lv_obj_t *parent, lv_coord_t width, lv_coord_t height)
+{
+    if (width <= 0 || width > LCD_HEIGHT || height <= 0 || height > LCD_WIDTH) {
+        ESP_LOGE(TAG, "Invalid spectrum size %dx%d", width, height);
+        return NULL;
+    }
+
+    spectrum_t *s = calloc(1, sizeof(spectrum_t));
+    lv_color_t *pixels = malloc((size_t)width * height * sizeof(lv_color_t));
+    if (!s || !pixels) {
+        ESP_LOGE(TAG, "Failed to allocate spectrum buffer");
+        free(s);
+        free(pixels);
+        return NULL;
+    }
+
+    s->mode = LVGL_SPECTRUM_BARS;
+    s->width = width;
+    s->height = height;
+    s->min_dbm = -110;
+    s->max_dbm = -30;
+    s->pixels = pixels;
+    spectrum_build_lut(s);
+    spectrum_clear(s);
+
+    lv_obj_t *obj = lv_obj_create(parent);
+    lv_obj_remove_style_all(obj);
+    lv_obj_clear_flag(obj, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_set_size(obj, width, height);
+    lv_obj_set_user_data(obj, s);
+    lv_obj_add_event_cb(obj, spectrum_event_cb, LV_EVENT_DRAW_MAIN, NULL);
+    lv_obj_add_event_cb(obj, spectrum_event_cb, LV_EVENT_DELETE, NULL);
+
+    // Live spectra get the high frame rate cap
+    lvgl_port_set_screen_frame_profile(lv_obj_get_screen(obj), LVGL_FRAME_PROFILE_SPECTRUM);
+
+    return obj;
+}
+
+/**
+ * @brief Select bar, line or waterfall view
+ */
+void lvgl_spectrum_set_mode(lv_obj_t *spectrum, lvgl_spectrum_mode_t mode)
+{
+    spectrum_t *s = lv_obj_get_user_data(spectrum);
+    if (!s || s->mode == mode) {
+        return;
+    }
+
+    s->mode = mode;
+    spectrum_clear(s);
+    lv_obj_invalidate(spectrum);
+}
+
+/**
+ * @brief Set the dBm range mapped onto the widget
+ */
+void lvgl_spectrum_set_range(lv_obj_t *spectrum, int8_t min_dbm, int8_t max_dbm)
+{
+    spectrum_t *s = lv_obj_get_user_data(spectrum);
+    if (!s || min_dbm >= max_dbm) {
+        return;
+    }
+
+    s->min_dbm = min_dbm;
+    s->max_dbm = max_dbm;
+    spectrum_build_lut(s);
+}
+
+/**
+ * @brief Attach the RSSI buffer the widget draws from
+ */
+void lvgl_spectrum_set_buffer(lv_obj_t *spectrum, const int8_t *rssi, uint16_t bins)
+{
+    spectrum_t *s = lv_obj_get_user_data(spectrum);
+    if (!s) {
+        return;
+    }
+
+    s->rssi = bins ? rssi : NULL;
+    s->bins = bins;
+    spectrum_build_columns(s);
+}
+
+/**
+ * @brief Render the current buffer contents and invalidate the widget
+ */
+void lvgl_spectrum_refresh(lv_obj_t *spectrum)
+{
+    spectrum_t *s = lv_obj_get_user_data(spectrum);
+    if (!s || !s->rssi) {
+        return;
+    }
+
+    switch (s->mode) {
+    case LVGL_SPECTRUM_BARS:
+        spectrum_render_bars(s);
+        break;
+    case LVGL_SPECTRUM_LINE:
+        spectrum_render_line(s);
+        break;
+    case LVGL_SPECTRUM_WATERFALL:
+        spectrum_render_waterfall_row(s);
+        break;
+    }
+
+    lv_obj_invalidate(spectrum);
+}
@@ -0,0 +1,347 @@
+/**
+ * @file lvgl_latency.c
+ * @brief Input-to-photon latency tracing
+ *
+ * Every input event gets an id from the event ring. The first reader that
+ * takes it from the ring starts a trace in a small slot table, and later
+ * stages are stamped as they happen: the app handler around its call, the
+ * first invalidation LVGL records after dispatch (from the rounder
+ * callback), and the completion of the last flush of the refresh that
+ * draws it. Completed traces are split into segments and added to
+ * log2 histograms by the UI task; events that redraw nothing expire.
+ *
+ * Slots are claimed with a compare-and-swap and each stage is stamped
+ * once, by whichever task gets there first, so the input task, the UI
+ * task and the SPI completion ISR never wait for each other. Invalidation
+ * is attributed to every event dispatched before it, so a running
+ * animation makes the update segment look shorter than it is.
+ *
+ * On the host, time is LVGL's virtual tick plus the real time spent since
+ * the tick last moved, so frame scheduling is deterministic and the work
+ * inside a frame is still measured.
+ */
+
+#include "lvgl_port.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include <stdatomic.h>
+#include <string.h>
+#if LVGL_PORT_HEADLESS
+#include <time.h>
+#else
+#include "esp_timer.h"
+#endif
+
+static const char *TAG = "LVGL_LAT";
+
+#define SLOT_MASK           (LVGL_LATENCY_SLOTS - 1)
+#define KEY_RETIRED         0x80000000u     // Trace finished, key kept so late readers skip it
+#define KEY_OF(id)          ((uint32_t)(id) + 1)
+#define STAGE_BIT(stage)    (1u << (stage))
+
+_Static_assert((LVGL_LATENCY_SLOTS & SLOT_MASK) == 0, "slot count must be a power of two");
+
+typedef struct {
+    atomic_uint key;                    // Event id + 1, 0 when never used
+    atomic_uint claimed;                // Stages someone is stamping
+    atomic_uint stamped;                // Stages whose time is written
+    uint32_t t[LVGL_LATENCY_STAGE_MAX];
+    input_event_t event;
+    uint32_t refresh;                   // Refresh that draws it (LVGL locked)
+} trace_slot_t;
+
+static trace_slot_t s_slots[LVGL_LATENCY_SLOTS];
+static atomic_uint s_active;            // Slots with a trace in flight
+
+// Refreshes are counted when their last area is started (LVGL locked) and
+// when it completes (flush-ready, possibly in an ISR)
+static uint32_t s_refresh_started = 0;
+static atomic_bool s_flushing_last;
+static atomic_uint s_refresh_done;
+static atomic_uint s_refresh_done_us;
+
+static atomic_uint s_traced;
+static atomic_uint s_untraced;
+static lvgl_latency_stats_t s_stats = {0};
+
+#if LVGL_PORT_HEADLESS
+static uint32_t s_tick = 0;
+static uint64_t s_tick_real_us = 0;
+#endif
+
+static uint32_t IRAM_ATTR now_us(void)
+{
+#if LVGL_PORT_HEADLESS
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t real = (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+    uint32_t tick = lv_tick_get();
+    if (tick != s_tick) {
+        s_tick = tick;
+        s_tick_real_us = real;
+    }
+    return tick * 1000 + (uint32_t)(real - s_tick_real_us);
+#else
+    return (uint32_t)esp_timer_get_time();
+#endif
+}
+
+static void stamp(trace_slot_t *slot, lvgl_latency_stage_t stage, uint32_t t)
+{
+    uint32_t bit = STAGE_BIT(stage);
+    if (atomic_fetch_or_explicit(&slot->claimed, bit, memory_order_relaxed) & bit) {
+        return;
+    }
+    slot->t[stage] = t;
+    atomic_fetch_or_explicit(&slot->stamped, bit, memory_order_release);
+}
+
+static void retire(trace_slot_t *slot, uint32_t key)
+{
+    atomic_store_explicit(&slot->stamped, 0, memory_order_relaxed);
+    atomic_store_explicit(&slot->claimed, 0, memory_order_relaxed);
+    atomic_store_explicit(&slot->key, key | KEY_RETIRED, memory_order_release);
+    atomic_fetch_sub_explicit(&s_active, 1, memory_order_relaxed);
+}
+
+void lvgl_latency_begin(const input_data_t *event)
+{
+    trace_slot_t *slot = &s_slots[event->id & SLOT_MASK];
+    uint32_t key = KEY_OF(event->id);
+    uint32_t cur = atomic_load_explicit(&slot->key, memory_order_acquire);
+
+    // The other reader got here first, or the trace is already finished
+    if ((cur & ~KEY_RETIRED) == key) {
+        if (cur == key) {
+            stamp(slot, LVGL_LATENCY_DISPATCH, now_us());
+        }
+        return;
+    }
+
+    // Busy with an event that has not redrawn yet
+    if (cur && !(cur & KEY_RETIRED)) {
+        atomic_fetch_add_explicit(&s_untraced, 1, memory_order_relaxed);
+        return;
+    }
+
+    if (!atomic_compare_exchange_strong_explicit(&slot->key, &cur, key,
+                                                 memory_order_acq_rel,
+                                                 memory_order_acquire)) {
+        // The other reader claimed it just now, or another event did
+        if (cur == key) {
+            stamp(slot, LVGL_LATENCY_DISPATCH, now_us());
+        } else {
+            atomic_fetch_add_explicit(&s_untraced, 1, memory_order_relaxed);
+        }
+        return;
+    }
+
+    slot->event = event->event;
+    atomic_fetch_add_explicit(&s_active, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s_traced, 1, memory_order_relaxed);
+    stamp(slot, LVGL_LATENCY_ISR, event->time_us);
+    stamp(slot, LVGL_LATENCY_DISPATCH, now_us());
+}
+
+void lvgl_latency_mark(uint16_t id, lvgl_latency_stage_t stage)
+{
+    trace_slot_t *slot = &s_slots[id & SLOT_MASK];
+    if (atomic_load_explicit(&slot->key, memory_order_acquire) == KEY_OF(id)) {
+        stamp(slot, stage, now_us());
+    }
+}
+
+void lvgl_latency_invalidate(void)
+{
+    if (atomic_load_explicit(&s_active, memory_order_relaxed) == 0) {
+        return;
+    }
+
+    uint32_t t = now_us();
+    for (int i = 0; i < LVGL_LATENCY_SLOTS; i++) {
+        trace_slot_t *slot = &s_slots[i];
+        uint32_t key = atomic_load_explicit(&slot->key, memory_order_acquire);
+        uint32_t stamped = atomic_load_explicit(&slot->stamped, memory_order_acquire);
+
+        if (!key || (key & KEY_RETIRED) ||
+            !(stamped & STAGE_BIT(LVGL_LATENCY_DISPATCH)) ||
+            (stamped & STAGE_BIT(LVGL_LATENCY_INVALIDATE))) {
+            continue;
+        }
+        // Drawn by the next refresh to reach its last area
+        slot->refresh = s_refresh_started + 1;
+        stamp(slot, LVGL_LATENCY_INVALIDATE, t);
+    }
+}
+
+void lvgl_latency_flush_start(lv_disp_drv_t *disp_drv)
+{
+    bool last = lv_disp_flush_is_last(disp_drv);
+    if (last) {
+        s_refresh_started++;
+    }
+    atomic_store_explicit(&s_flushing_last, last, memory_order_relaxed);
+}
+
+void IRAM_ATTR lvgl_latency_flush_done(void)
+{
+    if (!atomic_load_explicit(&s_flushing_last, memory_order_relaxed)) {
+        return;
+    }
+    atomic_store_explicit(&s_refresh_done_us, now_us(), memory_order_relaxed);
+    atomic_fetch_add_explicit(&s_refresh_done, 1, memory_order_release);
+}
+
+static void hist_add(lvgl_latency_hist_t *hist, uint32_t us)
+{
+    int bucket = us ? 32 - __builtin_clz(us) : 0;
+    if (bucket >= LVGL_LATENCY_BUCKETS) {
+        bucket = LVGL_LATENCY_BUCKETS - 1;
+    }
+
+    hist->buckets[bucket]++;
+    if (!hist->count || us < hist->min_us) {
+        hist->min_us = us;
+    }
+    if (us > hist->max_us) {
+        hist->max_us = us;
+    }
+    hist->total_us += us;
+    hist->count++;
+}
+
+// Time between two stamps; a stage stamped by another task can land a
+// little before the one it follows, which counts as no time
+static uint32_t span(const trace_slot_t *slot, uint32_t stamped,
+                     lvgl_latency_stage_t from, lvgl_latency_stage_t to)
+{
+    if (!(stamped & STAGE_BIT(from)) || !(stamped & STAGE_BIT(to))) {
+        return 0;
+    }
+    int32_t d = (int32_t)(slot->t[to] - slot->t[from]);
+    return d > 0 ? (uint32_t)d : 0;
+}
+
+static void record(trace_slot_t *slot, uint32_t key, uint32_t stamped)
+{
+    lvgl_latency_record_t *rec = &s_stats.last;
+
+    rec->id = (uint16_t)(key - 1);
+    rec->event = slot->event;
+    rec->us[LVGL_LATENCY_QUEUE] = span(slot, stamped, LVGL_LATENCY_ISR, LVGL_LATENCY_DISPATCH);
+    rec->us[LVGL_LATENCY_HANDLER] = span(slot, stamped, LVGL_LATENCY_HANDLER_ENTER,
+                                         LVGL_LATENCY_HANDLER_EXIT);
+    rec->us[LVGL_LATENCY_UPDATE] = span(slot, stamped, LVGL_LATENCY_DISPATCH, LVGL_LATENCY_INVALIDATE);
+    rec->us[LVGL_LATENCY_RENDER] = span(slot, stamped, LVGL_LATENCY_INVALIDATE, LVGL_LATENCY_FLUSH_DONE);
+    rec->us[LVGL_LATENCY_TOTAL] = span(slot, stamped, LVGL_LATENCY_ISR, LVGL_LATENCY_FLUSH_DONE);
+
+    for (int i = 0; i < LVGL_LATENCY_SEGMENT_MAX; i++) {
+        // Events nobody handled have no handler segment
+        if (i == LVGL_LATENCY_HANDLER && !(stamped & STAGE_BIT(LVGL_LATENCY_HANDLER_EXIT))) {
+            continue;
+        }
+        hist_add(&s_stats.hist[i], rec->us[i]);
+    }
+    s_stats.completed++;
+}
+
+void lvgl_latency_collect(void)
+{
+    if (atomic_load_explicit(&s_active, memory_order_relaxed) == 0) {
+        return;
+    }
+
+    uint32_t done = atomic_load_explicit(&s_refresh_done, memory_order_acquire);
+    uint32_t done_us = atomic_load_explicit(&s_refresh_done_us, memory_order_relaxed);
+    uint32_t t = now_us();
+
+    for (int i = 0; i < LVGL_LATENCY_SLOTS; i++) {
+        trace_slot_t *slot = &s_slots[i];
+        uint32_t key = atomic_load_explicit(&slot->key, memory_order_acquire);
+        uint32_t stamped = atomic_load_explicit(&slot->stamped, memory_order_acquire);
+
+        // Free, finished, or still being started by a reader
+        if (!key || (key & KEY_RETIRED) || !(stamped & STAGE_BIT(LVGL_LATENCY_ISR))) {
+            continue;
+        }
+
+        if ((stamped & STAGE_BIT(LVGL_LATENCY_INVALIDATE)) &&
+            (int32_t)(done - slot->refresh) >= 0) {
+            slot->t[LVGL_LATENCY_FLUSH_DONE] = done_us;
+            record(slot, key, stamped | STAGE_BIT(LVGL_LATENCY_FLUSH_DONE));
+            retire(slot, key);
+        } else if (t - slot->t[LVGL_LATENCY_ISR] >= LVGL_LATENCY_EXPIRE_MS * 1000) {
+            s_stats.expired++;
+            retire(slot, key);
+        }
+    }
+}
+
+void lvgl_port_get_latency_stats(lvgl_latency_stats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+
+    memcpy(stats, &s_stats, sizeof(*stats));
+    stats->traced = atomic_load(&s_traced);
+    stats->untraced = atomic_load(&s_untraced);
+}
+
+void lvgl_port_reset_latency_stats(void)
+{
+    for (int i = 0; i < LVGL_LATENCY_SLOTS; i++) {
+        atomic_store(&s_slots[i].key, 0);
+        atomic_store(&s_slots[i].claimed, 0);
+        atomic_store(&s_slots[i].stamped, 0);
+    }
+    atomic_store(&s_active, 0);
+    atomic_store(&s_traced, 0);
+    atomic_store(&s_untraced, 0);
+    memset(&s_stats, 0, sizeof(s_stats));
+}
+
+uint32_t lvgl_latency_percentile(const lvgl_latency_hist_t *hist, uint8_t percent)
+{
+    if (!hist || !hist->count) {
+        return 0;
+    }
+
+    uint64_t rank = ((uint64_t)hist->count * percent + 99) / 100;
+    uint64_t seen = 0;
+
+    for (int i = 0; i < LVGL_LATENCY_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank && seen) {
+            uint32_t upper = i ? (1u << i) - 1 : 0;
+            return upper < hist->max_us ? upper : hist->max_us;
+        }
+    }
+    return hist->max_us;
+}
+
+void lvgl_port_log_latency_report(void)
+{
+    static const char *const names[LVGL_LATENCY_SEGMENT_MAX] = {
+        "queue", "handler", "update", "render", "total",
+    };
+    lvgl_latency_stats_t stats;
+    lvgl_port_get_latency_stats(&stats);
+
+    ESP_LOGI(TAG, "Input latency: %u traced, %u completed, %u expired, %u untraced",
+             (unsigned)stats.traced, (unsigned)stats.completed,
+             (unsigned)stats.expired, (unsigned)stats.untraced);
+
+    for (int i = 0; i < LVGL_LATENCY_SEGMENT_MAX; i++) {
+        const lvgl_latency_hist_t *hist = &stats.hist[i];
+        if (!hist->count) {
+            continue;
+        }
+        ESP_LOGI(TAG, "  %-8s n=%-5u min %6u  avg %6u  p50 %6u  p95 %6u  max %6u us",
+                 names[i], (unsigned)hist->count, (unsigned)hist->min_us,
+                 (unsigned)(hist->total_us / hist->count),
+                 (unsigned)lvgl_latency_percentile(hist, 50),
+                 (unsigned)lvgl_latency_percentile(hist, 95),
+                 (unsigned)hist->max_us);
+    }
+}
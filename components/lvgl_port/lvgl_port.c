@@ -4,12 +4,17 @@
  */
 
 #include "lvgl_port.h"
+#include "trace.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
-#include "driver/gpio.h"
 #include <string.h>
+#if LVGL_PORT_HEADLESS
+#include <time.h>
+#else
+#include "esp_timer.h"
+#endif
 
 static const char *TAG = "LVGL_PORT";
 
@@ -23,19 +28,34 @@ static bool s_initialized = false;
 static input_callback_t s_input_callback = NULL;
 static void *s_input_user_data = NULL;
 static lv_obj_t *s_notification_obj = NULL;
+static lv_timer_t *s_notification_timer = NULL;
 static lv_obj_t *s_loading_obj = NULL;
 
+// Frame pacing
+static TaskHandle_t s_ui_task = NULL;
+static uint64_t s_last_tick_us = 0;
+static uint32_t s_refr_period_ms = 0;
+
+// Lock metrics
+static lvgl_lock_stats_t s_lock_stats = {0};
+static uint64_t s_lock_taken_us = 0;
+
 // Forward declarations
 extern esp_err_t display_driver_init(lv_disp_t **disp);
 extern esp_err_t input_driver_init(lv_indev_t **indev);
 extern void display_driver_deinit(void);
 extern void input_driver_deinit(void);
+extern void input_driver_register_callback(input_callback_t callback, void *user_data);
 
-// LVGL tick callback
-static void lv_tick_task(void *arg)
+static uint64_t now_us(void)
 {
-    (void)arg;
-    lv_tick_inc(portTICK_PERIOD_MS);
+#if LVGL_PORT_HEADLESS
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+#else
+    return (uint64_t)esp_timer_get_time();
+#endif
 }
 
 esp_err_t lvgl_port_init(void)
@@ -70,14 +90,20 @@ esp_err_t lvgl_port_init(void)
         return ESP_ERR_NOT_FOUND;
     }
 
-    // Create tick task for LVGL
-    const esp_timer_create_args_t periodic_timer_args = {
-        .callback = &lv_tick_task,
-        .name = "lv_tick"
-    };
-    esp_timer_handle_t periodic_timer;
-    ESP_ERROR_CHECK(esp_timer_create(&periodic_timer_args, &periodic_timer));
-    ESP_ERROR_CHECK(esp_timer_start_periodic(periodic_timer, portTICK_PERIOD_MS * 1000));
+    // LVGL time is advanced from the elapsed wall time whenever the port is
+    // locked, so no periodic tick interrupt keeps the CPU awake
+    s_last_tick_us = now_us();
+    s_refr_period_ms = 0;
+    lvgl_port_reset_frame_stats();
+    lvgl_cmd_reset();
+    lvgl_port_reset_lock_stats();
+    lvgl_port_reset_latency_stats();
+#if LVGL_PORT_HEADLESS
+    // Headless builds run on LVGL time, advanced per rendered frame
+    lvgl_power_reset(lv_tick_get());
+#else
+    lvgl_power_reset((uint32_t)(s_last_tick_us / 1000));
+#endif
 
     // Set default theme
     lv_theme_t *theme = lv_theme_default_init(s_display, 
@@ -106,6 +132,8 @@ esp_err_t lvgl_port_deinit(void)
     input_driver_deinit();
 
     // Deinitialize LVGL
+    lvgl_text_cache_flush();
+    lvgl_screen_cache_flush();
     lv_deinit();
 
     // Delete mutex
@@ -116,6 +144,7 @@ esp_err_t lvgl_port_deinit(void)
 
     s_display = NULL;
     s_input_device = NULL;
+    s_ui_task = NULL;
     s_initialized = false;
 
     ESP_LOGI(TAG, "LVGL port deinitialized");
@@ -134,39 +163,226 @@ lv_indev_t* lvgl_port_get_input_device(void)
 
 void lvgl_port_set_brightness(uint8_t brightness)
 {
-    extern void hw_set_backlight(uint8_t brightness);
-    hw_set_backlight(brightness);
+    lvgl_power_set_brightness(brightness);
 }
 
 void lvgl_port_register_input_callback(input_callback_t callback, void *user_data)
 {
     s_input_callback = callback;
     s_input_user_data = user_data;
+    input_driver_register_callback(callback, user_data);
 }
 
 void lvgl_port_lock(void)
 {
-    if (s_lvgl_mutex) {
+    if (!s_lvgl_mutex) {
+        return;
+    }
+
+    // Try first so uncontended acquisitions cost no timestamp
+    if (xSemaphoreTake(s_lvgl_mutex, 0) != pdTRUE) {
+        uint64_t wait_start = now_us();
         xSemaphoreTake(s_lvgl_mutex, portMAX_DELAY);
+        uint32_t waited = (uint32_t)(now_us() - wait_start);
+
+        s_lock_stats.lock_contended++;
+        s_lock_stats.lock_wait_total_us += waited;
+        if (waited > s_lock_stats.lock_wait_max_us) {
+            s_lock_stats.lock_wait_max_us = waited;
+        }
     }
+    s_lock_stats.lock_acquisitions++;
+    s_lock_taken_us = now_us();
+
+#if !LVGL_PORT_HEADLESS
+    // Bring LVGL time up to date for whoever holds the lock (headless
+    // builds advance it per rendered frame instead)
+    uint64_t now = now_us();
+    uint32_t elapsed_ms = (uint32_t)((now - s_last_tick_us) / 1000);
+    if (elapsed_ms) {
+        lv_tick_inc(elapsed_ms);
+        s_last_tick_us += (uint64_t)elapsed_ms * 1000;
+    }
+#endif
 }
 
 void lvgl_port_unlock(void)
 {
-    if (s_lvgl_mutex) {
-        xSemaphoreGive(s_lvgl_mutex);
+    // Another task changed the UI: make sure a sleeping UI task renders it
+    bool wake = s_display && s_display->inv_p > 0 && s_ui_task &&
+                xTaskGetCurrentTaskHandle() != s_ui_task;
+
+    if (!s_lvgl_mutex) {
+        return;
+    }
+
+    uint32_t held = (uint32_t)(now_us() - s_lock_taken_us);
+    s_lock_stats.lock_hold_total_us += held;
+    if (held > s_lock_stats.lock_hold_max_us) {
+        s_lock_stats.lock_hold_max_us = held;
+    }
+
+    xSemaphoreGive(s_lvgl_mutex);
+
+    if (wake) {
+        lvgl_port_wake();
+    }
+}
+
+// Time until the earliest running LVGL timer is due (call with LVGL locked)
+static uint32_t next_timer_delay(void)
+{
+    uint32_t delay = LV_NO_TIMER_READY;
+    uint32_t now = lv_tick_get();
+
+    for (lv_timer_t *t = lv_timer_get_next(NULL); t; t = lv_timer_get_next(t)) {
+        if (t->paused) {
+            continue;
+        }
+        uint32_t elapsed = now - t->last_run;
+        uint32_t remaining = elapsed >= t->period ? 0 : t->period - elapsed;
+        if (remaining < delay) {
+            delay = remaining;
+        }
     }
+    return delay;
 }
 
-void lvgl_port_task(void)
+uint32_t lvgl_port_task(void)
 {
     if (!s_initialized) {
+        return LVGL_FRAME_IDLE_MAX_MS;
+    }
+
+    s_ui_task = xTaskGetCurrentTaskHandle();
+
+    lvgl_refresh_stats_t before, after;
+    lvgl_port_get_refresh_stats(&before);
+
+    uint64_t start = now_us();
+    TRACE(TRACE_UI_FRAME_BEGIN, 0, 0);
+
+    lvgl_port_lock();
+
+    // The refresh timer period is the frame rate cap of the active screen
+    lvgl_frame_profile_t profile = lvgl_port_get_screen_frame_profile(lv_scr_act());
+
+    // Close latency traces whose refresh has left the bus since last frame
+    lvgl_latency_collect();
+
+    // Asleep: leave invalidations pending until something wakes the display
+    uint32_t power_delay = lvgl_power_step((uint32_t)(start / 1000),
+                                           profile == LVGL_FRAME_PROFILE_SPECTRUM);
+    if (lvgl_port_get_power_state() == LVGL_POWER_SLEEP) {
+        lvgl_port_unlock();
+        lvgl_frame_account(start, 0, false, profile);
+        TRACE(TRACE_UI_FRAME_END, 0, 0);
+        return LVGL_FRAME_WAIT_FOREVER;
+    }
+
+    uint32_t period = lvgl_frame_period_ms(profile);
+    if (period != s_refr_period_ms) {
+        lv_timer_set_period(s_display->refr_timer, period);
+        s_refr_period_ms = period;
+    }
+
+    // Everything other tasks posted since the last frame, in one batch
+    lvgl_port_apply_commands();
+
+    // Collapse the invalidations gathered since the last frame before
+    // LVGL renders them
+    lvgl_dirty_merge_display(s_display);
+
+    // Woken up: poll input again in this frame
+    if (s_input_device) {
+        lv_timer_resume(s_input_device->driver->read_timer);
+    }
+
+    uint32_t timer_delay = lv_timer_handler();
+
+    // Off-screen construction in whatever is left of the frame budget
+    bool preloading = lvgl_preload_run(LVGL_PRELOAD_BUDGET_US);
+
+    // Nothing left to draw: stop the refresh timer until the next
+    // invalidation resumes it, and stop polling input unless a key is held.
+    // lvgl_port_wake() brings the UI task back for either.
+    if (s_display->inv_p == 0) {
+        lv_timer_pause(s_display->refr_timer);
+        if (s_input_device && s_input_device->proc.state != LV_INDEV_STATE_PRESSED) {
+            lv_timer_pause(s_input_device->driver->read_timer);
+        }
+        timer_delay = next_timer_delay();
+    }
+    if (preloading && timer_delay > period) {
+        timer_delay = period;
+    }
+    if (power_delay < timer_delay) {
+        timer_delay = power_delay;
+    }
+
+    lvgl_port_unlock();
+
+    uint64_t end = now_us();
+    lvgl_port_get_refresh_stats(&after);
+
+    lvgl_frame_account(start, (uint32_t)(end - start), after.flushes != before.flushes, profile);
+    TRACE(TRACE_UI_FRAME_END, after.flushes - before.flushes, 0);
+    return lvgl_frame_schedule(end, timer_delay);
+}
+
+void lvgl_port_wait_frame(uint32_t max_ms)
+{
+    s_ui_task = xTaskGetCurrentTaskHandle();
+
+    uint64_t start = now_us();
+    TickType_t ticks = max_ms == LVGL_FRAME_WAIT_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(max_ms);
+    ulTaskNotifyTake(pdTRUE, ticks);
+    lvgl_frame_account_sleep((uint32_t)((now_us() - start) / 1000));
+}
+
+void lvgl_port_get_lock_stats(lvgl_lock_stats_t *stats)
+{
+    if (!stats) {
         return;
     }
 
     lvgl_port_lock();
-    lv_timer_handler();
+    *stats = s_lock_stats;
     lvgl_port_unlock();
+    lvgl_cmd_get_stats(stats);
+}
+
+void lvgl_port_reset_lock_stats(void)
+{
+    memset(&s_lock_stats, 0, sizeof(s_lock_stats));
+    lvgl_cmd_reset_stats();
+}
+
+void lvgl_port_wake(void)
+{
+    if (s_ui_task) {
+        xTaskNotifyGive(s_ui_task);
+    }
+}
+
+bool lvgl_port_set_label_text(lv_obj_t *label, const char *text)
+{
+    if (!label || !text) {
+        return false;
+    }
+    
+    if (!lv_obj_check_type(label, &lv_label_class)) {
+        return lvgl_cached_label_set_text(label, text);
+    }
+    
+    const char *current = lv_label_get_text(label);
+    if (current && strcmp(current, text) == 0) {
+        lvgl_dirty_account_skipped_update();
+        return false;
+    }
+    
+    lv_label_set_text(label, text);
+    return true;
 }
 
 // UI Helper functions
@@ -176,6 +392,7 @@ lv_obj_t* lvgl_port_create_menu_screen(void)
     
     lv_obj_t *screen = lv_obj_create(NULL);
     lv_obj_set_style_bg_color(screen, lv_color_black(), 0);
+    lvgl_port_set_screen_frame_profile(screen, LVGL_FRAME_PROFILE_MENU);
     
     // Create status bar
     lv_obj_t *status_bar = lvgl_port_create_status_bar(screen);
@@ -239,13 +456,18 @@ void lvgl_port_update_status_bar(lv_obj_t *status_bar, bool wifi_connected,
     // Update time
     lv_obj_t *time_label = lv_obj_get_child(status_bar, 0);
     if (time_label && time_str) {
-        lv_label_set_text(time_label, time_str);
+        lvgl_port_set_label_text(time_label, time_str);
     }
     
     // Update Wi-Fi icon
     lv_obj_t *wifi_icon = lv_obj_get_child(status_bar, 1);
     if (wifi_icon) {
-        lv_obj_set_style_opa(wifi_icon, wifi_connected ? LV_OPA_COVER : LV_OPA_30, 0);
+        lv_opa_t opa = wifi_connected ? LV_OPA_COVER : LV_OPA_30;
+        if (lv_obj_get_style_opa(wifi_icon, LV_PART_MAIN) != opa) {
+            lv_obj_set_style_opa(wifi_icon, opa, 0);
+        } else {
+            lvgl_dirty_account_skipped_update();
+        }
     }
     
     // Update battery icon
@@ -263,7 +485,7 @@ void lvgl_port_update_status_bar(lv_obj_t *status_bar, bool wifi_connected,
         } else {
             battery_symbol = LV_SYMBOL_BATTERY_EMPTY;
         }
-        lv_label_set_text(battery_icon, battery_symbol);
+        lvgl_port_set_label_text(battery_icon, battery_symbol);
     }
     
     lvgl_port_unlock();
@@ -271,15 +493,29 @@ void lvgl_port_update_status_bar(lv_obj_t *status_bar, bool wifi_connected,
 
 static void notification_close_cb(lv_event_t *e)
 {
-    lv_obj_t *obj = lv_event_get_target(e);
-    lv_obj_del(obj);
+    // Popup deleted (by timeout or replacement): drop our references
     s_notification_obj = NULL;
+    if (s_notification_timer) {
+        lv_timer_del(s_notification_timer);
+        s_notification_timer = NULL;
+    }
+}
+
+static void notification_timer_cb(lv_timer_t *timer)
+{
+    s_notification_timer = NULL;
+    lv_timer_del(timer);
+    if (s_notification_obj) {
+        lv_obj_del(s_notification_obj);
+    }
 }
 
 void lvgl_port_show_notification(const char *title, const char *message, uint32_t timeout_ms)
 {
     if (!s_initialized) return;
     
+    lvgl_port_power_activity(LVGL_POWER_WAKE_NOTIFICATION);
+    
     lvgl_port_lock();
     
     // Remove existing notification
@@ -314,21 +550,9 @@ void lvgl_port_show_notification(const char *title, const char *message, uint32_
     }
     
     // Auto close timer
+    lv_obj_add_event_cb(s_notification_obj, notification_close_cb, LV_EVENT_DELETE, NULL);
     if (timeout_ms > 0) {
-        lv_obj_add_event_cb(s_notification_obj, notification_close_cb, LV_EVENT_DELETE, NULL);
-        
-        // Create timer to auto close
-        static lv_timer_t *close_timer = NULL;
-        if (close_timer) {
-            lv_timer_del(close_timer);
-        }
-        close_timer = lv_timer_create([](lv_timer_t *timer) {
-            if (s_notification_obj) {
-                lv_obj_del(s_notification_obj);
-                s_notification_obj = NULL;
-            }
-            lv_timer_del(timer);
-        }, timeout_ms, NULL);
+        s_notification_timer = lv_timer_create(notification_timer_cb, timeout_ms, NULL);
     }
     
     lvgl_port_unlock();
@@ -0,0 +1,193 @@
+/**
+ * @file lvgl_power.c
+ * @brief Display idle manager: dim, then stop rendering and sleep the panel
+ *
+ * After LVGL_POWER_DIM_MS without input the backlight drops to the dim
+ * level; after LVGL_POWER_SLEEP_MS the backlight goes off, the UI task stops
+ * rendering and the ST7789 enters sleep mode. The panel keeps its frame
+ * memory while asleep, so waking only needs SLPOUT and the backlight: the
+ * last frame is still there and whatever changed meanwhile is drawn on the
+ * next frame.
+ *
+ * Input and notifications report activity from any task; the state machine
+ * itself only runs on the UI task, with LVGL locked, from
+ * lvgl_power_step(). Time is passed in, so host tests drive it with a
+ * virtual clock.
+ */
+
+#include "lvgl_port.h"
+#include "esp_log.h"
+#include <stdatomic.h>
+#include <string.h>
+
+static const char *TAG = "LVGL_POWER";
+
+// Provided by the display driver
+extern void display_driver_set_sleep(bool sleep);
+
+static lvgl_power_state_t s_state = LVGL_POWER_ACTIVE;
+static uint8_t s_brightness = 255;          // Level for the active state
+static uint32_t s_dim_ms = LVGL_POWER_DIM_MS;
+static uint32_t s_sleep_ms = LVGL_POWER_SLEEP_MS;
+static uint32_t s_last_activity_ms = 0;
+static uint32_t s_last_step_ms = 0;
+static atomic_uint s_pending_wake;          // lvgl_power_source_t bits
+static lvgl_power_stats_t s_stats = {0};
+
+static void apply_backlight(uint8_t level)
+{
+    s_stats.brightness = level;
+#if !LVGL_PORT_HEADLESS
+    extern void hw_set_backlight(uint8_t brightness);
+    hw_set_backlight(level);
+#endif
+}
+
+static uint8_t dim_level(void)
+{
+    return s_brightness < LVGL_POWER_DIM_LEVEL ? s_brightness : LVGL_POWER_DIM_LEVEL;
+}
+
+static void enter_state(lvgl_power_state_t state)
+{
+    if (state == s_state) {
+        return;
+    }
+
+    // Panel first on the way up, backlight first on the way down, so the
+    // panel is never lit while it is blank
+    if (s_state == LVGL_POWER_SLEEP) {
+        display_driver_set_sleep(false);
+    }
+
+    switch (state) {
+    case LVGL_POWER_ACTIVE:
+        apply_backlight(s_brightness);
+        break;
+    case LVGL_POWER_DIMMED:
+        apply_backlight(dim_level());
+        s_stats.dims++;
+        break;
+    default:
+        apply_backlight(0);
+        display_driver_set_sleep(true);
+        s_stats.sleeps++;
+        break;
+    }
+
+    ESP_LOGD(TAG, "Power state %d -> %d", s_state, state);
+    s_state = state;
+    s_stats.state = state;
+}
+
+// Deepest state the idle time allows
+static lvgl_power_state_t idle_target(uint32_t idle_ms, bool live_content)
+{
+    // Live views (spectrum, waterfall) may dim but keep being drawn
+    if (s_sleep_ms && idle_ms >= s_sleep_ms && !live_content) {
+        return LVGL_POWER_SLEEP;
+    }
+    if (s_dim_ms && idle_ms >= s_dim_ms) {
+        return LVGL_POWER_DIMMED;
+    }
+    return LVGL_POWER_ACTIVE;
+}
+
+void lvgl_power_reset(uint32_t now_ms)
+{
+    atomic_store(&s_pending_wake, 0);
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_last_activity_ms = now_ms;
+    s_last_step_ms = now_ms;
+
+    if (s_state == LVGL_POWER_SLEEP) {
+        display_driver_set_sleep(false);
+    }
+    s_state = LVGL_POWER_ACTIVE;
+    s_stats.state = LVGL_POWER_ACTIVE;
+    apply_backlight(s_brightness);
+}
+
+uint32_t lvgl_power_step(uint32_t now_ms, bool live_content)
+{
+    s_stats.time_ms[s_state] += now_ms - s_last_step_ms;
+    s_last_step_ms = now_ms;
+
+    uint32_t wake = atomic_exchange(&s_pending_wake, 0);
+    if (wake) {
+        s_last_activity_ms = now_ms;
+        if (s_state != LVGL_POWER_ACTIVE) {
+            if (wake & LVGL_POWER_WAKE_INPUT) {
+                s_stats.wakes_input++;
+            } else {
+                s_stats.wakes_notification++;
+            }
+            enter_state(LVGL_POWER_ACTIVE);
+        }
+    }
+
+    uint32_t idle = now_ms - s_last_activity_ms;
+    lvgl_power_state_t target = idle_target(idle, live_content);
+    if (target > s_state) {
+        enter_state(target);
+    }
+
+    // Time until the next transition the idle timer will cause
+    uint32_t next = LVGL_POWER_NO_DEADLINE;
+    if (s_state < LVGL_POWER_DIMMED && s_dim_ms > idle) {
+        next = s_dim_ms - idle;
+    }
+    if (s_state < LVGL_POWER_SLEEP && !live_content && s_sleep_ms > idle &&
+        s_sleep_ms - idle < next) {
+        next = s_sleep_ms - idle;
+    }
+    return next;
+}
+
+bool lvgl_port_power_activity(lvgl_power_source_t source)
+{
+    atomic_fetch_or(&s_pending_wake, source);
+    lvgl_port_wake();
+    return s_state == LVGL_POWER_SLEEP;
+}
+
+void lvgl_port_set_power_timeouts(uint32_t dim_ms, uint32_t sleep_ms)
+{
+    s_dim_ms = dim_ms;
+    s_sleep_ms = sleep_ms;
+
+    // Re-evaluate against the new timeouts right away
+    lvgl_port_wake();
+}
+
+void lvgl_power_set_brightness(uint8_t brightness)
+{
+    s_brightness = brightness;
+    if (s_state == LVGL_POWER_ACTIVE) {
+        apply_backlight(brightness);
+    } else if (s_state == LVGL_POWER_DIMMED) {
+        apply_backlight(dim_level());
+    }
+}
+
+lvgl_power_state_t lvgl_port_get_power_state(void)
+{
+    return s_state;
+}
+
+void lvgl_port_get_power_stats(lvgl_power_stats_t *stats)
+{
+    if (stats) {
+        *stats = s_stats;
+    }
+}
+
+void lvgl_port_reset_power_stats(void)
+{
+    lvgl_power_state_t state = s_stats.state;
+    uint8_t brightness = s_stats.brightness;
+
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_stats.state = state;
+    s_stats.brightness = brightness;
+}
@@ -0,0 +1,538 @@
+/**
+ * @file lvgl_screen_cache.c
+ * @brief App screen snapshots, launch previews and budgeted screen preloading
+ *
+ * When an app closes, its last screen is redrawn once and run-length
+ * compressed row by row straight out of the flush callback, so no
+ * full-screen buffer is ever needed. The last few snapshots are kept in a
+ * small LRU. Launching the same app again shows its snapshot on a preview
+ * screen at once, while the app builds its live screen off-screen; the live
+ * screen replaces the preview when the app loads it.
+ *
+ * Native screens can also be built off-screen in steps: preload jobs run on
+ * the UI task after each frame within a fixed time budget.
+ */
+
+#include "lvgl_port.h"
+#include "esp_log.h"
+#include <stdlib.h>
+#include <string.h>
+#if LVGL_PORT_HEADLESS
+#include <time.h>
+#else
+#include "esp_timer.h"
+#endif
+
+static const char *TAG = "LVGL_SCREEN";
+
+#define SNAPSHOT_MAX_DIM    LV_MAX(LCD_WIDTH, LCD_HEIGHT)
+#define SNAPSHOT_RUN        0x8000  // Token flag: one colour repeated
+#define SNAPSHOT_MAX_COUNT  0x7FFF
+#define SNAPSHOT_MIN_RUN    3       // Shorter repeats stay in literal runs
+#define SNAPSHOT_GROW_WORDS 4096
+
+// Row-wise RLE of lv_color_t values. A row is a list of tokens: a count
+// with SNAPSHOT_RUN set followed by one colour, or a plain count followed
+// by that many colours.
+typedef struct {
+    char app_id[LVGL_SCREEN_CACHE_ID_LEN];
+    uint32_t last_used;
+    lv_coord_t width;
+    lv_coord_t height;
+    uint32_t *rows;             // Word offset of each row, height + 1 entries
+    uint16_t *data;
+    size_t bytes;
+} screen_snapshot_t;
+
+typedef struct {
+    lvgl_preload_step_t step;
+    void *user_data;
+} preload_job_t;
+
+static screen_snapshot_t s_snapshots[LVGL_SCREEN_CACHE_SLOTS];
+static size_t s_snapshot_bytes = 0;
+static uint32_t s_use_clock = 0;
+
+// Capture in progress, filled by the flush callback
+static struct {
+    bool active;
+    bool failed;
+    lv_coord_t width;
+    lv_coord_t height;
+    lv_coord_t next_row;
+    uint16_t *data;
+    uint32_t words;
+    uint32_t cap;
+    uint32_t rows[SNAPSHOT_MAX_DIM + 1];
+} s_capture;
+
+// Launch being measured
+static struct {
+    uint64_t start_us;
+    bool waiting_first_pixel;
+    bool waiting_ready;
+    lv_obj_t *preview;
+    lv_obj_t *prev_screen;          // Shown before the launch, for aborts
+    screen_snapshot_t *snapshot;    // Pinned while the preview is shown
+} s_launch;
+
+static preload_job_t s_jobs[LVGL_PRELOAD_MAX_JOBS];
+static lvgl_launch_stats_t s_stats = {0};
+static uint64_t s_total_first_pixel_us = 0;
+static uint64_t s_total_ready_us = 0;
+
+static uint64_t now_us(void)
+{
+#if LVGL_PORT_HEADLESS
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+#else
+    return (uint64_t)esp_timer_get_time();
+#endif
+}
+
+static screen_snapshot_t* snapshot_find(const char *app_id)
+{
+    for (int i = 0; i < LVGL_SCREEN_CACHE_SLOTS; i++) {
+        if (s_snapshots[i].data && strcmp(s_snapshots[i].app_id, app_id) == 0) {
+            return &s_snapshots[i];
+        }
+    }
+    return NULL;
+}
+
+static void snapshot_free(screen_snapshot_t *snap)
+{
+    s_snapshot_bytes -= snap->bytes;
+    free(snap->rows);
+    memset(snap, 0, sizeof(*snap));
+}
+
+// Least recently used snapshot that is not on screen
+static screen_snapshot_t* snapshot_lru(void)
+{
+    screen_snapshot_t *oldest = NULL;
+    for (int i = 0; i < LVGL_SCREEN_CACHE_SLOTS; i++) {
+        screen_snapshot_t *snap = &s_snapshots[i];
+        if (!snap->data || snap == s_launch.snapshot) {
+            continue;
+        }
+        if (!oldest || snap->last_used < oldest->last_used) {
+            oldest = snap;
+        }
+    }
+    return oldest;
+}
+
+static bool capture_reserve(uint32_t words)
+{
+    if (s_capture.words + words <= s_capture.cap) {
+        return true;
+    }
+
+    // Screens that compress this badly are not worth keeping
+    uint32_t cap = s_capture.cap + LV_MAX(words, SNAPSHOT_GROW_WORDS);
+    if (cap * sizeof(uint16_t) > LVGL_SCREEN_CACHE_MAX_BYTES) {
+        return false;
+    }
+
+    uint16_t *data = realloc(s_capture.data, cap * sizeof(uint16_t));
+    if (!data) {
+        return false;
+    }
+    s_capture.data = data;
+    s_capture.cap = cap;
+    return true;
+}
+
+static bool capture_row(const lv_color_t *px, lv_coord_t w)
+{
+    // Worst case is one literal token per SNAPSHOT_MAX_COUNT pixels
+    if (!capture_reserve(w + 1 + w / SNAPSHOT_MAX_COUNT)) {
+        return false;
+    }
+
+    uint16_t *out = s_capture.data + s_capture.words;
+    lv_coord_t x = 0;
+
+    while (x < w) {
+        lv_coord_t run = 1;
+        while (x + run < w && run < SNAPSHOT_MAX_COUNT && px[x + run].full == px[x].full) {
+            run++;
+        }
+
+        if (run >= SNAPSHOT_MIN_RUN) {
+            *out++ = SNAPSHOT_RUN | run;
+            *out++ = px[x].full;
+            x += run;
+            continue;
+        }
+
+        // Literal run up to the next repeat worth encoding
+        lv_coord_t end = x;
+        while (end < w && end - x < SNAPSHOT_MAX_COUNT &&
+               !(end + 2 < w && px[end].full == px[end + 1].full &&
+                 px[end].full == px[end + 2].full)) {
+            end++;
+        }
+        *out++ = end - x;
+        for (; x < end; x++) {
+            *out++ = px[x].full;
+        }
+    }
+
+    s_capture.words = out - s_capture.data;
+    return true;
+}
+
+void lvgl_screen_cache_account_flush(const lv_area_t *area, const lv_color_t *color_p)
+{
+    if (s_launch.waiting_first_pixel) {
+        uint32_t latency = (uint32_t)(now_us() - s_launch.start_us);
+        s_launch.waiting_first_pixel = false;
+        s_stats.last_first_pixel_us = latency;
+        s_total_first_pixel_us += latency;
+        s_stats.avg_first_pixel_us = (uint32_t)(s_total_first_pixel_us / s_stats.launches);
+        if (latency > s_stats.max_first_pixel_us) {
+            s_stats.max_first_pixel_us = latency;
+        }
+    }
+
+    if (!s_capture.active || s_capture.failed) {
+        return;
+    }
+
+    // A full-screen refresh arrives as full-width strips, top to bottom
+    lv_coord_t w = area->x2 - area->x1 + 1;
+    if (area->x1 != 0 || w != s_capture.width || area->y1 != s_capture.next_row) {
+        s_capture.failed = true;
+        return;
+    }
+
+    for (lv_coord_t y = area->y1; y <= area->y2 && y < s_capture.height; y++) {
+        s_capture.rows[y] = s_capture.words;
+        if (!capture_row(color_p, w)) {
+            s_capture.failed = true;
+            return;
+        }
+        color_p += w;
+        s_capture.next_row = y + 1;
+    }
+}
+
+esp_err_t lvgl_port_screen_cache_store(const char *app_id)
+{
+    lv_disp_t *disp = lvgl_port_get_display();
+    if (!app_id || !app_id[0] || !disp) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    lvgl_port_lock();
+
+    // Redraw the active screen once with the capture armed
+    memset(&s_capture, 0, sizeof(s_capture));
+    s_capture.width = lv_disp_get_hor_res(disp);
+    s_capture.height = lv_disp_get_ver_res(disp);
+    s_capture.active = true;
+
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(disp);
+
+    s_capture.active = false;
+    bool complete = !s_capture.failed && s_capture.next_row == s_capture.height;
+
+    esp_err_t ret = ESP_OK;
+    uint32_t *rows = NULL;
+    size_t bytes = (s_capture.height + 1) * sizeof(uint32_t) + s_capture.words * sizeof(uint16_t);
+
+    if (complete) {
+        // Offsets and tokens in one block
+        rows = malloc(bytes);
+    }
+    if (!rows) {
+        s_stats.captures_failed++;
+        ret = complete ? ESP_ERR_NO_MEM : ESP_ERR_INVALID_SIZE;
+        ESP_LOGD(TAG, "Snapshot of %s not kept", app_id);
+    } else {
+        s_capture.rows[s_capture.height] = s_capture.words;
+        memcpy(rows, s_capture.rows, (s_capture.height + 1) * sizeof(uint32_t));
+        uint16_t *data = (uint16_t *)(rows + s_capture.height + 1);
+        memcpy(data, s_capture.data, s_capture.words * sizeof(uint16_t));
+
+        screen_snapshot_t *snap = snapshot_find(app_id);
+        if (snap && snap != s_launch.snapshot) {
+            snapshot_free(snap);
+        }
+
+        // Make room under the byte budget and in the table
+        screen_snapshot_t *victim;
+        while (s_snapshot_bytes + bytes > LVGL_SCREEN_CACHE_BYTES && (victim = snapshot_lru())) {
+            snapshot_free(victim);
+            s_stats.snapshot_evictions++;
+        }
+
+        snap = NULL;
+        for (int i = 0; i < LVGL_SCREEN_CACHE_SLOTS && !snap; i++) {
+            if (!s_snapshots[i].data) {
+                snap = &s_snapshots[i];
+            }
+        }
+        if (!snap && (snap = snapshot_lru())) {
+            snapshot_free(snap);
+            s_stats.snapshot_evictions++;
+        }
+
+        if (!snap || s_snapshot_bytes + bytes > LVGL_SCREEN_CACHE_BYTES) {
+            free(rows);
+            s_stats.captures_failed++;
+            ret = ESP_ERR_NO_MEM;
+        } else {
+            snprintf(snap->app_id, sizeof(snap->app_id), "%s", app_id);
+            snap->last_used = ++s_use_clock;
+            snap->width = s_capture.width;
+            snap->height = s_capture.height;
+            snap->rows = rows;
+            snap->data = data;
+            snap->bytes = bytes;
+            s_snapshot_bytes += bytes;
+            ESP_LOGD(TAG, "Snapshot of %s: %u bytes", app_id, (unsigned)bytes);
+        }
+    }
+
+    free(s_capture.data);
+    s_capture.data = NULL;
+
+    lvgl_port_unlock();
+    return ret;
+}
+
+void lvgl_port_screen_cache_drop(const char *app_id)
+{
+    lvgl_port_lock();
+    screen_snapshot_t *snap = app_id ? snapshot_find(app_id) : NULL;
+    if (snap && snap != s_launch.snapshot) {
+        snapshot_free(snap);
+    }
+    lvgl_port_unlock();
+}
+
+// Decode columns x1..x2 of one snapshot row
+static void snapshot_decode_row(const screen_snapshot_t *snap, lv_coord_t y,
+                                lv_coord_t x1, lv_coord_t x2, lv_color_t *dst)
+{
+    const uint16_t *p = snap->data + snap->rows[y];
+    const uint16_t *end = snap->data + snap->rows[y + 1];
+    lv_coord_t x = 0;
+
+    while (p < end && x <= x2) {
+        uint16_t token = *p++;
+        lv_coord_t count = token & SNAPSHOT_MAX_COUNT;
+        lv_coord_t from = LV_MAX(x, x1);
+        lv_coord_t to = LV_MIN(x + count - 1, x2);
+
+        if (token & SNAPSHOT_RUN) {
+            for (lv_coord_t i = from; i <= to; i++) {
+                dst[i - x1].full = *p;
+            }
+            p++;
+        } else {
+            for (lv_coord_t i = from; i <= to; i++) {
+                dst[i - x1].full = p[i - x];
+            }
+            p += count;
+        }
+        x += count;
+    }
+}
+
+static void preview_event_cb(lv_event_t *e)
+{
+    const screen_snapshot_t *snap = s_launch.snapshot;
+    if (!snap) {
+        return;
+    }
+
+    lv_draw_ctx_t *draw_ctx = lv_event_get_draw_ctx(e);
+    lv_area_t clip;
+    lv_area_t full = { 0, 0, snap->width - 1, snap->height - 1 };
+    if (!_lv_area_intersect(&clip, draw_ctx->clip_area, &full)) {
+        return;
+    }
+
+    // The preview covers the whole screen with opaque pixels, so rows are
+    // decoded straight into the draw buffer instead of blended as an image
+    lv_coord_t buf_w = lv_area_get_width(draw_ctx->buf_area);
+    lv_color_t *buf = draw_ctx->buf;
+    for (lv_coord_t y = clip.y1; y <= clip.y2; y++) {
+        lv_color_t *dst = buf + (y - draw_ctx->buf_area->y1) * buf_w +
+                          (clip.x1 - draw_ctx->buf_area->x1);
+        snapshot_decode_row(snap, y, clip.x1, clip.x2, dst);
+    }
+}
+
+static void preview_close(void)
+{
+    // Never delete the active screen: callers load another one first
+    if (s_launch.preview && s_launch.preview != lv_scr_act()) {
+        lv_obj_del(s_launch.preview);
+        s_launch.preview = NULL;
+    }
+    s_launch.snapshot = NULL;
+}
+
+esp_err_t lvgl_port_launch_begin(const char *app_id)
+{
+    if (!app_id) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    lvgl_port_lock();
+
+    s_launch.start_us = now_us();
+    s_launch.waiting_first_pixel = true;
+    s_launch.waiting_ready = true;
+    s_stats.launches++;
+
+    if (lv_scr_act() != s_launch.preview) {
+        s_launch.prev_screen = lv_scr_act();
+    }
+
+    screen_snapshot_t *snap = snapshot_find(app_id);
+    s_launch.snapshot = snap;
+    if (snap) {
+        snap->last_used = ++s_use_clock;
+        if (!s_launch.preview) {
+            s_launch.preview = lv_obj_create(NULL);
+            lv_obj_remove_style_all(s_launch.preview);
+            lv_obj_add_event_cb(s_launch.preview, preview_event_cb, LV_EVENT_DRAW_MAIN, NULL);
+        }
+        if (lv_scr_act() == s_launch.preview) {
+            lv_obj_invalidate(s_launch.preview);
+        } else {
+            lv_scr_load(s_launch.preview);
+        }
+        s_stats.snapshot_hits++;
+    }
+
+    lvgl_port_unlock();
+
+    // Render the preview now rather than on the next timer deadline
+    lvgl_port_wake();
+    return ESP_OK;
+}
+
+void lvgl_port_load_screen(lv_obj_t *screen)
+{
+    if (!screen) {
+        return;
+    }
+
+    lvgl_port_lock();
+
+    lv_scr_load(screen);
+    preview_close();
+
+    if (s_launch.waiting_ready) {
+        uint32_t latency = (uint32_t)(now_us() - s_launch.start_us);
+        s_launch.waiting_ready = false;
+        s_stats.last_ready_us = latency;
+        s_total_ready_us += latency;
+        s_stats.avg_ready_us = (uint32_t)(s_total_ready_us / s_stats.launches);
+    }
+
+    lvgl_port_unlock();
+}
+
+void lvgl_port_launch_abort(void)
+{
+    lvgl_port_lock();
+
+    // Go back to where the launch started from
+    if (s_launch.preview && lv_scr_act() == s_launch.preview &&
+        s_launch.prev_screen && lv_obj_is_valid(s_launch.prev_screen)) {
+        lv_scr_load(s_launch.prev_screen);
+    }
+    preview_close();
+    s_launch.waiting_first_pixel = false;
+    s_launch.waiting_ready = false;
+
+    lvgl_port_unlock();
+}
+
+esp_err_t lvgl_port_preload(lvgl_preload_step_t step, void *user_data)
+{
+    if (!step) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (int i = 0; i < LVGL_PRELOAD_MAX_JOBS; i++) {
+        if (!s_jobs[i].step) {
+            s_jobs[i].step = step;
+            s_jobs[i].user_data = user_data;
+            lvgl_port_wake();
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+bool lvgl_preload_run(uint32_t budget_us)
+{
+    uint64_t start = now_us();
+    bool pending = false;
+
+    // Round-robin one step per job until the budget runs out
+    do {
+        pending = false;
+        for (int i = 0; i < LVGL_PRELOAD_MAX_JOBS; i++) {
+            preload_job_t *job = &s_jobs[i];
+            if (!job->step) {
+                continue;
+            }
+            s_stats.preload_steps++;
+            if (job->step(job->user_data)) {
+                job->step = NULL;
+                s_stats.preload_jobs_done++;
+            } else {
+                pending = true;
+            }
+        }
+    } while (pending && now_us() - start < budget_us);
+
+    return pending;
+}
+
+void lvgl_port_get_launch_stats(lvgl_launch_stats_t *stats)
+{
+    if (stats) {
+        *stats = s_stats;
+        stats->snapshot_bytes = s_snapshot_bytes;
+        stats->snapshots = 0;
+        for (int i = 0; i < LVGL_SCREEN_CACHE_SLOTS; i++) {
+            if (s_snapshots[i].data) {
+                stats->snapshots++;
+            }
+        }
+    }
+}
+
+void lvgl_port_reset_launch_stats(void)
+{
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_total_first_pixel_us = 0;
+    s_total_ready_us = 0;
+}
+
+void lvgl_screen_cache_flush(void)
+{
+    // Preview and jobs refer to LVGL objects that are about to go away
+    memset(&s_launch, 0, sizeof(s_launch));
+    memset(s_jobs, 0, sizeof(s_jobs));
+
+    for (int i = 0; i < LVGL_SCREEN_CACHE_SLOTS; i++) {
+        if (s_snapshots[i].data) {
+            snapshot_free(&s_snapshots[i]);
+        }
+    }
+}
@@ -0,0 +1,471 @@
+/**
+ * @file lvgl_text_cache.c
+ * @brief Glyph and text-layout cache for frequently updated labels
+ *
+ * Readouts such as "RSSI: -67 dBm" change a few digits many times a second.
+ * A cached label keeps the layout of its text, so an update only
+ * invalidates the glyph cells that actually changed. When LVGL redraws
+ * those cells, glyphs come pre-rasterised as A8 bitmaps from a bounded LRU
+ * shared by all cached labels. Layouts of recently shown strings are kept
+ * in a second small LRU, so alternating values skip the layout pass too.
+ * Font, colour and letter spacing come from the object's style, inherited
+ * like a plain lv_label's.
+ */
+
+#include "lvgl_port.h"
+#include "esp_log.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "LVGL_TEXT";
+
+#define GLYPH_CACHE_ENTRIES     96
+#define GLYPH_CACHE_BYTES       (12 * 1024)
+#define LAYOUT_CACHE_ENTRIES    16
+#define CACHED_LABEL_MAGIC      0x54585443  // "TXTC"
+
+typedef struct {
+    const lv_font_t *font;
+    uint32_t letter;
+    uint32_t last_used;
+    lv_font_glyph_dsc_t dsc;
+    uint8_t *a8;                // box_w * box_h alpha values
+    lv_img_dsc_t img;
+} glyph_entry_t;
+
+typedef struct {
+    const lv_font_t *font;
+    lv_coord_t letter_space;
+    uint32_t hash;
+    uint32_t last_used;
+    uint8_t len;                // Glyphs, not bytes
+    char text[LVGL_CACHED_LABEL_MAX_CHARS * 4 + 1];
+    uint32_t letters[LVGL_CACHED_LABEL_MAX_CHARS];
+    lv_coord_t x[LVGL_CACHED_LABEL_MAX_CHARS + 1];
+} layout_entry_t;
+
+typedef struct {
+    uint32_t magic;
+    const lv_font_t *font;      // Style the layout below was made with
+    lv_coord_t letter_space;
+    uint8_t len;
+    char text[LVGL_CACHED_LABEL_MAX_CHARS * 4 + 1];
+    uint32_t letters[LVGL_CACHED_LABEL_MAX_CHARS];
+    lv_coord_t x[LVGL_CACHED_LABEL_MAX_CHARS + 1];
+} cached_label_t;
+
+static glyph_entry_t s_glyphs[GLYPH_CACHE_ENTRIES];
+static size_t s_glyph_bytes = 0;
+static layout_entry_t s_layouts[LAYOUT_CACHE_ENTRIES];
+static uint32_t s_use_clock = 0;
+static lvgl_text_cache_stats_t s_stats = {0};
+
+static uint32_t text_hash(const char *text)
+{
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    while (*text) {
+        h ^= (uint8_t)*text++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static uint32_t utf8_next(const char **p)
+{
+    const uint8_t *s = (const uint8_t *)*p;
+    uint32_t c = s[0];
+    int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+
+    if (extra) {
+        c &= 0x3F >> extra;
+    }
+    s++;
+    for (int i = 0; i < extra && (*s & 0xC0) == 0x80; i++) {
+        c = (c << 6) | (*s++ & 0x3F);
+    }
+
+    *p = (const char *)s;
+    return c;
+}
+
+// The part of text a label shows: whole glyphs, at most
+// LVGL_CACHED_LABEL_MAX_CHARS of them
+static void clip_text(const char *text, char *out, size_t size)
+{
+    const char *p = text;
+    const char *end = text;
+    for (int n = 0; *p && n < LVGL_CACHED_LABEL_MAX_CHARS; n++) {
+        utf8_next(&p);
+        if ((size_t)(p - text) >= size) {
+            break;
+        }
+        end = p;
+    }
+    memcpy(out, text, end - text);
+    out[end - text] = '\0';
+}
+
+static void glyph_evict(glyph_entry_t *e)
+{
+    lv_img_cache_invalidate_src(&e->img);
+    s_glyph_bytes -= (size_t)e->dsc.box_w * e->dsc.box_h;
+    free(e->a8);
+    memset(e, 0, sizeof(*e));
+    s_stats.glyph_evictions++;
+}
+
+// Free slot if there is one, otherwise the least recently used entry
+static glyph_entry_t* glyph_slot(bool want_free)
+{
+    glyph_entry_t *oldest = NULL;
+    for (int i = 0; i < GLYPH_CACHE_ENTRIES; i++) {
+        if (!s_glyphs[i].font) {
+            if (want_free) {
+                return &s_glyphs[i];
+            }
+            continue;
+        }
+        if (!oldest || s_glyphs[i].last_used < oldest->last_used) {
+            oldest = &s_glyphs[i];
+        }
+    }
+    return oldest;
+}
+
+// Expand an LVGL glyph bitmap (1/2/4/8 bpp, rows not padded) to A8
+static void glyph_to_a8(const uint8_t *src, uint8_t bpp, uint32_t px, uint8_t *dst)
+{
+    static const uint8_t scale2[4] = {0, 85, 170, 255};
+    uint32_t bit = 0;
+
+    for (uint32_t i = 0; i < px; i++, bit += bpp) {
+        uint8_t v = (src[bit >> 3] >> (8 - bpp - (bit & 7))) & ((1 << bpp) - 1);
+        switch (bpp) {
+        case 1: dst[i] = v ? 255 : 0; break;
+        case 2: dst[i] = scale2[v]; break;
+        case 4: dst[i] = v * 17; break;
+        default: dst[i] = v; break;
+        }
+    }
+}
+
+static const glyph_entry_t* glyph_get(const lv_font_t *font, uint32_t letter)
+{
+    for (int i = 0; i < GLYPH_CACHE_ENTRIES; i++) {
+        glyph_entry_t *e = &s_glyphs[i];
+        if (e->font == font && e->letter == letter) {
+            e->last_used = ++s_use_clock;
+            s_stats.glyph_hits++;
+            return e;
+        }
+    }
+
+    s_stats.glyph_misses++;
+
+    lv_font_glyph_dsc_t dsc;
+    if (!lv_font_get_glyph_dsc(font, &dsc, letter, 0)) {
+        return NULL;
+    }
+
+    size_t bytes = (size_t)dsc.box_w * dsc.box_h;
+    const uint8_t *bitmap = bytes ? lv_font_get_glyph_bitmap(font, letter) : NULL;
+    if (bytes && !bitmap) {
+        return NULL;
+    }
+
+    // Make room under the byte budget and in the table, oldest first
+    glyph_entry_t *victim;
+    while (s_glyph_bytes + bytes > GLYPH_CACHE_BYTES && (victim = glyph_slot(false))) {
+        glyph_evict(victim);
+    }
+    glyph_entry_t *slot = glyph_slot(true);
+    if (slot->font) {
+        glyph_evict(slot);
+    }
+
+    uint8_t *a8 = NULL;
+    if (bytes) {
+        a8 = malloc(bytes);
+        if (!a8) {
+            ESP_LOGW(TAG, "Glyph cache allocation failed");
+            return NULL;
+        }
+        glyph_to_a8(bitmap, dsc.bpp, bytes, a8);
+    }
+
+    slot->font = font;
+    slot->letter = letter;
+    slot->last_used = ++s_use_clock;
+    slot->dsc = dsc;
+    slot->a8 = a8;
+    slot->img.header.cf = LV_IMG_CF_ALPHA_8BIT;
+    slot->img.header.always_zero = 0;
+    slot->img.header.w = dsc.box_w;
+    slot->img.header.h = dsc.box_h;
+    slot->img.data_size = bytes;
+    slot->img.data = a8;
+    s_glyph_bytes += bytes;
+    return slot;
+}
+
+static const layout_entry_t* layout_get(const lv_font_t *font, lv_coord_t letter_space,
+                                        const char *text)
+{
+    uint32_t hash = text_hash(text);
+
+    for (int i = 0; i < LAYOUT_CACHE_ENTRIES; i++) {
+        layout_entry_t *e = &s_layouts[i];
+        if (e->font == font && e->hash == hash && e->letter_space == letter_space &&
+            strcmp(e->text, text) == 0) {
+            e->last_used = ++s_use_clock;
+            s_stats.layout_hits++;
+            return e;
+        }
+    }
+
+    s_stats.layout_misses++;
+
+    layout_entry_t *e = &s_layouts[0];
+    for (int i = 1; i < LAYOUT_CACHE_ENTRIES; i++) {
+        if (s_layouts[i].last_used < e->last_used) {
+            e = &s_layouts[i];
+        }
+    }
+
+    e->font = font;
+    e->letter_space = letter_space;
+    e->hash = hash;
+    e->last_used = ++s_use_clock;
+    e->len = 0;
+    e->x[0] = 0;
+    clip_text(text, e->text, sizeof(e->text));
+
+    // Advance widths include kerning against the following letter
+    const char *p = text;
+    uint32_t letter = *p ? utf8_next(&p) : 0;
+    while (letter && e->len < LVGL_CACHED_LABEL_MAX_CHARS) {
+        uint32_t next = *p ? utf8_next(&p) : 0;
+        lv_font_glyph_dsc_t dsc;
+        lv_coord_t adv = lv_font_get_glyph_dsc(font, &dsc, letter, next) ? dsc.adv_w : 0;
+
+        e->letters[e->len] = letter;
+        e->x[e->len + 1] = e->x[e->len] + adv + letter_space;
+        e->len++;
+        letter = next;
+    }
+
+    return e;
+}
+
+static cached_label_t* cached_label_get(lv_obj_t *obj)
+{
+    cached_label_t *l = obj ? lv_obj_get_user_data(obj) : NULL;
+    return (l && l->magic == CACHED_LABEL_MAGIC) ? l : NULL;
+}
+
+static void cached_label_event_cb(lv_event_t *e)
+{
+    lv_obj_t *obj = lv_event_get_target(e);
+    cached_label_t *l = cached_label_get(obj);
+    if (!l) {
+        return;
+    }
+
+    lv_event_code_t code = lv_event_get_code(e);
+    if (code == LV_EVENT_DELETE) {
+        l->magic = 0;
+        free(l);
+        lv_obj_set_user_data(obj, NULL);
+        return;
+    }
+    if (code == LV_EVENT_STYLE_CHANGED) {
+        // A new font or spacing moves every glyph; colour only repaints
+        if (lv_obj_get_style_text_font(obj, LV_PART_MAIN) != l->font ||
+            lv_obj_get_style_text_letter_space(obj, LV_PART_MAIN) != l->letter_space) {
+            char text[sizeof(l->text)];
+            memcpy(text, l->text, sizeof(text));
+            lvgl_cached_label_set_text(obj, text);
+        }
+        return;
+    }
+
+    lv_draw_ctx_t *draw_ctx = lv_event_get_draw_ctx(e);
+    lv_area_t coords;
+    lv_obj_get_coords(obj, &coords);
+
+    lv_draw_img_dsc_t dsc;
+    lv_draw_img_dsc_init(&dsc);
+    dsc.recolor = lv_obj_get_style_text_color(obj, LV_PART_MAIN);
+    dsc.recolor_opa = LV_OPA_COVER;
+
+    lv_coord_t baseline = l->font->line_height - l->font->base_line;
+
+    for (uint8_t i = 0; i < l->len; i++) {
+        // Glyph cells outside the area being redrawn are left alone
+        lv_area_t cell = {
+            .x1 = coords.x1 + l->x[i], .y1 = coords.y1,
+            .x2 = coords.x1 + l->x[i + 1] - 1, .y2 = coords.y2
+        };
+        if (!_lv_area_is_on(&cell, draw_ctx->clip_area)) {
+            s_stats.glyphs_clipped++;
+            continue;
+        }
+
+        const glyph_entry_t *g = glyph_get(l->font, l->letters[i]);
+        if (!g || !g->a8) {
+            continue;
+        }
+
+        lv_area_t area;
+        area.x1 = cell.x1 + g->dsc.ofs_x;
+        area.y1 = coords.y1 + baseline - g->dsc.box_h - g->dsc.ofs_y;
+        area.x2 = area.x1 + g->dsc.box_w - 1;
+        area.y2 = area.y1 + g->dsc.box_h - 1;
+        lv_draw_img(draw_ctx, &dsc, &area, &g->img);
+        s_stats.glyphs_drawn++;
+    }
+}
+
+/**
+ * @brief Create a label that renders through the text cache
+ */
+lv_obj_t* lvgl_create_cached_label(lv_obj_t *parent, const lv_font_t *font)
+{
+    cached_label_t *l = calloc(1, sizeof(cached_label_t));
+    if (!l) {
+        ESP_LOGE(TAG, "Failed to allocate cached label");
+        return NULL;
+    }
+
+    l->magic = CACHED_LABEL_MAGIC;
+
+    // No theme styles, so the text style is inherited as a label's is
+    lv_obj_t *obj = lv_obj_create(parent);
+    lv_obj_remove_style_all(obj);
+    if (font) {
+        lv_obj_set_style_text_font(obj, font, 0);
+    }
+    l->font = lv_obj_get_style_text_font(obj, LV_PART_MAIN);
+    l->letter_space = lv_obj_get_style_text_letter_space(obj, LV_PART_MAIN);
+    lv_obj_clear_flag(obj, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_set_size(obj, 0, lv_font_get_line_height(l->font));
+    lv_obj_set_user_data(obj, l);
+    lv_obj_add_event_cb(obj, cached_label_event_cb, LV_EVENT_DRAW_MAIN, NULL);
+    lv_obj_add_event_cb(obj, cached_label_event_cb, LV_EVENT_STYLE_CHANGED, NULL);
+    lv_obj_add_event_cb(obj, cached_label_event_cb, LV_EVENT_DELETE, NULL);
+
+    return obj;
+}
+
+bool lvgl_is_cached_label(lv_obj_t *obj)
+{
+    return cached_label_get(obj) != NULL;
+}
+
+bool lvgl_cached_label_set_text(lv_obj_t *obj, const char *text)
+{
+    cached_label_t *l = cached_label_get(obj);
+    if (!l || !text) {
+        return false;
+    }
+
+    // Compared as shown, so text past the limit still counts as unchanged
+    char shown[sizeof(l->text)];
+    clip_text(text, shown, sizeof(shown));
+    const lv_font_t *font = lv_obj_get_style_text_font(obj, LV_PART_MAIN);
+    lv_coord_t letter_space = lv_obj_get_style_text_letter_space(obj, LV_PART_MAIN);
+    bool restyled = font != l->font || letter_space != l->letter_space;
+
+    if (!restyled && strcmp(l->text, shown) == 0) {
+        lvgl_dirty_account_skipped_update();
+        return false;
+    }
+
+    const layout_entry_t *layout = layout_get(font, letter_space, shown);
+
+    // Another font or spacing: none of the old cells line up
+    if (restyled) {
+        lv_obj_invalidate(obj);
+        l->font = font;
+        l->letter_space = letter_space;
+        l->len = 0;
+        l->x[0] = 0;
+        lv_obj_set_height(obj, lv_font_get_line_height(font));
+    }
+
+    // Grow to fit; shrinking would repaint the whole old width
+    lv_coord_t width = layout->x[layout->len];
+    if (width > lv_obj_get_width(obj)) {
+        lv_obj_set_width(obj, width);
+    }
+
+    // Invalidate runs of glyph cells whose letter or position changed,
+    // covering both the old and the new extent of each run
+    lv_area_t coords;
+    lv_obj_get_coords(obj, &coords);
+
+    uint8_t max_len = LV_MAX(l->len, layout->len);
+    int run_start = -1;
+    for (int i = 0; i <= max_len; i++) {
+        bool changed = false;
+        if (i < max_len) {
+            changed = i >= l->len || i >= layout->len ||
+                      l->letters[i] != layout->letters[i] ||
+                      l->x[i] != layout->x[i] || l->x[i + 1] != layout->x[i + 1];
+        }
+
+        if (changed) {
+            s_stats.glyphs_changed++;
+            if (run_start < 0) {
+                run_start = i;
+            }
+            continue;
+        }
+        if (i < max_len) {
+            s_stats.glyphs_unchanged++;
+        }
+        if (run_start < 0) {
+            continue;
+        }
+
+        lv_coord_t x1 = LV_MIN(run_start < l->len ? l->x[run_start] : l->x[l->len],
+                               run_start < layout->len ? layout->x[run_start] : layout->x[layout->len]);
+        lv_coord_t x2 = LV_MAX(l->x[LV_MIN(i, l->len)], layout->x[LV_MIN(i, layout->len)]);
+        if (x2 > x1) {
+            lv_area_t area = { .x1 = coords.x1 + x1, .y1 = coords.y1,
+                               .x2 = coords.x1 + x2 - 1, .y2 = coords.y2 };
+            lv_obj_invalidate_area(obj, &area);
+        }
+        run_start = -1;
+    }
+
+    l->len = layout->len;
+    memcpy(l->letters, layout->letters, layout->len * sizeof(l->letters[0]));
+    memcpy(l->x, layout->x, (layout->len + 1) * sizeof(l->x[0]));
+    memcpy(l->text, layout->text, sizeof(l->text));
+    return true;
+}
+
+void lvgl_port_get_text_cache_stats(lvgl_text_cache_stats_t *stats)
+{
+    if (stats) {
+        *stats = s_stats;
+        stats->glyph_bytes = s_glyph_bytes;
+    }
+}
+
+void lvgl_port_reset_text_cache_stats(void)
+{
+    memset(&s_stats, 0, sizeof(s_stats));
+}
+
+void lvgl_text_cache_flush(void)
+{
+    for (int i = 0; i < GLYPH_CACHE_ENTRIES; i++) {
+        if (s_glyphs[i].font) {
+            glyph_evict(&s_glyphs[i]);
+        }
+    }
+    memset(s_layouts, 0, sizeof(s_layouts));
+}
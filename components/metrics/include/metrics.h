@@ -0,0 +1,213 @@
+/**
+ * @file metrics.h
+ * @brief System-wide counters, gauges and latency histograms
+ *
+ * Metrics are defined statically in the file that updates them and
+ * register themselves before app_main. Updates are a relaxed atomic on a
+ * slot owned by the current core, so they are safe from any task or ISR
+ * and never contend across cores; readers sum the slots when a snapshot
+ * is taken.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if CONFIG_IDF_TARGET_LINUX
+#define METRICS_CORES           1
+#define METRICS_CORE_ID()       0
+#else
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#define METRICS_CORES           portNUM_PROCESSORS
+#define METRICS_CORE_ID()       xPortGetCoreID()
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Log-linear histogram: values below 2^SUB_BITS get a bucket each, every
+// power of two above that is split into 2^SUB_BITS buckets (at most 25%
+// wide), and values from 2^MAX_BITS up share the last bucket
+#define METRIC_HIST_SUB_BITS    2
+#define METRIC_HIST_MAX_BITS    24
+#define METRIC_HIST_BUCKETS     (((METRIC_HIST_MAX_BITS - METRIC_HIST_SUB_BITS + 1) << METRIC_HIST_SUB_BITS) + 1)
+
+#define METRICS_JSON_MAX        2048    // Enough for the snapshot of every metric
+
+typedef enum {
+    METRIC_COUNTER,             // Monotonic, wraps at 2^32 per core
+    METRIC_GAUGE,               // Last value set
+    METRIC_HISTOGRAM            // Distribution of recorded values
+} metric_type_t;
+
+typedef struct {
+    atomic_uint buckets[METRICS_CORES][METRIC_HIST_BUCKETS];
+    atomic_uint max[METRICS_CORES];
+} metric_hist_data_t;
+
+typedef struct metric {
+    const char *name;
+    const char *unit;
+    metric_type_t type;
+    struct metric *next;        // Registry list
+    union {
+        atomic_uint counter[METRICS_CORES];
+        atomic_int gauge;
+        metric_hist_data_t *hist;
+    };
+} metric_t;
+
+typedef struct {
+    const char *name;
+    const char *unit;
+    metric_type_t type;
+    union {
+        uint64_t count;         // Counter: sum over cores
+        int32_t value;          // Gauge
+        struct {
+            uint64_t count;
+            uint32_t p50;       // Percentiles are bucket upper bounds
+            uint32_t p90;
+            uint32_t p99;
+            uint32_t max;
+        } hist;
+    };
+} metric_value_t;
+
+#define METRIC_REGISTER_(sym) \
+    static void __attribute__((constructor)) sym##_register(void) { metrics_register(&sym); }
+
+/** Define a file-local counter registered under `name_str` */
+#define METRIC_COUNTER_DEFINE(sym, name_str, unit_str) \
+    static metric_t sym = { .name = name_str, .unit = unit_str, .type = METRIC_COUNTER }; \
+    METRIC_REGISTER_(sym)
+
+/** Define a file-local gauge registered under `name_str` */
+#define METRIC_GAUGE_DEFINE(sym, name_str, unit_str) \
+    static metric_t sym = { .name = name_str, .unit = unit_str, .type = METRIC_GAUGE }; \
+    METRIC_REGISTER_(sym)
+
+/** Define a file-local histogram registered under `name_str` */
+#define METRIC_HISTOGRAM_DEFINE(sym, name_str, unit_str) \
+    static metric_hist_data_t sym##_data; \
+    static metric_t sym = { .name = name_str, .unit = unit_str, .type = METRIC_HISTOGRAM, \
+                            .hist = &sym##_data }; \
+    METRIC_REGISTER_(sym)
+
+/**
+ * @brief Add a metric to the registry (done by the DEFINE macros)
+ * @param metric Metric with static storage
+ */
+void metrics_register(metric_t *metric);
+
+/**
+ * @brief Add to a counter (any task or ISR)
+ * @param metric Counter
+ * @param n Amount
+ */
+static inline void metric_add(metric_t *metric, uint32_t n)
+{
+    atomic_fetch_add_explicit(&metric->counter[METRICS_CORE_ID()], n, memory_order_relaxed);
+}
+
+/**
+ * @brief Increment a counter (any task or ISR)
+ * @param metric Counter
+ */
+static inline void metric_inc(metric_t *metric)
+{
+    metric_add(metric, 1);
+}
+
+/**
+ * @brief Set a gauge (any task or ISR)
+ * @param metric Gauge
+ * @param value New value
+ */
+static inline void metric_set(metric_t *metric, int32_t value)
+{
+    atomic_store_explicit(&metric->gauge, value, memory_order_relaxed);
+}
+
+/**
+ * @brief Record a value in a histogram (any task or ISR)
+ * @param metric Histogram
+ * @param value Value, usually microseconds
+ */
+void metric_record(metric_t *metric, uint32_t value);
+
+/**
+ * @brief Histogram bucket of a value
+ * @param value Value
+ * @return Bucket index below METRIC_HIST_BUCKETS
+ */
+uint32_t metric_hist_bucket(uint32_t value);
+
+/**
+ * @brief Largest value that falls in a bucket
+ * @param bucket Bucket index
+ * @return Upper bound, UINT32_MAX for the last bucket
+ */
+uint32_t metric_hist_upper(uint32_t bucket);
+
+/**
+ * @brief Find a registered metric
+ * @param name Metric name
+ * @return Metric or NULL
+ */
+metric_t* metrics_find(const char *name);
+
+/**
+ * @brief Read one metric
+ * @param metric Metric
+ * @param value Value to fill
+ */
+void metrics_read(const metric_t *metric, metric_value_t *value);
+
+/**
+ * @brief Get the number of registered metrics
+ * @return Metric count
+ */
+size_t metrics_count(void);
+
+/**
+ * @brief Read every registered metric
+ * @param values Array to fill
+ * @param max_values Array length
+ * @return Number of values filled
+ */
+size_t metrics_snapshot(metric_value_t *values, size_t max_values);
+
+/**
+ * @brief Format a snapshot as one JSON object keyed by metric name
+ *
+ * Used by the JS API and meant for a web server endpoint.
+ * @param buf Output buffer
+ * @param len Buffer size
+ * @return Length of the full output, as snprintf
+ */
+int metrics_format_json(char *buf, size_t len);
+
+/**
+ * @brief Log every metric on the serial console
+ */
+void metrics_log(void);
+
+/**
+ * @brief Zero every registered metric
+ */
+void metrics_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METRICS_H
@@ -0,0 +1,265 @@
+/**
+ * @file metrics.c
+ * @brief Metrics registry, histogram buckets and snapshots
+ */
+
+#include "metrics.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "METRICS";
+
+#define SUB_COUNT       (1u << METRIC_HIST_SUB_BITS)
+#define OVERFLOW_BUCKET (METRIC_HIST_BUCKETS - 1)
+
+static _Atomic(metric_t *) s_head = NULL;
+
+void metrics_register(metric_t *metric)
+{
+    metric_t *head = atomic_load_explicit(&s_head, memory_order_relaxed);
+    do {
+        metric->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&s_head, &head, metric,
+                                                    memory_order_release,
+                                                    memory_order_relaxed));
+}
+
+uint32_t IRAM_ATTR metric_hist_bucket(uint32_t value)
+{
+    if (value < SUB_COUNT) {
+        return value;
+    }
+
+    uint32_t msb = 31 - __builtin_clz(value);
+    if (msb >= METRIC_HIST_MAX_BITS) {
+        return OVERFLOW_BUCKET;
+    }
+
+    // The bits under the leading one pick the linear step in its octave
+    uint32_t shift = msb - METRIC_HIST_SUB_BITS;
+    return ((shift + 1) << METRIC_HIST_SUB_BITS) + ((value >> shift) & (SUB_COUNT - 1));
+}
+
+uint32_t metric_hist_upper(uint32_t bucket)
+{
+    if (bucket < SUB_COUNT) {
+        return bucket;
+    }
+    if (bucket >= OVERFLOW_BUCKET) {
+        return UINT32_MAX;
+    }
+
+    uint32_t shift = (bucket >> METRIC_HIST_SUB_BITS) - 1;
+    uint32_t step = bucket & (SUB_COUNT - 1);
+    uint32_t lower = (SUB_COUNT + step) << shift;
+    return lower + (1u << shift) - 1;
+}
+
+void IRAM_ATTR metric_record(metric_t *metric, uint32_t value)
+{
+    int core = METRICS_CORE_ID();
+    metric_hist_data_t *hist = metric->hist;
+
+    atomic_fetch_add_explicit(&hist->buckets[core][metric_hist_bucket(value)], 1,
+                              memory_order_relaxed);
+
+    uint32_t max = atomic_load_explicit(&hist->max[core], memory_order_relaxed);
+    while (value > max &&
+           !atomic_compare_exchange_weak_explicit(&hist->max[core], &max, value,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+    }
+}
+
+metric_t* metrics_find(const char *name)
+{
+    if (!name) {
+        return NULL;
+    }
+
+    for (metric_t *m = atomic_load_explicit(&s_head, memory_order_acquire); m; m = m->next) {
+        if (strcmp(m->name, name) == 0) {
+            return m;
+        }
+    }
+    return NULL;
+}
+
+static void read_hist(const metric_hist_data_t *hist, metric_value_t *value)
+{
+    uint32_t merged[METRIC_HIST_BUCKETS];
+    uint64_t count = 0;
+    uint32_t max = 0;
+
+    for (int b = 0; b < METRIC_HIST_BUCKETS; b++) {
+        merged[b] = 0;
+        for (int c = 0; c < METRICS_CORES; c++) {
+            merged[b] += atomic_load_explicit(&hist->buckets[c][b], memory_order_relaxed);
+        }
+        count += merged[b];
+    }
+    for (int c = 0; c < METRICS_CORES; c++) {
+        uint32_t m = atomic_load_explicit(&hist->max[c], memory_order_relaxed);
+        if (m > max) {
+            max = m;
+        }
+    }
+
+    value->hist.count = count;
+    value->hist.max = max;
+
+    // Walk once, filling each percentile as its rank is passed
+    static const uint8_t pct[3] = { 50, 90, 99 };
+    uint32_t *out[3] = { &value->hist.p50, &value->hist.p90, &value->hist.p99 };
+    uint64_t seen = 0;
+    int next = 0;
+
+    for (int b = 0; b < METRIC_HIST_BUCKETS && next < 3; b++) {
+        seen += merged[b];
+        while (next < 3 && count && seen * 100 >= count * pct[next]) {
+            uint32_t upper = metric_hist_upper(b);
+            *out[next++] = upper < max ? upper : max;
+        }
+    }
+    while (next < 3) {
+        *out[next++] = 0;
+    }
+}
+
+void metrics_read(const metric_t *metric, metric_value_t *value)
+{
+    memset(value, 0, sizeof(*value));
+    value->name = metric->name;
+    value->unit = metric->unit;
+    value->type = metric->type;
+
+    switch (metric->type) {
+    case METRIC_COUNTER:
+        for (int c = 0; c < METRICS_CORES; c++) {
+            value->count += atomic_load_explicit(&metric->counter[c], memory_order_relaxed);
+        }
+        break;
+    case METRIC_GAUGE:
+        value->value = atomic_load_explicit(&metric->gauge, memory_order_relaxed);
+        break;
+    case METRIC_HISTOGRAM:
+        read_hist(metric->hist, value);
+        break;
+    }
+}
+
+size_t metrics_count(void)
+{
+    size_t n = 0;
+    for (metric_t *m = atomic_load_explicit(&s_head, memory_order_acquire); m; m = m->next) {
+        n++;
+    }
+    return n;
+}
+
+size_t metrics_snapshot(metric_value_t *values, size_t max_values)
+{
+    size_t n = 0;
+
+    if (!values) {
+        return 0;
+    }
+
+    for (metric_t *m = atomic_load_explicit(&s_head, memory_order_acquire);
+         m && n < max_values; m = m->next) {
+        metrics_read(m, &values[n++]);
+    }
+    return n;
+}
+
+// Append to a bounded buffer, tracking the full length like snprintf
+#define JSON_APPEND(buf, len, pos, ...) do { \
+        int w_ = snprintf((pos) < (len) ? (buf) + (pos) : NULL, \
+                          (pos) < (len) ? (len) - (pos) : 0, __VA_ARGS__); \
+        if (w_ > 0) { \
+            (pos) += (size_t)w_; \
+        } \
+    } while (0)
+
+int metrics_format_json(char *buf, size_t len)
+{
+    size_t pos = 0;
+    bool first = true;
+
+    JSON_APPEND(buf, len, pos, "{");
+    for (metric_t *m = atomic_load_explicit(&s_head, memory_order_acquire); m; m = m->next) {
+        metric_value_t v;
+        metrics_read(m, &v);
+
+        JSON_APPEND(buf, len, pos, "%s\"%s\":", first ? "" : ",", v.name);
+        first = false;
+
+        switch (v.type) {
+        case METRIC_COUNTER:
+            JSON_APPEND(buf, len, pos, "%" PRIu64, v.count);
+            break;
+        case METRIC_GAUGE:
+            JSON_APPEND(buf, len, pos, "%" PRId32, v.value);
+            break;
+        case METRIC_HISTOGRAM:
+            JSON_APPEND(buf, len, pos,
+                        "{\"count\":%" PRIu64 ",\"p50\":%" PRIu32 ",\"p90\":%" PRIu32
+                        ",\"p99\":%" PRIu32 ",\"max\":%" PRIu32 "}",
+                        v.hist.count, v.hist.p50, v.hist.p90, v.hist.p99, v.hist.max);
+            break;
+        }
+    }
+    JSON_APPEND(buf, len, pos, "}");
+
+    return (int)pos;
+}
+
+void metrics_log(void)
+{
+    for (metric_t *m = atomic_load_explicit(&s_head, memory_order_acquire); m; m = m->next) {
+        metric_value_t v;
+        metrics_read(m, &v);
+
+        switch (v.type) {
+        case METRIC_COUNTER:
+            ESP_LOGI(TAG, "%-24s %" PRIu64 " %s", v.name, v.count, v.unit);
+            break;
+        case METRIC_GAUGE:
+            ESP_LOGI(TAG, "%-24s %" PRId32 " %s", v.name, v.value, v.unit);
+            break;
+        case METRIC_HISTOGRAM:
+            ESP_LOGI(TAG, "%-24s n=%" PRIu64 " p50 %" PRIu32 " p90 %" PRIu32
+                     " p99 %" PRIu32 " max %" PRIu32 " %s",
+                     v.name, v.hist.count, v.hist.p50, v.hist.p90, v.hist.p99,
+                     v.hist.max, v.unit);
+            break;
+        }
+    }
+}
+
+void metrics_reset(void)
+{
+    for (metric_t *m = atomic_load_explicit(&s_head, memory_order_acquire); m; m = m->next) {
+        switch (m->type) {
+        case METRIC_COUNTER:
+            for (int c = 0; c < METRICS_CORES; c++) {
+                atomic_store(&m->counter[c], 0);
+            }
+            break;
+        case METRIC_GAUGE:
+            atomic_store(&m->gauge, 0);
+            break;
+        case METRIC_HISTOGRAM:
+            for (int c = 0; c < METRICS_CORES; c++) {
+                for (int b = 0; b < METRIC_HIST_BUCKETS; b++) {
+                    atomic_store(&m->hist->buckets[c][b], 0);
+                }
+                atomic_store(&m->hist->max[c], 0);
+            }
+            break;
+        }
+    }
+}
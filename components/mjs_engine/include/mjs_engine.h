@@ -7,6 +7,7 @@
 #define MJS_ENGINE_H
 
 #include "esp_err.h"
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -18,17 +19,64 @@ extern "C" {
 struct mjs;
 typedef struct mjs mjs_t;
 
+// App permissions: bit, manifest name. APP_PERM_* in app_manager.h are these bits.
+#define JS_PERMISSION_LIST(X) \
+    X(RF_RECEIVE, "rf.receive") \
+    X(RF_TRANSMIT, "rf.transmit") \
+    X(GPIO_READ, "gpio.read") \
+    X(GPIO_WRITE, "gpio.write") \
+    X(STORAGE_READ, "storage.read") \
+    X(STORAGE_WRITE, "storage.write") \
+    X(UI_CREATE, "ui.create") \
+    X(NETWORK, "network") \
+    X(SYSTEM, "system")
+
+typedef enum {
+#define JS_PERMISSION_BIT(id, name) JS_PERM_BIT_##id,
+    JS_PERMISSION_LIST(JS_PERMISSION_BIT)
+#undef JS_PERMISSION_BIT
+    JS_PERM_BIT_COUNT
+} js_permission_bit_t;
+
+#define JS_PERM_RF_RECEIVE      (1u << JS_PERM_BIT_RF_RECEIVE)
+#define JS_PERM_RF_TRANSMIT     (1u << JS_PERM_BIT_RF_TRANSMIT)
+#define JS_PERM_GPIO_READ       (1u << JS_PERM_BIT_GPIO_READ)
+#define JS_PERM_GPIO_WRITE      (1u << JS_PERM_BIT_GPIO_WRITE)
+#define JS_PERM_STORAGE_READ    (1u << JS_PERM_BIT_STORAGE_READ)
+#define JS_PERM_STORAGE_WRITE   (1u << JS_PERM_BIT_STORAGE_WRITE)
+#define JS_PERM_UI_CREATE       (1u << JS_PERM_BIT_UI_CREATE)
+#define JS_PERM_NETWORK         (1u << JS_PERM_BIT_NETWORK)
+#define JS_PERM_SYSTEM          (1u << JS_PERM_BIT_SYSTEM)
+
+#define JS_MAX_TIMERS           8       // Pending timers per context
+#define JS_TIMER_MAX_LAG_MS     1000    // An interval further behind drops its backlog
+
+// Pending setTimeout/setInterval; the callback is a function held in a global
+typedef struct {
+    uint32_t id;                // 0 if the slot is free
+    uint32_t due_ms;
+    uint32_t period_ms;         // 0 for a one-shot
+    char callback[32];
+} js_timer_t;
+
 // JavaScript execution context
 typedef struct {
     mjs_t *mjs;
     char *filename;
     char *code;
+    uint32_t source_size;       // Bytes held for filename and code
     bool is_running;
     uint32_t memory_limit;
     uint32_t execution_time_limit_ms;
+    uint32_t permissions;       // JS_PERM_* granted; applied when natives are bound
+    js_timer_t timers[JS_MAX_TIMERS];
+    uint32_t next_timer_id;
+    char encoder_handler[32];   // Global called with each batch of encoder steps
     void *user_data;
 } js_context_t;
 
+#define JS_MANIFEST_MAX_SIZE    4096    // Largest manifest.json read
+
 // JavaScript app manifest
 typedef struct {
     char name[32];
@@ -117,6 +165,54 @@ esp_err_t mjs_engine_stop(js_context_t *ctx);
  */
 bool mjs_engine_is_running(js_context_t *ctx);
 
+/**
+ * @brief Find the context that owns an interpreter
+ *
+ * For natives, which are only passed the interpreter.
+ * @param mjs mJS instance
+ * @return Context, or NULL if no live context uses it
+ */
+js_context_t* mjs_engine_find_context(struct mjs *mjs);
+
+/**
+ * @brief Schedule a callback
+ * @param ctx JavaScript context
+ * @param callback Name of the global holding the function
+ * @param now_ms Current time
+ * @param delay_ms Delay before the first call
+ * @param period_ms Interval between calls, 0 to call once
+ * @return Timer ID, 0 if the context has no free timer
+ */
+uint32_t mjs_engine_set_timer(js_context_t *ctx, const char *callback, uint32_t now_ms,
+                              uint32_t delay_ms, uint32_t period_ms);
+
+/**
+ * @brief Cancel a timer
+ * @param ctx JavaScript context
+ * @param id Timer ID
+ * @return ESP_OK, ESP_ERR_NOT_FOUND
+ */
+esp_err_t mjs_engine_clear_timer(js_context_t *ctx, uint32_t id);
+
+/**
+ * @brief Run due timers, earliest first, within an operation budget
+ *
+ * Timers still due when the budget runs out stay pending for the next
+ * call, so a slice never runs longer than its budget allows.
+ * @param ctx JavaScript context
+ * @param now_ms Current time
+ * @param budget Interpreter operations allowed (see mjs_set_budget), 0 for no limit
+ * @return Operations run
+ */
+uint32_t mjs_engine_run_timers(js_context_t *ctx, uint32_t now_ms, uint32_t budget);
+
+/**
+ * @brief Get the heap held by a context
+ * @param ctx JavaScript context
+ * @return Bytes for the context, its interpreter and its loaded source
+ */
+uint32_t mjs_engine_get_memory_usage(js_context_t *ctx);
+
 /**
  * @brief Get engine statistics
  * @param total_memory Total allocated memory
@@ -148,9 +244,26 @@ void mjs_engine_set_error_callback(js_error_callback_t callback, void *user_data
 esp_err_t mjs_engine_load_manifest(const char *manifest_path, js_app_manifest_t *manifest);
 
 /**
- * @brief Validate app permissions
+ * @brief Parse an app manifest held in memory
+ *
+ * name, version and entry_point (or its alias main) are required;
+ * permissions may be a comma-separated string or an array of strings.
+ * Unknown keys are ignored.
+ * @param json Manifest text, need not be NUL terminated
+ * @param len Text length
+ * @param manifest Manifest structure to fill
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG, ESP_ERR_INVALID_SIZE or
+ *         ESP_ERR_NOT_FOUND if the manifest does not match the schema
+ */
+esp_err_t mjs_engine_parse_manifest(const char *json, size_t len, js_app_manifest_t *manifest);
+
+/**
+ * @brief Check a permission by name against the context's grants
+ *
+ * For natives that decide per argument. APIs gated as a whole are
+ * resolved once when they are bound (js_api_bind) and need no check.
  * @param ctx JavaScript context
- * @param permission Permission string to check
+ * @param permission Permission name, e.g. "rf.transmit"
  * @return true if permission granted
  */
 bool mjs_engine_check_permission(js_context_t *ctx, const char *permission);
@@ -9,6 +9,8 @@
 #include <stdio.h>
 #include <ctype.h>
 
+#define MJS_MAX_GLOBALS 64      // Natives of every API module plus app globals
+
 // Simple mJS structure
 struct mjs {
     char *error_msg;
@@ -19,8 +21,11 @@ struct mjs {
     struct {
         char *name;
         mjs_val_t value;
-    } globals[32];
+    } globals[MJS_MAX_GLOBALS];
     int global_count;
+    uint32_t budget;            // Operations allowed, 0 for no limit
+    uint32_t ops;               // Operations run since the budget was set
+    size_t heap_used;
 };
 
 struct mjs *mjs_create(void)
@@ -32,6 +37,7 @@ struct mjs *mjs_create(void)
     
     mjs->global_object = MJS_NULL;
     mjs->global_count = 0;
+    mjs->heap_used = sizeof(struct mjs);
     
     return mjs;
 }
@@ -57,15 +63,30 @@ void mjs_destroy(struct mjs *mjs)
 static void set_error(struct mjs *mjs, const char *msg)
 {
     if (mjs->error_msg) {
+        mjs->heap_used -= strlen(mjs->error_msg) + 1;
         free(mjs->error_msg);
     }
     mjs->error_msg = strdup(msg);
+    if (mjs->error_msg) {
+        mjs->heap_used += strlen(msg) + 1;
+    }
     
     if (mjs->error_handler) {
         mjs->error_handler(mjs, msg, mjs->error_user_data);
     }
 }
 
+// Counts one operation against the budget; false once it is spent
+static bool charge_op(struct mjs *mjs)
+{
+    if (mjs->budget && mjs->ops >= mjs->budget) {
+        set_error(mjs, "Execution budget exhausted");
+        return false;
+    }
+    mjs->ops++;
+    return true;
+}
+
 // Simple JavaScript parser and executor (very basic implementation)
 static mjs_val_t eval_expression(struct mjs *mjs, const char *expr)
 {
@@ -130,6 +151,9 @@ mjs_val_t mjs_exec(struct mjs *mjs, const char *code, const char *filename)
     if (!mjs || !code) {
         return MJS_NULL;
     }
+    if (!charge_op(mjs)) {
+        return MJS_ERROR;
+    }
     
     // Very simple JavaScript execution
     // This is a placeholder implementation that handles basic expressions
@@ -225,7 +249,7 @@ mjs_val_t mjs_exec(struct mjs *mjs, const char *code, const char *filename)
 
 bool mjs_is_error(mjs_val_t val)
 {
-    return val == MJS_NULL && false; // Simplified error checking
+    return val == MJS_ERROR;
 }
 
 const char *mjs_get_error_message(struct mjs *mjs)
@@ -299,10 +323,14 @@ void mjs_set_global(struct mjs *mjs, const char *name, mjs_val_t val)
     }
     
     // Add new variable if space available
-    if (mjs->global_count < 32) {
+    if (mjs->global_count < MJS_MAX_GLOBALS) {
         mjs->globals[mjs->global_count].name = strdup(name);
+        if (!mjs->globals[mjs->global_count].name) {
+            return;
+        }
         mjs->globals[mjs->global_count].value = val;
         mjs->global_count++;
+        mjs->heap_used += strlen(name) + 1;
     }
 }
 
@@ -319,11 +347,67 @@ mjs_val_t mjs_get_global(struct mjs *mjs, const char *name)
     return MJS_UNDEFINED;
 }
 
+// Native functions: tag in the top nibble, pointer in the low 48 bits
+#define FFI_TAG         0x2000000000000000ULL
+#define FFI_PTR_MASK    0x0000FFFFFFFFFFFFULL
+
 void mjs_set_ffi_func(struct mjs *mjs, const char *name, mjs_func_ptr_t func)
 {
     if (!mjs || !name || !func) return;
     
     // Store function pointer as a special value
-    mjs_val_t func_val = 0x2000000000000000ULL | ((uint64_t)func & 0xFFFFFFFFULL);
+    mjs_val_t func_val = FFI_TAG | ((uint64_t)(uintptr_t)func & FFI_PTR_MASK);
     mjs_set_global(mjs, name, func_val);
-}
\ No newline at end of file
+}
+
+mjs_val_t mjs_call_ffi(struct mjs *mjs, const char *name)
+{
+    if (!mjs || !name) return MJS_ERROR;
+    
+    mjs_val_t func_val = mjs_get_global(mjs, name);
+    if ((func_val & ~FFI_PTR_MASK) != FFI_TAG) {
+        char msg[96];
+        snprintf(msg, sizeof(msg), "%s is not a function", name);
+        return mjs_throw(mjs, msg);
+    }
+    
+    if (!charge_op(mjs)) {
+        return MJS_ERROR;
+    }
+    
+    mjs_func_ptr_t func = (mjs_func_ptr_t)(uintptr_t)(func_val & FFI_PTR_MASK);
+    return func(mjs);
+}
+
+mjs_val_t mjs_throw(struct mjs *mjs, const char *message)
+{
+    if (mjs && message) {
+        set_error(mjs, message);
+    }
+    return MJS_ERROR;
+}
+
+void mjs_set_budget(struct mjs *mjs, uint32_t ops)
+{
+    if (mjs) {
+        mjs->budget = ops;
+        mjs->ops = 0;
+    }
+}
+
+uint32_t mjs_get_budget(struct mjs *mjs)
+{
+    if (!mjs) return 0;
+    if (!mjs->budget) return UINT32_MAX;
+    return mjs->ops < mjs->budget ? mjs->budget - mjs->ops : 0;
+}
+
+uint32_t mjs_get_ops(struct mjs *mjs)
+{
+    return mjs ? mjs->ops : 0;
+}
+
+size_t mjs_get_heap_used(struct mjs *mjs)
+{
+    return mjs ? mjs->heap_used : 0;
+}
@@ -26,6 +26,7 @@ typedef uint64_t mjs_val_t;
 #define MJS_UNDEFINED   ((mjs_val_t) 0x7ff8000000000002ULL)
 #define MJS_TRUE        ((mjs_val_t) 0x7ff8000000000003ULL)
 #define MJS_FALSE       ((mjs_val_t) 0x7ff8000000000004ULL)
+#define MJS_ERROR       ((mjs_val_t) 0x7ff8000000000005ULL)    // A thrown error; message in mjs_get_error_message
 
 // Error handler callback
 typedef void (*mjs_error_handler_t)(struct mjs *mjs, const char *msg, void *user_data);
@@ -148,6 +149,55 @@ typedef mjs_val_t (*mjs_func_ptr_t)(struct mjs *mjs);
  */
 void mjs_set_ffi_func(struct mjs *mjs, const char *name, mjs_func_ptr_t func);
 
+/**
+ * @brief Call a native function by its global name
+ * @param mjs mJS instance
+ * @param name Function name
+ * @return Function result, or MJS_ERROR if name is not a native function
+ */
+mjs_val_t mjs_call_ffi(struct mjs *mjs, const char *name);
+
+/**
+ * @brief Throw an error from a native function
+ *
+ * Use as the native's return value: return mjs_throw(mjs, "message");
+ * @param mjs mJS instance
+ * @param message Error message, copied
+ * @return MJS_ERROR
+ */
+mjs_val_t mjs_throw(struct mjs *mjs, const char *message);
+
+/**
+ * @brief Limit the operations the interpreter may run
+ *
+ * A statement executed and a native call are one operation each. Once
+ * the budget is spent, further execution throws until a new budget is set.
+ * @param mjs mJS instance
+ * @param ops Operations allowed from now on, 0 for no limit
+ */
+void mjs_set_budget(struct mjs *mjs, uint32_t ops);
+
+/**
+ * @brief Get the operations left in the budget
+ * @param mjs mJS instance
+ * @return Operations left, UINT32_MAX if there is no limit
+ */
+uint32_t mjs_get_budget(struct mjs *mjs);
+
+/**
+ * @brief Get the operations run since the budget was last set
+ * @param mjs mJS instance
+ * @return Operation count
+ */
+uint32_t mjs_get_ops(struct mjs *mjs);
+
+/**
+ * @brief Get the heap held by the instance
+ * @param mjs mJS instance
+ * @return Bytes allocated for the instance, its globals and its error message
+ */
+size_t mjs_get_heap_used(struct mjs *mjs);
+
 #ifdef __cplusplus
 }
 #endif
@@ -5,8 +5,11 @@
 
 #include "mjs_engine.h"
 #include "mjs.h"
+#include "metrics.h"
+#include "trace.h"
 #include "esp_log.h"
 #include "esp_system.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
@@ -22,6 +25,10 @@ static SemaphoreHandle_t s_engine_mutex = NULL;
 static js_context_t *s_contexts[8] = {0}; // Max 8 concurrent contexts
 static uint8_t s_context_count = 0;
 
+METRIC_COUNTER_DEFINE(s_exec_count, "js.exec", "runs");
+METRIC_COUNTER_DEFINE(s_exec_errors, "js.errors", "runs");
+METRIC_HISTOGRAM_DEFINE(s_exec_metric, "js.exec_us", "us");
+
 // Callbacks
 static js_log_callback_t s_log_callback = NULL;
 static js_error_callback_t s_error_callback = NULL;
@@ -270,6 +277,7 @@ esp_err_t mjs_engine_load_file(js_context_t *ctx, const char *filename)
     
     ctx->filename = strdup(filename);
     ctx->code = code;
+    ctx->source_size = strlen(filename) + 1 + file_size + 1;
     
     ESP_LOGI(TAG, "Loaded JavaScript file: %s (%ld bytes)", filename, file_size);
     return ESP_OK;
@@ -297,6 +305,7 @@ esp_err_t mjs_engine_load_string(js_context_t *ctx, const char *code, const char
     
     ctx->filename = filename ? strdup(filename) : strdup("string");
     ctx->code = strdup(code);
+    ctx->source_size = strlen(ctx->filename ? ctx->filename : "") + 1 + code_len + 1;
     
     ESP_LOGI(TAG, "Loaded JavaScript code (%zu bytes)", code_len);
     return ESP_OK;
@@ -312,15 +321,21 @@ js_exec_result_t mjs_engine_execute(js_context_t *ctx)
     
     ctx->is_running = true;
     uint32_t start_time = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    int64_t start_us = esp_timer_get_time();
+    TRACE(TRACE_JS_EXEC_BEGIN, 0, 0);
     
     // Execute JavaScript code
     mjs_val_t result = mjs_exec(ctx->mjs, ctx->code, NULL);
+    TRACE(TRACE_JS_EXEC_END, mjs_is_error(result), 0);
     
     uint32_t exec_time = (xTaskGetTickCount() * portTICK_PERIOD_MS) - start_time;
     ctx->is_running = false;
+    metric_inc(&s_exec_count);
+    metric_record(&s_exec_metric, (uint32_t)(esp_timer_get_time() - start_us));
     
     // Check execution result
     if (mjs_is_error(result)) {
+        metric_inc(&s_exec_errors);
         const char *error_msg = mjs_get_error_message(ctx->mjs);
         ESP_LOGE(TAG, "JavaScript execution error: %s", error_msg);
         
@@ -358,6 +373,118 @@ bool mjs_engine_is_running(js_context_t *ctx)
     return ctx ? ctx->is_running : false;
 }
 
+js_context_t* mjs_engine_find_context(struct mjs *mjs)
+{
+    if (!s_initialized || !mjs) {
+        return NULL;
+    }
+    
+    js_context_t *found = NULL;
+    xSemaphoreTake(s_engine_mutex, portMAX_DELAY);
+    for (int i = 0; i < 8 && !found; i++) {
+        if (s_contexts[i] && s_contexts[i]->mjs == mjs) {
+            found = s_contexts[i];
+        }
+    }
+    xSemaphoreGive(s_engine_mutex);
+    
+    return found;
+}
+
+uint32_t mjs_engine_set_timer(js_context_t *ctx, const char *callback, uint32_t now_ms,
+                              uint32_t delay_ms, uint32_t period_ms)
+{
+    if (!ctx || !callback || strlen(callback) >= sizeof(ctx->timers[0].callback)) {
+        return 0;
+    }
+    
+    for (int i = 0; i < JS_MAX_TIMERS; i++) {
+        js_timer_t *timer = &ctx->timers[i];
+        if (timer->id) {
+            continue;
+        }
+        
+        if (++ctx->next_timer_id == 0) {
+            ctx->next_timer_id = 1;
+        }
+        timer->id = ctx->next_timer_id;
+        timer->due_ms = now_ms + delay_ms;
+        timer->period_ms = period_ms;
+        strcpy(timer->callback, callback);
+        return timer->id;
+    }
+    
+    ESP_LOGW(TAG, "No free timer for %s", callback);
+    return 0;
+}
+
+esp_err_t mjs_engine_clear_timer(js_context_t *ctx, uint32_t id)
+{
+    if (!ctx || !id) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    for (int i = 0; i < JS_MAX_TIMERS; i++) {
+        if (ctx->timers[i].id == id) {
+            ctx->timers[i].id = 0;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+static js_timer_t *next_due_timer(js_context_t *ctx, uint32_t now_ms)
+{
+    js_timer_t *next = NULL;
+    for (int i = 0; i < JS_MAX_TIMERS; i++) {
+        js_timer_t *timer = &ctx->timers[i];
+        if (timer->id && (int32_t)(now_ms - timer->due_ms) >= 0 &&
+            (!next || (int32_t)(timer->due_ms - next->due_ms) < 0)) {
+            next = timer;
+        }
+    }
+    return next;
+}
+
+uint32_t mjs_engine_run_timers(js_context_t *ctx, uint32_t now_ms, uint32_t budget)
+{
+    if (!ctx || !ctx->mjs) {
+        return 0;
+    }
+    
+    mjs_set_budget(ctx->mjs, budget);
+    
+    js_timer_t *timer;
+    while (mjs_get_budget(ctx->mjs) > 0 && (timer = next_due_timer(ctx, now_ms)) != NULL) {
+        // Rescheduled before the call, so the callback may clear or re-arm it
+        char callback[sizeof(timer->callback)];
+        strcpy(callback, timer->callback);
+        if (timer->period_ms) {
+            timer->due_ms += timer->period_ms;
+            if ((int32_t)(now_ms - timer->due_ms) > JS_TIMER_MAX_LAG_MS) {
+                timer->due_ms = now_ms + timer->period_ms;
+            }
+        } else {
+            timer->id = 0;
+        }
+        
+        mjs_call_ffi(ctx->mjs, callback);
+    }
+    
+    uint32_t ops = mjs_get_ops(ctx->mjs);
+    mjs_set_budget(ctx->mjs, 0);
+    return ops;
+}
+
+uint32_t mjs_engine_get_memory_usage(js_context_t *ctx)
+{
+    if (!ctx) {
+        return 0;
+    }
+    
+    return (uint32_t)(sizeof(*ctx) + mjs_get_heap_used(ctx->mjs) + ctx->source_size);
+}
+
 void mjs_engine_get_stats(uint32_t *total_memory, uint32_t *free_memory, uint8_t *num_contexts)
 {
     if (!s_initialized) {
@@ -371,9 +498,8 @@ void mjs_engine_get_stats(uint32_t *total_memory, uint32_t *free_memory, uint8_t
     
     uint32_t total_used = 0;
     for (int i = 0; i < 8; i++) {
-        if (s_contexts[i] && s_contexts[i]->mjs) {
-            // Get memory usage from mJS (simplified)
-            total_used += 4096; // Approximate per context
+        if (s_contexts[i]) {
+            total_used += mjs_engine_get_memory_usage(s_contexts[i]);
         }
     }
     
@@ -395,8 +521,3 @@ void mjs_engine_set_error_callback(js_error_callback_t callback, void *user_data
     s_error_callback = callback;
     s_error_user_data = user_data;
 }
-
-bool mjs_engine_is_running(js_context_t *ctx)
-{
-    return ctx ? ctx->is_running : false;
-}
\ No newline at end of file
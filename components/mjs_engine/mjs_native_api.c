@@ -5,7 +5,9 @@
 
 #include "mjs_engine.h"
 #include "mjs.h"
+#include "json_reader.h"
 #include "esp_log.h"
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 
@@ -116,6 +118,41 @@ void mjs_register_native_functions(struct mjs *mjs)
     ESP_LOGI(TAG, "Registered %d native functions", s_native_functions.count + 4);
 }
 
+// Manifest schema: the device manifest and the SDK's build output (main, permission arrays)
+static const json_field_t s_manifest_fields[] = {
+    JSON_FIELD_STRING(js_app_manifest_t, name, "name", true),
+    JSON_FIELD_STRING(js_app_manifest_t, version, "version", true),
+    JSON_FIELD_STRING(js_app_manifest_t, author, "author", false),
+    JSON_FIELD_STRING(js_app_manifest_t, description, "description", false),
+    JSON_FIELD_STRING(js_app_manifest_t, entry_point, "entry_point", true),
+    JSON_FIELD_STRING(js_app_manifest_t, entry_point, "main", false),
+    JSON_FIELD_STRING_LIST(js_app_manifest_t, permissions, "permissions", false),
+    JSON_FIELD_UINT(js_app_manifest_t, memory_limit, "memory_limit", false, 0, 1024 * 1024),
+    JSON_FIELD_BOOL(js_app_manifest_t, has_icon, "has_icon", false),
+};
+
+esp_err_t mjs_engine_parse_manifest(const char *json, size_t len, js_app_manifest_t *manifest)
+{
+    if (!json || !manifest) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    memset(manifest, 0, sizeof(js_app_manifest_t));
+    
+    json_error_t error;
+    esp_err_t ret = json_read_object(json, len, s_manifest_fields,
+                                     sizeof(s_manifest_fields) / sizeof(s_manifest_fields[0]),
+                                     manifest, &error);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Invalid manifest at byte %u: %s%s%s", (unsigned)error.offset, error.reason,
+                 error.key ? ", key " : "", error.key ? error.key : "");
+        return ret;
+    }
+    
+    // memory_limit stays 0 when absent: the engine applies its default
+    return ESP_OK;
+}
+
 // Manifest loading implementation
 esp_err_t mjs_engine_load_manifest(const char *manifest_path, js_app_manifest_t *manifest)
 {
@@ -131,77 +168,29 @@ esp_err_t mjs_engine_load_manifest(const char *manifest_path, js_app_manifest_t
         return ESP_ERR_NOT_FOUND;
     }
     
-    char line[256];
-    memset(manifest, 0, sizeof(js_app_manifest_t));
-    
-    // Simple JSON-like parsing (very basic)
-    while (fgets(line, sizeof(line), file)) {
-        char *key_start = strstr(line, "\"");
-        if (!key_start) continue;
-        
-        key_start++; // Skip opening quote
-        char *key_end = strstr(key_start, "\"");
-        if (!key_end) continue;
-        
-        *key_end = '\0';
-        char *value_start = strstr(key_end + 1, ":");
-        if (!value_start) continue;
-        
-        value_start++;
-        while (*value_start == ' ' || *value_start == '\t') value_start++;
-        
-        if (*value_start == '\"') {
-            // String value
-            value_start++;
-            char *value_end = strstr(value_start, "\"");
-            if (value_end) {
-                *value_end = '\0';
-                
-                if (strcmp(key_start, "name") == 0) {
-                    strncpy(manifest->name, value_start, sizeof(manifest->name) - 1);
-                } else if (strcmp(key_start, "version") == 0) {
-                    strncpy(manifest->version, value_start, sizeof(manifest->version) - 1);
-                } else if (strcmp(key_start, "author") == 0) {
-                    strncpy(manifest->author, value_start, sizeof(manifest->author) - 1);
-                } else if (strcmp(key_start, "description") == 0) {
-                    strncpy(manifest->description, value_start, sizeof(manifest->description) - 1);
-                } else if (strcmp(key_start, "entry_point") == 0) {
-                    strncpy(manifest->entry_point, value_start, sizeof(manifest->entry_point) - 1);
-                } else if (strcmp(key_start, "permissions") == 0) {
-                    strncpy(manifest->permissions, value_start, sizeof(manifest->permissions) - 1);
-                }
-            }
-        } else if (isdigit(*value_start)) {
-            // Numeric value
-            int num_value = atoi(value_start);
-            if (strcmp(key_start, "memory_limit") == 0) {
-                manifest->memory_limit = num_value;
-            }
-        } else if (strncmp(value_start, "true", 4) == 0) {
-            // Boolean true
-            if (strcmp(key_start, "has_icon") == 0) {
-                manifest->has_icon = true;
-            }
-        }
+    // The reader works in place, so the text is the only buffer needed
+    char *json = malloc(JS_MANIFEST_MAX_SIZE + 1);
+    if (!json) {
+        fclose(file);
+        return ESP_ERR_NO_MEM;
     }
-    
+    size_t len = fread(json, 1, JS_MANIFEST_MAX_SIZE + 1, file);
     fclose(file);
     
-    // Set defaults if not specified
-    if (strlen(manifest->name) == 0) {
-        strcpy(manifest->name, "Unknown App");
+    esp_err_t ret;
+    if (len > JS_MANIFEST_MAX_SIZE) {
+        ESP_LOGE(TAG, "Manifest is over %u bytes", (unsigned)JS_MANIFEST_MAX_SIZE);
+        ret = ESP_ERR_INVALID_SIZE;
+    } else {
+        ret = mjs_engine_parse_manifest(json, len, manifest);
     }
-    if (strlen(manifest->version) == 0) {
-        strcpy(manifest->version, "1.0.0");
-    }
-    if (manifest->memory_limit == 0) {
-        manifest->memory_limit = DEFAULT_MEMORY_LIMIT;
-    }
-    
-    ESP_LOGI(TAG, "Loaded manifest: %s v%s by %s", 
-             manifest->name, manifest->version, manifest->author);
+    free(json);
     
-    return ESP_OK;
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Loaded manifest: %s v%s by %s", 
+                 manifest->name, manifest->version, manifest->author);
+    }
+    return ret;
 }
 
 // Permission checking
@@ -211,8 +200,18 @@ bool mjs_engine_check_permission(js_context_t *ctx, const char *permission)
         return false;
     }
     
-    // For now, allow all permissions (simplified)
-    // In a real implementation, this would check against the app's manifest permissions
-    ESP_LOGD(TAG, "Permission requested: %s (granted)", permission);
-    return true;
+    static const char *names[] = {
+#define JS_PERMISSION_NAME(id, name) name,
+        JS_PERMISSION_LIST(JS_PERMISSION_NAME)
+#undef JS_PERMISSION_NAME
+    };
+    
+    for (int bit = 0; bit < JS_PERM_BIT_COUNT; bit++) {
+        if (strcmp(names[bit], permission) == 0) {
+            return (ctx->permissions >> bit) & 1;
+        }
+    }
+    
+    ESP_LOGW(TAG, "Unknown permission: %s", permission);
+    return false;
 }
\ No newline at end of file
@@ -136,7 +136,7 @@ wifi_status_t network_service_get_wifi_status(void);
 esp_err_t network_service_get_ip_address(char *ip_str, size_t max_len);
 
 /**
- * @brief Set Wi-Fi event callback
+ * @brief Set Wi-Fi event callback (single subscriber; see EVENT_WIFI_STATUS on the event bus)
  * @param callback Callback function
  * @param user_data User data
  */
@@ -4,6 +4,7 @@
  */
 
 #include "network_service.h"
+#include "event_bus.h"
 #include "esp_log.h"
 #include "esp_netif.h"
 #include "esp_event.h"
@@ -226,6 +227,9 @@ void network_service_wifi_event(wifi_status_t status)
     if (s_wifi_callback) {
         s_wifi_callback(status, s_wifi_callback_data);
     }
+
+    event_wifi_status_t event = { .status = (uint32_t)status };
+    event_publish_wifi_status(&event, EVENT_PRIO_NORMAL);
     
     // Auto-start web IDE when connected in station mode
     if (status == WIFI_STATUS_CONNECTED && s_config.mode == NETWORK_MODE_STATION) {
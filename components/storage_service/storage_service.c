@@ -4,6 +4,8 @@
  */
 
 #include "storage_service.h"
+#include "metrics.h"
+#include "trace.h"
 #include "esp_log.h"
 #include "esp_spiffs.h"
 #include "esp_vfs.h"
@@ -17,6 +19,9 @@ static const char *TAG = "STORAGE_SVC";
 
 static bool s_initialized = false;
 
+METRIC_COUNTER_DEFINE(s_flash_writes, "flash.writes", "files");
+METRIC_COUNTER_DEFINE(s_flash_write_bytes, "flash.write_bytes", "B");
+
 esp_err_t storage_service_init(void)
 {
     if (s_initialized) {
@@ -146,14 +151,19 @@ esp_err_t storage_service_write_file(const char *filepath, const void *data, siz
         return ESP_ERR_INVALID_SIZE;
     }
     
+    TRACE(TRACE_FLASH_WRITE_BEGIN, data_size, 0);
     FILE *file = fopen(filepath, "w");
     if (!file) {
         ESP_LOGE(TAG, "Failed to open file for writing: %s", filepath);
+        TRACE(TRACE_FLASH_WRITE_END, 0, 0);
         return ESP_FAIL;
     }
     
     size_t written = fwrite(data, 1, data_size, file);
     fclose(file);
+    TRACE(TRACE_FLASH_WRITE_END, written, 0);
+    metric_inc(&s_flash_writes);
+    metric_add(&s_flash_write_bytes, (uint32_t)written);
     
     if (written != data_size) {
         ESP_LOGE(TAG, "Failed to write complete data to %s", filepath);
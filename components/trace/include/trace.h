@@ -0,0 +1,172 @@
+/**
+ * @file trace.h
+ * @brief Binary event tracing into per-core ring buffers
+ *
+ * TRACE() stores a fixed 16-byte record (timestamp, event, task, two
+ * arguments) in the ring of the calling core, from any task or ISR,
+ * without formatting or locks. Rings keep the most recent
+ * TRACE_RING_RECORDS records each; trace_dump() writes them out and
+ * sdk/tools/trace-decode.js turns the dump into Chrome trace JSON, which
+ * chrome://tracing and Perfetto both open.
+ *
+ * Build with TRACE_ENABLED=0 to compile every TRACE() out.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED           1
+#endif
+
+#if CONFIG_IDF_TARGET_LINUX
+#define TRACE_CORES             1
+#else
+#include "freertos/FreeRTOS.h"
+#define TRACE_CORES             portNUM_PROCESSORS
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TRACE_RING_RECORDS      512     // Per core, power of two
+#define TRACE_MAGIC             0x31435254  // "TRC1"
+#define TRACE_FORMAT_VERSION    1
+#define TRACE_TASK_ISR          0xFFFF  // Task tag of records written from an ISR
+#define TRACE_TASK_NAME_LEN     16
+
+typedef enum {
+#define TRACE_EVENT(id, category, phase, arg0, arg1) id,
+#include "trace_events.h"
+#undef TRACE_EVENT
+    TRACE_EVENT_COUNT
+} trace_event_t;
+
+typedef enum {
+    TRACE_PH_BEGIN,
+    TRACE_PH_END,
+    TRACE_PH_INSTANT,
+    TRACE_PH_COUNTER
+} trace_phase_t;
+
+typedef struct {
+    uint32_t timestamp_us;      // Low 32 bits of the microsecond clock
+    uint16_t event;             // trace_event_t
+    uint16_t task;              // FreeRTOS task number or TRACE_TASK_ISR
+    uint32_t arg0;
+    uint32_t arg1;
+} trace_record_t;
+
+/*
+ * Dump layout, little-endian:
+ *   trace_dump_header_t
+ *   task_count x trace_dump_task_t
+ *   per core: uint32_t core, uint32_t count, count x trace_record_t (oldest first)
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t cores;
+    uint32_t task_count;
+} trace_dump_header_t;
+
+typedef struct {
+    uint16_t number;
+    char name[TRACE_TASK_NAME_LEN];
+} __attribute__((packed)) trace_dump_task_t;
+
+typedef struct {
+    uint32_t recorded;          // Records written since the last clear
+    uint32_t overwritten;       // Records lost to ring wrap
+} trace_stats_t;
+
+/**
+ * @brief Sink for trace_dump()
+ * @param data Bytes to write
+ * @param len Number of bytes
+ * @param ctx User context
+ * @return ESP_OK to continue
+ */
+typedef esp_err_t (*trace_write_fn_t)(const void *data, size_t len, void *ctx);
+
+#if TRACE_ENABLED
+#define TRACE(event, arg0, arg1) trace_record((event), (uint32_t)(arg0), (uint32_t)(arg1))
+#else
+#define TRACE(event, arg0, arg1) ((void)0)
+#endif
+
+/**
+ * @brief Append a record to the calling core's ring (use TRACE())
+ * @param event Event ID
+ * @param arg0 First argument
+ * @param arg1 Second argument
+ */
+void trace_record(trace_event_t event, uint32_t arg0, uint32_t arg1);
+
+/**
+ * @brief Start or stop recording (on at boot)
+ * @param running true to record
+ */
+void trace_set_running(bool running);
+
+/**
+ * @brief Check whether records are being written
+ * @return true if recording
+ */
+bool trace_is_running(void);
+
+/**
+ * @brief Drop every recorded event
+ */
+void trace_clear(void);
+
+/**
+ * @brief Get recording statistics
+ * @param stats Statistics to fill
+ */
+void trace_get_stats(trace_stats_t *stats);
+
+/**
+ * @brief Phase of an event, from the catalogue
+ * @param event Event ID
+ * @return Phase
+ */
+trace_phase_t trace_event_phase(trace_event_t event);
+
+/**
+ * @brief Name of an event, from the catalogue
+ * @param event Event ID
+ * @return Identifier without the TRACE_ prefix, "?" if unknown
+ */
+const char* trace_event_name(trace_event_t event);
+
+/**
+ * @brief Write the rings in the dump format
+ *
+ * Recording is paused while the rings are read.
+ * @param write Sink called with consecutive chunks
+ * @param ctx Sink context
+ * @return ESP_OK on success, or the sink's error
+ */
+esp_err_t trace_dump(trace_write_fn_t write, void *ctx);
+
+/**
+ * @brief Write the rings to a file
+ * @param path File path
+ * @return ESP_OK on success
+ */
+esp_err_t trace_save(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TRACE_H
@@ -0,0 +1,40 @@
+/**
+ * @file trace_events.h
+ * @brief Trace event catalogue
+ *
+ * One line per event: identifier, category, phase and the names of its two
+ * arguments ("" when unused). An event's ID is its position in this list,
+ * so add new events only at the end of the file, whatever their group:
+ * inserting one renumbers every later event and older dumps would decode
+ * wrongly. Bump TRACE_FORMAT_VERSION in trace.h if events are ever
+ * reordered or removed. sdk/tools/trace-decode.js reads this file to name
+ * the records in a dump.
+ *
+ * Phases: BEGIN/END bracket a span on the same task, INSTANT marks a point,
+ * COUNTER plots arg0 over time.
+ */
+
+// RF
+TRACE_EVENT(TRACE_RF_SET_FREQUENCY,  "rf",      INSTANT, "hz",     "")
+TRACE_EVENT(TRACE_RF_RX_PACKET,      "rf",      INSTANT, "length", "rssi")
+TRACE_EVENT(TRACE_RF_TX,             "rf",      INSTANT, "length", "")
+
+// Input
+TRACE_EVENT(TRACE_INPUT_PUSH,        "input",   INSTANT, "event",  "id")
+
+// UI
+TRACE_EVENT(TRACE_UI_FRAME_BEGIN,    "ui",      BEGIN,   "",       "")
+TRACE_EVENT(TRACE_UI_FRAME_END,      "ui",      END,     "flushes", "")
+TRACE_EVENT(TRACE_UI_FLUSH_START,    "display", INSTANT, "px",     "")
+TRACE_EVENT(TRACE_UI_FLUSH_DONE,     "display", INSTANT, "",       "")
+
+// JavaScript
+TRACE_EVENT(TRACE_JS_EXEC_BEGIN,     "js",      BEGIN,   "",       "")
+TRACE_EVENT(TRACE_JS_EXEC_END,       "js",      END,     "result", "")
+
+// Storage
+TRACE_EVENT(TRACE_FLASH_WRITE_BEGIN, "flash",   BEGIN,   "bytes",  "")
+TRACE_EVENT(TRACE_FLASH_WRITE_END,   "flash",   END,     "bytes",  "")
+
+// System
+TRACE_EVENT(TRACE_SYS_FREE_HEAP,     "sys",     COUNTER, "bytes",  "")
@@ -0,0 +1,253 @@
+/**
+ * @file trace.c
+ * @brief Per-core trace rings and dump writer
+ */
+
+#include "trace.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#if CONFIG_IDF_TARGET_LINUX
+#include <time.h>
+#else
+#include "freertos/task.h"
+#include "esp_timer.h"
+#endif
+
+static const char *TAG = "TRACE";
+
+#define RING_MASK       (TRACE_RING_RECORDS - 1)
+#define DUMP_MAX_TASKS  32
+
+_Static_assert((TRACE_RING_RECORDS & RING_MASK) == 0, "TRACE_RING_RECORDS must be a power of two");
+_Static_assert(sizeof(trace_record_t) == 16, "trace record layout is part of the dump format");
+
+typedef struct {
+    atomic_uint head;           // Records ever reserved on this core
+    trace_record_t records[TRACE_RING_RECORDS];
+} trace_ring_t;
+
+static const struct {
+    const char *name;
+    trace_phase_t phase;
+} s_catalogue[TRACE_EVENT_COUNT] = {
+    // Names skip the "TRACE_" prefix
+#define TRACE_EVENT(id, category, phase, arg0, arg1) [id] = { #id + 6, TRACE_PH_##phase },
+#include "trace_events.h"
+#undef TRACE_EVENT
+};
+
+#if TRACE_ENABLED
+static trace_ring_t s_rings[TRACE_CORES];
+#endif
+static atomic_bool s_running = true;
+
+static inline uint32_t IRAM_ATTR now_us(void)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+#else
+    return (uint32_t)esp_timer_get_time();
+#endif
+}
+
+static inline int IRAM_ATTR core_id(void)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    return 0;
+#else
+    return xPortGetCoreID();
+#endif
+}
+
+static inline uint16_t IRAM_ATTR task_tag(void)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    return 0;
+#else
+    if (xPortInIsrContext()) {
+        return TRACE_TASK_ISR;
+    }
+    return (uint16_t)uxTaskGetTaskNumber(xTaskGetCurrentTaskHandle());
+#endif
+}
+
+void IRAM_ATTR trace_record(trace_event_t event, uint32_t arg0, uint32_t arg1)
+{
+#if TRACE_ENABLED
+    if (!atomic_load_explicit(&s_running, memory_order_relaxed)) {
+        return;
+    }
+
+    // Only this core writes its ring; the atomic reservation keeps an ISR
+    // that interrupts a half-written record off its slot
+    trace_ring_t *ring = &s_rings[core_id()];
+    uint32_t idx = atomic_fetch_add_explicit(&ring->head, 1, memory_order_relaxed);
+    trace_record_t *rec = &ring->records[idx & RING_MASK];
+
+    rec->timestamp_us = now_us();
+    rec->event = (uint16_t)event;
+    rec->task = task_tag();
+    rec->arg0 = arg0;
+    rec->arg1 = arg1;
+#else
+    (void)event;
+    (void)arg0;
+    (void)arg1;
+#endif
+}
+
+void trace_set_running(bool running)
+{
+    atomic_store(&s_running, running);
+}
+
+bool trace_is_running(void)
+{
+    return atomic_load(&s_running);
+}
+
+void trace_clear(void)
+{
+#if TRACE_ENABLED
+    for (int c = 0; c < TRACE_CORES; c++) {
+        atomic_store(&s_rings[c].head, 0);
+    }
+#endif
+}
+
+void trace_get_stats(trace_stats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+#if TRACE_ENABLED
+    for (int c = 0; c < TRACE_CORES; c++) {
+        uint32_t head = atomic_load(&s_rings[c].head);
+        stats->recorded += head;
+        if (head > TRACE_RING_RECORDS) {
+            stats->overwritten += head - TRACE_RING_RECORDS;
+        }
+    }
+#endif
+}
+
+trace_phase_t trace_event_phase(trace_event_t event)
+{
+    return event < TRACE_EVENT_COUNT ? s_catalogue[event].phase : TRACE_PH_INSTANT;
+}
+
+const char* trace_event_name(trace_event_t event)
+{
+    return event < TRACE_EVENT_COUNT ? s_catalogue[event].name : "?";
+}
+
+static uint32_t collect_tasks(trace_dump_task_t *tasks, uint32_t max_tasks)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    (void)tasks;
+    (void)max_tasks;
+    return 0;
+#else
+    static TaskStatus_t status[DUMP_MAX_TASKS];
+    UBaseType_t count = uxTaskGetSystemState(status, DUMP_MAX_TASKS, NULL);
+
+    if (count > max_tasks) {
+        count = max_tasks;
+    }
+    for (UBaseType_t i = 0; i < count; i++) {
+        tasks[i].number = (uint16_t)status[i].xTaskNumber;
+        strncpy(tasks[i].name, status[i].pcTaskName, TRACE_TASK_NAME_LEN);
+    }
+    return (uint32_t)count;
+#endif
+}
+
+esp_err_t trace_dump(trace_write_fn_t write, void *ctx)
+{
+    if (!write) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    static trace_dump_task_t tasks[DUMP_MAX_TASKS];
+    memset(tasks, 0, sizeof(tasks));
+    uint32_t task_count = collect_tasks(tasks, DUMP_MAX_TASKS);
+
+    bool was_running = atomic_exchange(&s_running, false);
+
+    trace_dump_header_t header = {
+        .magic = TRACE_MAGIC,
+        .version = TRACE_FORMAT_VERSION,
+        .record_size = sizeof(trace_record_t),
+        .cores = TRACE_ENABLED ? TRACE_CORES : 0,
+        .task_count = task_count,
+    };
+
+    esp_err_t ret = write(&header, sizeof(header), ctx);
+    if (ret == ESP_OK && task_count) {
+        ret = write(tasks, task_count * sizeof(trace_dump_task_t), ctx);
+    }
+
+#if TRACE_ENABLED
+    for (uint32_t c = 0; c < TRACE_CORES && ret == ESP_OK; c++) {
+        uint32_t head = atomic_load(&s_rings[c].head);
+        uint32_t count = head < TRACE_RING_RECORDS ? head : TRACE_RING_RECORDS;
+        uint32_t first = head - count;
+        uint32_t section[2] = { c, count };
+
+        ret = write(section, sizeof(section), ctx);
+
+        // Oldest first: the ring's tail end, then its start
+        uint32_t start = first & RING_MASK;
+        uint32_t tail_len = count < TRACE_RING_RECORDS - start ? count : TRACE_RING_RECORDS - start;
+        if (ret == ESP_OK && tail_len) {
+            ret = write(&s_rings[c].records[start], tail_len * sizeof(trace_record_t), ctx);
+        }
+        if (ret == ESP_OK && count > tail_len) {
+            ret = write(&s_rings[c].records[0], (count - tail_len) * sizeof(trace_record_t), ctx);
+        }
+    }
+#endif
+
+    atomic_store(&s_running, was_running);
+    return ret;
+}
+
+static esp_err_t file_write(const void *data, size_t len, void *ctx)
+{
+    return fwrite(data, 1, len, (FILE *)ctx) == len ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t trace_save(const char *path)
+{
+    if (!path) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        ESP_LOGE(TAG, "Failed to open %s", path);
+        return ESP_FAIL;
+    }
+
+    esp_err_t ret = trace_dump(file_write, file);
+    fclose(file);
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to write trace to %s", path);
+        return ret;
+    }
+
+    trace_stats_t stats;
+    trace_get_stats(&stats);
+    ESP_LOGI(TAG, "Saved trace to %s (%u recorded, %u overwritten)", path,
+             (unsigned)stats.recorded, (unsigned)stats.overwritten);
+    return ESP_OK;
+}
@@ -124,11 +124,24 @@ void app_main(void)
     ESP_LOGI(TAG, "Firmware initialization complete");
     ESP_LOGI(TAG, "Ready for JavaScript apps!");
 
-    // Main loop - keep the main task running
+    // Main loop: supervise task heartbeats, sample health once a second
+    const uint32_t checks_per_second = 1000 / TASK_WATCHDOG_CHECK_MS;
+    uint32_t checks = 0;
+    uint32_t seconds = 0;
     while (1) {
-        vTaskDelay(pdMS_TO_TICKS(1000));
-        
-        // System health check and monitoring can be added here
+        vTaskDelay(pdMS_TO_TICKS(TASK_WATCHDOG_CHECK_MS));
+        task_manager_watchdog_check();
+        if (++checks % checks_per_second) {
+            continue;
+        }
+
         system_manager_heartbeat();
+
+        // Loads cover the second since the last sample
+        task_manager_sample();
+        if (++seconds % TASK_MONITOR_REPORT_S == 0) {
+            task_manager_log_report();
+            system_manager_log_metrics();
+        }
     }
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
  */
 
 #include "hw_init.h"
+#include "lvgl_port.h"
 #include "esp_log.h"
 #include "driver/gpio.h"
 #include "driver/spi_master.h"
@@ -90,7 +91,7 @@ esp_err_t hw_init_spi(void)
         .sclk_io_num = TEMBED_LCD_CLK,
         .quadwp_io_num = -1,
         .quadhd_io_num = -1,
-        .max_transfer_sz = 4092
+        .max_transfer_sz = LCD_DRAW_BUF_BYTES
     };
     ESP_ERROR_CHECK(spi_bus_initialize(SPI3_HOST, &lcd_bus_cfg, SPI_DMA_CH_AUTO));
 
@@ -99,7 +100,9 @@ esp_err_t hw_init_spi(void)
         .clock_speed_hz = 40 * 1000 * 1000, // 40 MHz
         .mode = 0,
         .spics_io_num = TEMBED_LCD_CS,
-        .queue_size = 1,
+        .queue_size = 8,                        // One full flush chain
+        .pre_cb = display_driver_spi_pre_cb,    // Drives DC per transaction
+        .post_cb = display_driver_spi_post_cb,  // Signals LVGL flush-ready
     };
     ESP_ERROR_CHECK(spi_bus_add_device(SPI3_HOST, &lcd_dev_cfg, &s_hw_handles.lcd_spi));
 
@@ -4,6 +4,10 @@
  */
 
 #include "system_manager.h"
+#include "metrics.h"
+#include "trace.h"
+#include "event_bus.h"
+#include "network_service.h"
 #include "esp_log.h"
 #include "esp_system.h"
 #include "freertos/FreeRTOS.h"
@@ -19,6 +23,24 @@ static system_event_callback_t s_event_callback = NULL;
 static void *s_callback_user_data = NULL;
 static uint32_t s_boot_time = 0;
 
+METRIC_GAUGE_DEFINE(s_free_heap_metric, "sys.free_heap", "B");
+
+// Wi-Fi changes arrive on the bus and are folded in by the heartbeat
+EVENT_SUBSCRIBER_DEFINE(s_bus, "system", EVENT_TOPIC_BIT(EVENT_WIFI_STATUS), 0, 4);
+
+static void on_bus_event(const event_t *event, void *user_data)
+{
+    if (event->topic != EVENT_WIFI_STATUS) {
+        return;
+    }
+
+    if (event->wifi_status.status == WIFI_STATUS_CONNECTED) {
+        xEventGroupSetBits(s_system_event_group, SYSTEM_WIFI_CONNECTED_BIT);
+    } else {
+        xEventGroupClearBits(s_system_event_group, SYSTEM_WIFI_CONNECTED_BIT);
+    }
+}
+
 esp_err_t system_manager_init(void)
 {
     ESP_LOGI(TAG, "Initializing system manager");
@@ -38,6 +60,11 @@ esp_err_t system_manager_init(void)
     
     s_boot_time = esp_log_timestamp();
 
+    esp_err_t ret = event_bus_subscribe(&s_bus);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Event bus subscription failed: %s", esp_err_to_name(ret));
+    }
+
     ESP_LOGI(TAG, "System manager initialized");
     return ESP_OK;
 }
@@ -74,6 +101,9 @@ esp_err_t system_manager_set_state(system_state_t state)
         s_event_callback(state, s_callback_user_data);
     }
 
+    event_system_state_t event = { .state = (uint32_t)state };
+    event_publish_system_state(&event, EVENT_PRIO_URGENT);
+
     return ESP_OK;
 }
 
@@ -82,12 +112,16 @@ void system_manager_heartbeat(void)
     // Update status
     s_system_status.uptime_seconds = (esp_log_timestamp() - s_boot_time) / 1000;
     s_system_status.free_heap = esp_get_free_heap_size();
+    metric_set(&s_free_heap_metric, (int32_t)s_system_status.free_heap);
+    TRACE(TRACE_SYS_FREE_HEAP, s_system_status.free_heap, 0);
     
     // Check if heap is getting low
     if (s_system_status.free_heap < 10240) { // Less than 10KB
         ESP_LOGW(TAG, "Low memory warning: %d bytes free", s_system_status.free_heap);
     }
 
+    event_bus_dispatch(&s_bus, on_bus_event, NULL);
+
     // Update system state based on event group
     EventBits_t bits = xEventGroupGetBits(s_system_event_group);
     
@@ -104,6 +138,41 @@ void system_manager_heartbeat(void)
     }
 }
 
+esp_err_t system_manager_get_input_latency(lvgl_latency_stats_t *stats)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    lvgl_port_get_latency_stats(stats);
+    return ESP_OK;
+}
+
+void system_manager_log_input_latency(void)
+{
+    lvgl_port_log_latency_report();
+}
+
+int system_manager_get_metrics_json(char *buf, size_t len)
+{
+    if (!buf || len == 0) {
+        return -1;
+    }
+
+    return metrics_format_json(buf, len);
+}
+
+esp_err_t system_manager_save_trace(const char *path)
+{
+    return trace_save(path ? path : SYSTEM_TRACE_PATH);
+}
+
+void system_manager_log_metrics(void)
+{
+    ESP_LOGI(TAG, "Metrics (%u registered):", (unsigned)metrics_count());
+    metrics_log();
+}
+
 esp_err_t system_manager_register_callback(system_event_callback_t callback, void *user_data)
 {
     s_event_callback = callback;
@@ -9,6 +9,7 @@
 #include "esp_err.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
+#include "lvgl_port.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -20,6 +21,8 @@ extern "C" {
 #define SYSTEM_UI_READY_BIT         BIT2
 #define SYSTEM_RF_READY_BIT         BIT3
 
+#define SYSTEM_TRACE_PATH           "/spiffs/trace.bin"
+
 typedef enum {
     SYSTEM_STATE_BOOTING,
     SYSTEM_STATE_INITIALIZING,
@@ -70,7 +73,39 @@ esp_err_t system_manager_set_state(system_state_t state);
 void system_manager_heartbeat(void);
 
 /**
- * @brief Register system event callback
+ * @brief Get input-to-photon latency histograms
+ * @param stats Statistics structure to fill
+ * @return ESP_OK on success
+ */
+esp_err_t system_manager_get_input_latency(lvgl_latency_stats_t *stats);
+
+/**
+ * @brief Log the input latency report
+ */
+void system_manager_log_input_latency(void);
+
+/**
+ * @brief Format every metric as a JSON object, for the web API
+ * @param buf Output buffer
+ * @param len Buffer size
+ * @return Length of the full output, -1 on invalid arguments
+ */
+int system_manager_get_metrics_json(char *buf, size_t len);
+
+/**
+ * @brief Write the event trace rings to a file for trace-decode.js
+ * @param path File path, NULL for SYSTEM_TRACE_PATH
+ * @return ESP_OK on success
+ */
+esp_err_t system_manager_save_trace(const char *path);
+
+/**
+ * @brief Log every metric on the serial console
+ */
+void system_manager_log_metrics(void);
+
+/**
+ * @brief Register system event callback (single subscriber; see EVENT_SYSTEM_STATE on the event bus)
  * @param callback Callback function
  * @return ESP_OK on success
  */
@@ -5,85 +5,218 @@
 
 #include "task_manager.h"
 #include "system_manager.h"
+#include "lvgl_port.h"
+#include "dlog.h"
+#include "cc1101.h"
+#include "app_manager.h"
+#include "esp_timer.h"
+#include "esp_system.h"
 #include "esp_log.h"
 #include <string.h>
 
 static const char *TAG = "TASK_MGR";
 
+// A task asked to stop gets one period plus this to reach the top of its loop
+#define TASK_STOP_GRACE_MS  100
+#define TASK_STOP_POLL_MS   10
+
+// Run-time counter sampling
+static TaskStatus_t s_status[TASK_MONITOR_MAX_TASKS];
+static uint32_t s_last_total_runtime = 0;
+static task_load_t s_idle_load[TASK_CORE_COUNT];
+
+static esp_err_t recover_radio(int id, void *ctx);
+static esp_err_t recover_js(int id, void *ctx);
+
+// Network shares the RF core with the Wi-Fi driver; the app manager
+// launches JS apps and stays next to the engine
 static task_info_t s_tasks[TASK_ID_MAX] = {
     [TASK_ID_UI] = {
         .name = "ui_task",
         .function = ui_task,
         .stack_size = TASK_STACK_SIZE_LARGE,
         .priority = TASK_PRIORITY_HIGH,
+        .core = TASK_CORE_UI_JS,
         .handle = NULL,
-        .is_running = false
+        .is_running = false,
+        .period_ms = 1000,
+        .deadline_ms = 3000,
+        .recover = NULL
     },
     [TASK_ID_RF_SERVICE] = {
         .name = "rf_service_task", 
         .function = rf_service_task,
         .stack_size = TASK_STACK_SIZE_MEDIUM,
         .priority = TASK_PRIORITY_HIGH,
+        .core = TASK_CORE_RF_INPUT,
         .handle = NULL,
-        .is_running = false
+        .is_running = false,
+        .period_ms = 100,
+        .deadline_ms = 1000,
+        .recover = recover_radio
     },
     [TASK_ID_JS_ENGINE] = {
         .name = "js_engine_task",
         .function = js_engine_task,
         .stack_size = TASK_STACK_SIZE_LARGE,
         .priority = TASK_PRIORITY_NORMAL,
+        .core = TASK_CORE_UI_JS,
         .handle = NULL,
-        .is_running = false
+        .is_running = false,
+        .period_ms = 100,
+        .deadline_ms = 2000,
+        .recover = recover_js
     },
     [TASK_ID_NETWORK] = {
         .name = "network_task",
         .function = network_task,
         .stack_size = TASK_STACK_SIZE_MEDIUM,
         .priority = TASK_PRIORITY_NORMAL,
+        .core = TASK_CORE_RF_INPUT,
         .handle = NULL,
-        .is_running = false
+        .is_running = false,
+        .period_ms = 1000,
+        .deadline_ms = 5000,
+        .recover = NULL
     },
     [TASK_ID_APP_MANAGER] = {
         .name = "app_manager_task",
         .function = app_manager_task,
         .stack_size = TASK_STACK_SIZE_MEDIUM,
         .priority = TASK_PRIORITY_NORMAL,
+        .core = TASK_CORE_UI_JS,
         .handle = NULL,
-        .is_running = false
+        .is_running = false,
+        .period_ms = 1000,
+        .deadline_ms = 5000,
+        .recover = NULL
     },
     [TASK_ID_INPUT_HANDLER] = {
         .name = "input_handler_task",
         .function = input_handler_task,
         .stack_size = TASK_STACK_SIZE_SMALL,
         .priority = TASK_PRIORITY_HIGH,
+        .core = TASK_CORE_RF_INPUT,
         .handle = NULL,
-        .is_running = false
+        .is_running = false,
+        .period_ms = 20,
+        .deadline_ms = 500,
+        .recover = NULL
+    },
+    [TASK_ID_LOGGER] = {
+        .name = "logger_task",
+        .function = logger_task,
+        .stack_size = TASK_STACK_SIZE_MEDIUM,
+        .priority = TASK_PRIORITY_IDLE,
+        .core = tskNO_AFFINITY,     // Formats on whichever core has time
+        .handle = NULL,
+        .is_running = false,
+        .period_ms = DLOG_FLUSH_PERIOD_MS,
+        .deadline_ms = 2000,
+        .recover = NULL
     }
 };
 
+static uint32_t now_us(void)
+{
+    return (uint32_t)esp_timer_get_time();
+}
+
+static void escalate_restart(int id, const char *name)
+{
+    ESP_LOGE(TAG, "%s cannot be recovered, restarting", name);
+    dlog_flush();
+    esp_restart();
+}
+
+static esp_err_t create_task(task_info_t *task)
+{
+    atomic_store_explicit(&task->stop_requested, false, memory_order_relaxed);
+    BaseType_t ret = xTaskCreatePinnedToCore(
+        task->function,
+        task->name,
+        task->stack_size,
+        NULL,
+        task->priority,
+        &task->handle,
+        task->core
+    );
+
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create task %s", task->name);
+        return ESP_ERR_NO_MEM;
+    }
+
+    task->is_running = true;
+    task->stack_min_free = task->stack_size;
+    task->stack_recommended = 0;
+    memset(&task->load, 0, sizeof(task->load));
+    return ESP_OK;
+}
+
+// Called by each task at the top of its loop, where it holds no lock
+static void exit_if_stop_requested(task_id_t task_id)
+{
+    task_info_t *task = &s_tasks[task_id];
+    if (!atomic_load_explicit(&task->stop_requested, memory_order_acquire)) {
+        return;
+    }
+
+    // The handle is cleared before the waiter can see the task gone
+    ESP_LOGW(TAG, "Task %s stopping on request", task->name);
+    task->handle = NULL;
+    atomic_store_explicit(&task->is_running, false, memory_order_release);
+    vTaskDelete(NULL);
+}
+
+// Asks a task to stop and waits for it to exit; never deletes it
+static esp_err_t stop_task(task_info_t *task)
+{
+    uint32_t timeout_ms = task->period_ms + TASK_STOP_GRACE_MS;
+    uint32_t waited_ms = 0;
+
+    atomic_store_explicit(&task->stop_requested, true, memory_order_release);
+    while (atomic_load_explicit(&task->is_running, memory_order_acquire)) {
+        if (waited_ms >= timeout_ms) {
+            ESP_LOGE(TAG, "Task %s did not stop within %u ms", task->name, (unsigned)timeout_ms);
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(pdMS_TO_TICKS(TASK_STOP_POLL_MS));
+        waited_ms += TASK_STOP_POLL_MS;
+    }
+    return ESP_OK;
+}
+
 esp_err_t task_manager_start(void)
 {
     ESP_LOGI(TAG, "Starting system tasks");
 
+    task_watchdog_set_escalation(escalate_restart);
+
     for (int i = 0; i < TASK_ID_MAX; i++) {
         task_info_t *task = &s_tasks[i];
-        
-        BaseType_t ret = xTaskCreate(
-            task->function,
-            task->name,
-            task->stack_size,
-            NULL,
-            task->priority,
-            &task->handle
-        );
-
-        if (ret != pdPASS) {
-            ESP_LOGE(TAG, "Failed to create task %s", task->name);
-            return ESP_ERR_NO_MEM;
+
+        // Registered before the task runs, so its first heartbeat has an ID
+        task->watchdog_id = -1;
+        if (task->period_ms) {
+            task_watchdog_config_t config = {
+                .name = task->name,
+                .period_ms = task->period_ms,
+                .deadline_ms = task->deadline_ms,
+                .priority = (uint8_t)task->priority,
+                .core = task->core == tskNO_AFFINITY ? TASK_WATCHDOG_ANY_CORE : (int8_t)task->core,
+                .recover = task->recover,
+                .ctx = NULL,
+            };
+            task->watchdog_id = task_watchdog_register(&config, now_us());
         }
 
-        task->is_running = true;
-        ESP_LOGI(TAG, "Started task: %s", task->name);
+        esp_err_t ret = create_task(task);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        ESP_LOGI(TAG, "Started task: %s (core %d, priority %d)",
+                 task->name, (int)task->core, (int)task->priority);
     }
 
     ESP_LOGI(TAG, "All system tasks started successfully");
@@ -136,6 +269,208 @@ esp_err_t task_manager_get_stats(TaskStatus_t *stats)
     return ESP_OK;
 }
 
+esp_err_t task_manager_set_priority(task_id_t task_id, UBaseType_t priority)
+{
+    if (task_id >= TASK_ID_MAX || priority >= configMAX_PRIORITIES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    task_info_t *task = &s_tasks[task_id];
+    if (task->handle && task->is_running) {
+        vTaskPrioritySet(task->handle, priority);
+    }
+    ESP_LOGI(TAG, "Priority of %s: %d -> %d", task->name, (int)task->priority, (int)priority);
+    task->priority = priority;
+    return ESP_OK;
+}
+
+esp_err_t task_manager_set_core(task_id_t task_id, BaseType_t core)
+{
+    if (task_id >= TASK_ID_MAX || (core != tskNO_AFFINITY && (core < 0 || core >= TASK_CORE_COUNT))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // FreeRTOS cannot move a pinned task; it has to be created again
+    if (s_tasks[task_id].is_running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_tasks[task_id].core = core;
+    return ESP_OK;
+}
+
+static const TaskStatus_t* find_status(TaskHandle_t handle, UBaseType_t count)
+{
+    for (UBaseType_t i = 0; i < count; i++) {
+        if (s_status[i].xHandle == handle) {
+            return &s_status[i];
+        }
+    }
+    return NULL;
+}
+
+esp_err_t task_manager_sample(void)
+{
+    uint32_t total_runtime = 0;
+    UBaseType_t count = uxTaskGetSystemState(s_status, TASK_MONITOR_MAX_TASKS, &total_runtime);
+    if (count == 0) {
+        ESP_LOGW(TAG, "More than %d tasks, not sampled", TASK_MONITOR_MAX_TASKS);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // The total is wall time, so loads are shares of one core
+    uint32_t window = total_runtime - s_last_total_runtime;
+    s_last_total_runtime = total_runtime;
+
+    for (int i = 0; i < TASK_ID_MAX; i++) {
+        task_info_t *task = &s_tasks[i];
+        const TaskStatus_t *status = task->is_running ? find_status(task->handle, count) : NULL;
+        if (!status) {
+            continue;
+        }
+
+        task_load_update(&task->load, status->ulRunTimeCounter, window);
+
+        // High-water marks are in bytes on ESP-IDF
+        uint32_t free_bytes = status->usStackHighWaterMark;
+        if (free_bytes < task->stack_min_free) {
+            task->stack_min_free = free_bytes;
+            if (free_bytes < TASK_STACK_LOW_FREE) {
+                ESP_LOGW(TAG, "%s: only %u bytes of stack left at peak",
+                         task->name, (unsigned)free_bytes);
+            }
+        }
+        task->stack_recommended = task_stack_recommend(task->stack_size, task->stack_min_free);
+    }
+
+    for (BaseType_t core = 0; core < TASK_CORE_COUNT; core++) {
+        const TaskStatus_t *idle = find_status(xTaskGetIdleTaskHandleForCore(core), count);
+        if (idle) {
+            task_load_update(&s_idle_load[core], idle->ulRunTimeCounter, window);
+        }
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t task_manager_get_report(task_id_t task_id, task_report_t *report)
+{
+    if (task_id >= TASK_ID_MAX || !report) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const task_info_t *task = &s_tasks[task_id];
+    report->name = task->name;
+    report->priority = task->priority;
+    report->core = task->core;
+    report->stack_size = task->stack_size;
+    report->stack_min_free = task->stack_min_free;
+    report->stack_recommended = task->stack_recommended;
+    report->load = task->load.load;
+    report->avg_load = task->load.avg_load;
+    return ESP_OK;
+}
+
+uint16_t task_manager_get_core_load(BaseType_t core)
+{
+    if (core < 0 || core >= TASK_CORE_COUNT || !s_idle_load[core].windows) {
+        return 0;
+    }
+    return TASK_LOAD_FULL - s_idle_load[core].load;
+}
+
+void task_manager_log_report(void)
+{
+    ESP_LOGI(TAG, "Core load: %u.%u%% / %u.%u%%",
+             task_manager_get_core_load(0) / 10, task_manager_get_core_load(0) % 10,
+             task_manager_get_core_load(1) / 10, task_manager_get_core_load(1) % 10);
+
+    for (int i = 0; i < TASK_ID_MAX; i++) {
+        task_report_t r;
+        task_manager_get_report((task_id_t)i, &r);
+        if (!s_tasks[i].is_running) {
+            continue;
+        }
+        ESP_LOGI(TAG, "  %-18s core %d prio %2d  load %3u.%u%% (avg %3u.%u%%)  "
+                 "stack %u/%u, recommend %u",
+                 r.name, (int)r.core, (int)r.priority,
+                 r.load / 10, r.load % 10, r.avg_load / 10, r.avg_load % 10,
+                 (unsigned)(r.stack_size - r.stack_min_free), (unsigned)r.stack_size,
+                 (unsigned)r.stack_recommended);
+    }
+
+    task_watchdog_log_report();
+}
+
+esp_err_t task_manager_restart(task_id_t task_id)
+{
+    if (task_id >= TASK_ID_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    task_info_t *task = &s_tasks[task_id];
+    if (task->is_running) {
+        esp_err_t ret = stop_task(task);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    ESP_LOGW(TAG, "Restarting task: %s", task->name);
+    return create_task(task);
+}
+
+void task_manager_heartbeat(task_id_t task_id)
+{
+    if (task_id < TASK_ID_MAX) {
+        task_watchdog_beat(s_tasks[task_id].watchdog_id, now_us());
+    }
+}
+
+uint32_t task_manager_watchdog_check(void)
+{
+    return task_watchdog_check(now_us());
+}
+
+// The radio task stops between transfers, so the reset never cuts one
+// of its SPI transactions in half
+static esp_err_t recover_radio(int id, void *ctx)
+{
+    task_info_t *task = &s_tasks[TASK_ID_RF_SERVICE];
+    if (task->is_running) {
+        esp_err_t ret = stop_task(task);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    esp_err_t ret = cc1101_reset();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Radio reset failed: %s", esp_err_to_name(ret));
+    }
+    return task_manager_restart(TASK_ID_RF_SERVICE);
+}
+
+// The engine task stops between scheduler periods, with the app manager
+// unlocked, and the started apps are dropped with their runtimes. A script
+// that never returns keeps the task, and the watchdog escalates instead.
+static esp_err_t recover_js(int id, void *ctx)
+{
+    task_info_t *task = &s_tasks[TASK_ID_JS_ENGINE];
+    if (task->is_running) {
+        esp_err_t ret = stop_task(task);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    esp_err_t ret = app_manager_stop_all();
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "Stopping apps failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    return task_manager_restart(TASK_ID_JS_ENGINE);
+}
+
 // Placeholder task implementations
 void ui_task(void *pvParameters)
 {
@@ -147,9 +482,17 @@ void ui_task(void *pvParameters)
         xEventGroupSetBits(event_group, SYSTEM_UI_READY_BIT);
     }
 
+    // Render when LVGL has work, then sleep until the next timer deadline,
+    // an input event or an invalidation from another task; an idle screen
+    // still wakes once per heartbeat period for the watchdog
     while (1) {
-        // TODO: Implement UI handling
-        vTaskDelay(pdMS_TO_TICKS(50)); // 20 FPS
+        exit_if_stop_requested(TASK_ID_UI);
+        task_manager_heartbeat(TASK_ID_UI);
+        uint32_t wait = lvgl_port_task();
+        if (wait > s_tasks[TASK_ID_UI].period_ms) {
+            wait = s_tasks[TASK_ID_UI].period_ms;
+        }
+        lvgl_port_wait_frame(wait);
     }
 }
 
@@ -164,6 +507,8 @@ void rf_service_task(void *pvParameters)
     }
 
     while (1) {
+        exit_if_stop_requested(TASK_ID_RF_SERVICE);
+        task_manager_heartbeat(TASK_ID_RF_SERVICE);
         // TODO: Implement RF service
         vTaskDelay(pdMS_TO_TICKS(100));
     }
@@ -179,9 +524,14 @@ void js_engine_task(void *pvParameters)
         xEventGroupSetBits(event_group, SYSTEM_JS_ENGINE_READY_BIT);
     }
 
+    // Started apps run their timers here, at a fixed period so the
+    // foreground app's timing does not drift with background load
+    TickType_t last_wake = xTaskGetTickCount();
     while (1) {
-        // TODO: Implement JavaScript engine
-        vTaskDelay(pdMS_TO_TICKS(100));
+        exit_if_stop_requested(TASK_ID_JS_ENGINE);
+        task_manager_heartbeat(TASK_ID_JS_ENGINE);
+        app_manager_schedule();
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(APP_SCHEDULER_PERIOD_MS));
     }
 }
 
@@ -190,6 +540,8 @@ void network_task(void *pvParameters)
     ESP_LOGI(TAG, "Network task started");
 
     while (1) {
+        exit_if_stop_requested(TASK_ID_NETWORK);
+        task_manager_heartbeat(TASK_ID_NETWORK);
         // TODO: Implement networking
         vTaskDelay(pdMS_TO_TICKS(1000));
     }
@@ -199,7 +551,15 @@ void app_manager_task(void *pvParameters)
 {
     ESP_LOGI(TAG, "App manager task started");
 
+    // Installed apps come from the registry, no directory scan
+    esp_err_t ret = app_manager_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "App manager init failed: %s", esp_err_to_name(ret));
+    }
+
     while (1) {
+        exit_if_stop_requested(TASK_ID_APP_MANAGER);
+        task_manager_heartbeat(TASK_ID_APP_MANAGER);
         // TODO: Implement app manager
         vTaskDelay(pdMS_TO_TICKS(1000));
     }
@@ -210,7 +570,22 @@ void input_handler_task(void *pvParameters)
     ESP_LOGI(TAG, "Input handler task started");
 
     while (1) {
+        exit_if_stop_requested(TASK_ID_INPUT_HANDLER);
+        task_manager_heartbeat(TASK_ID_INPUT_HANDLER);
         // TODO: Implement input handling
         vTaskDelay(pdMS_TO_TICKS(20)); // 50 Hz
     }
-}
\ No newline at end of file
+}
+
+void logger_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "Logger task started");
+
+    // Deferred log lines are formatted and printed here, off the hot paths
+    while (1) {
+        exit_if_stop_requested(TASK_ID_LOGGER);
+        task_manager_heartbeat(TASK_ID_LOGGER);
+        dlog_flush();
+        vTaskDelay(pdMS_TO_TICKS(DLOG_FLUSH_PERIOD_MS));
+    }
+}
@@ -9,6 +9,8 @@
 #include "esp_err.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "task_monitor.h"
+#include "task_watchdog.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -26,6 +28,16 @@ extern "C" {
 #define TASK_STACK_SIZE_MEDIUM  4096
 #define TASK_STACK_SIZE_SMALL   2048
 
+// Core affinity: RF and input share the core the Wi-Fi stack runs on,
+// UI and JS get the other one to themselves
+#define TASK_CORE_RF_INPUT      0
+#define TASK_CORE_UI_JS         1
+#define TASK_CORE_COUNT         2
+
+// Tasks sampled by task_manager_sample(), including idle and driver tasks
+#define TASK_MONITOR_MAX_TASKS  32
+#define TASK_MONITOR_REPORT_S   60      // Seconds between logged reports
+
 typedef enum {
     TASK_ID_UI,
     TASK_ID_RF_SERVICE,
@@ -33,6 +45,7 @@ typedef enum {
     TASK_ID_NETWORK,
     TASK_ID_APP_MANAGER,
     TASK_ID_INPUT_HANDLER,
+    TASK_ID_LOGGER,
     TASK_ID_MAX
 } task_id_t;
 
@@ -41,10 +54,30 @@ typedef struct {
     TaskFunction_t function;
     uint32_t stack_size;
     UBaseType_t priority;
+    BaseType_t core;            // Core to pin to, or tskNO_AFFINITY
     TaskHandle_t handle;
-    bool is_running;
+    atomic_bool is_running;     // Cleared by the task itself when it stops on request
+    atomic_bool stop_requested; // The task exits at the top of its next loop
+    uint32_t stack_min_free;    // Lowest free stack seen, bytes
+    uint32_t stack_recommended;
+    task_load_t load;
+    uint32_t period_ms;         // Heartbeat period, 0 if not supervised
+    uint32_t deadline_ms;       // No heartbeat for this long is a miss
+    task_watchdog_recover_t recover;    // Watchdog recovery, NULL to only report
+    int watchdog_id;
 } task_info_t;
 
+typedef struct {
+    const char *name;
+    UBaseType_t priority;
+    BaseType_t core;
+    uint32_t stack_size;
+    uint32_t stack_min_free;
+    uint32_t stack_recommended;     // From the high-water mark, 0 before the first sample
+    uint16_t load;                  // Permille of one core over the last window
+    uint16_t avg_load;
+} task_report_t;
+
 /**
  * @brief Initialize and start all system tasks
  * @return ESP_OK on success
@@ -78,6 +111,74 @@ bool task_manager_is_running(task_id_t task_id);
  */
 esp_err_t task_manager_get_stats(TaskStatus_t *stats);
 
+/**
+ * @brief Change a task's priority at runtime
+ * @param task_id Task ID
+ * @param priority New priority
+ * @return ESP_OK on success
+ */
+esp_err_t task_manager_set_priority(task_id_t task_id, UBaseType_t priority);
+
+/**
+ * @brief Change the core a task is pinned to (takes effect when it is created)
+ * @param task_id Task ID
+ * @param core Core number or tskNO_AFFINITY
+ * @return ESP_ERR_INVALID_STATE if the task is already running
+ */
+esp_err_t task_manager_set_core(task_id_t task_id, BaseType_t core);
+
+/**
+ * @brief Sample run-time counters and stack high-water marks
+ *
+ * Call periodically; loads cover the time since the previous call.
+ * @return ESP_OK on success
+ */
+esp_err_t task_manager_sample(void);
+
+/**
+ * @brief Get the monitoring report of one task
+ * @param task_id Task ID
+ * @param report Report to fill
+ * @return ESP_OK on success
+ */
+esp_err_t task_manager_get_report(task_id_t task_id, task_report_t *report);
+
+/**
+ * @brief Get the load of a core over the last sample window
+ * @param core Core number
+ * @return Permille busy, from the core's idle task
+ */
+uint16_t task_manager_get_core_load(BaseType_t core);
+
+/**
+ * @brief Log load, stack use, stack size recommendations and watchdog counters of all tasks
+ */
+void task_manager_log_report(void);
+
+/**
+ * @brief Report progress from a system task's loop to the watchdog
+ * @param task_id Task ID
+ */
+void task_manager_heartbeat(task_id_t task_id);
+
+/**
+ * @brief Check heartbeat deadlines and run recoveries (every TASK_WATCHDOG_CHECK_MS)
+ * @return Number of tasks past their deadline
+ */
+uint32_t task_manager_watchdog_check(void);
+
+/**
+ * @brief Stop a task and create it again with the same parameters
+ *
+ * The task is asked to stop and exits at the top of its loop, where it
+ * holds no lock and has no transfer in flight. It is never deleted from
+ * outside, so one that does not come back within a period is left alone.
+ * Must not be called from the task itself.
+ * @param task_id Task ID
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT if the task did not stop
+ */
+esp_err_t task_manager_restart(task_id_t task_id);
+
 // Task functions (implemented in separate files)
 void ui_task(void *pvParameters);
 void rf_service_task(void *pvParameters);
@@ -85,6 +186,7 @@ void js_engine_task(void *pvParameters);
 void network_task(void *pvParameters);
 void app_manager_task(void *pvParameters);
 void input_handler_task(void *pvParameters);
+void logger_task(void *pvParameters);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,43 @@
+/**
+ * @file task_monitor.c
+ * @brief CPU load and stack sizing arithmetic for the task manager
+ */
+
+#include "task_monitor.h"
+
+uint16_t task_load_permille(uint32_t prev, uint32_t now, uint32_t window)
+{
+    if (window == 0) {
+        return 0;
+    }
+
+    // Unsigned difference is correct across one counter wrap
+    uint64_t ran = (uint32_t)(now - prev);
+    uint64_t permille = (ran * TASK_LOAD_FULL + window / 2) / window;
+    return permille > TASK_LOAD_FULL ? TASK_LOAD_FULL : (uint16_t)permille;
+}
+
+void task_load_update(task_load_t *load, uint32_t counter, uint32_t window)
+{
+    if (!load->primed) {
+        // Nothing to compare against: the counter only says what ran before
+        load->last_counter = counter;
+        load->primed = true;
+        return;
+    }
+
+    load->load = task_load_permille(load->last_counter, counter, window);
+    load->last_counter = counter;
+    if (load->windows++ == 0) {
+        load->avg_load = load->load;
+    } else {
+        load->avg_load = (uint16_t)((load->avg_load * 7 + load->load + 4) / 8);
+    }
+}
+
+uint32_t task_stack_recommend(uint32_t stack_size, uint32_t min_free)
+{
+    uint32_t peak = min_free < stack_size ? stack_size - min_free : 0;
+    uint32_t wanted = peak + peak / 4 + TASK_STACK_MARGIN;
+    return (wanted + TASK_STACK_GRANULE - 1) / TASK_STACK_GRANULE * TASK_STACK_GRANULE;
+}
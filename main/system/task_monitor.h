@@ -0,0 +1,61 @@
+/**
+ * @file task_monitor.h
+ * @brief CPU load and stack sizing arithmetic for the task manager
+ *
+ * Plain integer maths with no FreeRTOS dependency, so the host tests can
+ * feed it simulated run-time counters.
+ */
+
+#ifndef TASK_MONITOR_H
+#define TASK_MONITOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TASK_LOAD_FULL          1000    // Load is in permille of one core
+#define TASK_STACK_MARGIN       512     // Bytes kept free above the observed peak
+#define TASK_STACK_GRANULE      256     // Recommendations are rounded up to this
+#define TASK_STACK_LOW_FREE     256     // Less free than this at peak is a warning
+
+typedef struct {
+    uint32_t last_counter;      // Run-time counter at the previous sample
+    uint16_t load;              // Over the last window, permille
+    uint16_t avg_load;          // Smoothed over about eight windows
+    uint32_t windows;           // Windows measured so far
+    bool primed;                // A previous sample exists
+} task_load_t;
+
+/**
+ * @brief Share of a window a counter advanced by
+ * @param prev Counter at the start of the window
+ * @param now Counter at the end (may have wrapped once)
+ * @param window Total run time elapsed in the window
+ * @return Permille of one core, clamped to TASK_LOAD_FULL
+ */
+uint16_t task_load_permille(uint32_t prev, uint32_t now, uint32_t window);
+
+/**
+ * @brief Account one sample of a task's run-time counter
+ * @param load Load state
+ * @param counter Task run-time counter now
+ * @param window Total run time since the previous sample
+ */
+void task_load_update(task_load_t *load, uint32_t counter, uint32_t window);
+
+/**
+ * @brief Stack size to configure for an observed high-water mark
+ * @param stack_size Configured stack in bytes
+ * @param min_free Lowest free stack seen, in bytes
+ * @return Peak use plus a quarter and TASK_STACK_MARGIN, rounded to TASK_STACK_GRANULE
+ */
+uint32_t task_stack_recommend(uint32_t stack_size, uint32_t min_free);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TASK_MONITOR_H
@@ -0,0 +1,240 @@
+/**
+ * @file task_watchdog.c
+ * @brief Heartbeat deadlines, scheduling latency and recovery for system tasks
+ */
+
+#include "task_watchdog.h"
+#include "metrics.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "TASK_WDT";
+
+typedef struct {
+    task_watchdog_config_t config;
+    atomic_uint last_beat_us;
+    atomic_uint beats;
+    atomic_uint latency_outliers;
+    atomic_uint inversion_suspects;
+    atomic_uint max_latency_us;
+
+    // Supervisor only
+    uint32_t checked_beats;         // Beats seen at the previous check
+    uint32_t missed;
+    uint32_t recoveries;
+    uint32_t attempts;              // Recoveries since the last beat
+    uint32_t since_beat_ms;
+    task_watchdog_state_t state;
+} wdt_entry_t;
+
+static wdt_entry_t s_entries[TASK_WATCHDOG_MAX_TASKS];
+static atomic_int s_count = 0;
+static task_watchdog_escalate_t s_escalate = NULL;
+
+METRIC_COUNTER_DEFINE(s_missed_metric, "wdt.missed", "evt");
+METRIC_COUNTER_DEFINE(s_recoveries_metric, "wdt.recoveries", "evt");
+METRIC_COUNTER_DEFINE(s_outliers_metric, "wdt.latency_outliers", "evt");
+METRIC_COUNTER_DEFINE(s_inversions_metric, "wdt.inversion_suspects", "evt");
+METRIC_HISTOGRAM_DEFINE(s_latency_metric, "wdt.sched_latency_us", "us");
+
+static bool valid_id(int id)
+{
+    return id >= 0 && id < atomic_load_explicit(&s_count, memory_order_acquire);
+}
+
+void task_watchdog_reset(void)
+{
+    atomic_store(&s_count, 0);
+    memset(s_entries, 0, sizeof(s_entries));
+    s_escalate = NULL;
+}
+
+int task_watchdog_register(const task_watchdog_config_t *config, uint32_t now_us)
+{
+    if (!config || !config->name || config->deadline_ms == 0 || config->deadline_ms < config->period_ms) {
+        return -1;
+    }
+
+    int id = atomic_load(&s_count);
+    if (id >= TASK_WATCHDOG_MAX_TASKS) {
+        ESP_LOGE(TAG, "Watchdog table full, %s not supervised", config->name);
+        return -1;
+    }
+
+    wdt_entry_t *entry = &s_entries[id];
+    memset(entry, 0, sizeof(*entry));
+    entry->config = *config;
+    atomic_store(&entry->last_beat_us, now_us);
+    entry->state = TASK_WATCHDOG_OK;
+
+    // Published once filled in; beats and checks only look below the count
+    atomic_store_explicit(&s_count, id + 1, memory_order_release);
+    return id;
+}
+
+static bool may_share_core(const wdt_entry_t *a, const wdt_entry_t *b)
+{
+    return a->config.core == TASK_WATCHDOG_ANY_CORE || b->config.core == TASK_WATCHDOG_ANY_CORE ||
+           a->config.core == b->config.core;
+}
+
+// A lower-priority task on the same core beat while this one was late:
+// the core had time for it, so this task was blocked rather than starved
+static bool lower_priority_ran(const wdt_entry_t *entry, uint32_t since_us, uint32_t now_us)
+{
+    int count = atomic_load_explicit(&s_count, memory_order_acquire);
+    uint32_t window = now_us - since_us;
+
+    for (int i = 0; i < count; i++) {
+        const wdt_entry_t *other = &s_entries[i];
+        if (other == entry || other->config.priority >= entry->config.priority ||
+            !may_share_core(entry, other)) {
+            continue;
+        }
+        uint32_t beat = atomic_load_explicit(&other->last_beat_us, memory_order_relaxed);
+        uint32_t offset = beat - since_us;
+        if (offset > 0 && offset <= window) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void task_watchdog_beat(int id, uint32_t now_us)
+{
+    if (!valid_id(id)) {
+        return;
+    }
+
+    wdt_entry_t *entry = &s_entries[id];
+    uint32_t last = atomic_exchange_explicit(&entry->last_beat_us, now_us, memory_order_relaxed);
+    atomic_fetch_add_explicit(&entry->beats, 1, memory_order_release);
+
+    uint32_t gap = now_us - last;
+    uint32_t period = entry->config.period_ms * 1000;
+    if (gap <= period) {
+        return;
+    }
+
+    // Woken later than asked: what the scheduler (or the task's own work) added
+    uint32_t late = gap - period;
+    metric_record(&s_latency_metric, late);
+    if (late > atomic_load_explicit(&entry->max_latency_us, memory_order_relaxed)) {
+        atomic_store_explicit(&entry->max_latency_us, late, memory_order_relaxed);
+    }
+    if (late < TASK_WATCHDOG_OUTLIER_US) {
+        return;
+    }
+
+    atomic_fetch_add_explicit(&entry->latency_outliers, 1, memory_order_relaxed);
+    metric_inc(&s_outliers_metric);
+    if (lower_priority_ran(entry, last, now_us)) {
+        atomic_fetch_add_explicit(&entry->inversion_suspects, 1, memory_order_relaxed);
+        metric_inc(&s_inversions_metric);
+    }
+}
+
+static void handle_miss(int id, wdt_entry_t *entry, uint32_t last, uint32_t now_us)
+{
+    entry->missed++;
+    metric_inc(&s_missed_metric);
+
+    bool blocked = lower_priority_ran(entry, last, now_us);
+    if (blocked) {
+        atomic_fetch_add_explicit(&entry->inversion_suspects, 1, memory_order_relaxed);
+        metric_inc(&s_inversions_metric);
+    }
+    ESP_LOGW(TAG, "%s missed its %u ms deadline (%u ms since last beat, %s)",
+             entry->config.name, (unsigned)entry->config.deadline_ms, (unsigned)entry->since_beat_ms,
+             blocked ? "blocked while lower priority tasks ran" : "hung or starved");
+
+    if (!entry->config.recover) {
+        entry->state = TASK_WATCHDOG_MISSED;
+    } else if (entry->attempts < TASK_WATCHDOG_MAX_RECOVERIES) {
+        entry->state = TASK_WATCHDOG_MISSED;
+        entry->attempts++;
+        entry->recoveries++;
+        metric_inc(&s_recoveries_metric);
+
+        esp_err_t ret = entry->config.recover(id, entry->config.ctx);
+        ESP_LOGW(TAG, "Recovery %u/%u of %s: %s", (unsigned)entry->attempts,
+                 (unsigned)TASK_WATCHDOG_MAX_RECOVERIES, entry->config.name, esp_err_to_name(ret));
+    } else if (entry->state != TASK_WATCHDOG_ESCALATED) {
+        entry->state = TASK_WATCHDOG_ESCALATED;
+        ESP_LOGE(TAG, "%s did not recover after %u attempts", entry->config.name,
+                 (unsigned)entry->attempts);
+        if (s_escalate) {
+            s_escalate(id, entry->config.name);
+        }
+    }
+
+    // A full deadline of grace before the next miss; a beat in between wins
+    atomic_compare_exchange_strong(&entry->last_beat_us, &last, now_us);
+}
+
+uint32_t task_watchdog_check(uint32_t now_us)
+{
+    int count = atomic_load_explicit(&s_count, memory_order_acquire);
+    uint32_t late = 0;
+
+    for (int id = 0; id < count; id++) {
+        wdt_entry_t *entry = &s_entries[id];
+        uint32_t beats = atomic_load_explicit(&entry->beats, memory_order_acquire);
+        uint32_t last = atomic_load_explicit(&entry->last_beat_us, memory_order_relaxed);
+
+        entry->since_beat_ms = (now_us - last) / 1000;
+        if (beats != entry->checked_beats) {
+            // Progress since the previous check clears any miss
+            entry->checked_beats = beats;
+            entry->attempts = 0;
+            entry->state = TASK_WATCHDOG_OK;
+        }
+
+        if (entry->since_beat_ms < entry->config.deadline_ms) {
+            continue;
+        }
+        late++;
+        handle_miss(id, entry, last, now_us);
+    }
+    return late;
+}
+
+void task_watchdog_set_escalation(task_watchdog_escalate_t escalate)
+{
+    s_escalate = escalate;
+}
+
+esp_err_t task_watchdog_get_stats(int id, task_watchdog_stats_t *stats)
+{
+    if (!valid_id(id) || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const wdt_entry_t *entry = &s_entries[id];
+    stats->name = entry->config.name;
+    stats->state = entry->state;
+    stats->beats = atomic_load(&entry->beats);
+    stats->missed = entry->missed;
+    stats->recoveries = entry->recoveries;
+    stats->latency_outliers = atomic_load(&entry->latency_outliers);
+    stats->inversion_suspects = atomic_load(&entry->inversion_suspects);
+    stats->max_latency_us = atomic_load(&entry->max_latency_us);
+    stats->since_beat_ms = entry->since_beat_ms;
+    return ESP_OK;
+}
+
+void task_watchdog_log_report(void)
+{
+    static const char *const states[] = { "ok", "missed", "escalated" };
+    int count = atomic_load(&s_count);
+
+    for (int id = 0; id < count; id++) {
+        task_watchdog_stats_t s;
+        task_watchdog_get_stats(id, &s);
+        ESP_LOGI(TAG, "  %-18s %-9s missed %u, recovered %u, late beats %u (max %u us), "
+                 "inversion suspects %u",
+                 s.name, states[s.state], (unsigned)s.missed, (unsigned)s.recoveries,
+                 (unsigned)s.latency_outliers, (unsigned)s.max_latency_us,
+                 (unsigned)s.inversion_suspects);
+    }
+}
@@ -0,0 +1,129 @@
+/**
+ * @file task_watchdog.h
+ * @brief Heartbeat deadlines, scheduling latency and recovery for system tasks
+ *
+ * Each supervised task beats once per loop with task_watchdog_beat(). A
+ * supervisor calls task_watchdog_check() periodically; a task that has not
+ * beaten within its deadline is reported missed and its recovery policy
+ * runs. Beats that arrive later than the task's period are scheduler
+ * latency, recorded into a histogram. A late task on a core where a
+ * lower-priority task kept beating was not short of CPU, so it was blocked,
+ * most likely on a resource the lower-priority task holds; that is counted
+ * as a priority-inversion suspect.
+ *
+ * Times are passed in, with no FreeRTOS dependency, so the host tests can
+ * drive a simulated schedule.
+ */
+
+#ifndef TASK_WATCHDOG_H
+#define TASK_WATCHDOG_H
+
+#include "esp_err.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TASK_WATCHDOG_MAX_TASKS         12
+#define TASK_WATCHDOG_CHECK_MS          100     // Supervisor period
+#define TASK_WATCHDOG_OUTLIER_US        20000   // Beat later than the period by this is an outlier
+#define TASK_WATCHDOG_MAX_RECOVERIES    3       // Recoveries without a beat before escalating
+#define TASK_WATCHDOG_ANY_CORE          -1
+
+typedef enum {
+    TASK_WATCHDOG_OK,
+    TASK_WATCHDOG_MISSED,           // Past its deadline, recovery ran or is not possible
+    TASK_WATCHDOG_ESCALATED         // Recoveries did not bring it back
+} task_watchdog_state_t;
+
+/**
+ * @brief Recovery policy of a task that missed its deadline
+ * @param id Watchdog ID of the task
+ * @param ctx Context from the config
+ * @return ESP_OK if the task was restarted
+ */
+typedef esp_err_t (*task_watchdog_recover_t)(int id, void *ctx);
+
+/**
+ * @brief Called when recoveries did not help (typically restarts the system)
+ * @param id Watchdog ID of the task
+ * @param name Task name
+ */
+typedef void (*task_watchdog_escalate_t)(int id, const char *name);
+
+typedef struct {
+    const char *name;
+    uint32_t period_ms;             // Expected time between beats
+    uint32_t deadline_ms;           // No beat for this long is a miss
+    uint8_t priority;               // For the priority-inversion check
+    int8_t core;                    // Pinned core or TASK_WATCHDOG_ANY_CORE
+    task_watchdog_recover_t recover;    // NULL: only report
+    void *ctx;
+} task_watchdog_config_t;
+
+typedef struct {
+    const char *name;
+    task_watchdog_state_t state;
+    uint32_t beats;
+    uint32_t missed;                // Deadlines missed
+    uint32_t recoveries;            // Recovery policy runs
+    uint32_t latency_outliers;
+    uint32_t inversion_suspects;
+    uint32_t max_latency_us;        // Worst beat lateness beyond the period
+    uint32_t since_beat_ms;         // At the last check
+} task_watchdog_stats_t;
+
+/**
+ * @brief Forget all tasks and counters
+ */
+void task_watchdog_reset(void);
+
+/**
+ * @brief Supervise a task
+ * @param config Task config (copied)
+ * @param now_us Current time; the task counts as having just beaten
+ * @return Watchdog ID (>= 0), or -1 if the table is full or the config is invalid
+ */
+int task_watchdog_register(const task_watchdog_config_t *config, uint32_t now_us);
+
+/**
+ * @brief Report progress from the supervised task's loop
+ * @param id Watchdog ID
+ * @param now_us Current time
+ */
+void task_watchdog_beat(int id, uint32_t now_us);
+
+/**
+ * @brief Check deadlines and run recoveries (supervisor)
+ * @param now_us Current time
+ * @return Number of tasks found past their deadline
+ */
+uint32_t task_watchdog_check(uint32_t now_us);
+
+/**
+ * @brief Set the escalation handler
+ * @param escalate Handler, NULL to only log
+ */
+void task_watchdog_set_escalation(task_watchdog_escalate_t escalate);
+
+/**
+ * @brief Get the counters of a task
+ * @param id Watchdog ID
+ * @param stats Stats to fill
+ * @return ESP_OK, ESP_ERR_INVALID_ARG for an unknown ID
+ */
+esp_err_t task_watchdog_get_stats(int id, task_watchdog_stats_t *stats);
+
+/**
+ * @brief Log the state of every supervised task
+ */
+void task_watchdog_log_report(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TASK_WATCHDOG_H
@@ -120,6 +120,40 @@ program
     }
   });
 
+// Pack app command
+program
+  .command('pack')
+  .description('Pack a T-Embed app into an installable .tapk package')
+  .argument('<app-path>', 'app directory (source or build output)')
+  .option('-o, --output <file>', 'output package')
+  .option('-w, --window-bits <bits>', 'deflate window, 9 to 15', (v) => parseInt(v, 10))
+  .option('-s, --store', 'do not compress')
+  .action((appPath, options) => {
+    const { packToFile } = require('./tools/pack-app.js');
+    try {
+      packToFile(appPath, options);
+    } catch (error) {
+      console.error(chalk.red('Error:'), error.message);
+      process.exit(1);
+    }
+  });
+
+// Decode trace command
+program
+  .command('trace')
+  .description('Convert a device trace dump to Chrome trace JSON')
+  .argument('<dump>', 'trace dump copied from the device')
+  .option('-o, --output <file>', 'output JSON file')
+  .action((dump, options) => {
+    const { decode } = require('./tools/trace-decode.js');
+    try {
+      decode(dump, options);
+    } catch (error) {
+      console.error(chalk.red('Error:'), error.message);
+      process.exit(1);
+    }
+  });
+
 // List devices command
 program
   .command('devices')
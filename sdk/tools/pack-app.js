@@ -0,0 +1,181 @@
+#!/usr/bin/env node
+
+/**
+ * @file pack-app.js
+ * @brief Pack an app directory into a .tapk package for the device installer
+ *
+ * Layout (little-endian), read by components/app_manager/app_package.c:
+ *   header      magic "TAPK", version u16, window bits u8, reserved u8,
+ *               manifest size u32, file count u32, CRC-32 of manifest + table
+ *   manifest    manifest.json as the device reads it
+ *   file table  per file: path[48] NUL padded, size u32, stored size u32,
+ *               CRC-32 u32, method u8 (0 stored, 1 raw deflate), 3 reserved
+ *   contents    each file's stored bytes, in table order
+ *
+ * Files are deflated with a small window (4 KB by default) because the
+ * device keeps one window in RAM while installing; a file is stored
+ * instead when deflate does not make it smaller.
+ */
+
+const fs = require('fs');
+const path = require('path');
+const zlib = require('zlib');
+const { program } = require('commander');
+const chalk = require('chalk');
+
+const PACKAGE_MAGIC = 0x4B504154;
+const PACKAGE_VERSION = 1;
+const HEADER_SIZE = 20;
+const FILE_ENTRY_SIZE = 64;
+const PATH_MAX = 48;
+const MAX_FILES = 64;
+const MAX_MANIFEST = 4096;
+const METHOD_STORED = 0;
+const METHOD_DEFLATE = 1;
+const DEFAULT_WINDOW_BITS = 12;
+
+const SKIPPED = new Set(['manifest.json', '.build-info.json', 'install.sh', 'install.bat', 'PACKAGE.md']);
+
+const CRC_TABLE = (() => {
+  const table = new Uint32Array(256);
+  for (let n = 0; n < 256; n++) {
+    let c = n;
+    for (let k = 0; k < 8; k++) {
+      c = c & 1 ? 0xEDB88320 ^ (c >>> 1) : c >>> 1;
+    }
+    table[n] = c >>> 0;
+  }
+  return table;
+})();
+
+function crc32(buffer, crc = 0) {
+  crc = ~crc >>> 0;
+  for (let i = 0; i < buffer.length; i++) {
+    crc = CRC_TABLE[(crc ^ buffer[i]) & 0xFF] ^ (crc >>> 8);
+  }
+  return ~crc >>> 0;
+}
+
+/**
+ * The device manifest parser reads one "key": value per line, and calls
+ * the entry file entry_point and permissions a comma-separated string
+ */
+function deviceManifest(manifest) {
+  const device = Object.assign({}, manifest);
+  device.entry_point = manifest.entry_point || manifest.main || 'index.js';
+  delete device.main;
+  if (Array.isArray(device.permissions)) {
+    device.permissions = device.permissions.join(',');
+  }
+  return Buffer.from(JSON.stringify(device, null, 2) + '\n');
+}
+
+function listFiles(root, dir = '') {
+  const files = [];
+  for (const entry of fs.readdirSync(path.join(root, dir), { withFileTypes: true })) {
+    const relative = dir ? `${dir}/${entry.name}` : entry.name;
+    if (entry.name.startsWith('.') || (!dir && SKIPPED.has(entry.name))) {
+      continue;
+    }
+    if (entry.isDirectory()) {
+      files.push(...listFiles(root, relative));
+    } else if (entry.isFile()) {
+      files.push(relative);
+    }
+  }
+  return files.sort();
+}
+
+function pack(appPath, options = {}) {
+  const root = path.resolve(appPath);
+  const windowBits = options.windowBits || DEFAULT_WINDOW_BITS;
+  if (windowBits < 9 || windowBits > 15) {
+    throw new Error('Window bits must be 9 to 15');
+  }
+
+  const manifestPath = path.join(root, 'manifest.json');
+  if (!fs.existsSync(manifestPath)) {
+    throw new Error(`Missing manifest.json in ${root}`);
+  }
+  const manifest = deviceManifest(JSON.parse(fs.readFileSync(manifestPath, 'utf8')));
+  if (manifest.length > MAX_MANIFEST) {
+    throw new Error(`manifest.json is over ${MAX_MANIFEST} bytes`);
+  }
+
+  const names = listFiles(root);
+  if (names.length > MAX_FILES) {
+    throw new Error(`${names.length} files, a package holds at most ${MAX_FILES}`);
+  }
+
+  const table = Buffer.alloc(names.length * FILE_ENTRY_SIZE);
+  const contents = [];
+  let anyDeflated = false;
+  let size = 0;
+
+  names.forEach((name, i) => {
+    if (Buffer.byteLength(name) >= PATH_MAX) {
+      throw new Error(`Path too long for a package: ${name}`);
+    }
+    const data = fs.readFileSync(path.join(root, name));
+    const deflated = options.store ? null : zlib.deflateRawSync(data, { level: 9, windowBits });
+    const useDeflate = deflated && deflated.length < data.length;
+    const stored = useDeflate ? deflated : data;
+    anyDeflated = anyDeflated || useDeflate;
+    size += data.length;
+
+    const offset = i * FILE_ENTRY_SIZE;
+    table.write(name, offset, PATH_MAX, 'utf8');
+    table.writeUInt32LE(data.length, offset + 48);
+    table.writeUInt32LE(stored.length, offset + 52);
+    table.writeUInt32LE(crc32(data), offset + 56);
+    table.writeUInt8(useDeflate ? METHOD_DEFLATE : METHOD_STORED, offset + 60);
+    contents.push(stored);
+  });
+
+  const header = Buffer.alloc(HEADER_SIZE);
+  header.writeUInt32LE(PACKAGE_MAGIC, 0);
+  header.writeUInt16LE(PACKAGE_VERSION, 4);
+  header.writeUInt8(anyDeflated ? windowBits : 0, 6);
+  header.writeUInt32LE(manifest.length, 8);
+  header.writeUInt32LE(names.length, 12);
+  header.writeUInt32LE(crc32(table, crc32(manifest)), 16);
+
+  return {
+    buffer: Buffer.concat([header, manifest, table, ...contents]),
+    files: names.length,
+    size
+  };
+}
+
+function packToFile(appPath, options) {
+  const result = pack(appPath, options);
+  const output = options.output || `${path.basename(path.resolve(appPath))}.tapk`;
+  fs.writeFileSync(output, result.buffer);
+
+  console.log(chalk.green('✅ Packed'), `${result.files} file(s), ${result.size} bytes into ` +
+              `${result.buffer.length} bytes`);
+  console.log(`   ${output}`);
+}
+
+program
+  .name('pack-app')
+  .description('Pack a T-Embed app directory into an installable .tapk package')
+  .version('1.0.0')
+  .argument('<app-path>', 'app directory (source or build output)')
+  .option('-o, --output <file>', 'output package')
+  .option('-w, --window-bits <bits>', 'deflate window, 9 to 15', (v) => parseInt(v, 10))
+  .option('-s, --store', 'do not compress')
+  .action((appPath, options) => {
+    try {
+      packToFile(appPath, options);
+    } catch (error) {
+      console.error(chalk.red('Error:'), error.message);
+      process.exit(1);
+    }
+  });
+
+if (require.main === module) {
+  program.parse();
+}
+
+module.exports = { pack, packToFile, crc32 };
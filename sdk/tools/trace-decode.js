@@ -0,0 +1,227 @@
+#!/usr/bin/env node
+
+/**
+ * @file trace-decode.js
+ * @brief Convert a firmware trace dump to Chrome trace JSON
+ *
+ * The dump is what trace_dump()/trace_save() write on the device
+ * (components/trace). Event names, categories, phases and argument names
+ * come from components/trace/include/trace_events.h, so the catalogue has
+ * one source. The output opens in chrome://tracing and ui.perfetto.dev.
+ */
+
+const fs = require('fs');
+const path = require('path');
+const { program } = require('commander');
+const chalk = require('chalk');
+
+const TRACE_MAGIC = 0x31435254;
+const TRACE_FORMAT_VERSION = 1;
+const HEADER_SIZE = 16;
+const TASK_ENTRY_SIZE = 18;
+const TASK_NAME_LEN = 16;
+const TASK_ISR = 0xFFFF;
+
+const DEFAULT_CATALOGUE = path.resolve(__dirname, '../../components/trace/include/trace_events.h');
+
+const PHASES = {
+  BEGIN: 'B',
+  END: 'E',
+  INSTANT: 'i',
+  COUNTER: 'C'
+};
+
+/**
+ * Read the event catalogue; an event's ID is its position in the file
+ */
+function loadCatalogue(file) {
+  const source = fs.readFileSync(file, 'utf8');
+  const pattern = /^\s*TRACE_EVENT\(\s*(\w+)\s*,\s*"([^"]*)"\s*,\s*(\w+)\s*,\s*"([^"]*)"\s*,\s*"([^"]*)"\s*\)/gm;
+  const events = [];
+  let match;
+
+  while ((match = pattern.exec(source)) !== null) {
+    const [, id, category, phase, arg0, arg1] = match;
+    if (!PHASES[phase]) {
+      throw new Error(`Unknown phase ${phase} for ${id}`);
+    }
+    // A BEGIN/END pair draws as one span named without the suffix
+    let name = id.replace(/^TRACE_/, '').toLowerCase();
+    if (phase === 'BEGIN' || phase === 'END') {
+      name = name.replace(/_(begin|end)$/, '');
+    }
+    events.push({
+      name,
+      category,
+      phase: PHASES[phase],
+      args: [arg0, arg1]
+    });
+  }
+
+  if (events.length === 0) {
+    throw new Error(`No TRACE_EVENT entries in ${file}`);
+  }
+  return events;
+}
+
+/**
+ * Parse a dump into tasks and per-core records with 64-bit timestamps
+ */
+function parseDump(buffer) {
+  if (buffer.length < HEADER_SIZE || buffer.readUInt32LE(0) !== TRACE_MAGIC) {
+    throw new Error('Not a trace dump');
+  }
+
+  const version = buffer.readUInt16LE(4);
+  const recordSize = buffer.readUInt16LE(6);
+  const cores = buffer.readUInt32LE(8);
+  const taskCount = buffer.readUInt32LE(12);
+  if (version !== TRACE_FORMAT_VERSION) {
+    throw new Error(`Unsupported dump version ${version}`);
+  }
+  if (recordSize < 16) {
+    throw new Error(`Bad record size ${recordSize}`);
+  }
+
+  let offset = HEADER_SIZE;
+  const tasks = new Map();
+  for (let i = 0; i < taskCount; i++) {
+    const number = buffer.readUInt16LE(offset);
+    const raw = buffer.subarray(offset + 2, offset + 2 + TASK_NAME_LEN);
+    const end = raw.indexOf(0);
+    tasks.set(number, raw.subarray(0, end < 0 ? raw.length : end).toString('latin1'));
+    offset += TASK_ENTRY_SIZE;
+  }
+
+  const records = [];
+  for (let c = 0; c < cores; c++) {
+    if (offset + 8 > buffer.length) {
+      throw new Error('Dump truncated');
+    }
+    const core = buffer.readUInt32LE(offset);
+    const count = buffer.readUInt32LE(offset + 4);
+    offset += 8;
+
+    // Records are in write order; timestamps are the low 32 bits of a
+    // microsecond clock, so unwrap with signed deltas. An ISR can slot in
+    // between a task's reservation and its timestamp, hence signed.
+    let time = null;
+    let last = 0;
+    for (let i = 0; i < count; i++) {
+      if (offset + recordSize > buffer.length) {
+        throw new Error('Dump truncated');
+      }
+      const stamp = buffer.readUInt32LE(offset);
+      time = time === null ? stamp : time + ((stamp - last) | 0);
+      last = stamp;
+
+      records.push({
+        core,
+        time,
+        event: buffer.readUInt16LE(offset + 4),
+        task: buffer.readUInt16LE(offset + 6),
+        arg0: buffer.readInt32LE(offset + 8),
+        arg1: buffer.readInt32LE(offset + 12)
+      });
+      offset += recordSize;
+    }
+  }
+
+  return { cores, tasks, records };
+}
+
+function threadName(tasks, task) {
+  if (task === TASK_ISR) {
+    return 'ISR';
+  }
+  return tasks.get(task) || `task ${task}`;
+}
+
+/**
+ * Build the Chrome trace event list
+ */
+function toChromeTrace(dump, catalogue) {
+  const events = [];
+  const threads = new Set();
+  const base = dump.records.reduce((min, r) => Math.min(min, r.time), Infinity);
+
+  for (let c = 0; c < dump.cores; c++) {
+    events.push({ name: 'process_name', ph: 'M', pid: c, tid: 0, args: { name: `core ${c}` } });
+  }
+
+  const sorted = dump.records.slice().sort((a, b) => a.time - b.time);
+  for (const record of sorted) {
+    const info = catalogue[record.event];
+    const event = {
+      name: info ? info.name : `event_${record.event}`,
+      cat: info ? info.category : 'unknown',
+      ph: info ? info.phase : 'i',
+      ts: record.time - base,
+      pid: record.core,
+      tid: record.task
+    };
+
+    const args = {};
+    const names = info ? info.args : ['arg0', 'arg1'];
+    if (names[0]) {
+      args[names[0]] = record.arg0;
+    }
+    if (names[1]) {
+      args[names[1]] = record.arg1;
+    }
+    event.args = args;
+    if (event.ph === 'i') {
+      event.s = 't';
+    }
+    events.push(event);
+
+    const key = `${record.core}:${record.task}`;
+    if (!threads.has(key)) {
+      threads.add(key);
+      events.push({
+        name: 'thread_name', ph: 'M', pid: record.core, tid: record.task,
+        args: { name: threadName(dump.tasks, record.task) }
+      });
+    }
+  }
+
+  return { traceEvents: events, displayTimeUnit: 'ms' };
+}
+
+function decode(input, options) {
+  const catalogue = loadCatalogue(options.events || DEFAULT_CATALOGUE);
+  const dump = parseDump(fs.readFileSync(input));
+  const trace = toChromeTrace(dump, catalogue);
+  const output = options.output || input.replace(/\.bin$/, '') + '.json';
+
+  fs.writeFileSync(output, JSON.stringify(trace));
+
+  const span = dump.records.length
+    ? (Math.max(...dump.records.map(r => r.time)) - Math.min(...dump.records.map(r => r.time))) / 1000
+    : 0;
+  console.log(chalk.green('✅ Decoded'), `${dump.records.length} records from ${dump.cores} core(s), ` +
+              `${span.toFixed(1)} ms`);
+  console.log(`   ${output}`);
+}
+
+program
+  .name('trace-decode')
+  .description('Convert a T-Embed trace dump to Chrome trace JSON')
+  .version('1.0.0')
+  .argument('<dump>', 'trace dump written by trace_save()')
+  .option('-o, --output <file>', 'output JSON file')
+  .option('-e, --events <file>', 'event catalogue (trace_events.h)')
+  .action((input, options) => {
+    try {
+      decode(input, options);
+    } catch (error) {
+      console.error(chalk.red('Error:'), error.message);
+      process.exit(1);
+    }
+  });
+
+if (require.main === module) {
+  program.parse();
+}
+
+module.exports = { loadCatalogue, parseDump, toChromeTrace, decode };
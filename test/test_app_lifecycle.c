@@ -0,0 +1,353 @@
+/**
+ * @file test_app_lifecycle.c
+ * @brief App lifecycle on a simulated schedule: foreground, quotas, eviction
+ *
+ * Apps are bare contexts whose timer callbacks are natives that spin for a
+ * fixed time, so CPU use is real while the schedule is simulated: every
+ * period advances the clock by APP_SCHEDULER_PERIOD_MS however long the
+ * run took. Time starts close to the 32-bit limit so the runs also cross
+ * a wrap.
+ */
+
+#include "app_manager.h"
+#include "mjs.h"
+#include "esp_timer.h"
+#include "unity.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TIME_START      (UINT32_MAX - 500u)
+#define SIM_PERIODS     100
+#define FRAME_WORK_US   300
+#define LOG_WORK_US     1500
+#define SENSOR_WORK_US  200
+
+typedef struct {
+    char id[32];
+    js_context_t *ctx;
+} sim_app_t;
+
+static sim_app_t s_apps[MAX_RUNNING_APPS];
+static uint32_t s_now_ms;
+static int64_t s_period_start_us;
+static uint32_t s_frames;
+static uint32_t s_frame_delay_max_us;
+static uint32_t s_log_writes;
+static uint32_t s_sensor_polls;
+static char s_evicted[32];
+
+static void spin_us(uint32_t us)
+{
+    int64_t end = esp_timer_get_time() + us;
+    while (esp_timer_get_time() < end) {
+    }
+}
+
+static mjs_val_t native_frame(struct mjs *mjs)
+{
+    uint32_t delay_us = (uint32_t)(esp_timer_get_time() - s_period_start_us);
+    if (delay_us > s_frame_delay_max_us) {
+        s_frame_delay_max_us = delay_us;
+    }
+    s_frames++;
+    spin_us(FRAME_WORK_US);
+    return MJS_UNDEFINED;
+}
+
+static mjs_val_t native_log(struct mjs *mjs)
+{
+    s_log_writes++;
+    spin_us(LOG_WORK_US);
+    return MJS_UNDEFINED;
+}
+
+static mjs_val_t native_sensor(struct mjs *mjs)
+{
+    s_sensor_polls++;
+    spin_us(SENSOR_WORK_US);
+    return MJS_UNDEFINED;
+}
+
+static js_context_t *start_app(const char *id)
+{
+    js_context_t *ctx = calloc(1, sizeof(js_context_t));
+    TEST_ASSERT_NOT_NULL(ctx);
+    ctx->mjs = mjs_create();
+    ctx->memory_limit = 65536;
+    mjs_set_ffi_func(ctx->mjs, "frame", native_frame);
+    mjs_set_ffi_func(ctx->mjs, "logWrite", native_log);
+    mjs_set_ffi_func(ctx->mjs, "sensorPoll", native_sensor);
+
+    for (int i = 0; i < MAX_RUNNING_APPS; i++) {
+        if (!s_apps[i].ctx) {
+            snprintf(s_apps[i].id, sizeof(s_apps[i].id), "%s", id);
+            s_apps[i].ctx = ctx;
+            break;
+        }
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, app_lifecycle_add(id, ctx, s_now_ms));
+    return ctx;
+}
+
+static void stop_app(const char *id)
+{
+    for (int i = 0; i < MAX_RUNNING_APPS; i++) {
+        if (s_apps[i].ctx && strcmp(s_apps[i].id, id) == 0) {
+            TEST_ASSERT_EQUAL(ESP_OK, app_lifecycle_remove(id));
+            mjs_destroy(s_apps[i].ctx->mjs);
+            free(s_apps[i].ctx);
+            memset(&s_apps[i], 0, sizeof(s_apps[i]));
+            return;
+        }
+    }
+}
+
+static void evict(const char *app_id, void *ctx)
+{
+    snprintf(s_evicted, sizeof(s_evicted), "%s", app_id);
+    stop_app(app_id);
+}
+
+static void reset(void)
+{
+    for (int i = 0; i < MAX_RUNNING_APPS; i++) {
+        if (s_apps[i].ctx) {
+            stop_app(s_apps[i].id);
+        }
+    }
+    TEST_ASSERT_EQUAL(0, app_lifecycle_count());
+    s_now_ms = TIME_START;
+    s_frames = s_log_writes = s_sensor_polls = 0;
+    s_frame_delay_max_us = 0;
+    s_evicted[0] = '\0';
+}
+
+// Runs periods back to back; returns the longest run in microseconds
+static uint32_t simulate(int periods, uint32_t free_heap)
+{
+    uint32_t longest_us = 0;
+    for (int i = 0; i < periods; i++) {
+        s_period_start_us = esp_timer_get_time();
+        app_lifecycle_run(s_now_ms, free_heap, evict, NULL);
+        uint32_t run_us = (uint32_t)(esp_timer_get_time() - s_period_start_us);
+        if (run_us > longest_us) {
+            longest_us = run_us;
+        }
+        s_now_ms += APP_SCHEDULER_PERIOD_MS;
+    }
+    return longest_us;
+}
+
+static app_state_t state_of(const char *id)
+{
+    app_info_t info = {0};
+    TEST_ASSERT_TRUE(app_lifecycle_get(id, &info));
+    return info.state;
+}
+
+void test_timers_run_within_budget(void)
+{
+    reset();
+    js_context_t *ctx = start_app("timers");
+
+    uint32_t once = mjs_engine_set_timer(ctx, "sensorPoll", s_now_ms, 12, 0);
+    uint32_t every = mjs_engine_set_timer(ctx, "logWrite", s_now_ms, 5, 5);
+    TEST_ASSERT_NOT_EQUAL(0, once);
+    TEST_ASSERT_NOT_EQUAL(0, every);
+
+    // Nothing due yet
+    TEST_ASSERT_EQUAL(0, mjs_engine_run_timers(ctx, s_now_ms + 4, 0));
+
+    // Due at +20: the interval four times (5, 10, 15, 20) and the one-shot
+    // at 12; a budget of 2 leaves the rest pending, earliest first
+    TEST_ASSERT_EQUAL(2, mjs_engine_run_timers(ctx, s_now_ms + 20, 2));
+    TEST_ASSERT_EQUAL(2, s_log_writes);
+    TEST_ASSERT_EQUAL(0, s_sensor_polls);
+    TEST_ASSERT_EQUAL(3, mjs_engine_run_timers(ctx, s_now_ms + 20, 0));
+    TEST_ASSERT_EQUAL(4, s_log_writes);
+    TEST_ASSERT_EQUAL(1, s_sensor_polls);
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, mjs_engine_clear_timer(ctx, once));
+
+    // An interval far behind drops its backlog instead of replaying it
+    TEST_ASSERT_EQUAL(1, mjs_engine_run_timers(ctx, s_now_ms + 20 + JS_TIMER_MAX_LAG_MS * 3, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, mjs_engine_clear_timer(ctx, every));
+    TEST_ASSERT_EQUAL(0, mjs_engine_run_timers(ctx, s_now_ms + 100000, 0));
+
+    for (int i = 0; i < JS_MAX_TIMERS; i++) {
+        TEST_ASSERT_NOT_EQUAL(0, mjs_engine_set_timer(ctx, "logWrite", s_now_ms, 1000, 0));
+    }
+    TEST_ASSERT_EQUAL(0, mjs_engine_set_timer(ctx, "logWrite", s_now_ms, 1000, 0));
+
+    // The interpreter refuses work past its budget
+    mjs_set_budget(ctx->mjs, 1);
+    TEST_ASSERT_FALSE(mjs_is_error(mjs_call_ffi(ctx->mjs, "sensorPoll")));
+    TEST_ASSERT_TRUE(mjs_is_error(mjs_call_ffi(ctx->mjs, "sensorPoll")));
+    TEST_ASSERT_EQUAL(2, s_sensor_polls);
+    mjs_set_budget(ctx->mjs, 0);
+    reset();
+}
+
+void test_foreground_and_background(void)
+{
+    reset();
+    start_app("logger");
+    s_now_ms += 1000;
+    start_app("scanner");
+    s_now_ms += 1000;
+    start_app("menu");
+
+    TEST_ASSERT_EQUAL_STRING("menu", app_lifecycle_get_foreground());
+    TEST_ASSERT_EQUAL(APP_STATE_RUNNING, state_of("menu"));
+    TEST_ASSERT_EQUAL(APP_STATE_BACKGROUND, state_of("logger"));
+    TEST_ASSERT_EQUAL(APP_STATE_BACKGROUND, state_of("scanner"));
+    TEST_ASSERT_EQUAL_STRING("logger", app_lifecycle_get_lru());
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, app_lifecycle_add("menu", s_apps[0].ctx, s_now_ms));
+
+    // Bringing the logger forward makes the scanner the oldest
+    s_now_ms += 1000;
+    TEST_ASSERT_EQUAL(ESP_OK, app_lifecycle_set_foreground("logger", s_now_ms));
+    TEST_ASSERT_EQUAL(APP_STATE_BACKGROUND, state_of("menu"));
+    TEST_ASSERT_EQUAL_STRING("scanner", app_lifecycle_get_lru());
+
+    // The foreground app cannot be paused; a paused app gets no CPU
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, app_lifecycle_pause("logger"));
+    TEST_ASSERT_EQUAL(ESP_OK, app_lifecycle_pause("scanner"));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, app_lifecycle_pause("nope"));
+    js_context_t *scanner = s_apps[1].ctx;
+    mjs_engine_set_timer(scanner, "sensorPoll", s_now_ms, 0, APP_SCHEDULER_PERIOD_MS);
+    simulate(5, UINT32_MAX);
+    TEST_ASSERT_EQUAL(0, s_sensor_polls);
+    TEST_ASSERT_EQUAL(ESP_OK, app_lifecycle_resume("scanner"));
+    TEST_ASSERT_EQUAL(APP_STATE_BACKGROUND, state_of("scanner"));
+    simulate(5, UINT32_MAX);
+    TEST_ASSERT_TRUE(s_sensor_polls >= 4);
+
+    // A paused app can be brought straight to the foreground
+    TEST_ASSERT_EQUAL(ESP_OK, app_lifecycle_pause("menu"));
+    TEST_ASSERT_EQUAL(ESP_OK, app_lifecycle_set_foreground("menu", s_now_ms));
+    TEST_ASSERT_EQUAL(APP_STATE_RUNNING, state_of("menu"));
+
+    stop_app("menu");
+    TEST_ASSERT_NULL(app_lifecycle_get_foreground());
+    TEST_ASSERT_EQUAL(2, app_lifecycle_count());
+    reset();
+}
+
+void test_background_quota_keeps_foreground_on_time(void)
+{
+    // Reference: the greedy logger alone in the foreground runs unbounded
+    reset();
+    js_context_t *logger = start_app("logger");
+    mjs_engine_set_timer(logger, "logWrite", s_now_ms, 1, 1);
+    uint32_t unbounded_us = simulate(3, UINT32_MAX);
+    printf("Logger in the foreground: longest period %u us\n", (unsigned)unbounded_us);
+    TEST_ASSERT_TRUE(unbounded_us > APP_SCHEDULER_PERIOD_MS * 1000);
+
+    // The same logger in the background, behind a UI app drawing each period
+    js_context_t *ui = start_app("ui");
+    mjs_engine_set_timer(ui, "frame", s_now_ms, 0, APP_SCHEDULER_PERIOD_MS);
+    js_context_t *sensor = start_app("sensor");
+    mjs_engine_set_timer(sensor, "sensorPoll", s_now_ms, 0, 100);
+    TEST_ASSERT_EQUAL(ESP_OK, app_lifecycle_set_foreground("ui", s_now_ms));
+
+    app_info_t before;
+    TEST_ASSERT_TRUE(app_lifecycle_get("logger", &before));
+    s_frames = s_log_writes = s_sensor_polls = 0;
+    uint32_t longest_us = simulate(SIM_PERIODS, UINT32_MAX);
+
+    app_info_t after;
+    TEST_ASSERT_TRUE(app_lifecycle_get("logger", &after));
+    uint32_t logger_ms = after.cpu_time - before.cpu_time;
+    uint32_t quota_ms = SIM_PERIODS * APP_BACKGROUND_QUOTA_US / 1000;
+    printf("Logger in the background: %u writes, %u ms CPU (quota %u ms), "
+           "longest period %u us, frame delay up to %u us\n",
+           (unsigned)s_log_writes, (unsigned)logger_ms, (unsigned)quota_ms,
+           (unsigned)longest_us, (unsigned)s_frame_delay_max_us);
+
+    // Every frame on time, and no period overruns into the next one
+    TEST_ASSERT_EQUAL(SIM_PERIODS, s_frames);
+    TEST_ASSERT_TRUE(longest_us < APP_SCHEDULER_PERIOD_MS * 1000 / 2);
+    TEST_ASSERT_TRUE(s_frame_delay_max_us < 1000);
+
+    // The logger keeps running, within its quota
+    TEST_ASSERT_TRUE(s_log_writes >= SIM_PERIODS / 2);
+    TEST_ASSERT_TRUE(logger_ms <= quota_ms + LOG_WORK_US / 1000 + 1);
+    TEST_ASSERT_TRUE(s_sensor_polls >= SIM_PERIODS * APP_SCHEDULER_PERIOD_MS / 100 - 1);
+    reset();
+}
+
+void test_heap_pressure_evicts_lru(void)
+{
+    reset();
+    start_app("a");
+    s_now_ms += 10;
+    start_app("b");
+    s_now_ms += 10;
+    start_app("c");
+    s_now_ms += 10;
+    start_app("d");
+    TEST_ASSERT_EQUAL(MAX_RUNNING_APPS, app_lifecycle_count());
+    TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, app_lifecycle_add("e", s_apps[0].ctx, s_now_ms));
+
+    // "a" was used again most recently among the background apps
+    s_now_ms += 10;
+    app_lifecycle_set_foreground("a", s_now_ms);
+    app_lifecycle_set_foreground("d", s_now_ms);
+
+    simulate(3, APP_HEAP_LOW_WATER);
+    TEST_ASSERT_EQUAL(0, s_evicted[0]);
+
+    // One app per period, oldest first, never the foreground app
+    simulate(1, APP_HEAP_LOW_WATER - 1);
+    TEST_ASSERT_EQUAL_STRING("b", s_evicted);
+    simulate(1, APP_HEAP_LOW_WATER - 1);
+    TEST_ASSERT_EQUAL_STRING("c", s_evicted);
+    simulate(1, APP_HEAP_LOW_WATER - 1);
+    TEST_ASSERT_EQUAL_STRING("a", s_evicted);
+    s_evicted[0] = '\0';
+    simulate(3, 0);
+    TEST_ASSERT_EQUAL(0, s_evicted[0]);
+    TEST_ASSERT_EQUAL(1, app_lifecycle_count());
+    TEST_ASSERT_EQUAL_STRING("d", app_lifecycle_get_foreground());
+    reset();
+}
+
+void test_memory_accounting(void)
+{
+    reset();
+    js_context_t *ctx = start_app("notes");
+
+    app_info_t info;
+    TEST_ASSERT_TRUE(app_lifecycle_get("notes", &info));
+    uint32_t empty = info.memory_usage;
+    TEST_ASSERT_TRUE(empty >= sizeof(js_context_t));
+    TEST_ASSERT_EQUAL(empty, mjs_engine_get_memory_usage(ctx));
+
+    // Globals created by the app are charged to it on its next slice
+    char name[32];
+    for (int i = 0; i < 10; i++) {
+        snprintf(name, sizeof(name), "note_%d", i);
+        mjs_set_global(ctx->mjs, name, MJS_TRUE);
+    }
+    simulate(1, UINT32_MAX);
+    TEST_ASSERT_TRUE(app_lifecycle_get("notes", &info));
+    TEST_ASSERT_EQUAL(empty + 10 * (strlen("note_0") + 1), info.memory_usage);
+
+    // A thrown error holds its message until the next one
+    mjs_call_ffi(ctx->mjs, "missing");
+    TEST_ASSERT_TRUE(mjs_engine_get_memory_usage(ctx) > info.memory_usage);
+    reset();
+}
+
+void app_main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_timers_run_within_budget);
+    RUN_TEST(test_foreground_and_background);
+    RUN_TEST(test_background_quota_keeps_foreground_on_time);
+    RUN_TEST(test_heap_pressure_evicts_lru);
+    RUN_TEST(test_memory_accounting);
+
+    UNITY_END();
+}
@@ -0,0 +1,435 @@
+/**
+ * @file test_app_package.c
+ * @brief Streaming package install: integrity, commit, removal, throughput and peak memory
+ *
+ * Host test. Packages are built here with zlib the way sdk/tools/pack-app.js
+ * builds them, then installed from memory through the same streaming path
+ * the device uses for package files.
+ */
+
+#include "app_manager.h"
+#include "unity.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <zlib.h>
+
+#define TEST_DIR        "/tmp/app_package_test"
+#define TEST_APP        TEST_DIR "/app_1"
+#define BENCH_RUNS      5
+
+typedef struct {
+    const char *path;
+    const uint8_t *data;
+    size_t size;
+} test_file_t;
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+} buffer_t;
+
+typedef struct {
+    const buffer_t *package;
+    size_t pos;
+    size_t chunk;               // Largest read handed out, to vary refills
+} mem_reader_t;
+
+static const char *s_manifest =
+    "{\n  \"name\": \"Packed\",\n  \"version\": \"1.2.0\",\n  \"author\": \"Tester\",\n"
+    "  \"entry_point\": \"index.js\",\n  \"permissions\": \"ui.create\"\n}\n";
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static size_t mem_read(void *buffer, size_t size, void *ctx)
+{
+    mem_reader_t *reader = ctx;
+    size_t left = reader->package->size - reader->pos;
+    if (size > reader->chunk) {
+        size = reader->chunk;
+    }
+    if (size > left) {
+        size = left;
+    }
+    memcpy(buffer, reader->package->data + reader->pos, size);
+    reader->pos += size;
+    return size;
+}
+
+static void append(buffer_t *b, const void *data, size_t len)
+{
+    b->data = realloc(b->data, b->size + len);
+    memcpy(b->data + b->size, data, len);
+    b->size += len;
+}
+
+static size_t deflate_raw(const uint8_t *data, size_t size, int level, int window_bits, uint8_t **out)
+{
+    z_stream z = {0};
+    deflateInit2(&z, level, Z_DEFLATED, -window_bits, 8, Z_DEFAULT_STRATEGY);
+    size_t capacity = deflateBound(&z, size) + 16;   // Bound is short for empty stored input
+    *out = malloc(capacity);
+    z.next_in = (uint8_t *)data;
+    z.avail_in = size;
+    z.next_out = *out;
+    z.avail_out = capacity;
+    deflate(&z, Z_FINISH);
+    size_t len = z.total_out;
+    deflateEnd(&z);
+    return len;
+}
+
+// level < 0 stores the files; otherwise each is deflated at that level
+static buffer_t build_package(const test_file_t *files, int count, int level, int window_bits)
+{
+    buffer_t package = {0};
+    buffer_t contents = {0};
+    app_package_file_t *table = calloc(count ? count : 1, sizeof(app_package_file_t));
+
+    for (int i = 0; i < count; i++) {
+        app_package_file_t *entry = &table[i];
+        strncpy(entry->path, files[i].path, APP_PACKAGE_PATH_MAX);
+        entry->size = files[i].size;
+        entry->crc32 = crc32(0, files[i].data, files[i].size);
+        if (level < 0) {
+            entry->method = APP_PACKAGE_STORED;
+            entry->stored_size = files[i].size;
+            append(&contents, files[i].data, files[i].size);
+        } else {
+            uint8_t *deflated;
+            entry->method = APP_PACKAGE_DEFLATE;
+            entry->stored_size = deflate_raw(files[i].data, files[i].size, level, window_bits, &deflated);
+            append(&contents, deflated, entry->stored_size);
+            free(deflated);
+        }
+    }
+
+    app_package_header_t header = {
+        .magic = APP_PACKAGE_MAGIC,
+        .version = APP_PACKAGE_VERSION,
+        .window_bits = level < 0 ? 0 : window_bits,
+        .manifest_size = strlen(s_manifest),
+        .file_count = count,
+    };
+    header.crc32 = crc32(crc32(0, (const uint8_t *)s_manifest, header.manifest_size),
+                         (const uint8_t *)table, count * sizeof(app_package_file_t));
+
+    append(&package, &header, sizeof(header));
+    append(&package, s_manifest, header.manifest_size);
+    append(&package, table, count * sizeof(app_package_file_t));
+    append(&package, contents.data, contents.size);
+    free(contents.data);
+    free(table);
+    return package;
+}
+
+static esp_err_t install(const buffer_t *package, size_t chunk, app_package_info_t *info)
+{
+    mem_reader_t reader = { .package = package, .chunk = chunk };
+    return app_package_install(mem_read, &reader, TEST_APP, info);
+}
+
+static bool exists(const char *path)
+{
+    struct stat st;
+    return stat(path, &st) == 0;
+}
+
+static bool file_equals(const char *path, const uint8_t *data, size_t size)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+    uint8_t *read_back = malloc(size + 1);
+    size_t len = fread(read_back, 1, size + 1, file);
+    fclose(file);
+    bool equal = len == size && memcmp(read_back, data, size) == 0;
+    free(read_back);
+    return equal;
+}
+
+static void fresh_dir(void)
+{
+    (void)system("rm -rf " TEST_DIR);
+    mkdir(TEST_DIR, 0755);
+}
+
+// Source-like text: compresses the way app code does
+static uint8_t* make_text(size_t size, unsigned seed)
+{
+    static const char *words[] = {
+        "function ", "var ", "return ", "ui.label(", "rf.setFrequency(", "433920000", ");\n",
+        "if (", ") {\n", "}\n", "    ", "value", "count + 1", "// update the readout\n", "state.",
+    };
+    uint8_t *text = malloc(size);
+    srand(seed);
+    for (size_t i = 0; i < size;) {
+        const char *w = words[rand() % (sizeof(words) / sizeof(words[0]))];
+        for (; *w && i < size; w++) {
+            text[i++] = (uint8_t)*w;
+        }
+    }
+    return text;
+}
+
+static uint8_t* make_noise(size_t size, unsigned seed)
+{
+    uint8_t *noise = malloc(size);
+    srand(seed);
+    for (size_t i = 0; i < size; i++) {
+        noise[i] = (uint8_t)rand();
+    }
+    return noise;
+}
+
+void test_install_multi_file_package(void)
+{
+    uint8_t *code = make_text(20000, 1);
+    uint8_t *lib = make_text(7000, 2);
+    uint8_t *icon = make_noise(3000, 3);
+    const test_file_t files[] = {
+        { "index.js", code, 20000 },
+        { "lib/util.js", lib, 7000 },
+        { "assets/icons/app.bin", icon, 3000 },
+        { "empty.txt", code, 0 },
+    };
+
+    // Dynamic, fixed and stored deflate blocks, and plain stored files
+    const int levels[] = { 9, 1, 0, -1 };
+    for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++) {
+        fresh_dir();
+        buffer_t package = build_package(files, 4, levels[l], 12);
+
+        app_package_info_t info;
+        TEST_ASSERT_EQUAL(ESP_OK, install(&package, 7 + l * 300, &info));
+        TEST_ASSERT_EQUAL(4, info.files);
+        TEST_ASSERT_EQUAL(30000, info.installed_bytes);
+        TEST_ASSERT_EQUAL(package.size, info.package_bytes);
+
+        TEST_ASSERT_TRUE(file_equals(TEST_APP "/index.js", code, 20000));
+        TEST_ASSERT_TRUE(file_equals(TEST_APP "/lib/util.js", lib, 7000));
+        TEST_ASSERT_TRUE(file_equals(TEST_APP "/assets/icons/app.bin", icon, 3000));
+        TEST_ASSERT_TRUE(file_equals(TEST_APP "/empty.txt", code, 0));
+        TEST_ASSERT_TRUE(file_equals(TEST_APP "/manifest.json", (const uint8_t *)s_manifest,
+                                     strlen(s_manifest)));
+        TEST_ASSERT_TRUE(exists(TEST_APP "/.installed"));
+        TEST_ASSERT_FALSE(exists(TEST_APP ".tmp"));
+        free(package.data);
+    }
+    free(code);
+    free(lib);
+    free(icon);
+}
+
+void test_full_window_back_references(void)
+{
+    // Repeats as far apart as zlib reaches in the largest window
+    // (32 KB less its 262 byte lookahead)
+    fresh_dir();
+    uint8_t *block = make_noise(32000, 4);
+    uint8_t *data = malloc(3 * 32000);
+    for (int i = 0; i < 3; i++) {
+        memcpy(data + i * 32000, block, 32000);
+    }
+    const test_file_t files[] = { { "index.js", data, 3 * 32000 } };
+    buffer_t package = build_package(files, 1, 9, 15);
+    TEST_ASSERT_TRUE(package.size < 40000);
+
+    app_package_info_t info;
+    TEST_ASSERT_EQUAL(ESP_OK, install(&package, 512, &info));
+    TEST_ASSERT_TRUE(file_equals(TEST_APP "/index.js", data, 3 * 32000));
+    free(package.data);
+    free(data);
+    free(block);
+}
+
+void test_corrupt_package_leaves_nothing(void)
+{
+    uint8_t *code = make_text(50000, 5);
+    const test_file_t files[] = { { "index.js", code, 20000 }, { "b.js", code + 20000, 30000 } };
+
+    // A flipped bit in the second file's contents
+    fresh_dir();
+    buffer_t package = build_package(files, 2, 9, 12);
+    package.data[package.size - 40] ^= 0x10;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_CRC, install(&package, 512, NULL));
+    TEST_ASSERT_FALSE(exists(TEST_APP));
+    TEST_ASSERT_FALSE(exists(TEST_APP ".tmp"));
+    free(package.data);
+
+    // The same in a stored file
+    package = build_package(files, 2, -1, 12);
+    package.data[package.size - 40] ^= 0x10;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_CRC, install(&package, 512, NULL));
+    TEST_ASSERT_FALSE(exists(TEST_APP));
+    free(package.data);
+
+    // A damaged file table is caught before anything is written
+    package = build_package(files, 2, 9, 12);
+    package.data[sizeof(app_package_header_t) + strlen(s_manifest) + 50] ^= 1;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_CRC, install(&package, 512, NULL));
+    TEST_ASSERT_FALSE(exists(TEST_APP ".tmp"));
+
+    // Cut short in the middle of a file
+    package.data[sizeof(app_package_header_t) + strlen(s_manifest) + 50] ^= 1;
+    package.size -= 100;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, install(&package, 512, NULL));
+    TEST_ASSERT_FALSE(exists(TEST_APP));
+    TEST_ASSERT_FALSE(exists(TEST_APP ".tmp"));
+    free(package.data);
+    free(code);
+}
+
+void test_rejects_bad_headers_and_paths(void)
+{
+    uint8_t data[16] = {0};
+    fresh_dir();
+
+    test_file_t files[] = { { "index.js", data, sizeof(data) } };
+    buffer_t package = build_package(files, 1, -1, 12);
+    app_package_header_t *header = (app_package_header_t *)package.data;
+
+    header->magic ^= 1;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_VERSION, install(&package, 512, NULL));
+    header->magic ^= 1;
+    header->version++;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_VERSION, install(&package, 512, NULL));
+    free(package.data);
+
+    const char *unsafe[] = {
+        "../escape.js", "/abs.js", "a/../../b.js", "a//b.js", "dir/", "./x.js", "manifest.json", "a\\b.js",
+        ".installed",
+    };
+    for (size_t i = 0; i < sizeof(unsafe) / sizeof(unsafe[0]); i++) {
+        files[0].path = unsafe[i];
+        package = build_package(files, 1, -1, 12);
+        TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, install(&package, 512, NULL));
+        free(package.data);
+    }
+
+    const test_file_t twice[] = { { "a.js", data, 4 }, { "a.js", data, 4 } };
+    package = build_package(twice, 2, -1, 12);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, install(&package, 512, NULL));
+    free(package.data);
+
+    // Names that only look like traversal are fine
+    const test_file_t fine[] = { { "..js", data, 4 }, { "a/.hidden", data, 4 }, { "b/...", data, 4 } };
+    package = build_package(fine, 3, -1, 12);
+    TEST_ASSERT_EQUAL(ESP_OK, install(&package, 512, NULL));
+    free(package.data);
+    TEST_ASSERT_FALSE(exists(TEST_DIR "/escape.js"));
+}
+
+static void write_stale(const char *path)
+{
+    FILE *stale = fopen(path, "w");
+    fputs("old", stale);
+    fclose(stale);
+}
+
+void test_replaces_interrupted_install(void)
+{
+    // Cut short while staging, and while moving files into place
+    fresh_dir();
+    mkdir(TEST_APP ".tmp", 0755);
+    write_stale(TEST_APP ".tmp/stale.js");
+    mkdir(TEST_APP, 0755);
+    write_stale(TEST_APP "/moved.js");
+
+    uint8_t data[100] = {1};
+    const test_file_t files[] = { { "index.js", data, sizeof(data) } };
+    buffer_t package = build_package(files, 1, 6, 12);
+    TEST_ASSERT_EQUAL(ESP_OK, install(&package, 512, NULL));
+    TEST_ASSERT_FALSE(exists(TEST_APP "/stale.js"));
+    TEST_ASSERT_FALSE(exists(TEST_APP "/moved.js"));
+    TEST_ASSERT_TRUE(file_equals(TEST_APP "/index.js", data, sizeof(data)));
+
+    // An existing app is never overwritten
+    TEST_ASSERT_EQUAL(ESP_FAIL, install(&package, 512, NULL));
+    TEST_ASSERT_TRUE(file_equals(TEST_APP "/index.js", data, sizeof(data)));
+    TEST_ASSERT_FALSE(exists(TEST_APP ".tmp"));
+    free(package.data);
+}
+
+void test_remove_deletes_every_file(void)
+{
+    fresh_dir();
+    uint8_t data[100] = {2};
+    const test_file_t files[] = { { "index.js", data, sizeof(data) }, { "lib/a/b.js", data, 10 } };
+    buffer_t package = build_package(files, 2, 6, 12);
+    TEST_ASSERT_EQUAL(ESP_OK, install(&package, 512, NULL));
+    mkdir(TEST_APP ".tmp", 0755);
+    write_stale(TEST_APP ".tmp/stale.js");
+
+    TEST_ASSERT_EQUAL(ESP_OK, app_package_remove(TEST_APP));
+    TEST_ASSERT_FALSE(exists(TEST_APP));
+    TEST_ASSERT_FALSE(exists(TEST_APP ".tmp"));
+
+    // Nothing there is not an error, and the path can be installed again
+    TEST_ASSERT_EQUAL(ESP_OK, app_package_remove(TEST_APP));
+    TEST_ASSERT_EQUAL(ESP_OK, install(&package, 512, NULL));
+    TEST_ASSERT_TRUE(file_equals(TEST_APP "/lib/a/b.js", data, 10));
+    free(package.data);
+}
+
+static void bench(const char *label, size_t total, int level, int window_bits)
+{
+    enum { FILES = 16 };
+    test_file_t files[FILES];
+    char names[FILES][16];
+    uint8_t *text = make_text(total, 6);
+    for (int i = 0; i < FILES; i++) {
+        snprintf(names[i], sizeof(names[i]), "src/m%02d.js", i);
+        files[i] = (test_file_t){ names[i], text + i * (total / FILES), total / FILES };
+    }
+    buffer_t package = build_package(files, FILES, level, window_bits);
+
+    app_package_info_t info = {0};
+    double elapsed = 0;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        fresh_dir();
+        double t0 = now_us();
+        TEST_ASSERT_EQUAL(ESP_OK, install(&package, 4096, &info));
+        elapsed += now_us() - t0;
+    }
+    elapsed /= BENCH_RUNS;
+
+    printf("  %-22s %5u KB -> %5u KB package: %6.1f MB/s installed, peak RAM %u bytes\n", label,
+           (unsigned)(total / 1024), (unsigned)(package.size / 1024), info.installed_bytes / elapsed,
+           (unsigned)info.peak_memory);
+    TEST_ASSERT_TRUE(info.peak_memory < (1u << window_bits) + 8192);
+    free(package.data);
+    free(text);
+}
+
+void test_install_throughput_and_memory(void)
+{
+    printf("Install, 16 files (host file system):\n");
+    bench("stored", 1 << 20, -1, 12);
+    bench("deflate, 4 KB window", 1 << 20, 9, 12);
+    bench("deflate, 4 KB window", 4 << 20, 9, 12);
+    bench("deflate, 32 KB window", 4 << 20, 9, 15);
+    (void)system("rm -rf " TEST_DIR);
+}
+
+void app_main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_install_multi_file_package);
+    RUN_TEST(test_full_window_back_references);
+    RUN_TEST(test_corrupt_package_leaves_nothing);
+    RUN_TEST(test_rejects_bad_headers_and_paths);
+    RUN_TEST(test_replaces_interrupted_install);
+    RUN_TEST(test_remove_deletes_every_file);
+    RUN_TEST(test_install_throughput_and_memory);
+
+    UNITY_END();
+}
@@ -0,0 +1,324 @@
+/**
+ * @file test_app_registry.c
+ * @brief App registry persistence, crash safety and boot enumeration cost
+ *
+ * The benchmark compares loading and listing 500 apps from the registry
+ * with what boot would otherwise do: scan the app directories and read
+ * every manifest.
+ */
+
+#include "app_manager.h"
+#include "unity.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TEST_DIR        "/tmp/app_registry_test"
+#define TEST_REGISTRY   TEST_DIR "/registry.bin"
+#define BENCH_APPS      500
+#define BENCH_RUNS      20
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void make_app(int n, char *id, char *name, char *path, app_registry_entry_t *entry)
+{
+    sprintf(id, "app_%08x", (unsigned)(n * 2654435761u));
+    sprintf(name, "App number %d", n);
+    sprintf(path, "/apps/%s", id);
+    *entry = (app_registry_entry_t){
+        .id = id,
+        .name = name,
+        .version = "1.0.0",
+        .author = "Tester",
+        .entry_point = "index.js",
+        .install_path = path,
+        .permissions = APP_PERM_UI_CREATE | (n & 1 ? APP_PERM_RF_RECEIVE : 0),
+        .code_hash = (uint32_t)n * 40503u,
+        .is_system_app = n == 0,
+    };
+}
+
+static void add_apps(int count)
+{
+    for (int n = 0; n < count; n++) {
+        char id[32], name[32], path[64];
+        app_registry_entry_t entry;
+        make_app(n, id, name, path, &entry);
+        TEST_ASSERT_EQUAL(ESP_OK, app_registry_add(&entry));
+    }
+}
+
+static void fresh_dir(void)
+{
+    (void)system("rm -rf " TEST_DIR);
+    mkdir(TEST_DIR, 0755);
+    app_registry_clear();
+}
+
+void test_add_find_replace_remove(void)
+{
+    fresh_dir();
+    add_apps(100);
+    TEST_ASSERT_EQUAL(100, app_registry_count());
+
+    app_registry_entry_t entry;
+    TEST_ASSERT_TRUE(app_registry_find("app_00000000", &entry));
+    TEST_ASSERT_EQUAL_STRING("App number 0", entry.name);
+    TEST_ASSERT_TRUE(entry.is_system_app);
+    TEST_ASSERT_FALSE(app_registry_find("app_missing", NULL));
+
+    // Same ID replaces, even when the new strings come from the registry itself
+    TEST_ASSERT_TRUE(app_registry_find("app_9e3779b1", &entry));
+    entry.version = entry.name;
+    TEST_ASSERT_EQUAL(ESP_OK, app_registry_add(&entry));
+    TEST_ASSERT_EQUAL(100, app_registry_count());
+    TEST_ASSERT_TRUE(app_registry_find("app_9e3779b1", &entry));
+    TEST_ASSERT_EQUAL_STRING("App number 1", entry.version);
+
+    TEST_ASSERT_EQUAL(ESP_OK, app_registry_set_permissions("app_9e3779b1", APP_PERM_NETWORK));
+    TEST_ASSERT_TRUE(app_registry_find("app_9e3779b1", &entry));
+    TEST_ASSERT_EQUAL(APP_PERM_NETWORK, entry.permissions);
+
+    // Remove every other app: the rest stay reachable through compactions
+    for (int n = 0; n < 100; n += 2) {
+        char id[32], name[32], path[64];
+        make_app(n, id, name, path, &entry);
+        TEST_ASSERT_EQUAL(ESP_OK, app_registry_remove(id));
+    }
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, app_registry_remove("app_00000000"));
+    TEST_ASSERT_EQUAL(50, app_registry_count());
+    for (int n = 1; n < 100; n += 2) {
+        char id[32], name[32], path[64], expected[32];
+        make_app(n, id, name, path, &entry);
+        TEST_ASSERT_TRUE(app_registry_find(id, &entry));
+        TEST_ASSERT_EQUAL_STRING(path, entry.install_path);
+        sprintf(expected, "App number %d", n);
+        TEST_ASSERT_EQUAL_STRING(expected, n == 1 ? entry.version : entry.name);
+    }
+}
+
+void test_field_limits(void)
+{
+    fresh_dir();
+    char long_name[MAX_APP_NAME_LEN + 1];
+    memset(long_name, 'x', MAX_APP_NAME_LEN);
+    long_name[MAX_APP_NAME_LEN] = '\0';
+
+    app_registry_entry_t entry = {
+        .id = "app_1", .name = long_name, .version = "1", .author = "a",
+        .entry_point = "index.js", .install_path = "/apps/app_1",
+    };
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, app_registry_add(&entry));
+
+    long_name[MAX_APP_NAME_LEN - 1] = '\0';
+    TEST_ASSERT_EQUAL(ESP_OK, app_registry_add(&entry));
+
+    entry.id = "";
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, app_registry_add(&entry));
+    entry.id = "app_2";
+    entry.author = NULL;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, app_registry_add(&entry));
+    TEST_ASSERT_EQUAL(1, app_registry_count());
+}
+
+void test_save_load_roundtrip(void)
+{
+    fresh_dir();
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, app_registry_load(TEST_REGISTRY));
+    TEST_ASSERT_EQUAL(0, app_registry_count());
+
+    add_apps(40);
+    TEST_ASSERT_EQUAL(ESP_OK, app_registry_remove("app_00000000"));
+    TEST_ASSERT_EQUAL(ESP_OK, app_registry_save(TEST_REGISTRY));
+
+    app_registry_clear();
+    TEST_ASSERT_EQUAL(ESP_OK, app_registry_load(TEST_REGISTRY));
+    TEST_ASSERT_EQUAL(39, app_registry_count());
+
+    for (int n = 1; n < 40; n++) {
+        char id[32], name[32], path[64];
+        app_registry_entry_t expected, entry;
+        make_app(n, id, name, path, &expected);
+        TEST_ASSERT_TRUE(app_registry_find(id, &entry));
+        TEST_ASSERT_EQUAL_STRING(expected.name, entry.name);
+        TEST_ASSERT_EQUAL_STRING(expected.install_path, entry.install_path);
+        TEST_ASSERT_EQUAL(expected.permissions, entry.permissions);
+        TEST_ASSERT_EQUAL(expected.code_hash, entry.code_hash);
+    }
+
+    // Loaded registries keep growing
+    char id[32], name[32], path[64];
+    app_registry_entry_t entry;
+    make_app(1000, id, name, path, &entry);
+    TEST_ASSERT_EQUAL(ESP_OK, app_registry_add(&entry));
+    TEST_ASSERT_TRUE(app_registry_find(id, NULL));
+    TEST_ASSERT_EQUAL(40, app_registry_count());
+}
+
+void test_interrupted_save(void)
+{
+    fresh_dir();
+    add_apps(10);
+    TEST_ASSERT_EQUAL(ESP_OK, app_registry_save(TEST_REGISTRY));
+
+    // Power lost after the new file was written, before the swap
+    add_apps(20);
+    TEST_ASSERT_EQUAL(ESP_OK, app_registry_save(TEST_REGISTRY ".tmp"));
+    TEST_ASSERT_EQUAL(0, rename(TEST_REGISTRY ".tmp", TEST_REGISTRY ".new"));
+
+    TEST_ASSERT_EQUAL(ESP_OK, app_registry_load(TEST_REGISTRY));
+    TEST_ASSERT_EQUAL(20, app_registry_count());
+
+    struct stat st;
+    TEST_ASSERT_NOT_EQUAL(0, stat(TEST_REGISTRY ".new", &st));
+    TEST_ASSERT_EQUAL(0, stat(TEST_REGISTRY, &st));
+
+    // Power lost while writing the new file: the old one is used
+    FILE *torn = fopen(TEST_REGISTRY ".new", "wb");
+    fwrite("APRG", 1, 4, torn);
+    fclose(torn);
+    TEST_ASSERT_EQUAL(ESP_OK, app_registry_load(TEST_REGISTRY));
+    TEST_ASSERT_EQUAL(20, app_registry_count());
+    TEST_ASSERT_NOT_EQUAL(0, stat(TEST_REGISTRY ".new", &st));
+}
+
+void test_damaged_registry(void)
+{
+    fresh_dir();
+    add_apps(10);
+    TEST_ASSERT_EQUAL(ESP_OK, app_registry_save(TEST_REGISTRY));
+
+    // A flipped byte in the string pool
+    FILE *file = fopen(TEST_REGISTRY, "r+b");
+    fseek(file, -5, SEEK_END);
+    fputc('#', file);
+    fclose(file);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_CRC, app_registry_load(TEST_REGISTRY));
+    TEST_ASSERT_EQUAL(0, app_registry_count());
+
+    // Truncated
+    add_apps(10);
+    TEST_ASSERT_EQUAL(ESP_OK, app_registry_save(TEST_REGISTRY));
+    TEST_ASSERT_EQUAL(0, truncate(TEST_REGISTRY, 200));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_CRC, app_registry_load(TEST_REGISTRY));
+
+    // Written by a different format version
+    add_apps(10);
+    TEST_ASSERT_EQUAL(ESP_OK, app_registry_save(TEST_REGISTRY));
+    file = fopen(TEST_REGISTRY, "r+b");
+    fseek(file, 4, SEEK_SET);
+    fputc(APP_REGISTRY_VERSION + 1, file);
+    fclose(file);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_VERSION, app_registry_load(TEST_REGISTRY));
+}
+
+// What boot costs without a registry: list the app directories, read every manifest
+static int scan_manifests(void)
+{
+    DIR *dir = opendir(TEST_DIR "/apps");
+    struct dirent *d;
+    int found = 0;
+
+    while ((d = readdir(dir)) != NULL) {
+        if (d->d_name[0] == '.') {
+            continue;
+        }
+        char path[300], buffer[1024];
+        snprintf(path, sizeof(path), TEST_DIR "/apps/%s/manifest.json", d->d_name);
+        FILE *file = fopen(path, "r");
+        if (!file) {
+            continue;
+        }
+        size_t len = fread(buffer, 1, sizeof(buffer) - 1, file);
+        fclose(file);
+        buffer[len] = '\0';
+
+        char name[MAX_APP_NAME_LEN];
+        const char *p = strstr(buffer, "\"name\"");
+        if (p && sscanf(p, "\"name\": \"%31[^\"]\"", name) == 1) {
+            found++;
+        }
+    }
+    closedir(dir);
+    return found;
+}
+
+void test_boot_enumeration_500_apps(void)
+{
+    fresh_dir();
+    mkdir(TEST_DIR "/apps", 0755);
+    for (int n = 0; n < BENCH_APPS; n++) {
+        char id[32], name[32], path[64], file_path[300];
+        app_registry_entry_t entry;
+        make_app(n, id, name, path, &entry);
+        TEST_ASSERT_EQUAL(ESP_OK, app_registry_add(&entry));
+
+        snprintf(file_path, sizeof(file_path), TEST_DIR "/apps/%s", id);
+        mkdir(file_path, 0755);
+        strcat(file_path, "/manifest.json");
+        FILE *file = fopen(file_path, "w");
+        fprintf(file, "{\n  \"name\": \"%s\",\n  \"version\": \"1.0.0\",\n  \"author\": \"Tester\",\n"
+                "  \"entry_point\": \"index.js\",\n  \"permissions\": \"ui.create\"\n}\n", name);
+        fclose(file);
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, app_registry_save(TEST_REGISTRY));
+
+    struct stat st;
+    stat(TEST_REGISTRY, &st);
+
+    double load_us = 0, scan_us = 0, lookup_us = 0;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        double t0 = now_us();
+        TEST_ASSERT_EQUAL(ESP_OK, app_registry_load(TEST_REGISTRY));
+        size_t listed = 0;
+        for (size_t i = 0; i < app_registry_count(); i++) {
+            app_registry_entry_t entry;
+            listed += app_registry_get(i, &entry) && entry.name[0];
+        }
+        load_us += now_us() - t0;
+        TEST_ASSERT_EQUAL(BENCH_APPS, listed);
+
+        t0 = now_us();
+        for (int n = 0; n < BENCH_APPS; n++) {
+            char id[32];
+            sprintf(id, "app_%08x", (unsigned)(n * 2654435761u));
+            TEST_ASSERT_TRUE(app_registry_find(id, NULL));
+        }
+        lookup_us += now_us() - t0;
+
+        t0 = now_us();
+        TEST_ASSERT_EQUAL(BENCH_APPS, scan_manifests());
+        scan_us += now_us() - t0;
+    }
+
+    printf("%d apps, registry %u bytes (%u per app)\n", BENCH_APPS, (unsigned)st.st_size,
+           (unsigned)(st.st_size / BENCH_APPS));
+    printf("  registry load + list: %8.1f us\n", load_us / BENCH_RUNS);
+    printf("  manifest scan:        %8.1f us\n", scan_us / BENCH_RUNS);
+    printf("  hashed lookup:        %8.1f ns per app\n", lookup_us * 1000 / BENCH_RUNS / BENCH_APPS);
+
+    TEST_ASSERT_TRUE(load_us < scan_us);
+    (void)system("rm -rf " TEST_DIR);
+}
+
+void app_main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_add_find_replace_remove);
+    RUN_TEST(test_field_limits);
+    RUN_TEST(test_save_load_roundtrip);
+    RUN_TEST(test_interrupted_save);
+    RUN_TEST(test_damaged_registry);
+    RUN_TEST(test_boot_enumeration_500_apps);
+
+    UNITY_END();
+}
@@ -0,0 +1,130 @@
+/**
+ * @file test_display_flush_pipeline.c
+ * @brief Host frame-timing simulation of the ST7789 flush pipeline
+ *
+ * Models LVGL double buffering on top of display_driver.c: a full-screen
+ * redraw is rendered in LCD_DRAW_BUF_PIXELS bands and each band is pushed
+ * over a 40 MHz SPI bus. The synchronous driver blocks rendering until the
+ * transfer ends; the queued driver lets LVGL render the next band while the
+ * previous one streams out.
+ */
+
+#include "unity.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SIM_LCD_WIDTH           170
+#define SIM_LCD_HEIGHT          320
+#define SIM_DRAW_BUF_PIXELS     (SIM_LCD_WIDTH * SIM_LCD_HEIGHT / 10)
+#define SIM_SPI_CLOCK_HZ        40000000ULL
+#define SIM_WINDOW_SETUP_NS     40000ULL    // CASET/RASET/RAMWR before each push
+#define SIM_FRAMES              60
+
+typedef struct {
+    uint64_t render_ns_per_px;
+} sim_profile_t;
+
+static uint64_t sim_transfer_ns(uint32_t pixels)
+{
+    return SIM_WINDOW_SETUP_NS + (uint64_t)pixels * 16 * 1000000000ULL / SIM_SPI_CLOCK_HZ;
+}
+
+/**
+ * @brief Simulate full-screen redraws and return the total elapsed time
+ * @param queued true for the queued (async) flush, false for blocking flush
+ */
+static uint64_t sim_run(const sim_profile_t *profile, bool queued, uint32_t frames)
+{
+    const uint32_t total_px = SIM_LCD_WIDTH * SIM_LCD_HEIGHT;
+    uint64_t cpu_time = 0;      // When the render thread is free
+    uint64_t bus_free = 0;      // When the SPI bus finishes the last push
+    uint64_t buf_free[2] = {0, 0};
+    uint32_t buf = 0;
+
+    for (uint32_t f = 0; f < frames; f++) {
+        for (uint32_t done = 0; done < total_px; done += SIM_DRAW_BUF_PIXELS) {
+            uint32_t px = total_px - done;
+            if (px > SIM_DRAW_BUF_PIXELS) {
+                px = SIM_DRAW_BUF_PIXELS;
+            }
+
+            // Render into the current buffer once its last push completed
+            if (cpu_time < buf_free[buf]) {
+                cpu_time = buf_free[buf];
+            }
+            cpu_time += px * profile->render_ns_per_px;
+
+            // LVGL waits for the previous flush-ready before flushing again
+            uint64_t start = cpu_time > bus_free ? cpu_time : bus_free;
+            uint64_t end = start + sim_transfer_ns(px);
+            bus_free = end;
+            buf_free[buf] = end;
+
+            if (!queued) {
+                // spi_device_transmit() blocks the render thread
+                cpu_time = end;
+            }
+            buf ^= 1;
+        }
+    }
+
+    return cpu_time > bus_free ? cpu_time : bus_free;
+}
+
+static double sim_fps(uint64_t elapsed_ns, uint32_t frames)
+{
+    return (double)frames * 1e9 / (double)elapsed_ns;
+}
+
+static void run_profile(const char *name, uint64_t ns_per_px, double *sync_fps, double *async_fps)
+{
+    sim_profile_t profile = { .render_ns_per_px = ns_per_px };
+
+    *sync_fps = sim_fps(sim_run(&profile, false, SIM_FRAMES), SIM_FRAMES);
+    *async_fps = sim_fps(sim_run(&profile, true, SIM_FRAMES), SIM_FRAMES);
+
+    printf("%-10s render %3llu ns/px: blocking %5.1f FPS, queued %5.1f FPS\n",
+           name, (unsigned long long)ns_per_px, *sync_fps, *async_fps);
+}
+
+void test_queued_flush_overlaps_render(void)
+{
+    double sync_fps, async_fps;
+
+    // Fill-heavy screens are cheap to render, text/gradients much less so
+    run_profile("fills", 50, &sync_fps, &async_fps);
+    TEST_ASSERT_TRUE(async_fps > sync_fps);
+
+    run_profile("widgets", 200, &sync_fps, &async_fps);
+    TEST_ASSERT_TRUE(async_fps > sync_fps * 1.4);
+
+    run_profile("text", 400, &sync_fps, &async_fps);
+    TEST_ASSERT_TRUE(async_fps > sync_fps);
+}
+
+void test_queued_flush_bounded_by_bus(void)
+{
+    // With free rendering the result must converge to the raw bus limit
+    sim_profile_t profile = { .render_ns_per_px = 0 };
+    uint64_t frame_bus_ns = 0;
+    for (uint32_t done = 0; done < SIM_LCD_WIDTH * SIM_LCD_HEIGHT; done += SIM_DRAW_BUF_PIXELS) {
+        frame_bus_ns += sim_transfer_ns(SIM_DRAW_BUF_PIXELS);
+    }
+
+    double fps = sim_fps(sim_run(&profile, true, SIM_FRAMES), SIM_FRAMES);
+    double bus_fps = 1e9 / (double)frame_bus_ns;
+    printf("bus limit %.1f FPS, queued %.1f FPS\n", bus_fps, fps);
+
+    TEST_ASSERT_TRUE(fps <= bus_fps + 0.01);
+    TEST_ASSERT_TRUE(fps > bus_fps * 0.99);
+}
+
+void app_main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_queued_flush_overlaps_render);
+    RUN_TEST(test_queued_flush_bounded_by_bus);
+
+    UNITY_END();
+}
@@ -0,0 +1,194 @@
+/**
+ * @file test_display_spi_batching.c
+ * @brief Mock-SPI transaction-count tests for the ST7789 display driver
+ */
+
+#include "lvgl_port.h"
+#include "unity.h"
+#include "driver/spi_master.h"
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+// Pins referenced by display_driver.c
+const int TEMBED_LCD_MOSI = 35;
+const int TEMBED_LCD_CLK = 36;
+const int TEMBED_LCD_CS = 37;
+const int TEMBED_LCD_DC = 4;
+const int TEMBED_LCD_RST = 5;
+
+extern esp_err_t display_driver_init(lv_disp_t **disp);
+extern void display_driver_deinit(void);
+
+// Mirrors hw_handles_t from main/system/hw_init.h
+typedef struct {
+    spi_device_handle_t lcd_spi;
+    spi_device_handle_t cc1101_spi;
+} hw_handles_t;
+
+static hw_handles_t s_mock_handles = {
+    .lcd_spi = (spi_device_handle_t)0x1,
+};
+
+#define MOCK_MAX_TRANS  32
+
+typedef struct {
+    size_t length;
+    int dc;
+    uint8_t data[4];
+} mock_trans_t;
+
+static mock_trans_t s_log[MOCK_MAX_TRANS];
+static int s_queued = 0;
+static int s_transmitted = 0;
+static int s_reaped = 0;
+static int s_dc_level = -1;
+static int s_dc_writes = 0;
+static spi_transaction_t *s_pending[MOCK_MAX_TRANS];
+static int s_pending_head = 0;
+static int s_pending_tail = 0;
+
+static void mock_reset(void)
+{
+    memset(s_log, 0, sizeof(s_log));
+    s_queued = 0;
+    s_transmitted = 0;
+    s_reaped = 0;
+    s_dc_writes = 0;
+}
+
+// Mock hardware layer
+hw_handles_t* hw_get_handles(void)
+{
+    return &s_mock_handles;
+}
+
+esp_err_t gpio_set_level(int gpio_num, uint32_t level)
+{
+    if (gpio_num == TEMBED_LCD_DC) {
+        s_dc_level = level;
+        s_dc_writes++;
+    }
+    return ESP_OK;
+}
+
+// Mock SPI master: transfers complete instantly, running the device
+// callbacks the same way the driver ISR would
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans, TickType_t ticks)
+{
+    display_driver_spi_pre_cb(trans);
+
+    if (s_queued + s_transmitted < MOCK_MAX_TRANS) {
+        mock_trans_t *log = &s_log[s_queued + s_transmitted];
+        log->length = trans->length;
+        log->dc = s_dc_level;
+        if (trans->flags & SPI_TRANS_USE_TXDATA) {
+            memcpy(log->data, trans->tx_data, 4);
+        }
+    }
+
+    display_driver_spi_post_cb(trans);
+
+    s_pending[s_pending_tail++ % MOCK_MAX_TRANS] = trans;
+    s_queued++;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans, TickType_t ticks)
+{
+    TEST_ASSERT_TRUE(s_pending_head != s_pending_tail);
+    *trans = s_pending[s_pending_head++ % MOCK_MAX_TRANS];
+    s_reaped++;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *trans)
+{
+    spi_transaction_t *done;
+    spi_device_queue_trans(handle, trans, portMAX_DELAY);
+    s_queued--;
+    s_transmitted++;
+    spi_device_get_trans_result(handle, &done, portMAX_DELAY);
+    s_reaped--;
+    return ESP_OK;
+}
+
+static lv_disp_t *s_disp = NULL;
+
+static void flush_area(lv_coord_t x1, lv_coord_t y1, lv_coord_t x2, lv_coord_t y2)
+{
+    static lv_color_t pixels[LCD_DRAW_BUF_PIXELS];
+    lv_area_t area = { .x1 = x1, .y1 = y1, .x2 = x2, .y2 = y2 };
+
+    s_disp->driver->draw_buf->flushing = 1;
+    s_disp->driver->flush_cb(s_disp->driver, &area, pixels);
+}
+
+void test_display_init_sequence(void)
+{
+    lv_init();
+    mock_reset();
+
+    TEST_ASSERT_EQUAL(ESP_OK, display_driver_init(&s_disp));
+    TEST_ASSERT_NOT_NULL(s_disp);
+
+    // 6 commands, COLMOD and MADCTL parameters each in one data transaction
+    TEST_ASSERT_EQUAL(8, s_transmitted);
+    TEST_ASSERT_EQUAL(0, s_queued);
+}
+
+void test_flush_is_one_queued_chain(void)
+{
+    mock_reset();
+    flush_area(10, 20, 169, 51);
+
+    // CASET, x range, RASET, y range, RAMWR, pixels - nothing blocking
+    TEST_ASSERT_EQUAL(0, s_transmitted);
+    TEST_ASSERT_EQUAL(6, s_queued);
+
+    const int expected_dc[6] = {0, 1, 0, 1, 0, 1};
+    const size_t expected_len[6] = {8, 32, 8, 32, 8, 160 * 32 * 16};
+    for (int i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL(expected_dc[i], s_log[i].dc);
+        TEST_ASSERT_EQUAL(expected_len[i], s_log[i].length);
+    }
+
+    // DC is only driven from the pre-transfer callback
+    TEST_ASSERT_EQUAL(6, s_dc_writes);
+
+    TEST_ASSERT_EQUAL_UINT8(0x2A, s_log[0].data[0]);
+    const uint8_t x_range[4] = {0x00, 10, 0x00, 169};
+    TEST_ASSERT_EQUAL_MEMORY(x_range, s_log[1].data, 4);
+    TEST_ASSERT_EQUAL_UINT8(0x2B, s_log[2].data[0]);
+    const uint8_t y_range[4] = {0x00, 20, 0x00, 51};
+    TEST_ASSERT_EQUAL_MEMORY(y_range, s_log[3].data, 4);
+    TEST_ASSERT_EQUAL_UINT8(0x2C, s_log[4].data[0]);
+
+    // Flush-ready comes from the post-transfer callback of the pixel push
+    TEST_ASSERT_EQUAL(0, s_disp->driver->draw_buf->flushing);
+}
+
+void test_next_flush_reaps_previous_chain(void)
+{
+    mock_reset();
+    flush_area(0, 0, 169, 31);
+
+    // The chain from the previous test is collected before reuse
+    TEST_ASSERT_EQUAL(6, s_reaped);
+    TEST_ASSERT_EQUAL(6, s_queued);
+
+    mock_reset();
+    display_driver_deinit();
+    TEST_ASSERT_EQUAL(6, s_reaped);
+}
+
+void app_main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_display_init_sequence);
+    RUN_TEST(test_flush_is_one_queued_chain);
+    RUN_TEST(test_next_flush_reaps_previous_chain);
+
+    UNITY_END();
+}
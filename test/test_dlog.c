@@ -0,0 +1,241 @@
+/**
+ * @file test_dlog.c
+ * @brief Deferred logging: formatting, levels, rate limits and throughput (linux target)
+ */
+
+#include "dlog.h"
+#include "unity.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_ROUNDS        200000
+#define BENCH_BATCH         32      // Messages queued between flushes
+
+static char s_last[DLOG_LINE_MAX];
+static char s_last_tag[16];
+static char s_last_warn[DLOG_LINE_MAX];
+static esp_log_level_t s_last_level;
+static uint32_t s_lines;
+
+static void capture_sink(esp_log_level_t level, const char *tag, uint32_t timestamp_ms,
+                         const char *message)
+{
+    strncpy(s_last, message, sizeof(s_last) - 1);
+    strncpy(s_last_tag, tag, sizeof(s_last_tag) - 1);
+    s_last_level = level;
+    if (level == ESP_LOG_WARN) {
+        strncpy(s_last_warn, message, sizeof(s_last_warn) - 1);
+    }
+    s_lines++;
+}
+
+static void count_sink(esp_log_level_t level, const char *tag, uint32_t timestamp_ms,
+                       const char *message)
+{
+    s_lines++;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void reset(void)
+{
+    dlog_flush();
+    dlog_set_sink(capture_sink);
+    dlog_set_level("*", ESP_LOG_INFO);
+    dlog_set_rate("*", 0);
+    s_last[0] = '\0';
+    s_last_warn[0] = '\0';
+    s_lines = 0;
+}
+
+void test_formatting(void)
+{
+    reset();
+
+    // The string is copied at the call, so reusing the buffer is safe
+    char name[16] = "preset_a";
+    DLOGI("TEST", "Loaded %s (%d of %u)", name, -3, 7u);
+    strcpy(name, "overwritten");
+    TEST_ASSERT_EQUAL(1, dlog_flush());
+    TEST_ASSERT_EQUAL(0, strcmp("Loaded preset_a (-3 of 7)", s_last));
+    TEST_ASSERT_EQUAL(0, strcmp("TEST", s_last_tag));
+    TEST_ASSERT_EQUAL(ESP_LOG_INFO, s_last_level);
+
+    // Unsigned conversions see a negative int at its own width
+    DLOGI("TEST", "%u %x %08X", -1, -1, 0xBEEFu);
+    dlog_flush();
+    TEST_ASSERT_EQUAL(0, strcmp("4294967295 ffffffff 0000BEEF", s_last));
+
+    uint32_t freq = 433920000;
+    int64_t big = -5000000000LL;
+    DLOGI("TEST", "f=%" PRIu32 " big=%lld %.0f Hz %5.2f%%", freq, (long long)big, 868.35e6, 1.5f);
+    dlog_flush();
+    TEST_ASSERT_EQUAL(0, strcmp("f=433920000 big=-5000000000 868350000 Hz  1.50%", s_last));
+
+    DLOGI("TEST", "%c%c [%-4s] [%3d]", 'o', 'k', "ab", 7);
+    dlog_flush();
+    TEST_ASSERT_EQUAL(0, strcmp("ok [ab  ] [  7]", s_last));
+
+    int value;
+    char expected[32];
+    snprintf(expected, sizeof(expected), "at %p", (void *)&value);
+    DLOGI("TEST", "at %p", &value);
+    dlog_flush();
+    TEST_ASSERT_EQUAL(0, strcmp(expected, s_last));
+
+    DLOGI("TEST", "no arguments");
+    dlog_flush();
+    TEST_ASSERT_EQUAL(0, strcmp("no arguments", s_last));
+
+    // Missing arguments are marked instead of read from nowhere
+    const dlog_arg_t none[1] = { dlog_arg_int(0, sizeof(int)) };
+    char line[32];
+    dlog_format(line, sizeof(line), "x=%d y=%d", none, 1);
+    TEST_ASSERT_EQUAL(0, strcmp("x=0 y=<?>", line));
+
+    // Output is truncated, never overrun
+    TEST_ASSERT_EQUAL(7, dlog_format(line, 8, "%s", (dlog_arg_t[]) { dlog_arg_str("truncated", 0) }, 1));
+    TEST_ASSERT_EQUAL(0, strcmp("truncat", line));
+}
+
+void test_level_gating(void)
+{
+    reset();
+
+    DLOGD("GATE", "debug hidden");
+    TEST_ASSERT_EQUAL(0, dlog_flush());
+
+    dlog_set_level("GATE", ESP_LOG_DEBUG);
+    DLOGD("GATE", "debug shown");
+    DLOGV("GATE", "verbose hidden");
+    DLOGD("OTHER", "other module hidden");
+    TEST_ASSERT_EQUAL(1, dlog_flush());
+    TEST_ASSERT_EQUAL(0, strcmp("debug shown", s_last));
+
+    dlog_set_level("*", ESP_LOG_WARN);
+    DLOGI("GATE", "info hidden");
+    DLOGW("GATE", "warn shown");
+    TEST_ASSERT_EQUAL(1, dlog_flush());
+    TEST_ASSERT_EQUAL(ESP_LOG_WARN, s_last_level);
+
+    // Modules created after a "*" change start at the new default
+    DLOGI("LATE", "info hidden");
+    TEST_ASSERT_EQUAL(0, dlog_flush());
+}
+
+void test_rate_limit(void)
+{
+    reset();
+    dlog_set_rate("NOISY", 5);
+
+    dlog_stats_t before, after;
+    dlog_get_stats(&before);
+    for (int i = 0; i < 20; i++) {
+        DLOGI("NOISY", "burst %d", i);
+    }
+    dlog_get_stats(&after);
+    TEST_ASSERT_EQUAL(15, after.suppressed - before.suppressed);
+
+    // Five lines through, plus one notice counting the rest
+    TEST_ASSERT_EQUAL(5, dlog_flush());
+    TEST_ASSERT_EQUAL(6, s_lines);
+    TEST_ASSERT_EQUAL(0, strcmp("15 messages suppressed by rate limit", s_last_warn));
+    TEST_ASSERT_EQUAL(0, strcmp("burst 4", s_last));
+
+    // Unlimited modules are unaffected
+    DLOGI("QUIET", "still printed");
+    TEST_ASSERT_EQUAL(1, dlog_flush());
+}
+
+void test_full_ring_drops(void)
+{
+    reset();
+
+    dlog_stats_t before, after;
+    dlog_get_stats(&before);
+    for (int i = 0; i < DLOG_RING_LEN + 10; i++) {
+        DLOGI("FLOOD", "entry %d", i);
+    }
+    dlog_get_stats(&after);
+    TEST_ASSERT_EQUAL(10, after.dropped - before.dropped);
+    TEST_ASSERT_EQUAL(DLOG_RING_LEN, after.max_depth);
+
+    // The oldest entries survive; the ring is usable again after a flush
+    TEST_ASSERT_EQUAL(DLOG_RING_LEN, dlog_flush());
+    TEST_ASSERT_EQUAL(0, strcmp("entry 63", s_last));
+    DLOGI("FLOOD", "after");
+    TEST_ASSERT_EQUAL(1, dlog_flush());
+}
+
+void test_throughput(void)
+{
+    reset();
+    dlog_set_sink(count_sink);
+
+    const char *preset = "OOK_650";
+    uint32_t freq = 433920000;
+    int rssi = -72;
+
+    // Hot-path cost: queue a batch, then let the "formatter task" drain it
+    uint64_t write_ns = 0;
+    uint64_t flush_ns = 0;
+    for (int round = 0; round < BENCH_ROUNDS / BENCH_BATCH; round++) {
+        uint64_t t0 = now_ns();
+        for (int i = 0; i < BENCH_BATCH; i++) {
+            DLOGI("BENCH", "Read signal: freq=%" PRIu32 ", rssi=%d, preset=%s", freq, rssi, preset);
+        }
+        uint64_t t1 = now_ns();
+        dlog_flush();
+        flush_ns += now_ns() - t1;
+        write_ns += t1 - t0;
+    }
+
+    // What an ESP_LOGI formats and writes on the calling task
+    FILE *null = fopen("/dev/null", "w");
+    TEST_ASSERT_NOT_NULL(null);
+    char line[DLOG_LINE_MAX];
+    uint64_t t0 = now_ns();
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        int n = snprintf(line, sizeof(line), "I (%u) %s: Read signal: freq=%" PRIu32 ", rssi=%d, preset=%s\n",
+                         (unsigned)i, "BENCH", freq, rssi, preset);
+        fwrite(line, 1, (size_t)n, null);
+    }
+    uint64_t inline_ns = now_ns() - t0;
+    fclose(null);
+
+    // Below the level nothing but a compare runs
+    dlog_set_level("BENCH", ESP_LOG_WARN);
+    t0 = now_ns();
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        DLOGI("BENCH", "Read signal: freq=%" PRIu32 ", rssi=%d, preset=%s", freq, rssi, preset);
+    }
+    uint64_t gated_ns = now_ns() - t0;
+
+    uint32_t count = (BENCH_ROUNDS / BENCH_BATCH) * BENCH_BATCH;
+    printf("DLOGI on the caller: %.1f ns, formatter: %.1f ns (%.0f msgs/s), "
+           "inline format+write: %.1f ns, gated: %.2f ns\n",
+           (double)write_ns / count, (double)flush_ns / count, count * 1e9 / (double)flush_ns,
+           (double)inline_ns / BENCH_ROUNDS, (double)gated_ns / BENCH_ROUNDS);
+
+    TEST_ASSERT_EQUAL(count, s_lines);
+    TEST_ASSERT_TRUE(write_ns < inline_ns * count / BENCH_ROUNDS);
+}
+
+void app_main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_formatting);
+    RUN_TEST(test_level_gating);
+    RUN_TEST(test_rate_limit);
+    RUN_TEST(test_full_ring_drops);
+    RUN_TEST(test_throughput);
+
+    UNITY_END();
+}
@@ -0,0 +1,260 @@
+/**
+ * @file test_event_bus.c
+ * @brief Event bus fan-out, bounded queues, priorities and throughput (linux target)
+ */
+
+#include "event_bus.h"
+#include "unity.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_EVENTS        2000000
+#define PRODUCERS           3
+#define EVENTS_PER_PRODUCER 60000       // Fits the 16-bit count field
+
+EVENT_SUBSCRIBER_DEFINE(s_ui, "ui", EVENT_TOPIC_BIT(EVENT_INPUT) | EVENT_TOPIC_BIT(EVENT_RF_RX), 5, 8);
+EVENT_SUBSCRIBER_DEFINE(s_rf, "rf", EVENT_TOPIC_BIT(EVENT_RF_RX) | EVENT_TOPIC_BIT(EVENT_RF_TX), 9, 8);
+EVENT_SUBSCRIBER_DEFINE(s_net, "net", EVENT_TOPIC_BIT(EVENT_WIFI_STATUS), 1, 2);
+EVENT_SUBSCRIBER_DEFINE(s_bench, "bench", EVENT_TOPIC_ALL, 0, 256);
+EVENT_SUBSCRIBER_DEFINE(s_bench2, "bench2", EVENT_TOPIC_ALL, 0, 256);
+EVENT_SUBSCRIBER_DEFINE(s_bench3, "bench3", EVENT_TOPIC_ALL, 0, 256);
+EVENT_SUBSCRIBER_DEFINE(s_bench4, "bench4", EVENT_TOPIC_ALL, 0, 256);
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void subscribe_all(void)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, event_bus_subscribe(&s_ui));
+    TEST_ASSERT_EQUAL(ESP_OK, event_bus_subscribe(&s_rf));
+    TEST_ASSERT_EQUAL(ESP_OK, event_bus_subscribe(&s_net));
+}
+
+static void unsubscribe_all(void)
+{
+    event_bus_unsubscribe(&s_ui);
+    event_bus_unsubscribe(&s_rf);
+    event_bus_unsubscribe(&s_net);
+}
+
+void test_fan_out_by_topic(void)
+{
+    subscribe_all();
+
+    event_rf_rx_t rx = { .frequency = 433920000, .rssi = -60, .length = 3, .data = { 1, 2, 3 } };
+    TEST_ASSERT_EQUAL(2, event_publish_rf_rx(&rx, EVENT_PRIO_NORMAL));
+
+    event_rf_tx_t tx = { .frequency = 868350000, .length = 8 };
+    TEST_ASSERT_EQUAL(1, event_publish_rf_tx(&tx, EVENT_PRIO_NORMAL));
+
+    event_system_state_t state = { .state = 2 };
+    TEST_ASSERT_EQUAL(0, event_publish_system_state(&state, EVENT_PRIO_NORMAL));
+
+    // Each subscriber has its own copy
+    event_t event;
+    TEST_ASSERT_TRUE(event_bus_receive(&s_ui, &event, 0));
+    TEST_ASSERT_EQUAL(EVENT_RF_RX, event.topic);
+    TEST_ASSERT_EQUAL(-60, event.rf_rx.rssi);
+    TEST_ASSERT_EQUAL(3, event.rf_rx.data[2]);
+    TEST_ASSERT_FALSE(event_bus_receive(&s_ui, &event, 0));
+
+    TEST_ASSERT_TRUE(event_bus_receive(&s_rf, &event, 0));
+    TEST_ASSERT_EQUAL(EVENT_RF_RX, event.topic);
+    uint32_t rx_seq = event.seq;
+    TEST_ASSERT_TRUE(event_bus_receive(&s_rf, &event, 0));
+    TEST_ASSERT_EQUAL(EVENT_RF_TX, event.topic);
+    TEST_ASSERT_EQUAL(868350000, event.rf_tx.frequency);
+    TEST_ASSERT_EQUAL(rx_seq + 1, event.seq);
+
+    TEST_ASSERT_EQUAL(0, event_bus_pending(&s_net));
+    TEST_ASSERT_EQUAL(0, strcmp("RF_RX", event_topic_name(EVENT_RF_RX)));
+
+    unsubscribe_all();
+}
+
+void test_bounded_queue_drops_per_subscriber(void)
+{
+    subscribe_all();
+
+    // net has two slots and is not reading; rf keeps up
+    event_wifi_status_t wifi = { .status = 1 };
+    event_rf_tx_t tx = { .length = 1 };
+    for (int i = 0; i < 5; i++) {
+        wifi.status = (uint32_t)i;
+        event_publish_wifi_status(&wifi, EVENT_PRIO_NORMAL);
+        event_publish_rf_tx(&tx, EVENT_PRIO_NORMAL);
+
+        event_t event;
+        TEST_ASSERT_TRUE(event_bus_receive(&s_rf, &event, 0));
+    }
+
+    TEST_ASSERT_EQUAL(2, event_bus_pending(&s_net));
+    TEST_ASSERT_EQUAL(3, atomic_load(&s_net.dropped));
+    TEST_ASSERT_EQUAL(0, atomic_load(&s_rf.dropped));
+
+    // The oldest are kept
+    event_t event;
+    TEST_ASSERT_TRUE(event_bus_receive(&s_net, &event, 0));
+    TEST_ASSERT_EQUAL(0, event.wifi_status.status);
+
+    unsubscribe_all();
+}
+
+void test_urgent_lane_first(void)
+{
+    subscribe_all();
+
+    event_input_t input = { .event = 1 };
+    event_publish_input(&input, EVENT_PRIO_NORMAL);
+    input.event = 2;
+    event_publish_input(&input, EVENT_PRIO_NORMAL);
+    input.event = 9;
+    event_publish_input(&input, EVENT_PRIO_URGENT);
+
+    event_t event;
+    TEST_ASSERT_TRUE(event_bus_receive(&s_ui, &event, 0));
+    TEST_ASSERT_EQUAL(9, event.input.event);
+    TEST_ASSERT_TRUE(event_bus_receive(&s_ui, &event, 0));
+    TEST_ASSERT_EQUAL(1, event.input.event);
+    TEST_ASSERT_TRUE(event_bus_receive(&s_ui, &event, 0));
+    TEST_ASSERT_EQUAL(2, event.input.event);
+
+    unsubscribe_all();
+}
+
+void test_subscribe_rules(void)
+{
+    static event_slot_t slots[3 + EVENT_URGENT_DEPTH];
+    event_subscriber_t odd = { .name = "odd", .topics = EVENT_TOPIC_ALL, .depth = 3, .storage = slots };
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, event_bus_subscribe(&odd));
+
+    TEST_ASSERT_EQUAL(ESP_OK, event_bus_subscribe(&s_ui));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, event_bus_subscribe(&s_ui));
+    TEST_ASSERT_EQUAL(ESP_OK, event_bus_unsubscribe(&s_ui));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, event_bus_unsubscribe(&s_ui));
+
+    // Unsubscribed: nothing is queued and receive gives up
+    event_input_t input = { .event = 1 };
+    TEST_ASSERT_EQUAL(0, event_publish_input(&input, EVENT_PRIO_NORMAL));
+    event_t event;
+    TEST_ASSERT_FALSE(event_bus_receive(&s_ui, &event, 5));
+
+    event_bus_stats_t stats;
+    event_bus_get_stats(&stats);
+    TEST_ASSERT_EQUAL(0, stats.subscribers);
+    TEST_ASSERT_TRUE(stats.unheard > 0);
+}
+
+static atomic_int s_producers_done;
+
+static void *producer(void *arg)
+{
+    event_input_t input = { .key_id = (uint8_t)(uintptr_t)arg };
+    for (uint32_t i = 0; i < EVENTS_PER_PRODUCER; i++) {
+        input.count = (uint16_t)i;
+        event_publish_input(&input, EVENT_PRIO_NORMAL);
+    }
+    atomic_fetch_add(&s_producers_done, 1);
+    return NULL;
+}
+
+void test_concurrent_producers(void)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, event_bus_subscribe(&s_bench));
+
+    pthread_t threads[PRODUCERS];
+    for (uintptr_t i = 0; i < PRODUCERS; i++) {
+        pthread_create(&threads[i], NULL, producer, (void *)i);
+    }
+
+    // Per producer, events arrive in order; every one is received or dropped
+    uint32_t received = 0;
+    int32_t last[PRODUCERS] = { -1, -1, -1 };
+    event_t event;
+    while (atomic_load(&s_producers_done) < PRODUCERS || event_bus_pending(&s_bench)) {
+        if (!event_bus_receive(&s_bench, &event, 0)) {
+            continue;
+        }
+        int p = event.input.key_id;
+        TEST_ASSERT_TRUE(event.input.count > last[p]);
+        last[p] = event.input.count;
+        received++;
+    }
+    for (int i = 0; i < PRODUCERS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    TEST_ASSERT_EQUAL(PRODUCERS * EVENTS_PER_PRODUCER, received + atomic_load(&s_bench.dropped));
+    printf("%u producers: %u received, %u dropped by a full queue\n", (unsigned)PRODUCERS,
+           (unsigned)received, (unsigned)atomic_load(&s_bench.dropped));
+
+    event_bus_unsubscribe(&s_bench);
+}
+
+static void count_event(const event_t *event, void *user_data)
+{
+    (*(uint32_t *)user_data)++;
+}
+
+static double bench_publish(event_subscriber_t **subs, int n)
+{
+    for (int i = 0; i < n; i++) {
+        event_bus_subscribe(subs[i]);
+    }
+
+    event_rf_tx_t tx = { .frequency = 433920000, .length = 8 };
+    uint32_t handled = 0;
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < BENCH_EVENTS; i += 128) {
+        for (int j = 0; j < 128; j++) {
+            event_publish_rf_tx(&tx, EVENT_PRIO_NORMAL);
+        }
+        for (int s = 0; s < n; s++) {
+            event_bus_dispatch(subs[s], count_event, &handled);
+        }
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    TEST_ASSERT_EQUAL((uint32_t)n * BENCH_EVENTS, handled);
+    for (int i = 0; i < n; i++) {
+        event_bus_unsubscribe(subs[i]);
+    }
+    return (double)elapsed / BENCH_EVENTS;
+}
+
+void test_throughput(void)
+{
+    event_subscriber_t *subs[] = { &s_bench, &s_bench2, &s_bench3, &s_bench4 };
+
+    double one = bench_publish(subs, 1);
+    double four = bench_publish(subs, 4);
+    printf("publish + deliver: %.1f ns/event with 1 subscriber (%.1f M events/s), "
+           "%.1f ns/event with 4\n", one, 1000.0 / one, four);
+
+    // Publishing with nobody listening is close to free
+    event_rf_tx_t tx = { .length = 8 };
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < BENCH_EVENTS; i++) {
+        event_publish_rf_tx(&tx, EVENT_PRIO_NORMAL);
+    }
+    printf("publish with no subscriber: %.1f ns\n", (double)(now_ns() - start) / BENCH_EVENTS);
+}
+
+void app_main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_fan_out_by_topic);
+    RUN_TEST(test_bounded_queue_drops_per_subscriber);
+    RUN_TEST(test_urgent_lane_first);
+    RUN_TEST(test_subscribe_rules);
+    RUN_TEST(test_concurrent_producers);
+    RUN_TEST(test_throughput);
+
+    UNITY_END();
+}
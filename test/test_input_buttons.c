@@ -0,0 +1,263 @@
+/**
+ * @file test_input_buttons.c
+ * @brief Button debounce and gesture tests on a virtual clock
+ *
+ * Raw edges are fed the way the button ISR reports them, and the state
+ * machines are stepped only at the deadlines they return, the way the
+ * input task sleeps between them. Each test checks the event sequence the
+ * app cursor receives and when it arrives.
+ */
+
+#include "lvgl_port.h"
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_RECORDED    64
+
+typedef struct {
+    input_event_t event;
+    uint8_t key_id;
+    uint32_t at_ms;
+} recorded_t;
+
+static recorded_t s_events[MAX_RECORDED];
+static int s_count;
+static uint32_t s_now;
+static uint32_t s_deadline;     // Absolute time of the next step, or none
+static uint32_t s_wakeups;
+
+static void collect(void)
+{
+    input_data_t event;
+    while (input_events_pop(INPUT_READER_APP, &event)) {
+        if (s_count < MAX_RECORDED) {
+            s_events[s_count++] = (recorded_t){ event.event, event.key_id, event.timestamp };
+        }
+    }
+    while (input_events_pop(INPUT_READER_LVGL, &event)) {
+    }
+}
+
+static void step(void)
+{
+    uint32_t next = input_buttons_step(s_now);
+    s_deadline = next == INPUT_BUTTONS_NO_DEADLINE ? INPUT_BUTTONS_NO_DEADLINE : s_now + next;
+    s_wakeups++;
+    collect();
+}
+
+// Sleep until `until`, waking only at the deadlines the machines ask for
+static void run_until(uint32_t until)
+{
+    while (s_deadline != INPUT_BUTTONS_NO_DEADLINE && s_deadline <= until) {
+        s_now = s_deadline;
+        step();
+    }
+    s_now = until;
+}
+
+// A raw edge from the ISR wakes the task
+static void edge(uint32_t at, uint8_t key, bool pressed)
+{
+    run_until(at);
+    input_buttons_raw(key, pressed, s_now);
+    step();
+}
+
+static void reset_machine(void)
+{
+    input_events_reset();
+    input_buttons_reset(0);
+    s_count = 0;
+    s_now = 0;
+    s_deadline = INPUT_BUTTONS_NO_DEADLINE;
+    s_wakeups = 0;
+}
+
+static int count_of(input_event_t event, uint8_t key_id)
+{
+    int n = 0;
+    for (int i = 0; i < s_count; i++) {
+        n += s_events[i].event == event && s_events[i].key_id == key_id;
+    }
+    return n;
+}
+
+static const recorded_t* find(input_event_t event, uint8_t key_id)
+{
+    for (int i = 0; i < s_count; i++) {
+        if (s_events[i].event == event && s_events[i].key_id == key_id) {
+            return &s_events[i];
+        }
+    }
+    return NULL;
+}
+
+void test_bounce_is_filtered(void)
+{
+    reset_machine();
+
+    // Contact chatter for 7 ms, then a clean hold
+    edge(0, 1, true);
+    edge(2, 1, false);
+    edge(4, 1, true);
+    edge(5, 1, false);
+    edge(7, 1, true);
+    run_until(100);
+
+    TEST_ASSERT_EQUAL(1, count_of(INPUT_EVENT_PRESS, 1));
+    TEST_ASSERT_EQUAL(7 + INPUT_DEBOUNCE_MS, find(INPUT_EVENT_PRESS, 1)->at_ms);
+
+    // A glitch shorter than the debounce time is not a release
+    edge(200, 1, false);
+    edge(205, 1, true);
+    run_until(300);
+    TEST_ASSERT_EQUAL(0, count_of(INPUT_EVENT_RELEASE, 1));
+
+    lvgl_input_stats_t stats;
+    lvgl_port_get_input_stats(&stats);
+    TEST_ASSERT_EQUAL(7, stats.button_edges);
+    TEST_ASSERT_EQUAL(6, stats.bounces_filtered);
+}
+
+void test_click_waits_out_double_click_window(void)
+{
+    reset_machine();
+
+    edge(0, 0, true);
+    edge(100, 0, false);
+    run_until(1000);
+
+    const recorded_t *click = find(INPUT_EVENT_CLICK, 0);
+    TEST_ASSERT_NOT_NULL(click);
+    TEST_ASSERT_EQUAL(100 + INPUT_DEBOUNCE_MS + INPUT_DOUBLE_CLICK_MS, click->at_ms);
+    TEST_ASSERT_EQUAL(1, count_of(INPUT_EVENT_PRESS, 0));
+    TEST_ASSERT_EQUAL(1, count_of(INPUT_EVENT_RELEASE, 0));
+    TEST_ASSERT_EQUAL(0, count_of(INPUT_EVENT_LONG_PRESS, 0));
+}
+
+void test_double_click(void)
+{
+    reset_machine();
+
+    edge(0, 2, true);
+    edge(80, 2, false);
+    edge(200, 2, true);
+    edge(280, 2, false);
+    run_until(1000);
+
+    TEST_ASSERT_EQUAL(1, count_of(INPUT_EVENT_DOUBLE_CLICK, 2));
+    TEST_ASSERT_EQUAL(0, count_of(INPUT_EVENT_CLICK, 2));
+    TEST_ASSERT_EQUAL(280 + INPUT_DEBOUNCE_MS, find(INPUT_EVENT_DOUBLE_CLICK, 2)->at_ms);
+
+    // Too slow for a double click: two clicks
+    reset_machine();
+    edge(0, 2, true);
+    edge(80, 2, false);
+    edge(500, 2, true);
+    edge(580, 2, false);
+    run_until(2000);
+    TEST_ASSERT_EQUAL(2, count_of(INPUT_EVENT_CLICK, 2));
+    TEST_ASSERT_EQUAL(0, count_of(INPUT_EVENT_DOUBLE_CLICK, 2));
+}
+
+void test_long_press_and_repeat(void)
+{
+    reset_machine();
+
+    uint32_t pressed_at = INPUT_DEBOUNCE_MS;
+    uint32_t released_at = 1000 + INPUT_DEBOUNCE_MS;
+
+    edge(0, 1, true);
+    edge(1000, 1, false);
+    run_until(2000);
+
+    const recorded_t *held = find(INPUT_EVENT_LONG_PRESS, 1);
+    TEST_ASSERT_NOT_NULL(held);
+    TEST_ASSERT_EQUAL(pressed_at + INPUT_LONG_PRESS_MS, held->at_ms);
+
+    int repeats = (released_at - pressed_at - INPUT_LONG_PRESS_MS - 1) / INPUT_REPEAT_MS;
+    TEST_ASSERT_EQUAL(repeats, count_of(INPUT_EVENT_REPEAT, 1));
+
+    // A long press is not also a click
+    TEST_ASSERT_EQUAL(0, count_of(INPUT_EVENT_CLICK, 1));
+    TEST_ASSERT_EQUAL(1, count_of(INPUT_EVENT_RELEASE, 1));
+}
+
+void test_chord(void)
+{
+    reset_machine();
+
+    // Button 1 and 2 pressed 40 ms apart and held
+    edge(0, 1, true);
+    edge(40, 2, true);
+    edge(1200, 1, false);
+    edge(1210, 2, false);
+    run_until(2000);
+
+    const recorded_t *chord = find(INPUT_EVENT_CHORD, (1 << 1) | (1 << 2));
+    TEST_ASSERT_NOT_NULL(chord);
+    TEST_ASSERT_EQUAL(INPUT_DEBOUNCE_MS + INPUT_CHORD_MS, chord->at_ms);
+
+    // The chord replaces the keys' own gestures
+    TEST_ASSERT_EQUAL(0, count_of(INPUT_EVENT_LONG_PRESS, 1));
+    TEST_ASSERT_EQUAL(0, count_of(INPUT_EVENT_LONG_PRESS, 2));
+    TEST_ASSERT_EQUAL(0, count_of(INPUT_EVENT_CLICK, 1));
+    TEST_ASSERT_EQUAL(0, count_of(INPUT_EVENT_CLICK, 2));
+
+    // Presses and releases still go through for LVGL and apps
+    TEST_ASSERT_EQUAL(1, count_of(INPUT_EVENT_PRESS, 1));
+    TEST_ASSERT_EQUAL(1, count_of(INPUT_EVENT_RELEASE, 2));
+}
+
+void test_late_second_key_is_not_a_chord(void)
+{
+    reset_machine();
+
+    edge(0, 1, true);
+    edge(300, 0, true);
+    edge(350, 0, false);
+    edge(400, 1, false);
+    run_until(2000);
+
+    TEST_ASSERT_EQUAL(0, count_of(INPUT_EVENT_CHORD, (1 << 0) | (1 << 1)));
+    TEST_ASSERT_EQUAL(1, count_of(INPUT_EVENT_CLICK, 0));
+    TEST_ASSERT_EQUAL(1, count_of(INPUT_EVENT_CLICK, 1));
+}
+
+void test_wakes_only_for_edges_and_deadlines(void)
+{
+    reset_machine();
+
+    // A click, a long hold and a double click spread over 5 s
+    edge(0, 0, true);
+    edge(120, 0, false);
+    edge(1000, 1, true);
+    edge(2500, 1, false);
+    edge(3000, 2, true);
+    edge(3090, 2, false);
+    edge(3200, 2, true);
+    edge(3290, 2, false);
+    run_until(5000);
+
+    uint32_t polls = 5000 / 10;
+    printf("%d events from %u wake-ups over 5 s (10 ms polling: %u)\n", s_count, s_wakeups, polls);
+
+    TEST_ASSERT_EQUAL(INPUT_BUTTONS_NO_DEADLINE, s_deadline);
+    TEST_ASSERT_TRUE(s_wakeups < polls / 10);
+}
+
+void app_main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_bounce_is_filtered);
+    RUN_TEST(test_click_waits_out_double_click_window);
+    RUN_TEST(test_double_click);
+    RUN_TEST(test_long_press_and_repeat);
+    RUN_TEST(test_chord);
+    RUN_TEST(test_late_second_key_is_not_a_chord);
+    RUN_TEST(test_wakes_only_for_edges_and_deadlines);
+
+    UNITY_END();
+}
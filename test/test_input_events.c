@@ -0,0 +1,518 @@
+/**
+ * @file test_input_events.c
+ * @brief Quadrature decoder and input event ring replay tests
+ *
+ * Synthetic encoder traces are replayed edge by edge through the decoder
+ * the way the GPIO ISR sees them: fast spins, contact bounce on every edge,
+ * direction reversals and aborted half-turns. The detent count read back
+ * through both ring cursors must match the trace exactly. The app path is
+ * checked for acceleration and for folding a spin into one event per frame.
+ */
+
+#include "lvgl_port.h"
+#include "unity.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EDGE_US             60      // ~4000 detents/s, far beyond a hand spin
+#define BOUNCE_PERCENT      30
+
+typedef struct {
+    input_quad_t quad;
+    uint8_t a, b;
+    uint32_t now_us;
+    int32_t expected;       // Net detents the trace moved
+} trace_t;
+
+typedef struct {
+    int32_t steps;
+    uint32_t events;
+    uint32_t last_us;
+    bool ordered;
+} reader_tally_t;
+
+// CW sequence of (A, B) levels starting at the rest state
+static const uint8_t s_gray[4][2] = { {1, 1}, {1, 0}, {0, 0}, {0, 1} };
+
+static uint32_t s_rand = 12345;
+
+static uint32_t next_rand(void)
+{
+    s_rand = s_rand * 1103515245u + 12345u;
+    return s_rand >> 16;
+}
+
+// What encoder_isr_handler does on one edge
+static void isr_edge(trace_t *trace, uint8_t a, uint8_t b)
+{
+    trace->a = a;
+    trace->b = b;
+    trace->now_us += EDGE_US;
+
+    int step = input_quad_update(&trace->quad, a, b);
+    if (step) {
+        input_data_t event = {
+            .type = INPUT_TYPE_ENCODER,
+            .event = step > 0 ? INPUT_EVENT_ENCODER_CW : INPUT_EVENT_ENCODER_CCW,
+            .timestamp = trace->now_us / 1000,
+            .time_us = trace->now_us,
+            .delta = (int16_t)step,
+            .count = 1,
+        };
+        input_events_push(&event);
+    }
+}
+
+// Move to the next Gray state, optionally chattering on the edge first
+static void move(trace_t *trace, int *phase, int dir, bool bounce)
+{
+    int next = (*phase + dir + 4) & 3;
+
+    if (bounce) {
+        for (int i = 0; i < 2; i++) {
+            isr_edge(trace, s_gray[next][0], s_gray[next][1]);
+            isr_edge(trace, s_gray[*phase][0], s_gray[*phase][1]);
+        }
+    }
+    isr_edge(trace, s_gray[next][0], s_gray[next][1]);
+    *phase = next;
+}
+
+static void trace_init(trace_t *trace)
+{
+    memset(trace, 0, sizeof(*trace));
+    input_events_reset();
+    input_quad_init(&trace->quad, 1, 1);
+}
+
+// One full detent, or a half-turn that goes back where it started
+static void trace_detent(trace_t *trace, int dir, bool abort)
+{
+    int phase = 0;
+    bool bounce = next_rand() % 100 < BOUNCE_PERCENT;
+
+    if (abort) {
+        move(trace, &phase, dir, bounce);
+        move(trace, &phase, dir, false);
+        move(trace, &phase, -dir, bounce);
+        move(trace, &phase, -dir, false);
+        return;
+    }
+    for (int i = 0; i < 4; i++) {
+        move(trace, &phase, dir, bounce && i == 0);
+    }
+    trace->expected += dir;
+}
+
+// Clean detents with no bounce
+static void spin(trace_t *trace, int dir, int detents)
+{
+    for (int i = 0; i < detents; i++) {
+        int phase = 0;
+        for (int k = 0; k < 4; k++) {
+            move(trace, &phase, dir, false);
+        }
+        trace->expected += dir;
+    }
+}
+
+static void drain(input_reader_t reader, reader_tally_t *tally)
+{
+    input_data_t event;
+    while (input_events_pop(reader, &event)) {
+        tally->steps += event.event == INPUT_EVENT_ENCODER_CW ? 1 : -1;
+        if (tally->events && (int32_t)(event.time_us - tally->last_us) < 0) {
+            tally->ordered = false;
+        }
+        tally->last_us = event.time_us;
+        tally->events++;
+    }
+}
+
+void test_decoder_counts_clean_detents(void)
+{
+    trace_t trace;
+    trace_init(&trace);
+
+    spin(&trace, 1, 10);
+    TEST_ASSERT_EQUAL(10, input_events_pending(INPUT_READER_LVGL));
+
+    input_data_t event;
+    TEST_ASSERT_TRUE(input_events_pop(INPUT_READER_APP, &event));
+    TEST_ASSERT_EQUAL(INPUT_EVENT_ENCODER_CW, event.event);
+    TEST_ASSERT_EQUAL(4 * EDGE_US, event.time_us);
+
+    // Quarter steps between detents produce nothing
+    int phase = 0;
+    move(&trace, &phase, -1, false);
+    move(&trace, &phase, -1, false);
+    move(&trace, &phase, -1, false);
+    TEST_ASSERT_EQUAL(10, input_events_pending(INPUT_READER_LVGL));
+    move(&trace, &phase, -1, false);
+    TEST_ASSERT_EQUAL(11, input_events_pending(INPUT_READER_LVGL));
+}
+
+void test_bounce_and_half_turns_cancel(void)
+{
+    trace_t trace;
+    trace_init(&trace);
+
+    trace_detent(&trace, 1, true);
+    trace_detent(&trace, -1, true);
+
+    // Chatter at rest: the contact reopens and closes without moving
+    isr_edge(&trace, 1, 0);
+    isr_edge(&trace, 1, 1);
+    isr_edge(&trace, 0, 1);
+    isr_edge(&trace, 1, 1);
+
+    TEST_ASSERT_EQUAL(0, input_events_pending(INPUT_READER_LVGL));
+}
+
+void test_missed_edge_keeps_step(void)
+{
+    trace_t trace;
+    trace_init(&trace);
+
+    // 11 -> 10 -> (00 lost) -> 01 -> 11: a jump over one state
+    isr_edge(&trace, 1, 0);
+    isr_edge(&trace, 0, 1);
+    isr_edge(&trace, 1, 1);
+
+    reader_tally_t tally = { .ordered = true };
+    drain(INPUT_READER_LVGL, &tally);
+    TEST_ASSERT_EQUAL(1, tally.steps);
+
+    lvgl_input_stats_t stats;
+    lvgl_port_get_input_stats(&stats);
+    TEST_ASSERT_EQUAL(1, stats.invalid_transitions);
+}
+
+void test_replay_high_speed_trace(void)
+{
+    trace_t trace;
+    trace_init(&trace);
+
+    reader_tally_t lvgl = { .ordered = true };
+    reader_tally_t app = { .ordered = true };
+
+    // Spins of random length and direction, readers polling at their own
+    // rates: LVGL every 48 detents, the app task every 100
+    int dir = 1;
+    for (int i = 0; i < 20000; i++) {
+        if (next_rand() % 64 == 0) {
+            dir = -dir;
+        }
+        trace_detent(&trace, dir, next_rand() % 16 == 0);
+
+        if (i % 48 == 0) {
+            drain(INPUT_READER_LVGL, &lvgl);
+        }
+        if (i % 100 == 0) {
+            drain(INPUT_READER_APP, &app);
+        }
+    }
+    drain(INPUT_READER_LVGL, &lvgl);
+    drain(INPUT_READER_APP, &app);
+
+    lvgl_input_stats_t stats;
+    lvgl_port_get_input_stats(&stats);
+    printf("%u edges over %u ms: %u events, max backlog %u, %d net detents\n",
+           trace.now_us / EDGE_US, trace.now_us / 1000, stats.events,
+           stats.max_depth, trace.expected);
+
+    TEST_ASSERT_EQUAL(0, stats.dropped);
+    TEST_ASSERT_EQUAL(0, stats.invalid_transitions);
+    TEST_ASSERT_EQUAL(trace.expected, lvgl.steps);
+    TEST_ASSERT_EQUAL(trace.expected, app.steps);
+    TEST_ASSERT_EQUAL(stats.events, lvgl.events);
+    TEST_ASSERT_EQUAL(stats.events, app.events);
+    TEST_ASSERT_TRUE(lvgl.ordered);
+    TEST_ASSERT_TRUE(app.ordered);
+}
+
+void test_lagging_reader_drops_new_events_only(void)
+{
+    trace_t trace;
+    trace_init(&trace);
+
+    // The app cursor never moves; LVGL keeps up
+    reader_tally_t lvgl = { .ordered = true };
+    for (int i = 0; i < INPUT_RING_LEN + 10; i++) {
+        spin(&trace, 1, 1);
+        drain(INPUT_READER_LVGL, &lvgl);
+    }
+
+    lvgl_input_stats_t stats;
+    lvgl_port_get_input_stats(&stats);
+    TEST_ASSERT_EQUAL(10, stats.dropped);
+    TEST_ASSERT_EQUAL(INPUT_RING_LEN, stats.pending_app);
+    TEST_ASSERT_EQUAL(INPUT_RING_LEN, lvgl.events);
+
+    // The oldest events are intact for the lagging reader
+    input_data_t event;
+    TEST_ASSERT_TRUE(input_events_pop(INPUT_READER_APP, &event));
+    TEST_ASSERT_EQUAL(4 * EDGE_US, event.time_us);
+}
+
+typedef struct {
+    uint32_t calls;
+    int32_t delta;
+    uint32_t count;
+    input_data_t last;
+} app_tally_t;
+
+static void tally_app(const input_data_t *input, void *user_data)
+{
+    app_tally_t *tally = user_data;
+    tally->calls++;
+    tally->delta += input->delta;
+    tally->count += input->count;
+    tally->last = *input;
+}
+
+static void push_step(int dir, uint32_t time_us)
+{
+    input_data_t event = {
+        .type = INPUT_TYPE_ENCODER,
+        .event = dir > 0 ? INPUT_EVENT_ENCODER_CW : INPUT_EVENT_ENCODER_CCW,
+        .time_us = time_us,
+        .delta = (int16_t)dir,
+        .count = 1,
+    };
+    input_events_push(&event);
+}
+
+static void push_button(uint8_t key_id, input_event_t edge, uint32_t time_us)
+{
+    input_data_t event = { .type = INPUT_TYPE_BUTTON, .event = edge, .key_id = key_id, .time_us = time_us };
+    input_events_push(&event);
+}
+
+void test_slow_turning_is_one_to_one(void)
+{
+    input_events_reset();
+    app_tally_t tally = {0};
+
+    // 10 detents/s: one event per detent, never scaled
+    for (int i = 1; i <= 20; i++) {
+        push_step(1, i * 100000);
+        TEST_ASSERT_EQUAL(1, input_events_dispatch(tally_app, &tally));
+        TEST_ASSERT_EQUAL(1, tally.last.delta);
+    }
+    TEST_ASSERT_EQUAL(20, tally.delta);
+}
+
+void test_fast_spin_accelerates(void)
+{
+    input_accel_t accel = {0};
+    int total = 0;
+
+    // The first step after a pause is never scaled
+    TEST_ASSERT_EQUAL(-1, input_accel_apply(&accel, -1, 1000000));
+
+    // Steps 5 ms apart ramp up to the maximum multiplier
+    int delta = 0;
+    for (int i = 1; i <= 20; i++) {
+        delta = input_accel_apply(&accel, 1, 1000000 + i * 5000);
+        total += delta;
+    }
+    TEST_ASSERT_EQUAL(INPUT_ACCEL_MAX, delta);
+
+    // A reversal drops straight back to 1:1
+    TEST_ASSERT_EQUAL(-1, input_accel_apply(&accel, -1, 1000000 + 21 * 5000));
+    printf("20 fast detents moved %d steps\n", total);
+}
+
+void test_spin_coalesces_to_one_event_per_frame(void)
+{
+    input_events_reset();
+    app_tally_t tally = {0};
+    uint32_t frames = 0;
+
+    // 500 detents at 1 ms spacing, delivered once per frame; LVGL keeps
+    // its own cursor drained
+    reader_tally_t lvgl = { .ordered = true };
+    uint32_t t = 0;
+    for (int i = 0; i < 500; i++) {
+        t += 1000;
+        push_step(1, t);
+        drain(INPUT_READER_LVGL, &lvgl);
+        if (t % (INPUT_DISPATCH_MS * 1000) < 1000) {
+            uint32_t before = tally.calls;
+            input_events_dispatch(tally_app, &tally);
+            TEST_ASSERT_EQUAL(before + 1, tally.calls);
+            frames++;
+        }
+    }
+    input_events_dispatch(tally_app, &tally);
+    frames++;
+
+    lvgl_input_stats_t stats;
+    lvgl_port_get_input_stats(&stats);
+    printf("500 detents -> %u app events, delta %d, at most %u detents per event\n",
+           tally.calls, tally.delta, stats.max_coalesced);
+
+    TEST_ASSERT_EQUAL(frames, tally.calls);
+    TEST_ASSERT_EQUAL(500, tally.count);
+    TEST_ASSERT_EQUAL(500, stats.encoder_steps);
+    TEST_ASSERT_EQUAL(500, lvgl.events);
+    TEST_ASSERT_EQUAL(0, stats.dropped);
+    TEST_ASSERT_TRUE(tally.delta > 500 * (INPUT_ACCEL_MAX / 2));
+}
+
+void test_reversal_and_click_split_runs(void)
+{
+    input_events_reset();
+    app_tally_t tally = {0};
+
+    push_step(1, 100000);
+    push_step(1, 200000);
+    push_step(-1, 300000);
+    push_button(0, INPUT_EVENT_PRESS, 350000);
+    push_step(-1, 400000);
+    push_step(-1, 500000);
+
+    // CW run, CCW run, click, CCW run
+    TEST_ASSERT_EQUAL(4, input_events_dispatch(tally_app, &tally));
+    TEST_ASSERT_EQUAL(INPUT_EVENT_ENCODER_CCW, tally.last.event);
+    TEST_ASSERT_EQUAL(-2, tally.last.delta);
+    TEST_ASSERT_EQUAL(2, tally.last.count);
+    TEST_ASSERT_EQUAL(400000, tally.last.time_us);
+    TEST_ASSERT_EQUAL(5, tally.count);
+
+    // The LVGL cursor still gets every detent on its own
+    TEST_ASSERT_EQUAL(6, input_events_pending(INPUT_READER_LVGL));
+}
+
+#define THREAD_EVENTS   200000
+
+static void *reader_thread(void *arg)
+{
+    input_reader_t reader = (input_reader_t)(uintptr_t)arg;
+    uint32_t expected = 0;
+    input_data_t event;
+
+    while (expected < THREAD_EVENTS) {
+        if (!input_events_pop(reader, &event)) {
+            continue;
+        }
+        if (event.time_us != expected) {
+            return (void *)1;
+        }
+        expected++;
+    }
+    return NULL;
+}
+
+void test_concurrent_readers_see_every_event(void)
+{
+    input_events_reset();
+
+    pthread_t readers[INPUT_READER_MAX];
+    for (int i = 0; i < INPUT_READER_MAX; i++) {
+        pthread_create(&readers[i], NULL, reader_thread, (void *)(uintptr_t)i);
+    }
+
+    // The producer retries on a full ring so every sequence number arrives
+    for (uint32_t seq = 0; seq < THREAD_EVENTS; seq++) {
+        input_data_t event = { .type = INPUT_TYPE_ENCODER, .event = INPUT_EVENT_ENCODER_CW, .time_us = seq };
+        while (!input_events_push(&event)) {
+        }
+    }
+
+    for (int i = 0; i < INPUT_READER_MAX; i++) {
+        void *result;
+        pthread_join(readers[i], &result);
+        TEST_ASSERT_NULL(result);
+    }
+
+    lvgl_input_stats_t stats;
+    lvgl_port_get_input_stats(&stats);
+    TEST_ASSERT_EQUAL(THREAD_EVENTS, stats.events);
+    TEST_ASSERT_EQUAL(0, stats.pending_lvgl);
+    TEST_ASSERT_EQUAL(0, stats.pending_app);
+}
+
+static void count_steps(const input_data_t *input, void *user_data)
+{
+    int32_t *steps = user_data;
+    *steps += input->event == INPUT_EVENT_ENCODER_CW ? input->count : -input->count;
+}
+
+void test_headless_script_reaches_both_cursors(void)
+{
+    int32_t app_steps = 0;
+
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_init());
+    lvgl_port_register_input_callback(count_steps, &app_steps);
+
+    static const lvgl_input_step_t spin[] = {
+        { 0, INPUT_TYPE_ENCODER, INPUT_EVENT_ENCODER_CW, 0 },
+        { 0, INPUT_TYPE_ENCODER, INPUT_EVENT_ENCODER_CW, 0 },
+        { 0, INPUT_TYPE_ENCODER, INPUT_EVENT_ENCODER_CW, 0 },
+        { 20, INPUT_TYPE_ENCODER, INPUT_EVENT_ENCODER_CCW, 0 },
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_headless_play_input(spin, 4));
+    for (int i = 0; i < 4 && !lvgl_headless_input_done(); i++) {
+        lvgl_headless_render_frame(16, NULL);
+    }
+    lvgl_headless_render_frame(16, NULL);
+
+    lvgl_input_stats_t stats;
+    lvgl_port_get_input_stats(&stats);
+    TEST_ASSERT_TRUE(lvgl_headless_input_done());
+    TEST_ASSERT_EQUAL(4, stats.events);
+    TEST_ASSERT_EQUAL(0, stats.pending_lvgl);
+    TEST_ASSERT_EQUAL(0, stats.pending_app);
+    TEST_ASSERT_EQUAL(2, app_steps);
+
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_deinit());
+}
+
+// Legal on the device, where callbacks run on the input task
+static void lock_and_count(const input_data_t *input, void *user_data)
+{
+    lvgl_port_lock();
+    (*(int32_t *)user_data)++;
+    lvgl_port_unlock();
+}
+
+void test_headless_callbacks_run_unlocked(void)
+{
+    int32_t calls = 0;
+
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_init());
+    lvgl_port_register_input_callback(lock_and_count, &calls);
+
+    static const lvgl_input_step_t click[] = {
+        { 0, INPUT_TYPE_ENCODER, INPUT_EVENT_ENCODER_CW, 0 },
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_headless_play_input(click, 1));
+    lvgl_headless_render_frame(16, NULL);
+    lvgl_headless_render_frame(16, NULL);
+    TEST_ASSERT_EQUAL(1, calls);
+
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_deinit());
+}
+
+void app_main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_decoder_counts_clean_detents);
+    RUN_TEST(test_bounce_and_half_turns_cancel);
+    RUN_TEST(test_missed_edge_keeps_step);
+    RUN_TEST(test_replay_high_speed_trace);
+    RUN_TEST(test_lagging_reader_drops_new_events_only);
+    RUN_TEST(test_concurrent_readers_see_every_event);
+    RUN_TEST(test_slow_turning_is_one_to_one);
+    RUN_TEST(test_fast_spin_accelerates);
+    RUN_TEST(test_spin_coalesces_to_one_event_per_frame);
+    RUN_TEST(test_reversal_and_click_split_runs);
+    RUN_TEST(test_headless_script_reaches_both_cursors);
+    RUN_TEST(test_headless_callbacks_run_unlocked);
+
+    UNITY_END();
+}
@@ -0,0 +1,172 @@
+/**
+ * @file test_input_latency.c
+ * @brief Input-to-photon latency traces on the headless backend
+ *
+ * Scripted input is played against a screen whose input handler posts a
+ * label update, the way app handlers change the UI. Every handled event
+ * must be traced from its edge to the flush that drew it, and the report
+ * is printed the same way the system manager logs it on the device.
+ */
+
+#include "lvgl_port.h"
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+
+#define FRAME_MS    16
+
+static lv_obj_t *s_label;
+static uint32_t s_handled;
+
+static void update_label(const input_data_t *input, void *user_data)
+{
+    char text[32];
+    snprintf(text, sizeof(text), "event %u", (unsigned)input->id);
+    lvgl_port_post_label_text(s_label, text);
+    s_handled++;
+}
+
+static void setup_screen(bool with_handler)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_init());
+
+    lvgl_port_lock();
+    lv_obj_t *screen = lv_obj_create(NULL);
+    s_label = lv_label_create(screen);
+    lv_label_set_text(s_label, "idle");
+    lv_scr_load(screen);
+    lvgl_port_unlock();
+
+    s_handled = 0;
+    lvgl_port_register_input_callback(with_handler ? update_label : NULL, NULL);
+
+    // Draw the first frame before any input so it is not attributed to it
+    lvgl_headless_render_frame(FRAME_MS, NULL);
+    lvgl_port_reset_latency_stats();
+}
+
+static void play(const lvgl_input_step_t *steps, size_t count, uint32_t settle_ms)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_headless_play_input(steps, count));
+    while (!lvgl_headless_input_done()) {
+        lvgl_headless_render_frame(FRAME_MS, NULL);
+    }
+    for (uint32_t t = 0; t < settle_ms; t += FRAME_MS) {
+        lvgl_headless_render_frame(FRAME_MS, NULL);
+    }
+}
+
+void test_percentile_of_histogram(void)
+{
+    lvgl_latency_hist_t hist = {0};
+
+    TEST_ASSERT_EQUAL(0, lvgl_latency_percentile(&hist, 50));
+
+    // 90 samples around 1 ms (bucket [512, 1024)) and 10 around 20 ms
+    hist.buckets[10] = 90;
+    hist.buckets[15] = 10;
+    hist.count = 100;
+    hist.min_us = 600;
+    hist.max_us = 20000;
+
+    TEST_ASSERT_EQUAL(1023, lvgl_latency_percentile(&hist, 50));
+    TEST_ASSERT_EQUAL(1023, lvgl_latency_percentile(&hist, 90));
+    TEST_ASSERT_EQUAL(20000, lvgl_latency_percentile(&hist, 95));
+    TEST_ASSERT_EQUAL(20000, lvgl_latency_percentile(&hist, 100));
+}
+
+void test_scripted_input_is_traced_to_flush(void)
+{
+    setup_screen(true);
+
+    // Single detents far enough apart that each is dispatched on its own
+    static const lvgl_input_step_t script[] = {
+        { 0, INPUT_TYPE_ENCODER, INPUT_EVENT_ENCODER_CW, 0 },
+        { 100, INPUT_TYPE_ENCODER, INPUT_EVENT_ENCODER_CW, 0 },
+        { 200, INPUT_TYPE_ENCODER, INPUT_EVENT_ENCODER_CCW, 0 },
+        { 300, INPUT_TYPE_ENCODER, INPUT_EVENT_ENCODER_CW, 0 },
+        { 400, INPUT_TYPE_ENCODER, INPUT_EVENT_ENCODER_CCW, 0 },
+    };
+    play(script, 5, 200);
+
+    lvgl_latency_stats_t stats;
+    lvgl_port_get_latency_stats(&stats);
+
+    TEST_ASSERT_EQUAL(5, s_handled);
+    TEST_ASSERT_EQUAL(5, stats.traced);
+    TEST_ASSERT_EQUAL(5, stats.completed);
+    TEST_ASSERT_EQUAL(0, stats.untraced);
+    TEST_ASSERT_EQUAL(5, stats.hist[LVGL_LATENCY_TOTAL].count);
+    TEST_ASSERT_EQUAL(5, stats.hist[LVGL_LATENCY_HANDLER].count);
+
+    // The label changes in the frame after the handler posts it, and the
+    // edge waits up to an input read period before it is seen
+    const lvgl_latency_hist_t *total = &stats.hist[LVGL_LATENCY_TOTAL];
+    TEST_ASSERT_TRUE(total->min_us >= FRAME_MS * 1000);
+    TEST_ASSERT_TRUE(total->max_us < (LV_INDEV_DEF_READ_PERIOD + 3 * FRAME_MS) * 1000);
+
+    // Stages are in order, so the segments add up to the total
+    const lvgl_latency_record_t *last = &stats.last;
+    TEST_ASSERT_EQUAL(INPUT_EVENT_ENCODER_CCW, last->event);
+    TEST_ASSERT_EQUAL(last->us[LVGL_LATENCY_TOTAL],
+                      last->us[LVGL_LATENCY_QUEUE] + last->us[LVGL_LATENCY_UPDATE] +
+                      last->us[LVGL_LATENCY_RENDER]);
+
+    lvgl_port_log_latency_report();
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_deinit());
+}
+
+void test_button_latency_includes_debounce(void)
+{
+    setup_screen(true);
+
+    static const lvgl_input_step_t press[] = {
+        { 0, INPUT_TYPE_BUTTON, INPUT_EVENT_PRESS, 1 },
+    };
+    play(press, 1, 200);
+
+    lvgl_latency_stats_t stats;
+    lvgl_port_get_latency_stats(&stats);
+
+    TEST_ASSERT_EQUAL(1, stats.completed);
+    TEST_ASSERT_EQUAL(INPUT_EVENT_PRESS, stats.last.event);
+    TEST_ASSERT_TRUE(stats.last.us[LVGL_LATENCY_QUEUE] >= INPUT_DEBOUNCE_MS * 1000);
+
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_deinit());
+}
+
+void test_events_without_redraw_expire(void)
+{
+    // Nothing handles the input and nothing on screen is focusable
+    setup_screen(false);
+
+    static const lvgl_input_step_t spin[] = {
+        { 0, INPUT_TYPE_ENCODER, INPUT_EVENT_ENCODER_CW, 0 },
+        { 50, INPUT_TYPE_ENCODER, INPUT_EVENT_ENCODER_CW, 0 },
+    };
+    play(spin, 2, LVGL_LATENCY_EXPIRE_MS / 2);
+
+    lvgl_latency_stats_t stats;
+    lvgl_port_get_latency_stats(&stats);
+    TEST_ASSERT_EQUAL(2, stats.traced);
+    TEST_ASSERT_EQUAL(0, stats.completed);
+    TEST_ASSERT_EQUAL(0, stats.expired);
+
+    play(spin, 0, LVGL_LATENCY_EXPIRE_MS);
+    lvgl_port_get_latency_stats(&stats);
+    TEST_ASSERT_EQUAL(0, stats.completed);
+    TEST_ASSERT_EQUAL(2, stats.expired);
+
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_deinit());
+}
+
+void app_main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_percentile_of_histogram);
+    RUN_TEST(test_scripted_input_is_traced_to_flush);
+    RUN_TEST(test_button_latency_includes_debounce);
+    RUN_TEST(test_events_without_redraw_expire);
+
+    UNITY_END();
+}
@@ -0,0 +1,153 @@
+/**
+ * @file test_js_api_bind.c
+ * @brief Bind-time permission resolution for JavaScript natives
+ */
+
+#include "js_api.h"
+#include "mjs_engine.h"
+#include "mjs.h"
+#include "unity.h"
+#include <string.h>
+
+static int s_calls_tx;
+static int s_calls_rx;
+static int s_calls_log;
+
+static mjs_val_t fake_tx(struct mjs *mjs) { s_calls_tx++; return MJS_TRUE; }
+static mjs_val_t fake_rx(struct mjs *mjs) { s_calls_rx++; return MJS_TRUE; }
+static mjs_val_t fake_log(struct mjs *mjs) { s_calls_log++; return MJS_UNDEFINED; }
+
+static const js_api_binding_t s_bindings[] = {
+    {"t.tune", fake_rx,     JS_PERM_RF_RECEIVE | JS_PERM_RF_TRANSMIT},
+    {"t.receive", fake_rx,  JS_PERM_RF_RECEIVE},
+    {"t.transmit", fake_tx, JS_PERM_RF_TRANSMIT},
+    {"t.log", fake_log,     0},
+};
+#define BINDING_COUNT   (sizeof(s_bindings) / sizeof(s_bindings[0]))
+
+static js_context_t s_ctx;
+
+static void bind_with(uint32_t permissions)
+{
+    memset(&s_ctx, 0, sizeof(s_ctx));
+    s_ctx.mjs = mjs_create();
+    s_ctx.permissions = permissions;
+    s_calls_tx = s_calls_rx = s_calls_log = 0;
+    TEST_ASSERT_NOT_NULL(s_ctx.mjs);
+    TEST_ASSERT_EQUAL(ESP_OK, js_api_bind(&s_ctx, s_bindings, BINDING_COUNT));
+}
+
+static void unbind(void)
+{
+    mjs_destroy(s_ctx.mjs);
+    s_ctx.mjs = NULL;
+}
+
+void test_granted_natives_are_bound_directly(void)
+{
+    bind_with(JS_PERM_RF_RECEIVE | JS_PERM_RF_TRANSMIT);
+
+    // Same global as an unchecked registration: no per-call cost once granted
+    struct mjs *plain = mjs_create();
+    mjs_set_ffi_func(plain, "t.transmit", fake_tx);
+    TEST_ASSERT_TRUE(mjs_get_global(plain, "t.transmit") == mjs_get_global(s_ctx.mjs, "t.transmit"));
+    mjs_destroy(plain);
+
+    TEST_ASSERT_EQUAL(MJS_TRUE, mjs_call_ffi(s_ctx.mjs, "t.transmit"));
+    TEST_ASSERT_EQUAL(MJS_TRUE, mjs_call_ffi(s_ctx.mjs, "t.receive"));
+    TEST_ASSERT_EQUAL(1, s_calls_tx);
+    TEST_ASSERT_EQUAL(1, s_calls_rx);
+    unbind();
+}
+
+void test_denied_natives_throw_without_running(void)
+{
+    bind_with(JS_PERM_RF_RECEIVE);
+
+    mjs_val_t result = mjs_call_ffi(s_ctx.mjs, "t.transmit");
+    TEST_ASSERT_TRUE(mjs_is_error(result));
+    TEST_ASSERT_EQUAL_STRING("Permission denied: requires rf.transmit",
+                             mjs_get_error_message(s_ctx.mjs));
+    TEST_ASSERT_EQUAL(0, s_calls_tx);
+
+    // The rest of the module is still usable
+    TEST_ASSERT_EQUAL(MJS_TRUE, mjs_call_ffi(s_ctx.mjs, "t.receive"));
+    TEST_ASSERT_EQUAL(1, s_calls_rx);
+    unbind();
+}
+
+void test_any_of_and_ungated_natives(void)
+{
+    bind_with(JS_PERM_RF_TRANSMIT);
+    TEST_ASSERT_EQUAL(MJS_TRUE, mjs_call_ffi(s_ctx.mjs, "t.tune"));
+    TEST_ASSERT_TRUE(mjs_is_error(mjs_call_ffi(s_ctx.mjs, "t.receive")));
+    TEST_ASSERT_EQUAL_STRING("Permission denied: requires rf.receive",
+                             mjs_get_error_message(s_ctx.mjs));
+    unbind();
+
+    // No grants at all: an "any of" native names the first permission it accepts
+    bind_with(0);
+    TEST_ASSERT_TRUE(mjs_is_error(mjs_call_ffi(s_ctx.mjs, "t.tune")));
+    TEST_ASSERT_EQUAL_STRING("Permission denied: requires rf.receive",
+                             mjs_get_error_message(s_ctx.mjs));
+    TEST_ASSERT_EQUAL(0, s_calls_rx);
+    TEST_ASSERT_FALSE(mjs_is_error(mjs_call_ffi(s_ctx.mjs, "t.log")));
+    TEST_ASSERT_EQUAL(1, s_calls_log);
+    unbind();
+}
+
+void test_bind_rejects_bad_arguments(void)
+{
+    js_context_t empty = {0};
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, js_api_bind(NULL, s_bindings, BINDING_COUNT));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, js_api_bind(&empty, s_bindings, BINDING_COUNT));
+
+    bind_with(0);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, js_api_bind(&s_ctx, NULL, 1));
+    TEST_ASSERT_EQUAL(ESP_OK, js_api_bind(&s_ctx, NULL, 0));
+    TEST_ASSERT_TRUE(mjs_is_error(mjs_call_ffi(s_ctx.mjs, "t.missing")));
+    TEST_ASSERT_EQUAL_STRING("t.missing is not a function", mjs_get_error_message(s_ctx.mjs));
+    unbind();
+}
+
+void test_rf_module_gates_transmit(void)
+{
+    // A receive-only app never reaches the driver's transmit path
+    memset(&s_ctx, 0, sizeof(s_ctx));
+    s_ctx.mjs = mjs_create();
+    s_ctx.permissions = JS_PERM_RF_RECEIVE | JS_PERM_UI_CREATE;
+    TEST_ASSERT_EQUAL(ESP_OK, js_rf_api_register(&s_ctx));
+
+    const char *transmit_natives[] = {"rf.transmit", "rf.startJammer", "rf.stopJammer"};
+    for (size_t i = 0; i < sizeof(transmit_natives) / sizeof(transmit_natives[0]); i++) {
+        TEST_ASSERT_TRUE(mjs_is_error(mjs_call_ffi(s_ctx.mjs, transmit_natives[i])));
+        TEST_ASSERT_EQUAL_STRING("Permission denied: requires rf.transmit",
+                                 mjs_get_error_message(s_ctx.mjs));
+    }
+    unbind();
+}
+
+void test_check_permission_by_name(void)
+{
+    js_context_t ctx = {0};
+    ctx.permissions = JS_PERM_STORAGE_READ | JS_PERM_NETWORK;
+
+    TEST_ASSERT_TRUE(mjs_engine_check_permission(&ctx, "storage.read"));
+    TEST_ASSERT_TRUE(mjs_engine_check_permission(&ctx, "network"));
+    TEST_ASSERT_FALSE(mjs_engine_check_permission(&ctx, "storage.write"));
+    TEST_ASSERT_FALSE(mjs_engine_check_permission(&ctx, "rf"));
+    TEST_ASSERT_FALSE(mjs_engine_check_permission(NULL, "network"));
+}
+
+void app_main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_granted_natives_are_bound_directly);
+    RUN_TEST(test_denied_natives_throw_without_running);
+    RUN_TEST(test_any_of_and_ungated_natives);
+    RUN_TEST(test_bind_rejects_bad_arguments);
+    RUN_TEST(test_rf_module_gates_transmit);
+    RUN_TEST(test_check_permission_by_name);
+
+    UNITY_END();
+}
@@ -0,0 +1,111 @@
+/**
+ * @file test_js_input_api.c
+ * @brief Encoder steps reach the foreground app's handler with their summed delta
+ */
+
+#include "js_api.h"
+#include "event_bus.h"
+#include "lvgl_port.h"
+#include "mjs_engine.h"
+#include "mjs.h"
+#include "unity.h"
+#include <string.h>
+
+static int s_calls;
+static double s_delta;
+static double s_count;
+
+// Stands in for the app's handler; arguments arrive as input.* globals
+static mjs_val_t record_encoder(struct mjs *mjs)
+{
+    s_calls++;
+    s_delta = mjs_get_double(mjs, mjs_get_global(mjs, "input.delta"));
+    s_count = mjs_get_double(mjs, mjs_get_global(mjs, "input.count"));
+    return MJS_UNDEFINED;
+}
+
+static void post_encoder(int16_t delta, uint16_t count)
+{
+    event_input_t input = {
+        .type = INPUT_TYPE_ENCODER,
+        .event = delta > 0 ? INPUT_EVENT_ENCODER_CW : INPUT_EVENT_ENCODER_CCW,
+        .delta = delta,
+        .count = count,
+    };
+    event_publish_input(&input, EVENT_PRIO_URGENT);
+}
+
+static js_context_t *create_app(void)
+{
+    js_context_t *ctx = mjs_engine_create_context(0);
+    TEST_ASSERT_NOT_NULL(ctx);
+    TEST_ASSERT_EQUAL(ESP_OK, js_input_api_register(ctx));
+
+    // The handler argument names the global to call
+    char handler[32];
+    TEST_ASSERT_EQUAL(ESP_OK, js_get_string_arg(ctx->mjs, 0, handler, sizeof(handler)));
+    mjs_set_ffi_func(ctx->mjs, handler, record_encoder);
+    TEST_ASSERT_FALSE(mjs_is_error(mjs_call_ffi(ctx->mjs, "input.onEncoder")));
+
+    s_calls = 0;
+    return ctx;
+}
+
+void test_steps_between_deliveries_are_summed(void)
+{
+    js_context_t *ctx = create_app();
+
+    // Three frames of a fast spin, then a button that carries no steps
+    post_encoder(1, 1);
+    post_encoder(4, 2);
+    post_encoder(10, 3);
+    event_input_t button = { .type = INPUT_TYPE_BUTTON, .event = INPUT_EVENT_PRESS };
+    event_publish_input(&button, EVENT_PRIO_URGENT);
+
+    TEST_ASSERT_EQUAL(6, js_input_api_deliver(ctx));
+    TEST_ASSERT_EQUAL(1, s_calls);
+    TEST_ASSERT_EQUAL(15, (int)s_delta);
+    TEST_ASSERT_EQUAL(6, (int)s_count);
+
+    // Nothing new: no call
+    TEST_ASSERT_EQUAL(0, js_input_api_deliver(ctx));
+    TEST_ASSERT_EQUAL(1, s_calls);
+
+    post_encoder(-3, 3);
+    TEST_ASSERT_EQUAL(3, js_input_api_deliver(ctx));
+    TEST_ASSERT_EQUAL(2, s_calls);
+    TEST_ASSERT_EQUAL(-3, (int)s_delta);
+
+    mjs_engine_destroy_context(ctx);
+}
+
+void test_steps_without_foreground_are_discarded(void)
+{
+    js_context_t *ctx = create_app();
+
+    post_encoder(5, 5);
+    TEST_ASSERT_EQUAL(0, js_input_api_deliver(NULL));
+    TEST_ASSERT_EQUAL(0, js_input_api_deliver(ctx));
+    TEST_ASSERT_EQUAL(0, s_calls);
+
+    // A reversal that cancels out within one period moves nothing
+    post_encoder(2, 2);
+    post_encoder(-2, 2);
+    TEST_ASSERT_EQUAL(0, js_input_api_deliver(ctx));
+    TEST_ASSERT_EQUAL(0, s_calls);
+
+    mjs_engine_destroy_context(ctx);
+}
+
+void app_main(void) {
+    UNITY_BEGIN();
+
+    TEST_ASSERT_EQUAL(ESP_OK, mjs_engine_init());
+    TEST_ASSERT_EQUAL(ESP_OK, js_input_api_init());
+
+    RUN_TEST(test_steps_between_deliveries_are_summed);
+    RUN_TEST(test_steps_without_foreground_are_discarded);
+
+    mjs_engine_deinit();
+    UNITY_END();
+}
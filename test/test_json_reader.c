@@ -0,0 +1,416 @@
+/**
+ * @file test_json_reader.c
+ * @brief JSON tokenizer and schema reader: grammar, schema checks, fuzzing and speed (host)
+ *
+ * Build with -fsanitize=address,undefined: every fuzzed document sits in a
+ * buffer of exactly its own size, so any read past the end is caught.
+ */
+
+#include "json_reader.h"
+#include "mjs_engine.h"
+#include "unity.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FUZZ_MUTATIONS      200000
+#define FUZZ_GENERATED      20000
+#define BENCH_BYTES         (4 * 1024 * 1024)
+
+// Mirrors the manifest schema in mjs_native_api.c
+static const json_field_t s_manifest_fields[] = {
+    JSON_FIELD_STRING(js_app_manifest_t, name, "name", true),
+    JSON_FIELD_STRING(js_app_manifest_t, version, "version", true),
+    JSON_FIELD_STRING(js_app_manifest_t, author, "author", false),
+    JSON_FIELD_STRING(js_app_manifest_t, description, "description", false),
+    JSON_FIELD_STRING(js_app_manifest_t, entry_point, "entry_point", true),
+    JSON_FIELD_STRING(js_app_manifest_t, entry_point, "main", false),
+    JSON_FIELD_STRING_LIST(js_app_manifest_t, permissions, "permissions", false),
+    JSON_FIELD_UINT(js_app_manifest_t, memory_limit, "memory_limit", false, 0, 1024 * 1024),
+    JSON_FIELD_BOOL(js_app_manifest_t, has_icon, "has_icon", false),
+};
+#define MANIFEST_FIELDS (sizeof(s_manifest_fields) / sizeof(s_manifest_fields[0]))
+
+// What sdk/tools/build-app.js writes with --minify
+static const char *s_minified =
+    "{\"manifest_version\":\"1.0\",\"name\":\"rf-scanner\",\"description\":\"Advanced RF signal "
+    "scanner\",\"version\":\"1.0.0\",\"author\":\"T-Embed SDK Team\",\"main\":\"app.js\","
+    "\"permissions\":[\"rf.receive\",\"rf.transmit\",\"ui.create\",\"storage.write\"],"
+    "\"icon\":\"app.png\",\"category\":\"rf\",\"_build\":{\"timestamp\":\"2026-01-01T00:00:00Z\","
+    "\"version\":\"1.0.0\",\"minified\":true,\"sizes\":[1,2.5,-3e2]}}";
+
+// What sdk/tools/pack-app.js puts in a package
+static const char *s_device =
+    "{\n  \"name\": \"Packed \\\"quoted\\\" \\u00e9\\ud83d\\ude00\",\n  \"version\": \"1.2.0\",\n"
+    "  \"author\": \"Tester\",\n  \"entry_point\": \"index.js\",\n"
+    "  \"permissions\": \"ui.create,rf.receive\",\n  \"memory_limit\": 32768,\n"
+    "  \"has_icon\": true\n}\n";
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static esp_err_t read_manifest(const char *json, js_app_manifest_t *manifest, json_error_t *error)
+{
+    memset(manifest, 0, sizeof(*manifest));
+    return json_read_object(json, strlen(json), s_manifest_fields, MANIFEST_FIELDS, manifest, error);
+}
+
+// Reads a whole document; returns the last token type (JSON_END or JSON_ERROR)
+static json_token_type_t tokenize(const char *json, size_t len, int *tokens)
+{
+    json_reader_t reader;
+    json_token_t token;
+    json_token_type_t type;
+    int count = 0;
+
+    json_reader_init(&reader, json, len);
+    while ((type = json_next(&reader, &token)) != JSON_END && type != JSON_ERROR) {
+        count++;
+        TEST_ASSERT_TRUE(count <= (int)len);
+    }
+    if (tokens) {
+        *tokens = count;
+    }
+    return type;
+}
+
+void test_tokens(void)
+{
+    static const char *json = " {\"a\" : [1, -0.5e+3, \"x\\ny\", true, false, null, {}, []], \"b\":{\"c\":0}} ";
+    static const json_token_type_t expected[] = {
+        JSON_OBJECT, JSON_KEY, JSON_ARRAY, JSON_NUMBER, JSON_NUMBER, JSON_STRING, JSON_TRUE, JSON_FALSE,
+        JSON_NULL, JSON_OBJECT, JSON_OBJECT_END, JSON_ARRAY, JSON_ARRAY_END, JSON_ARRAY_END, JSON_KEY,
+        JSON_OBJECT, JSON_KEY, JSON_NUMBER, JSON_OBJECT_END, JSON_OBJECT_END, JSON_END, JSON_END,
+    };
+    json_reader_t reader;
+    json_token_t token;
+    json_reader_init(&reader, json, strlen(json));
+
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+        TEST_ASSERT_EQUAL(expected[i], json_next(&reader, &token));
+        if (i == 4) {
+            TEST_ASSERT_FALSE(token.integer);
+            TEST_ASSERT_EQUAL(7, token.len);
+        }
+        if (i == 5) {
+            char text[8];
+            TEST_ASSERT_TRUE(token.escaped);
+            TEST_ASSERT_EQUAL(3, json_string_copy(&token, text, sizeof(text)));
+            TEST_ASSERT_EQUAL_STRING("x\ny", text);
+        }
+    }
+
+    // Skipping a container lands after its close
+    json_reader_init(&reader, json, strlen(json));
+    json_next(&reader, &token);
+    json_next(&reader, &token);
+    json_next(&reader, &token);
+    TEST_ASSERT_TRUE(json_skip(&reader, &token));
+    TEST_ASSERT_EQUAL(JSON_KEY, json_next(&reader, &token));
+    TEST_ASSERT_TRUE(json_string_equals(&token, "b"));
+
+    int64_t value;
+    json_token_t number = { .type = JSON_NUMBER, .text = "-9223372036854775808", .len = 20, .integer = true };
+    TEST_ASSERT_TRUE(json_number_to_int(&number, &value));
+    TEST_ASSERT_TRUE(value == INT64_MIN);
+    number.text = "9223372036854775808";
+    number.len = 19;
+    TEST_ASSERT_FALSE(json_number_to_int(&number, &value));
+}
+
+void test_read_manifests(void)
+{
+    js_app_manifest_t manifest;
+    json_error_t error;
+
+    TEST_ASSERT_EQUAL(ESP_OK, read_manifest(s_minified, &manifest, &error));
+    TEST_ASSERT_EQUAL_STRING("rf-scanner", manifest.name);
+    TEST_ASSERT_EQUAL_STRING("1.0.0", manifest.version);
+    TEST_ASSERT_EQUAL_STRING("app.js", manifest.entry_point);
+    TEST_ASSERT_EQUAL_STRING("rf.receive,rf.transmit,ui.create,storage.write", manifest.permissions);
+    TEST_ASSERT_EQUAL(0, manifest.memory_limit);
+    TEST_ASSERT_FALSE(manifest.has_icon);
+
+    TEST_ASSERT_EQUAL(ESP_OK, read_manifest(s_device, &manifest, &error));
+    TEST_ASSERT_EQUAL_STRING("Packed \"quoted\" \xc3\xa9\xf0\x9f\x98\x80", manifest.name);
+    TEST_ASSERT_EQUAL_STRING("index.js", manifest.entry_point);
+    TEST_ASSERT_EQUAL_STRING("ui.create,rf.receive", manifest.permissions);
+    TEST_ASSERT_EQUAL(32768, manifest.memory_limit);
+    TEST_ASSERT_TRUE(manifest.has_icon);
+
+    // Escaped keys match, null is absent, a repeated key wins
+    TEST_ASSERT_EQUAL(ESP_OK, read_manifest("{\"n\\u0061me\":\"a\",\"version\":\"1\",\"main\":\"m.js\","
+                                            "\"author\":null,\"version\":\"2\"}", &manifest, &error));
+    TEST_ASSERT_EQUAL_STRING("a", manifest.name);
+    TEST_ASSERT_EQUAL_STRING("2", manifest.version);
+    TEST_ASSERT_EQUAL_STRING("", manifest.author);
+}
+
+void test_schema_violations(void)
+{
+    static const struct {
+        const char *json;
+        esp_err_t ret;
+        const char *key;
+    } cases[] = {
+        { "{\"version\":\"1\",\"main\":\"a.js\"}", ESP_ERR_NOT_FOUND, "name" },
+        { "{\"name\":\"\",\"version\":\"1\",\"main\":\"a.js\"}", ESP_ERR_NOT_FOUND, "name" },
+        { "{\"name\":\"a\",\"version\":\"1\"}", ESP_ERR_NOT_FOUND, "entry_point" },
+        { "{\"name\":\"a\",\"version\":\"1\",\"main\":null}", ESP_ERR_NOT_FOUND, "entry_point" },
+        { "{\"name\":1,\"version\":\"1\",\"main\":\"a.js\"}", ESP_ERR_INVALID_ARG, "name" },
+        { "{\"name\":\"0123456789012345678901234567890123\",\"version\":\"1\",\"main\":\"a\"}",
+          ESP_ERR_INVALID_SIZE, "name" },
+        { "{\"name\":\"a\",\"version\":\"1\",\"main\":\"a\",\"memory_limit\":-1}", ESP_ERR_INVALID_ARG, "memory_limit" },
+        { "{\"name\":\"a\",\"version\":\"1\",\"main\":\"a\",\"memory_limit\":2097152}", ESP_ERR_INVALID_ARG, "memory_limit" },
+        { "{\"name\":\"a\",\"version\":\"1\",\"main\":\"a\",\"memory_limit\":1.5}", ESP_ERR_INVALID_ARG, "memory_limit" },
+        { "{\"name\":\"a\",\"version\":\"1\",\"main\":\"a\",\"has_icon\":1}", ESP_ERR_INVALID_ARG, "has_icon" },
+        { "{\"name\":\"a\",\"version\":\"1\",\"main\":\"a\",\"permissions\":[\"a\",2]}", ESP_ERR_INVALID_ARG, "permissions" },
+        { "{\"name\":\"a\",\"version\":\"1\",\"main\":\"a\",\"permissions\":[\"a,b\"]}", ESP_ERR_INVALID_ARG, "permissions" },
+        { "{\"name\":\"a\",\"version\":\"1\",\"main\":\"a\",\"permissions\":[\"\"]}", ESP_ERR_INVALID_ARG, "permissions" },
+        { "{\"name\":\"\\ud800\",\"version\":\"1\",\"main\":\"a\"}", ESP_ERR_INVALID_ARG, "name" },
+        { "{\"name\":\"\\u0000\",\"version\":\"1\",\"main\":\"a\"}", ESP_ERR_INVALID_ARG, "name" },
+        { "[]", ESP_ERR_INVALID_ARG, NULL },
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        js_app_manifest_t manifest;
+        json_error_t error;
+        TEST_ASSERT_EQUAL(cases[i].ret, read_manifest(cases[i].json, &manifest, &error));
+        if (cases[i].key) {
+            TEST_ASSERT_EQUAL_STRING(cases[i].key, error.key);
+        }
+        TEST_ASSERT_NOT_NULL(error.reason);
+    }
+
+    // A list that overflows its member
+    char json[600];
+    int len = snprintf(json, sizeof(json), "{\"name\":\"a\",\"version\":\"1\",\"main\":\"a\",\"permissions\":[");
+    for (int i = 0; i < 25; i++) {
+        len += snprintf(json + len, sizeof(json) - len, "%s\"storage.write\"", i ? "," : "");
+    }
+    snprintf(json + len, sizeof(json) - len, "]}");
+    js_app_manifest_t manifest;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, read_manifest(json, &manifest, NULL));
+    TEST_ASSERT_TRUE(strlen(manifest.permissions) < sizeof(manifest.permissions));
+}
+
+void test_grammar(void)
+{
+    static const char *valid[] = {
+        "0", "-0", "1.5e-3", "\"\"", "true", "null", "[]", "{}", " [ 1 , [ ] , { } ] ",
+        "{\"\":\"\\\"\\\\\\/\\b\\f\\n\\r\\t\\u0041\"}", "[\"\\ud83d\\ude00\"]",
+    };
+    static const char *invalid[] = {
+        "", " ", "{", "[", "}", "]", "[1,]", "{\"a\":1,}", "{,}", "[,1]", "{\"a\" 1}", "{\"a\":}",
+        "{1:2}", "{'a':1}", "[01]", "[1.]", "[.5]", "[1e]", "[-]", "[+1]", "[0x10]", "[NaN]",
+        "[tru]", "[nul]", "[True]", "\"abc", "\"a\\x\"", "\"\\u12\"", "\"\\u12G4\"", "\"a\tb\"",
+        "[1]x", "{}{}", "[1 2]", "{\"a\":1 \"b\":2}", "[\"a\":1]", "{\"a\"}", "[}", "{]",
+    };
+
+    for (size_t i = 0; i < sizeof(valid) / sizeof(valid[0]); i++) {
+        TEST_ASSERT_EQUAL(JSON_END, tokenize(valid[i], strlen(valid[i]), NULL));
+    }
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        TEST_ASSERT_EQUAL(JSON_ERROR, tokenize(invalid[i], strlen(invalid[i]), NULL));
+    }
+
+    // Embedded NUL, and a document that stops short of its buffer
+    TEST_ASSERT_EQUAL(JSON_ERROR, tokenize("\"a\0b\"", 5, NULL));
+    TEST_ASSERT_EQUAL(JSON_END, tokenize("[1]garbage", 3, NULL));
+
+    // Depth limit
+    char deep[2 * JSON_MAX_DEPTH + 3];
+    for (int depth = JSON_MAX_DEPTH; depth <= JSON_MAX_DEPTH + 1; depth++) {
+        memset(deep, '[', depth);
+        memset(deep + depth, ']', depth);
+        TEST_ASSERT_EQUAL(depth <= JSON_MAX_DEPTH ? JSON_END : JSON_ERROR, tokenize(deep, 2 * depth, NULL));
+    }
+}
+
+static uint32_t s_rng = 12345;
+
+static uint32_t rnd(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+// Random valid JSON; counts the tokens the reader should produce
+static int generate(char *buf, int pos, int size, int depth, int *tokens)
+{
+    static const char *scalars[] = {
+        "0", "-12", "3.25", "1e9", "-0.5E-2", "true", "false", "null", "\"\"", "\"plain\"",
+        "\"esc\\\"\\\\\\n\"", "\"\\u00e9\\ud83d\\ude00\"",
+    };
+    int kind = depth >= 6 ? 2 : (int)(rnd() % 3);
+    (*tokens)++;
+
+    if (kind == 2 || size - pos < 64) {
+        const char *s = scalars[rnd() % (sizeof(scalars) / sizeof(scalars[0]))];
+        return pos + snprintf(buf + pos, size - pos, "%s", s);
+    }
+
+    bool object = kind == 0;
+    int count = (int)(rnd() % 5);
+    buf[pos++] = object ? '{' : '[';
+    for (int i = 0; i < count && size - pos > 64; i++) {
+        if (i) {
+            buf[pos++] = ',';
+        }
+        if (rnd() % 4 == 0) {
+            buf[pos++] = ' ';
+        }
+        if (object) {
+            pos += snprintf(buf + pos, size - pos, "\"k%d\":", i);
+            (*tokens)++;
+        }
+        pos = generate(buf, pos, size, depth + 1, tokens);
+    }
+    buf[pos++] = object ? '}' : ']';
+    (*tokens)++;
+    return pos;
+}
+
+void test_fuzz_generated_documents(void)
+{
+    char buf[4096];
+    for (int i = 0; i < FUZZ_GENERATED; i++) {
+        int expected = 0;
+        int len = generate(buf, 0, sizeof(buf) - 8, 0, &expected);
+        char *doc = malloc(len);
+        memcpy(doc, buf, len);
+
+        int tokens;
+        TEST_ASSERT_EQUAL(JSON_END, tokenize(doc, len, &tokens));
+        TEST_ASSERT_EQUAL(expected, tokens);
+        free(doc);
+    }
+}
+
+static void check_strings(const js_app_manifest_t *manifest)
+{
+    TEST_ASSERT_TRUE(memchr(manifest->name, '\0', sizeof(manifest->name)) != NULL);
+    TEST_ASSERT_TRUE(memchr(manifest->version, '\0', sizeof(manifest->version)) != NULL);
+    TEST_ASSERT_TRUE(memchr(manifest->author, '\0', sizeof(manifest->author)) != NULL);
+    TEST_ASSERT_TRUE(memchr(manifest->description, '\0', sizeof(manifest->description)) != NULL);
+    TEST_ASSERT_TRUE(memchr(manifest->entry_point, '\0', sizeof(manifest->entry_point)) != NULL);
+    TEST_ASSERT_TRUE(memchr(manifest->permissions, '\0', sizeof(manifest->permissions)) != NULL);
+}
+
+void test_fuzz_mutated_manifests(void)
+{
+    static const char structural[] = "{}[]\":,\\ -0123456789.eEtfnu";
+    const char *seeds[] = { s_minified, s_device };
+    char buf[1024];
+    int accepted = 0;
+
+    for (int i = 0; i < FUZZ_MUTATIONS; i++) {
+        const char *seed = seeds[i & 1];
+        size_t len = strlen(seed);
+        memcpy(buf, seed, len);
+
+        for (int m = 1 + rnd() % 4; m > 0 && len > 1; m--) {
+            size_t at = rnd() % len;
+            switch (rnd() % 5) {
+            case 0: buf[at] ^= (char)(1 << (rnd() % 8)); break;
+            case 1: buf[at] = structural[rnd() % (sizeof(structural) - 1)]; break;
+            case 2: memmove(buf + at, buf + at + 1, len - at - 1); len--; break;
+            case 3:
+                if (len < sizeof(buf)) {
+                    memmove(buf + at + 1, buf + at, len - at);
+                    buf[at] = structural[rnd() % (sizeof(structural) - 1)];
+                    len++;
+                }
+                break;
+            default: len = at + 1; break;
+            }
+        }
+
+        // Exact-size copy so the sanitizer sees any over-read
+        char *doc = malloc(len);
+        memcpy(doc, buf, len);
+        struct {
+            uint32_t before;
+            js_app_manifest_t manifest;
+            uint32_t after;
+        } guarded = { .before = 0xA5A5A5A5, .after = 0x5A5A5A5A };
+
+        json_error_t error;
+        esp_err_t ret = json_read_object(doc, len, s_manifest_fields, MANIFEST_FIELDS,
+                                         &guarded.manifest, &error);
+        TEST_ASSERT_EQUAL_HEX32(0xA5A5A5A5, guarded.before);
+        TEST_ASSERT_EQUAL_HEX32(0x5A5A5A5A, guarded.after);
+        if (ret == ESP_OK) {
+            accepted++;
+            check_strings(&guarded.manifest);
+        } else {
+            TEST_ASSERT_NOT_NULL(error.reason);
+            TEST_ASSERT_TRUE(error.offset <= len);
+        }
+        tokenize(doc, len, NULL);
+        free(doc);
+    }
+    printf("fuzz: %d mutated manifests, %d still valid\n", FUZZ_MUTATIONS, accepted);
+}
+
+void test_benchmark_large_manifest(void)
+{
+    // A large manifest: the fields the device wants at the end, after a
+    // long tail of build metadata it skips
+    char *json = malloc(BENCH_BYTES + 1024);
+    int len = snprintf(json, 64, "{\"_build\":{\"files\":[");
+    for (int i = 0; len < BENCH_BYTES; i++) {
+        len += sprintf(json + len, "%s{\"path\":\"lib/module_%d.js\",\"size\":%d,\"hash\":\"%08x\","
+                       "\"deps\":[\"ui\",\"rf\",\"storage\"],\"minified\":true,\"ratio\":0.%d}",
+                       i ? "," : "", i, 1000 + i, (unsigned)(i * 2654435761u), i % 100);
+    }
+    len += sprintf(json + len, "]},%s", s_minified + 1);
+
+    js_app_manifest_t manifest;
+    int tokens = 0;
+    double start = now_us();
+    TEST_ASSERT_EQUAL(JSON_END, tokenize(json, len, &tokens));
+    double tokenize_us = now_us() - start;
+
+    start = now_us();
+    TEST_ASSERT_EQUAL(ESP_OK, json_read_object(json, len, s_manifest_fields, MANIFEST_FIELDS, &manifest, NULL));
+    double read_us = now_us() - start;
+    TEST_ASSERT_EQUAL_STRING("rf.receive,rf.transmit,ui.create,storage.write", manifest.permissions);
+
+    printf("large manifest, %d KB, %d tokens:\n", len / 1024, tokens);
+    printf("  tokenize      %7.1f MB/s, %5.1f ns/token\n", len / tokenize_us, tokenize_us * 1000 / tokens);
+    printf("  read struct   %7.1f MB/s\n", len / read_us);
+
+    // The typical case: one minified manifest, start to finish
+    const int runs = 100000;
+    size_t small = strlen(s_minified);
+    start = now_us();
+    for (int i = 0; i < runs; i++) {
+        json_read_object(s_minified, small, s_manifest_fields, MANIFEST_FIELDS, &manifest, NULL);
+    }
+    double per_us = (now_us() - start) / runs;
+    printf("  %u byte manifest: %.2f us per read, no allocation, %u bytes of reader state\n",
+           (unsigned)small, per_us, (unsigned)sizeof(json_reader_t));
+    free(json);
+}
+
+void app_main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_tokens);
+    RUN_TEST(test_read_manifests);
+    RUN_TEST(test_schema_violations);
+    RUN_TEST(test_grammar);
+    RUN_TEST(test_fuzz_generated_documents);
+    RUN_TEST(test_fuzz_mutated_manifests);
+    RUN_TEST(test_benchmark_large_manifest);
+
+    UNITY_END();
+}
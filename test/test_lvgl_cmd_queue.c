@@ -0,0 +1,270 @@
+/**
+ * @file test_lvgl_cmd_queue.c
+ * @brief UI command queue tests and host pthreads stress test
+ *
+ * Several producer threads stand in for JS contexts posting UI updates
+ * while one consumer thread plays the UI task. Every command must be
+ * applied exactly once and in per-producer order. The same workload is
+ * then run through a single mutex for comparison.
+ */
+
+#include "lvgl_port.h"
+#include "unity.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define PRODUCERS           4
+#define CMDS_PER_PRODUCER   200000
+
+static uint32_t s_next_seq[PRODUCERS];
+static uint32_t s_order_errors;
+static atomic_uint s_producers_done;
+static uint32_t s_retries[PRODUCERS];
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+// Stands in for an LVGL update: checks ordering per producer
+static void record_cmd(const lvgl_ui_cmd_t *cmd)
+{
+    int producer = cmd->arg[0];
+    if ((uint32_t)cmd->arg[1] != s_next_seq[producer]) {
+        s_order_errors++;
+    }
+    s_next_seq[producer] = cmd->arg[1] + 1;
+}
+
+void test_fifo_and_full_queue(void)
+{
+    lvgl_cmd_reset();
+
+    for (int i = 0; i < LVGL_CMD_QUEUE_LEN; i++) {
+        lvgl_ui_cmd_t cmd = { .fn = record_cmd, .arg = { 0, i } };
+        TEST_ASSERT_EQUAL(ESP_OK, lvgl_cmd_push(&cmd));
+    }
+
+    lvgl_ui_cmd_t extra = { .fn = record_cmd };
+    TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, lvgl_cmd_push(&extra));
+
+    lvgl_ui_cmd_t cmd;
+    for (int i = 0; i < LVGL_CMD_QUEUE_LEN; i++) {
+        TEST_ASSERT_TRUE(lvgl_cmd_pop(&cmd));
+        TEST_ASSERT_EQUAL(i, cmd.arg[1]);
+    }
+    TEST_ASSERT_FALSE(lvgl_cmd_pop(&cmd));
+
+    lvgl_lock_stats_t stats;
+    lvgl_cmd_get_stats(&stats);
+    TEST_ASSERT_EQUAL(LVGL_CMD_QUEUE_LEN, stats.cmds_posted);
+    TEST_ASSERT_EQUAL(1, stats.cmds_rejected);
+    TEST_ASSERT_EQUAL(LVGL_CMD_QUEUE_LEN, stats.cmd_queue_max_depth);
+}
+
+void test_rejects_invalid_commands(void)
+{
+    char long_text[LVGL_CMD_TEXT_MAX + 8];
+    memset(long_text, 'x', sizeof(long_text) - 1);
+    long_text[sizeof(long_text) - 1] = '\0';
+
+    lvgl_ui_cmd_t no_fn = {0};
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, lvgl_cmd_push(&no_fn));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, lvgl_port_post_label_text(NULL, "x"));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE,
+                      lvgl_port_post_label_text((lv_obj_t *)long_text, long_text));
+}
+
+void test_full_queue_keeps_order(void)
+{
+    lvgl_cmd_reset();
+    memset(s_next_seq, 0, sizeof(s_next_seq));
+    s_order_errors = 0;
+
+    for (int i = 0; i < LVGL_CMD_QUEUE_LEN; i++) {
+        lvgl_ui_cmd_t cmd = { .fn = record_cmd, .arg = { 0, i } };
+        TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_post(&cmd));
+    }
+
+    // The queued commands are applied ahead of the one that did not fit
+    lvgl_ui_cmd_t late = { .fn = record_cmd, .arg = { 0, LVGL_CMD_QUEUE_LEN } };
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_post_ordered(&late));
+    TEST_ASSERT_EQUAL(LVGL_CMD_QUEUE_LEN, s_next_seq[0]);
+    TEST_ASSERT_EQUAL(1, lvgl_port_apply_commands());
+    TEST_ASSERT_EQUAL(LVGL_CMD_QUEUE_LEN + 1, s_next_seq[0]);
+    TEST_ASSERT_EQUAL(0, s_order_errors);
+}
+
+void test_deleted_objects_are_dropped(void)
+{
+    lvgl_cmd_reset();
+    memset(s_next_seq, 0, sizeof(s_next_seq));
+
+    lvgl_port_lock();
+    lv_obj_t *live = lv_obj_create(NULL);
+    lv_obj_t *deleted = lv_obj_create(NULL);
+    lvgl_port_cmd_target(live);
+    lvgl_port_cmd_target(deleted);
+    lvgl_port_unlock();
+
+    lvgl_ui_cmd_t cmd = { .fn = record_cmd, .obj = deleted, .arg = { 0, 0 } };
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_post(&cmd));
+    cmd.obj = live;
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_post(&cmd));
+
+    // A new object in the deleted one's memory gets none of its commands
+    lvgl_port_lock();
+    lv_obj_del(deleted);
+    lv_obj_t *reused = lv_obj_create(NULL);
+    lvgl_port_cmd_target(reused);
+    TEST_ASSERT_EQUAL(2, lvgl_port_apply_commands());
+    lv_obj_del(reused);
+    lv_obj_del(live);
+    lvgl_port_unlock();
+
+    lvgl_lock_stats_t stats;
+    lvgl_cmd_get_stats(&stats);
+    TEST_ASSERT_EQUAL(1, s_next_seq[0]);
+    TEST_ASSERT_EQUAL(1, stats.cmds_stale);
+}
+
+static void *producer_thread(void *arg)
+{
+    int id = (int)(intptr_t)arg;
+
+    for (uint32_t seq = 0; seq < CMDS_PER_PRODUCER; seq++) {
+        lvgl_ui_cmd_t cmd = { .fn = record_cmd, .arg = { id, (int32_t)seq } };
+        while (lvgl_cmd_push(&cmd) != ESP_OK) {
+            s_retries[id]++;
+            sched_yield();
+        }
+    }
+
+    atomic_fetch_add(&s_producers_done, 1);
+    return NULL;
+}
+
+static void *consumer_thread(void *arg)
+{
+    (void)arg;
+
+    // Drain in frame-sized batches until every producer has finished
+    for (;;) {
+        bool done = atomic_load(&s_producers_done) == PRODUCERS;
+        if (lvgl_port_apply_commands() == 0) {
+            if (done) {
+                break;
+            }
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+void test_stress_lock_free_queue(void)
+{
+    pthread_t producers[PRODUCERS], consumer;
+
+    lvgl_cmd_reset();
+    memset(s_next_seq, 0, sizeof(s_next_seq));
+    memset(s_retries, 0, sizeof(s_retries));
+    s_order_errors = 0;
+    atomic_store(&s_producers_done, 0);
+
+    uint64_t start = now_us();
+    pthread_create(&consumer, NULL, consumer_thread, NULL);
+    for (int i = 0; i < PRODUCERS; i++) {
+        pthread_create(&producers[i], NULL, producer_thread, (void *)(intptr_t)i);
+    }
+    for (int i = 0; i < PRODUCERS; i++) {
+        pthread_join(producers[i], NULL);
+    }
+    pthread_join(consumer, NULL);
+    uint64_t elapsed = now_us() - start;
+
+    lvgl_lock_stats_t stats;
+    lvgl_cmd_get_stats(&stats);
+
+    uint32_t retries = 0;
+    for (int i = 0; i < PRODUCERS; i++) {
+        TEST_ASSERT_EQUAL(CMDS_PER_PRODUCER, s_next_seq[i]);
+        retries += s_retries[i];
+    }
+
+    printf("queue: %u cmds in %llu us (%.1f Mcmd/s), %u full retries, max depth %u\n",
+           stats.cmds_applied, (unsigned long long)elapsed,
+           (double)stats.cmds_applied / elapsed, retries, stats.cmd_queue_max_depth);
+
+    TEST_ASSERT_EQUAL(0, s_order_errors);
+    TEST_ASSERT_EQUAL(PRODUCERS * CMDS_PER_PRODUCER, stats.cmds_posted);
+    TEST_ASSERT_EQUAL(PRODUCERS * CMDS_PER_PRODUCER, stats.cmds_applied);
+    TEST_ASSERT_EQUAL(retries, stats.cmds_rejected);
+}
+
+// Baseline: every producer takes one global mutex per update
+
+static pthread_mutex_t s_mutex = PTHREAD_MUTEX_INITIALIZER;
+static atomic_ullong s_mutex_wait_us;
+static atomic_uint s_mutex_contended;
+
+static void *mutex_producer_thread(void *arg)
+{
+    int id = (int)(intptr_t)arg;
+
+    for (uint32_t seq = 0; seq < CMDS_PER_PRODUCER; seq++) {
+        lvgl_ui_cmd_t cmd = { .fn = record_cmd, .arg = { id, (int32_t)seq } };
+        if (pthread_mutex_trylock(&s_mutex) != 0) {
+            uint64_t t0 = now_us();
+            pthread_mutex_lock(&s_mutex);
+            atomic_fetch_add(&s_mutex_wait_us, now_us() - t0);
+            atomic_fetch_add(&s_mutex_contended, 1);
+        }
+        cmd.fn(&cmd);
+        pthread_mutex_unlock(&s_mutex);
+    }
+    return NULL;
+}
+
+void test_stress_global_mutex_baseline(void)
+{
+    pthread_t producers[PRODUCERS];
+
+    memset(s_next_seq, 0, sizeof(s_next_seq));
+    s_order_errors = 0;
+    atomic_store(&s_mutex_wait_us, 0);
+    atomic_store(&s_mutex_contended, 0);
+
+    uint64_t start = now_us();
+    for (int i = 0; i < PRODUCERS; i++) {
+        pthread_create(&producers[i], NULL, mutex_producer_thread, (void *)(intptr_t)i);
+    }
+    for (int i = 0; i < PRODUCERS; i++) {
+        pthread_join(producers[i], NULL);
+    }
+    uint64_t elapsed = now_us() - start;
+
+    printf("mutex: %u cmds in %llu us, %u contended, %llu us total wait\n",
+           PRODUCERS * CMDS_PER_PRODUCER, (unsigned long long)elapsed,
+           atomic_load(&s_mutex_contended), (unsigned long long)atomic_load(&s_mutex_wait_us));
+
+    TEST_ASSERT_EQUAL(0, s_order_errors);
+}
+
+void app_main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_fifo_and_full_queue);
+    RUN_TEST(test_rejects_invalid_commands);
+    RUN_TEST(test_full_queue_keeps_order);
+    RUN_TEST(test_deleted_objects_are_dropped);
+    RUN_TEST(test_stress_lock_free_queue);
+    RUN_TEST(test_stress_global_mutex_baseline);
+
+    UNITY_END();
+}
@@ -0,0 +1,197 @@
+/**
+ * @file test_lvgl_dirty.c
+ * @brief Unit tests for dirty-rectangle merging and refresh statistics
+ */
+
+#include "lvgl_port.h"
+#include "unity.h"
+
+#define SCREEN_MAX_X    (LCD_HEIGHT - 1)   // Landscape after LCD_ROTATION
+#define SCREEN_MAX_Y    (LCD_WIDTH - 1)
+
+static lv_area_t make_area(lv_coord_t x1, lv_coord_t y1, lv_coord_t x2, lv_coord_t y2)
+{
+    lv_area_t a = { .x1 = x1, .y1 = y1, .x2 = x2, .y2 = y2 };
+    return a;
+}
+
+static uint32_t area_px(const lv_area_t *a)
+{
+    return (uint32_t)(a->x2 - a->x1 + 1) * (a->y2 - a->y1 + 1);
+}
+
+void test_align_snaps_to_tiles_and_clips(void)
+{
+    lv_area_t a = make_area(13, 3, 50, 17);
+    lvgl_dirty_align(&a, SCREEN_MAX_X, SCREEN_MAX_Y);
+    TEST_ASSERT_EQUAL(12, a.x1);
+    TEST_ASSERT_EQUAL(0, a.y1);
+    TEST_ASSERT_EQUAL(51, a.x2);
+    TEST_ASSERT_EQUAL(19, a.y2);
+
+    a = make_area(310, 165, SCREEN_MAX_X, SCREEN_MAX_Y);
+    lvgl_dirty_align(&a, SCREEN_MAX_X, SCREEN_MAX_Y);
+    TEST_ASSERT_EQUAL(SCREEN_MAX_X, a.x2);
+    TEST_ASSERT_EQUAL(SCREEN_MAX_Y, a.y2);
+}
+
+void test_overlapping_areas_merge(void)
+{
+    lvgl_dirty_region_t region;
+    lvgl_dirty_reset(&region);
+
+    lv_area_t a = make_area(0, 0, 63, 15);
+    lv_area_t b = make_area(32, 8, 95, 23);
+    lvgl_dirty_add(&region, &a);
+    lvgl_dirty_add(&region, &b);
+
+    TEST_ASSERT_EQUAL(1, region.count);
+    TEST_ASSERT_EQUAL(0, region.rects[0].x1);
+    TEST_ASSERT_EQUAL(95, region.rects[0].x2);
+    TEST_ASSERT_EQUAL(23, region.rects[0].y2);
+}
+
+void test_repeated_label_updates_collapse(void)
+{
+    lvgl_dirty_region_t region;
+    lvgl_dirty_reset(&region);
+
+    // An app re-setting the same label ten times in one frame
+    for (int i = 0; i < 10; i++) {
+        lv_area_t a = make_area(100, 40, 180, 55);
+        lvgl_dirty_add(&region, &a);
+    }
+
+    TEST_ASSERT_EQUAL(1, region.count);
+    TEST_ASSERT_EQUAL(81 * 16, lvgl_dirty_pixels(&region));
+}
+
+void test_distant_areas_stay_separate(void)
+{
+    lvgl_dirty_region_t region;
+    lvgl_dirty_reset(&region);
+
+    // Status bar clock (top-left) and RSSI readout (bottom-right)
+    lv_area_t clock = make_area(0, 0, 47, 23);
+    lv_area_t rssi = make_area(240, 144, 319, 167);
+    lvgl_dirty_add(&region, &clock);
+    lvgl_dirty_add(&region, &rssi);
+
+    TEST_ASSERT_EQUAL(2, region.count);
+    TEST_ASSERT_EQUAL(area_px(&clock) + area_px(&rssi), lvgl_dirty_pixels(&region));
+}
+
+void test_full_region_merges_cheapest_pair(void)
+{
+    lvgl_dirty_region_t region;
+    lvgl_dirty_reset(&region);
+
+    // A diagonal of small, far-apart squares overflows the rect table
+    for (int i = 0; i < LVGL_DIRTY_MAX_RECTS + 2; i++) {
+        lv_area_t a = make_area(i * 30, i * 15, i * 30 + 7, i * 15 + 7);
+        lvgl_dirty_add(&region, &a);
+    }
+
+    TEST_ASSERT_TRUE(region.count <= LVGL_DIRTY_MAX_RECTS);
+
+    // Every square is still covered
+    for (int i = 0; i < LVGL_DIRTY_MAX_RECTS + 2; i++) {
+        bool covered = false;
+        for (int r = 0; r < region.count; r++) {
+            const lv_area_t *c = &region.rects[r];
+            if (c->x1 <= i * 30 && c->y1 <= i * 15 && c->x2 >= i * 30 + 7 && c->y2 >= i * 15 + 7) {
+                covered = true;
+            }
+        }
+        TEST_ASSERT_TRUE(covered);
+    }
+}
+
+void test_typical_app_screen_bandwidth(void)
+{
+    // One spectrum-scanner frame: clock, RSSI label, frequency label,
+    // progress bar and three list rows changing text
+    const lv_area_t updates[] = {
+        {  4,   4,  44,  20 },  // Clock
+        {  6,   4,  40,  20 },  // Clock again (re-set by a second JS call)
+        {200,  40, 300,  56 },  // RSSI label
+        {200,  60, 300,  76 },  // Frequency label
+        {205,  58, 290,  74 },  // Frequency label, shorter text
+        { 10, 100, 300, 108 },  // Progress bar
+        { 10, 120, 150, 135 },  // List row 1
+        { 10, 136, 150, 151 },  // List row 2
+        { 10, 152, 150, 167 },  // List row 3
+    };
+    const int n = sizeof(updates) / sizeof(updates[0]);
+
+    lvgl_dirty_region_t region;
+    lvgl_dirty_reset(&region);
+
+    uint32_t naive_px = 0;
+    for (int i = 0; i < n; i++) {
+        lv_area_t a = updates[i];
+        naive_px += area_px(&a);
+        lvgl_dirty_align(&a, SCREEN_MAX_X, SCREEN_MAX_Y);
+        lvgl_dirty_add(&region, &a);
+    }
+
+    // Window setup is paid once per rect on the bus
+    uint32_t naive_cost = naive_px + n * LVGL_DIRTY_FLUSH_OVERHEAD_PX;
+    uint32_t merged_cost = lvgl_dirty_pixels(&region) +
+                           region.count * LVGL_DIRTY_FLUSH_OVERHEAD_PX;
+    uint32_t full_screen = LCD_WIDTH * LCD_HEIGHT;
+
+    printf("%d updates: naive %u px-eq, merged %u px-eq in %u rects, full %u px\n",
+           n, naive_cost, merged_cost, region.count, full_screen);
+
+    TEST_ASSERT_TRUE(region.count < n);
+    TEST_ASSERT_TRUE(merged_cost < naive_cost);
+    TEST_ASSERT_TRUE(merged_cost < full_screen / 2);
+}
+
+void test_refresh_stats_accounting(void)
+{
+    lvgl_refresh_stats_t stats;
+
+    lvgl_port_reset_refresh_stats();
+    lvgl_dirty_account_flush(1000);
+    lvgl_dirty_account_flush(500);
+    lvgl_dirty_account_skipped_update();
+
+    lvgl_port_get_refresh_stats(&stats);
+    TEST_ASSERT_EQUAL(2, stats.flushes);
+    TEST_ASSERT_EQUAL(1500, stats.pixels_pushed);
+    TEST_ASSERT_EQUAL(1, stats.updates_skipped);
+}
+
+void test_refresh_rate_decays_when_idle(void)
+{
+    lvgl_refresh_stats_t stats;
+
+    lvgl_port_reset_refresh_stats();
+    lvgl_dirty_account_flush(3000);
+    lv_tick_inc(1000);
+    lvgl_dirty_account_flush(0);
+    lvgl_port_get_refresh_stats(&stats);
+    TEST_ASSERT_TRUE(stats.pixels_per_sec > 0 && stats.pixels_per_sec <= 3000);
+
+    // No flush for a full second: the busy rate is not reported forever
+    lv_tick_inc(2000);
+    lvgl_port_get_refresh_stats(&stats);
+    TEST_ASSERT_EQUAL(0, stats.pixels_per_sec);
+}
+
+void app_main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_align_snaps_to_tiles_and_clips);
+    RUN_TEST(test_overlapping_areas_merge);
+    RUN_TEST(test_repeated_label_updates_collapse);
+    RUN_TEST(test_distant_areas_stay_separate);
+    RUN_TEST(test_full_region_merges_cheapest_pair);
+    RUN_TEST(test_typical_app_screen_bandwidth);
+    RUN_TEST(test_refresh_stats_accounting);
+    RUN_TEST(test_refresh_rate_decays_when_idle);
+
+    UNITY_END();
+}
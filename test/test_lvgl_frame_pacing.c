@@ -0,0 +1,173 @@
+/**
+ * @file test_lvgl_frame_pacing.c
+ * @brief Unit tests and wake-up simulation for LVGL frame pacing
+ */
+
+#include "lvgl_port.h"
+#include "unity.h"
+#include <stdio.h>
+
+#define SIM_SECONDS     10
+#define US_PER_MS       1000ULL
+
+void test_profile_periods(void)
+{
+    TEST_ASSERT_EQUAL(1000 / LVGL_FRAME_FPS_MENU, lvgl_frame_period_ms(LVGL_FRAME_PROFILE_MENU));
+    TEST_ASSERT_EQUAL(1000 / LVGL_FRAME_FPS_APP, lvgl_frame_period_ms(LVGL_FRAME_PROFILE_APP));
+    TEST_ASSERT_EQUAL(1000 / LVGL_FRAME_FPS_SPECTRUM, lvgl_frame_period_ms(LVGL_FRAME_PROFILE_SPECTRUM));
+    TEST_ASSERT_TRUE(lvgl_frame_period_ms(LVGL_FRAME_PROFILE_SPECTRUM) <
+                     lvgl_frame_period_ms(LVGL_FRAME_PROFILE_MENU));
+}
+
+void test_schedule_clamps_idle_sleep(void)
+{
+    lvgl_port_reset_frame_stats();
+
+    TEST_ASSERT_EQUAL(16, lvgl_frame_schedule(0, 16));
+    TEST_ASSERT_EQUAL(LVGL_FRAME_IDLE_MAX_MS, lvgl_frame_schedule(0, LV_NO_TIMER_READY));
+}
+
+void test_on_time_frames_have_no_jitter(void)
+{
+    lvgl_port_reset_frame_stats();
+
+    uint64_t now = 0;
+    for (int i = 0; i < 100; i++) {
+        uint32_t wait = lvgl_frame_schedule(now, 33);
+        now += wait * US_PER_MS;
+        lvgl_frame_account(now, 5000, true, LVGL_FRAME_PROFILE_APP);
+        now += 5000;
+    }
+
+    lvgl_frame_stats_t stats;
+    lvgl_port_get_frame_stats(&stats);
+    TEST_ASSERT_EQUAL(100, stats.frames);
+    TEST_ASSERT_EQUAL(5000, stats.avg_frame_us);
+    TEST_ASSERT_EQUAL(0, stats.jitter_us);
+    TEST_ASSERT_EQUAL(0, stats.missed_deadlines);
+}
+
+void test_late_and_slow_frames_are_missed(void)
+{
+    lvgl_port_reset_frame_stats();
+
+    // Woken 12 ms late at 60 fps: more than half a period
+    lvgl_frame_schedule(0, 16);
+    lvgl_frame_account(28 * US_PER_MS, 2000, true, LVGL_FRAME_PROFILE_SPECTRUM);
+
+    // On time but the frame itself overran the period
+    lvgl_frame_schedule(40 * US_PER_MS, 16);
+    lvgl_frame_account(56 * US_PER_MS, 20000, true, LVGL_FRAME_PROFILE_SPECTRUM);
+
+    // Same render time is fine for a 15 fps menu
+    lvgl_frame_schedule(100 * US_PER_MS, 66);
+    lvgl_frame_account(166 * US_PER_MS, 20000, true, LVGL_FRAME_PROFILE_MENU);
+
+    lvgl_frame_stats_t stats;
+    lvgl_port_get_frame_stats(&stats);
+    TEST_ASSERT_EQUAL(3, stats.frames);
+    TEST_ASSERT_EQUAL(2, stats.missed_deadlines);
+    TEST_ASSERT_EQUAL(20000, stats.max_frame_us);
+    TEST_ASSERT_TRUE(stats.jitter_us > 0);
+}
+
+void test_idle_wakeups_not_counted_as_frames(void)
+{
+    lvgl_port_reset_frame_stats();
+
+    lvgl_frame_schedule(0, 16);
+    lvgl_frame_account(16 * US_PER_MS, 100, false, LVGL_FRAME_PROFILE_APP);
+    lvgl_frame_account_sleep(16);
+
+    lvgl_frame_stats_t stats;
+    lvgl_port_get_frame_stats(&stats);
+    TEST_ASSERT_EQUAL(0, stats.frames);
+    TEST_ASSERT_EQUAL(1, stats.idle_wakeups);
+    TEST_ASSERT_EQUAL(16, stats.slept_ms);
+}
+
+void test_screen_profiles(void)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_init());
+
+    lvgl_port_lock();
+    lv_obj_t *menu = lv_obj_create(NULL);
+    lv_obj_t *app = lv_obj_create(NULL);
+    lvgl_port_set_screen_frame_profile(menu, LVGL_FRAME_PROFILE_MENU);
+    lvgl_port_unlock();
+
+    TEST_ASSERT_EQUAL(LVGL_FRAME_PROFILE_MENU, lvgl_port_get_screen_frame_profile(menu));
+    TEST_ASSERT_EQUAL(LVGL_FRAME_PROFILE_APP, lvgl_port_get_screen_frame_profile(app));
+
+    // A spectrum widget raises its screen to the spectrum cap
+    lvgl_port_lock();
+    lvgl_create_spectrum(app, 100, 50);
+    lvgl_port_unlock();
+    TEST_ASSERT_EQUAL(LVGL_FRAME_PROFILE_SPECTRUM, lvgl_port_get_screen_frame_profile(app));
+
+    // Deleted screens release their slot
+    lvgl_port_lock();
+    lv_obj_del(menu);
+    lv_obj_del(app);
+    lvgl_port_unlock();
+    TEST_ASSERT_EQUAL(LVGL_FRAME_PROFILE_APP, lvgl_port_get_screen_frame_profile(menu));
+
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_deinit());
+}
+
+/**
+ * Wake-ups over SIM_SECONDS for a UI task that used to loop every 50 ms with
+ * a 1 ms tick interrupt, against one that sleeps until the next deadline.
+ * The idle menu only wakes for the clock once a second; the spectrum view
+ * redraws every frame at its cap.
+ */
+static uint32_t simulate_paced(lvgl_frame_profile_t profile, bool animating)
+{
+    uint32_t wakeups = 0;
+    uint64_t now = 0;
+    uint64_t end = SIM_SECONDS * 1000 * US_PER_MS;
+
+    lvgl_port_reset_frame_stats();
+    while (now < end) {
+        // Clock label timer is the only LVGL timer on an idle screen
+        uint32_t timer_delay = animating ? lvgl_frame_period_ms(profile) : 1000;
+        uint32_t wait = lvgl_frame_schedule(now, timer_delay);
+        now += wait * US_PER_MS;
+        lvgl_frame_account_sleep(wait);
+        lvgl_frame_account(now, 3000, true, profile);
+        wakeups++;
+    }
+    return wakeups;
+}
+
+void test_simulated_wakeups(void)
+{
+    uint32_t legacy = SIM_SECONDS * (1000 + 1000 / 50);     // Tick ISR + 20 Hz loop
+    uint32_t menu = simulate_paced(LVGL_FRAME_PROFILE_MENU, false);
+    uint32_t spectrum = simulate_paced(LVGL_FRAME_PROFILE_SPECTRUM, true);
+
+    lvgl_frame_stats_t stats;
+    lvgl_port_get_frame_stats(&stats);
+
+    printf("%d s: legacy %u wake-ups, idle menu %u, spectrum %u (%u fps, %u missed)\n",
+           SIM_SECONDS, legacy, menu, spectrum, stats.frames / SIM_SECONDS,
+           stats.missed_deadlines);
+
+    TEST_ASSERT_EQUAL(SIM_SECONDS, menu);
+    TEST_ASSERT_TRUE(spectrum < legacy / 10);
+    TEST_ASSERT_EQUAL(0, stats.missed_deadlines);
+}
+
+void app_main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_profile_periods);
+    RUN_TEST(test_schedule_clamps_idle_sleep);
+    RUN_TEST(test_on_time_frames_have_no_jitter);
+    RUN_TEST(test_late_and_slow_frames_are_missed);
+    RUN_TEST(test_idle_wakeups_not_counted_as_frames);
+    RUN_TEST(test_screen_profiles);
+    RUN_TEST(test_simulated_wakeups);
+
+    UNITY_END();
+}
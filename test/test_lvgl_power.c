@@ -0,0 +1,270 @@
+/**
+ * @file test_lvgl_power.c
+ * @brief Display idle manager state machine tests and usage simulation
+ *
+ * The state machine is driven with a virtual clock the way the UI task
+ * drives it: step, then sleep until the returned deadline or the next
+ * input. The headless test checks that a sleeping display stops rendering
+ * and comes back with its last frame intact.
+ */
+
+#include "lvgl_port.h"
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+
+#define DIM_MS      1000
+#define SLEEP_MS    3000
+
+static uint32_t s_now;
+
+// Advance the clock to `until`, stepping at every deadline like the UI task
+static void run_until(uint32_t until, bool live)
+{
+    for (;;) {
+        uint32_t next = lvgl_power_step(s_now, live);
+        if (next == LVGL_POWER_NO_DEADLINE || s_now + next > until) {
+            break;
+        }
+        s_now += next;
+    }
+    s_now = until;
+    lvgl_power_step(s_now, live);
+}
+
+static void input_at(uint32_t t)
+{
+    run_until(t, false);
+    lvgl_port_power_activity(LVGL_POWER_WAKE_INPUT);
+    lvgl_power_step(s_now, false);
+}
+
+static void reset_machine(void)
+{
+    s_now = 0;
+    lvgl_power_set_brightness(200);
+    lvgl_port_set_power_timeouts(DIM_MS, SLEEP_MS);
+    lvgl_power_reset(0);
+}
+
+void test_dims_then_sleeps_on_schedule(void)
+{
+    reset_machine();
+
+    TEST_ASSERT_EQUAL(DIM_MS, lvgl_power_step(0, false));
+
+    run_until(DIM_MS - 1, false);
+    TEST_ASSERT_EQUAL(LVGL_POWER_ACTIVE, lvgl_port_get_power_state());
+
+    run_until(DIM_MS, false);
+    TEST_ASSERT_EQUAL(LVGL_POWER_DIMMED, lvgl_port_get_power_state());
+
+    lvgl_power_stats_t stats;
+    lvgl_port_get_power_stats(&stats);
+    TEST_ASSERT_EQUAL(LVGL_POWER_DIM_LEVEL, stats.brightness);
+    TEST_ASSERT_FALSE(lvgl_headless_panel_asleep());
+
+    run_until(SLEEP_MS, false);
+    TEST_ASSERT_EQUAL(LVGL_POWER_SLEEP, lvgl_port_get_power_state());
+    TEST_ASSERT_TRUE(lvgl_headless_panel_asleep());
+    TEST_ASSERT_EQUAL(LVGL_POWER_NO_DEADLINE, lvgl_power_step(s_now, false));
+
+    lvgl_port_get_power_stats(&stats);
+    TEST_ASSERT_EQUAL(0, stats.brightness);
+    TEST_ASSERT_EQUAL(DIM_MS, stats.time_ms[LVGL_POWER_ACTIVE]);
+    TEST_ASSERT_EQUAL(SLEEP_MS - DIM_MS, stats.time_ms[LVGL_POWER_DIMMED]);
+}
+
+void test_input_wakes_and_restarts_idle_timer(void)
+{
+    reset_machine();
+
+    run_until(SLEEP_MS + 500, false);
+    TEST_ASSERT_TRUE(lvgl_port_power_activity(LVGL_POWER_WAKE_INPUT));
+    lvgl_power_step(s_now, false);
+
+    lvgl_power_stats_t stats;
+    lvgl_port_get_power_stats(&stats);
+    TEST_ASSERT_EQUAL(LVGL_POWER_ACTIVE, lvgl_port_get_power_state());
+    TEST_ASSERT_FALSE(lvgl_headless_panel_asleep());
+    TEST_ASSERT_EQUAL(200, stats.brightness);
+    TEST_ASSERT_EQUAL(1, stats.wakes_input);
+
+    // Activity while active only pushes the dim deadline out
+    input_at(s_now + DIM_MS / 2);
+    TEST_ASSERT_EQUAL(DIM_MS, lvgl_power_step(s_now, false));
+    lvgl_port_get_power_stats(&stats);
+    TEST_ASSERT_EQUAL(1, stats.wakes_input);
+}
+
+void test_notification_wakes_from_dim(void)
+{
+    reset_machine();
+
+    run_until(DIM_MS + 10, false);
+    TEST_ASSERT_FALSE(lvgl_port_power_activity(LVGL_POWER_WAKE_NOTIFICATION));
+    lvgl_power_step(s_now, false);
+
+    lvgl_power_stats_t stats;
+    lvgl_port_get_power_stats(&stats);
+    TEST_ASSERT_EQUAL(LVGL_POWER_ACTIVE, lvgl_port_get_power_state());
+    TEST_ASSERT_EQUAL(1, stats.wakes_notification);
+}
+
+void test_live_content_dims_but_never_sleeps(void)
+{
+    reset_machine();
+
+    run_until(SLEEP_MS * 10, true);
+    TEST_ASSERT_EQUAL(LVGL_POWER_DIMMED, lvgl_port_get_power_state());
+
+    // Leaving the live view lets the panel sleep right away
+    run_until(s_now + 1, false);
+    TEST_ASSERT_EQUAL(LVGL_POWER_SLEEP, lvgl_port_get_power_state());
+}
+
+void test_disabled_timeouts(void)
+{
+    reset_machine();
+    lvgl_port_set_power_timeouts(0, SLEEP_MS);
+
+    // No dim stage: straight to sleep
+    TEST_ASSERT_EQUAL(SLEEP_MS, lvgl_power_step(0, false));
+    run_until(SLEEP_MS, false);
+    TEST_ASSERT_EQUAL(LVGL_POWER_SLEEP, lvgl_port_get_power_state());
+
+    reset_machine();
+    lvgl_port_set_power_timeouts(0, 0);
+    TEST_ASSERT_EQUAL(LVGL_POWER_NO_DEADLINE, lvgl_power_step(0, false));
+}
+
+void test_brightness_follows_state(void)
+{
+    reset_machine();
+
+    lvgl_power_stats_t stats;
+    lvgl_power_set_brightness(120);
+    lvgl_port_get_power_stats(&stats);
+    TEST_ASSERT_EQUAL(120, stats.brightness);
+
+    // A dim level above the user's own setting never brightens the screen
+    lvgl_power_set_brightness(10);
+    run_until(DIM_MS, false);
+    lvgl_port_get_power_stats(&stats);
+    TEST_ASSERT_EQUAL(10, stats.brightness);
+}
+
+/**
+ * About 45 simulated minutes: bursts of input every few seconds for a minute,
+ * then the device is left alone for a while. Residency per state must
+ * match what the timeouts imply for each idle gap.
+ */
+void test_simulated_usage(void)
+{
+    reset_machine();
+    lvgl_port_set_power_timeouts(LVGL_POWER_DIM_MS, LVGL_POWER_SLEEP_MS);
+
+    static const uint32_t gaps_s[] = { 20, 45, 300, 5, 90, 600, 40, 1200 };
+    uint64_t expect[LVGL_POWER_STATE_MAX] = {0};
+    uint32_t wakes = 0;
+
+    for (size_t i = 0; i < sizeof(gaps_s) / sizeof(gaps_s[0]); i++) {
+        // A minute of use: input every 4 s
+        for (int k = 0; k < 15; k++) {
+            input_at(s_now + 4000);
+        }
+        expect[LVGL_POWER_ACTIVE] += 60000;
+
+        // Then idle until the next session starts
+        uint32_t gap = gaps_s[i] * 1000;
+        uint32_t active = gap < LVGL_POWER_DIM_MS ? gap : LVGL_POWER_DIM_MS;
+        uint32_t dimmed = gap < LVGL_POWER_SLEEP_MS ? gap - active : LVGL_POWER_SLEEP_MS - active;
+        expect[LVGL_POWER_ACTIVE] += active;
+        expect[LVGL_POWER_DIMMED] += dimmed;
+        expect[LVGL_POWER_SLEEP] += gap - active - dimmed;
+        wakes += gap >= LVGL_POWER_DIM_MS;
+
+        run_until(s_now + gap, false);
+        lvgl_port_power_activity(LVGL_POWER_WAKE_INPUT);
+        lvgl_power_step(s_now, false);
+    }
+
+    lvgl_power_stats_t stats;
+    lvgl_port_get_power_stats(&stats);
+
+    printf("%llu s: active %llu s, dimmed %llu s, asleep %llu s, %u dims, %u sleeps, %u wakes\n",
+           (unsigned long long)(s_now / 1000),
+           (unsigned long long)(stats.time_ms[LVGL_POWER_ACTIVE] / 1000),
+           (unsigned long long)(stats.time_ms[LVGL_POWER_DIMMED] / 1000),
+           (unsigned long long)(stats.time_ms[LVGL_POWER_SLEEP] / 1000),
+           stats.dims, stats.sleeps, stats.wakes_input);
+
+    TEST_ASSERT_EQUAL(expect[LVGL_POWER_ACTIVE], stats.time_ms[LVGL_POWER_ACTIVE]);
+    TEST_ASSERT_EQUAL(expect[LVGL_POWER_DIMMED], stats.time_ms[LVGL_POWER_DIMMED]);
+    TEST_ASSERT_EQUAL(expect[LVGL_POWER_SLEEP], stats.time_ms[LVGL_POWER_SLEEP]);
+    TEST_ASSERT_EQUAL(wakes, stats.wakes_input);
+    TEST_ASSERT_EQUAL(s_now, stats.time_ms[LVGL_POWER_ACTIVE] + stats.time_ms[LVGL_POWER_DIMMED] +
+                             stats.time_ms[LVGL_POWER_SLEEP]);
+}
+
+void test_headless_sleep_keeps_last_frame(void)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_init());
+    lvgl_port_set_power_timeouts(100, 200);
+
+    lvgl_port_lock();
+    lv_obj_t *screen = lv_obj_create(NULL);
+    lv_obj_t *label = lv_label_create(screen);
+    lv_label_set_text(label, "before");
+    lv_scr_load(screen);
+    lvgl_port_unlock();
+    lvgl_headless_render_frame(16, NULL);
+
+    lv_coord_t w, h;
+    const uint16_t *fb = lvgl_headless_get_framebuffer(&w, &h);
+    static uint16_t last[LCD_WIDTH * LCD_HEIGHT];
+    memcpy(last, fb, (size_t)w * h * sizeof(uint16_t));
+
+    for (int i = 0; i < 20; i++) {
+        lvgl_headless_render_frame(16, NULL);
+    }
+    TEST_ASSERT_EQUAL(LVGL_POWER_SLEEP, lvgl_port_get_power_state());
+
+    // Changes made while asleep are not drawn
+    lvgl_port_lock();
+    lv_label_set_text(label, "after");
+    lvgl_port_unlock();
+
+    lvgl_headless_frame_t frame;
+    lvgl_headless_render_frame(16, &frame);
+    TEST_ASSERT_EQUAL(0, frame.flushed_px);
+    TEST_ASSERT_EQUAL_MEMORY(last, fb, (size_t)w * h * sizeof(uint16_t));
+
+    // Input wakes the panel and the pending change is drawn
+    static const lvgl_input_step_t press[] = {
+        { 0, INPUT_TYPE_BUTTON, INPUT_EVENT_PRESS, 1 },
+    };
+    lvgl_headless_play_input(press, 1);
+    lvgl_headless_render_frame(16, NULL);
+    lvgl_headless_render_frame(16, &frame);
+    TEST_ASSERT_EQUAL(LVGL_POWER_ACTIVE, lvgl_port_get_power_state());
+    TEST_ASSERT_FALSE(lvgl_headless_panel_asleep());
+    TEST_ASSERT_TRUE(frame.flushed_px > 0);
+
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_deinit());
+}
+
+void app_main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_dims_then_sleeps_on_schedule);
+    RUN_TEST(test_input_wakes_and_restarts_idle_timer);
+    RUN_TEST(test_notification_wakes_from_dim);
+    RUN_TEST(test_live_content_dims_but_never_sleeps);
+    RUN_TEST(test_disabled_timeouts);
+    RUN_TEST(test_brightness_follows_state);
+    RUN_TEST(test_simulated_usage);
+    RUN_TEST(test_headless_sleep_keeps_last_frame);
+
+    UNITY_END();
+}
@@ -0,0 +1,195 @@
+/**
+ * @file test_metrics.c
+ * @brief Metrics registry, histogram buckets and update cost (linux target)
+ *
+ * Besides checking the bucket layout and snapshots, this times counter
+ * increments and histogram records in a tight loop and prints the cost per
+ * update, which should stay in single-digit nanoseconds on a host CPU.
+ */
+
+#include "metrics.h"
+#include "unity.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_ITERATIONS    10000000
+#define THREADS             4
+#define THREAD_INCREMENTS   250000
+
+METRIC_COUNTER_DEFINE(s_test_counter, "test.counter", "n");
+METRIC_GAUGE_DEFINE(s_test_gauge, "test.gauge", "n");
+METRIC_HISTOGRAM_DEFINE(s_test_hist, "test.hist_us", "us");
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void test_bucket_layout(void)
+{
+    // Small values are exact
+    for (uint32_t v = 0; v < 4; v++) {
+        TEST_ASSERT_EQUAL(v, metric_hist_bucket(v));
+        TEST_ASSERT_EQUAL(v, metric_hist_upper(v));
+    }
+
+    // Every value lies in its bucket, buckets are contiguous and at most
+    // a quarter of their lower bound wide
+    uint32_t prev = 0;
+    for (uint32_t v = 1; v < (1u << METRIC_HIST_MAX_BITS); v += 1 + v / 64) {
+        uint32_t b = metric_hist_bucket(v);
+        TEST_ASSERT_TRUE(b >= prev);
+        TEST_ASSERT_TRUE(v <= metric_hist_upper(b));
+        if (b > 0) {
+            TEST_ASSERT_TRUE(v > metric_hist_upper(b - 1));
+        }
+        if (v >= 4) {
+            uint32_t width = metric_hist_upper(b) - metric_hist_upper(b - 1);
+            TEST_ASSERT_TRUE(width * 4 <= metric_hist_upper(b - 1) + 1);
+        }
+        prev = b;
+    }
+
+    TEST_ASSERT_EQUAL(METRIC_HIST_BUCKETS - 2, metric_hist_bucket((1u << METRIC_HIST_MAX_BITS) - 1));
+    TEST_ASSERT_EQUAL(METRIC_HIST_BUCKETS - 1, metric_hist_bucket(1u << METRIC_HIST_MAX_BITS));
+    TEST_ASSERT_EQUAL(METRIC_HIST_BUCKETS - 1, metric_hist_bucket(UINT32_MAX));
+    TEST_ASSERT_EQUAL(UINT32_MAX, metric_hist_upper(METRIC_HIST_BUCKETS - 1));
+}
+
+void test_registry_and_values(void)
+{
+    metrics_reset();
+
+    TEST_ASSERT_TRUE(metrics_find("test.counter") == &s_test_counter);
+    TEST_ASSERT_NULL(metrics_find("test.missing"));
+    TEST_ASSERT_TRUE(metrics_count() >= 3);
+
+    metric_inc(&s_test_counter);
+    metric_add(&s_test_counter, 41);
+    metric_set(&s_test_gauge, -7);
+
+    // 90 fast samples and 10 slow ones
+    for (int i = 0; i < 90; i++) {
+        metric_record(&s_test_hist, 100);
+    }
+    for (int i = 0; i < 10; i++) {
+        metric_record(&s_test_hist, 5000 + i);
+    }
+
+    metric_value_t v;
+    metrics_read(&s_test_counter, &v);
+    TEST_ASSERT_EQUAL(42, v.count);
+    metrics_read(&s_test_gauge, &v);
+    TEST_ASSERT_EQUAL(-7, v.value);
+
+    metrics_read(&s_test_hist, &v);
+    TEST_ASSERT_EQUAL(100, v.hist.count);
+    TEST_ASSERT_EQUAL(5009, v.hist.max);
+    TEST_ASSERT_EQUAL(metric_hist_upper(metric_hist_bucket(100)), v.hist.p50);
+    TEST_ASSERT_EQUAL(v.hist.p50, v.hist.p90);
+    TEST_ASSERT_TRUE(v.hist.p99 >= 5000 && v.hist.p99 <= 5009);
+
+    metrics_reset();
+    metrics_read(&s_test_hist, &v);
+    TEST_ASSERT_EQUAL(0, v.hist.count);
+    TEST_ASSERT_EQUAL(0, v.hist.p50);
+}
+
+void test_snapshot_and_json(void)
+{
+    metrics_reset();
+    metric_add(&s_test_counter, 3);
+    metric_record(&s_test_hist, 10);
+
+    metric_value_t values[64];
+    size_t n = metrics_snapshot(values, 64);
+    TEST_ASSERT_EQUAL(metrics_count(), n);
+    TEST_ASSERT_EQUAL(1, metrics_snapshot(values, 1));
+
+    char json[METRICS_JSON_MAX];
+    int len = metrics_format_json(json, sizeof(json));
+    TEST_ASSERT_TRUE(len > 0 && len < (int)sizeof(json));
+    TEST_ASSERT_EQUAL(len, strlen(json));
+    TEST_ASSERT_TRUE(json[0] == '{' && json[len - 1] == '}');
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"test.counter\":3"));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"test.hist_us\":{\"count\":1,"));
+    printf("%s\n", json);
+
+    // A short buffer still reports the full length and stays terminated
+    char small[16];
+    TEST_ASSERT_EQUAL(len, metrics_format_json(small, sizeof(small)));
+    TEST_ASSERT_EQUAL(sizeof(small) - 1, strlen(small));
+}
+
+static void *increment_thread(void *arg)
+{
+    for (int i = 0; i < THREAD_INCREMENTS; i++) {
+        metric_inc(&s_test_counter);
+        metric_record(&s_test_hist, (uint32_t)i);
+    }
+    return NULL;
+}
+
+void test_concurrent_updates(void)
+{
+    pthread_t threads[THREADS];
+
+    metrics_reset();
+    for (int i = 0; i < THREADS; i++) {
+        TEST_ASSERT_EQUAL(0, pthread_create(&threads[i], NULL, increment_thread, NULL));
+    }
+    for (int i = 0; i < THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    // No update is lost even when every thread shares one slot
+    metric_value_t v;
+    metrics_read(&s_test_counter, &v);
+    TEST_ASSERT_EQUAL(THREADS * THREAD_INCREMENTS, v.count);
+    metrics_read(&s_test_hist, &v);
+    TEST_ASSERT_EQUAL(THREADS * THREAD_INCREMENTS, v.hist.count);
+    TEST_ASSERT_EQUAL(THREAD_INCREMENTS - 1, v.hist.max);
+}
+
+void test_update_cost(void)
+{
+    metrics_reset();
+
+    uint64_t start = now_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        metric_inc(&s_test_counter);
+    }
+    uint64_t inc_ns = now_ns() - start;
+
+    start = now_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        metric_record(&s_test_hist, (uint32_t)i & 0xFFFF);
+    }
+    uint64_t record_ns = now_ns() - start;
+
+    metric_value_t v;
+    metrics_read(&s_test_counter, &v);
+    TEST_ASSERT_EQUAL(BENCH_ITERATIONS, v.count);
+
+    printf("metric_inc:    %.2f ns\n", (double)inc_ns / BENCH_ITERATIONS);
+    printf("metric_record: %.2f ns\n", (double)record_ns / BENCH_ITERATIONS);
+    // Loose bound so a busy CI host does not fail it; a lock or a syscall
+    // on the update path would still blow well past it
+    TEST_ASSERT_TRUE(inc_ns < 50ull * BENCH_ITERATIONS);
+}
+
+void app_main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_bucket_layout);
+    RUN_TEST(test_registry_and_values);
+    RUN_TEST(test_snapshot_and_json);
+    RUN_TEST(test_concurrent_updates);
+    RUN_TEST(test_update_cost);
+
+    UNITY_END();
+}
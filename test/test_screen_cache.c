@@ -0,0 +1,200 @@
+/**
+ * @file test_screen_cache.c
+ * @brief Headless tests for app screen snapshots and launch previews
+ *
+ * Builds an app-like screen from dozens of widgets, closes it into a
+ * snapshot and launches it again. A cold launch shows nothing until the
+ * whole screen is built; a cached launch shows the snapshot on the first
+ * frame. Both launch-to-first-pixel latencies are reported.
+ */
+
+#include "lvgl_port.h"
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+
+#define FRAME_MS        16
+#define APP_ROWS        24      // Label + button pairs, like a settings app
+#define ROWS_PER_STEP   4
+
+typedef struct {
+    lv_obj_t *screen;
+    int row;
+} build_state_t;
+
+static void build_row(lv_obj_t *screen, int row)
+{
+    char text[32];
+    snprintf(text, sizeof(text), "Setting %d", row);
+
+    lv_obj_t *label = lv_label_create(screen);
+    lv_label_set_text(label, text);
+    lv_obj_set_pos(label, 4, 4 + row * 7);
+
+    lv_obj_t *btn = lv_btn_create(screen);
+    lv_obj_set_size(btn, 60, 6);
+    lv_obj_set_pos(btn, 240, 4 + row * 7);
+}
+
+static lv_obj_t* build_app_screen(void)
+{
+    lv_obj_t *screen = lv_obj_create(NULL);
+    lv_obj_set_style_bg_color(screen, lv_color_black(), 0);
+    for (int i = 0; i < APP_ROWS; i++) {
+        build_row(screen, i);
+    }
+    return screen;
+}
+
+static bool build_step(void *user_data)
+{
+    build_state_t *state = user_data;
+    for (int i = 0; i < ROWS_PER_STEP && state->row < APP_ROWS; i++) {
+        build_row(state->screen, state->row++);
+    }
+    return state->row == APP_ROWS;
+}
+
+void test_headless_init(void)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_init());
+}
+
+void test_snapshot_round_trip(void)
+{
+    lv_coord_t fb_w, fb_h;
+    const uint16_t *fb = lvgl_headless_get_framebuffer(&fb_w, &fb_h);
+    static uint16_t expected[LCD_WIDTH * LCD_HEIGHT];
+
+    lvgl_port_lock();
+    lv_obj_t *menu = lv_scr_act();
+    lv_obj_t *app = build_app_screen();
+    lv_scr_load(app);
+    lvgl_port_unlock();
+    lvgl_headless_render_frame(FRAME_MS, NULL);
+    memcpy(expected, fb, (size_t)fb_w * fb_h * sizeof(uint16_t));
+
+    // Close the app: snapshot it and go back to the menu
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_screen_cache_store("settings"));
+    lvgl_port_lock();
+    lv_scr_load(menu);
+    lv_obj_del(app);
+    lvgl_port_unlock();
+    lvgl_headless_render_frame(FRAME_MS, NULL);
+
+    // The preview repaints exactly what the app last showed
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_launch_begin("settings"));
+    lvgl_headless_render_frame(FRAME_MS, NULL);
+    TEST_ASSERT_EQUAL_MEMORY(expected, fb, (size_t)fb_w * fb_h * sizeof(uint16_t));
+
+    lvgl_launch_stats_t stats;
+    lvgl_port_get_launch_stats(&stats);
+    TEST_ASSERT_EQUAL(1, stats.snapshots);
+    TEST_ASSERT_TRUE(stats.snapshot_bytes < (uint32_t)fb_w * fb_h * 2 / 4);
+    printf("snapshot: %u bytes for a %u byte screen\n", stats.snapshot_bytes, fb_w * fb_h * 2);
+
+    lvgl_port_launch_abort();
+    TEST_ASSERT_EQUAL_PTR(menu, lv_scr_act());
+}
+
+void test_bench_launch_latency(void)
+{
+    lvgl_launch_stats_t stats;
+    lvgl_port_lock();
+    lv_obj_t *menu = lv_scr_act();
+    lvgl_port_unlock();
+
+    // Cold: nothing cached, first pixels appear once the screen is built
+    lvgl_port_reset_launch_stats();
+    lvgl_port_launch_begin("cold_app");
+    lvgl_port_lock();
+    lv_obj_t *cold = build_app_screen();
+    lvgl_port_unlock();
+    lvgl_port_load_screen(cold);
+    lvgl_headless_render_frame(FRAME_MS, NULL);
+    lvgl_port_get_launch_stats(&stats);
+    uint32_t cold_us = stats.last_first_pixel_us;
+
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_screen_cache_store("cached_app"));
+    lvgl_port_lock();
+    lv_scr_load(menu);
+    lv_obj_del(cold);
+    lvgl_port_unlock();
+
+    // Cached: the snapshot is on screen before the app builds anything,
+    // and the live screen is built off-screen within the preload budget
+    lvgl_port_reset_launch_stats();
+    lvgl_port_launch_begin("cached_app");
+    lvgl_headless_render_frame(FRAME_MS, NULL);
+
+    build_state_t state = { 0 };
+    lvgl_port_lock();
+    state.screen = lv_obj_create(NULL);
+    lv_obj_set_style_bg_color(state.screen, lv_color_black(), 0);
+    lvgl_port_unlock();
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_preload(build_step, &state));
+
+    int frames = 0;
+    while (state.row < APP_ROWS && frames < 100) {
+        lvgl_headless_render_frame(FRAME_MS, NULL);
+        frames++;
+    }
+    lvgl_port_load_screen(state.screen);
+    lvgl_headless_render_frame(FRAME_MS, NULL);
+
+    lvgl_port_get_launch_stats(&stats);
+    printf("launch to first pixel: cold %u us, cached %u us; live screen after %u us "
+           "(%u preload steps over %d frames)\n",
+           cold_us, stats.last_first_pixel_us, stats.last_ready_us,
+           stats.preload_steps, frames);
+
+    TEST_ASSERT_EQUAL(1, stats.snapshot_hits);
+    TEST_ASSERT_EQUAL(1, stats.preload_jobs_done);
+    TEST_ASSERT_EQUAL(APP_ROWS, state.row);
+    TEST_ASSERT_TRUE(stats.last_first_pixel_us < stats.last_ready_us);
+    TEST_ASSERT_EQUAL_PTR(state.screen, lv_scr_act());
+
+    lvgl_port_lock();
+    lv_scr_load(menu);
+    lv_obj_del(state.screen);
+    lvgl_port_unlock();
+}
+
+void test_snapshot_lru_eviction(void)
+{
+    char app_id[16];
+    lvgl_launch_stats_t stats;
+
+    lvgl_port_reset_launch_stats();
+    for (int i = 0; i < LVGL_SCREEN_CACHE_SLOTS + 2; i++) {
+        snprintf(app_id, sizeof(app_id), "app_%d", i);
+        TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_screen_cache_store(app_id));
+    }
+
+    lvgl_port_get_launch_stats(&stats);
+    TEST_ASSERT_EQUAL(LVGL_SCREEN_CACHE_SLOTS, stats.snapshots);
+    TEST_ASSERT_TRUE(stats.snapshot_bytes <= LVGL_SCREEN_CACHE_BYTES);
+
+    // The oldest ones went first
+    lvgl_port_launch_begin("app_0");
+    lvgl_port_get_launch_stats(&stats);
+    TEST_ASSERT_EQUAL(0, stats.snapshot_hits);
+    lvgl_port_launch_abort();
+}
+
+void test_headless_deinit(void)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_deinit());
+}
+
+void app_main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_headless_init);
+    RUN_TEST(test_snapshot_round_trip);
+    RUN_TEST(test_bench_launch_latency);
+    RUN_TEST(test_snapshot_lru_eviction);
+    RUN_TEST(test_headless_deinit);
+
+    UNITY_END();
+}
@@ -0,0 +1,223 @@
+/**
+ * @file test_spectrum_widget.c
+ * @brief Headless benchmark for the native spectrum / waterfall widget
+ *
+ * Compares the widget's bar, line and waterfall views against the old
+ * approach of rendering one text bar per bin into labels, and checks that
+ * the waterfall scrolls by exactly one row per refresh.
+ */
+
+#include "lvgl_port.h"
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+
+#define FRAME_MS        16
+#define FRAMES          120
+#define SPECTRUM_W      300
+#define SPECTRUM_H      100
+#define SPECTRUM_BINS   128
+#define LABEL_ROWS      8       // Text bars that fit the same area
+
+static int8_t s_rssi[SPECTRUM_BINS];
+
+typedef struct {
+    const char *name;
+    uint64_t total_us;
+    uint32_t max_us;
+    uint64_t total_px;
+} bench_result_t;
+
+static void fill_sweep(int frame)
+{
+    // Noise floor with a carrier drifting across the band
+    for (int i = 0; i < SPECTRUM_BINS; i++) {
+        int carrier = (frame * 3) % SPECTRUM_BINS;
+        int dist = i > carrier ? i - carrier : carrier - i;
+        int noise = (i * 7 + frame * 13) % 9;
+        s_rssi[i] = (int8_t)(dist < 4 ? -45 - dist * 5 : -100 + noise);
+    }
+}
+
+static lv_obj_t* load_blank_screen(void)
+{
+    lvgl_port_lock();
+    lv_obj_t *screen = lv_obj_create(NULL);
+    lv_obj_set_style_bg_color(screen, lv_color_black(), 0);
+    lv_scr_load(screen);
+    lvgl_port_unlock();
+
+    lvgl_headless_render_frame(FRAME_MS, NULL);
+    return screen;
+}
+
+static void bench_account(bench_result_t *result)
+{
+    lvgl_headless_frame_t frame;
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_headless_render_frame(FRAME_MS, &frame));
+
+    result->total_us += frame.render_us;
+    result->total_px += frame.flushed_px;
+    if (frame.render_us > result->max_us) result->max_us = frame.render_us;
+}
+
+static void bench_report(const bench_result_t *result)
+{
+    printf("%-10s avg %6llu us  max %6u us  avg %6llu px/frame\n", result->name,
+           (unsigned long long)(result->total_us / FRAMES), result->max_us,
+           (unsigned long long)(result->total_px / FRAMES));
+}
+
+static bench_result_t bench_widget(const char *name, lvgl_spectrum_mode_t mode)
+{
+    bench_result_t result = { .name = name };
+    lv_obj_t *screen = load_blank_screen();
+
+    lvgl_port_lock();
+    lv_obj_t *spectrum = lvgl_create_spectrum(screen, SPECTRUM_W, SPECTRUM_H);
+    lv_obj_set_pos(spectrum, 10, 40);
+    lvgl_spectrum_set_mode(spectrum, mode);
+    lvgl_spectrum_set_range(spectrum, -110, -30);
+    lvgl_spectrum_set_buffer(spectrum, s_rssi, SPECTRUM_BINS);
+    lvgl_port_unlock();
+
+    for (int f = 0; f < FRAMES; f++) {
+        fill_sweep(f);
+        lvgl_port_lock();
+        lvgl_spectrum_refresh(spectrum);
+        lvgl_port_unlock();
+        bench_account(&result);
+    }
+
+    bench_report(&result);
+
+    lvgl_port_lock();
+    lv_obj_del(screen);
+    lvgl_port_unlock();
+    return result;
+}
+
+void test_headless_init(void)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_init());
+}
+
+void test_create_rejects_bad_size(void)
+{
+    lvgl_port_lock();
+    lv_obj_t *screen = lv_obj_create(NULL);
+    TEST_ASSERT_NULL(lvgl_create_spectrum(screen, 0, SPECTRUM_H));
+    TEST_ASSERT_NULL(lvgl_create_spectrum(screen, SPECTRUM_W, LCD_WIDTH + 1));
+    lv_obj_del(screen);
+    lvgl_port_unlock();
+}
+
+void test_waterfall_scrolls_one_row(void)
+{
+    lv_obj_t *screen = load_blank_screen();
+
+    lvgl_port_lock();
+    lv_obj_t *spectrum = lvgl_create_spectrum(screen, SPECTRUM_W, SPECTRUM_H);
+    lv_obj_set_pos(spectrum, 10, 40);
+    lvgl_spectrum_set_mode(spectrum, LVGL_SPECTRUM_WATERFALL);
+    lvgl_spectrum_set_buffer(spectrum, s_rssi, SPECTRUM_BINS);
+    lvgl_port_unlock();
+
+    lv_coord_t fb_w;
+    const uint16_t *fb = lvgl_headless_get_framebuffer(&fb_w, NULL);
+    uint16_t prev_row[SPECTRUM_W];
+    lv_area_t coords;
+
+    for (int f = 0; f < 4; f++) {
+        fill_sweep(f);
+        lvgl_port_lock();
+        lvgl_spectrum_refresh(spectrum);
+        lvgl_port_unlock();
+        lvgl_headless_render_frame(FRAME_MS, NULL);
+
+        lv_obj_get_coords(spectrum, &coords);
+        const uint16_t *top = &fb[coords.y1 * fb_w + coords.x1];
+
+        // Last frame's newest row is now one line further down
+        if (f > 0) {
+            TEST_ASSERT_EQUAL_MEMORY(prev_row, top + fb_w, sizeof(prev_row));
+        }
+        memcpy(prev_row, top, sizeof(prev_row));
+    }
+
+    lvgl_port_lock();
+    lv_obj_del(screen);
+    lvgl_port_unlock();
+}
+
+void test_bench_label_bars(void)
+{
+    bench_result_t result = { .name = "labels" };
+    lv_obj_t *screen = load_blank_screen();
+    lv_obj_t *rows[LABEL_ROWS];
+    char bar[48];
+
+    lvgl_port_lock();
+    for (int i = 0; i < LABEL_ROWS; i++) {
+        rows[i] = lv_label_create(screen);
+        lv_obj_set_pos(rows[i], 10, 40 + i * 12);
+    }
+    lvgl_port_unlock();
+
+    // What the JS app did before: one "[====    ]" string per bin group
+    for (int f = 0; f < FRAMES; f++) {
+        fill_sweep(f);
+        lvgl_port_lock();
+        for (int i = 0; i < LABEL_ROWS; i++) {
+            int8_t rssi = s_rssi[i * SPECTRUM_BINS / LABEL_ROWS];
+            int filled = (rssi + 110) * 40 / 80;
+            if (filled < 0) filled = 0;
+            if (filled > 40) filled = 40;
+            bar[0] = '[';
+            memset(bar + 1, '=', filled);
+            memset(bar + 1 + filled, ' ', 40 - filled);
+            bar[41] = ']';
+            bar[42] = '\0';
+            lvgl_port_set_label_text(rows[i], bar);
+        }
+        lvgl_port_unlock();
+        bench_account(&result);
+    }
+
+    bench_report(&result);
+
+    lvgl_port_lock();
+    lv_obj_del(screen);
+    lvgl_port_unlock();
+}
+
+void test_bench_spectrum_views(void)
+{
+    bench_result_t bars = bench_widget("bars", LVGL_SPECTRUM_BARS);
+    bench_result_t line = bench_widget("line", LVGL_SPECTRUM_LINE);
+    bench_result_t waterfall = bench_widget("waterfall", LVGL_SPECTRUM_WATERFALL);
+
+    // Every view only ever repaints the widget itself
+    uint64_t widget_px = (uint64_t)SPECTRUM_W * SPECTRUM_H * FRAMES;
+    TEST_ASSERT_TRUE(bars.total_px <= widget_px * 2);
+    TEST_ASSERT_TRUE(line.total_px <= widget_px * 2);
+    TEST_ASSERT_TRUE(waterfall.total_px <= widget_px * 2);
+}
+
+void test_headless_deinit(void)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_deinit());
+}
+
+void app_main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_headless_init);
+    RUN_TEST(test_create_rejects_bad_size);
+    RUN_TEST(test_waterfall_scrolls_one_row);
+    RUN_TEST(test_bench_label_bars);
+    RUN_TEST(test_bench_spectrum_views);
+    RUN_TEST(test_headless_deinit);
+
+    UNITY_END();
+}
@@ -0,0 +1,199 @@
+/**
+ * @file test_task_monitor.c
+ * @brief Task load and stack sizing arithmetic on simulated counters
+ *
+ * A two-core scheduler is simulated in 1 ms slices with fixed duty cycles
+ * per task, and the run-time counters it produces are sampled once a
+ * second the way task_manager_sample() does. Counters start close to the
+ * 32-bit limit so every test also crosses a wrap.
+ */
+
+#include "task_monitor.h"
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SIM_TASKS       4
+#define SLICE_US        1000
+#define WINDOW_US       1000000
+#define COUNTER_START   (UINT32_MAX - 3 * WINDOW_US / 2)
+
+typedef struct {
+    const char *name;
+    int core;
+    uint32_t duty;          // Slices per 1000 this task runs on its core
+    uint32_t counter;       // Run-time counter, microseconds
+    task_load_t load;
+} sim_task_t;
+
+static sim_task_t s_sim[SIM_TASKS];
+static uint32_t s_idle_counter[2];
+static task_load_t s_idle_load[2];
+static uint32_t s_total;
+static uint32_t s_last_total;
+
+static void sim_reset(void)
+{
+    static const sim_task_t tasks[SIM_TASKS] = {
+        { "ui",    1, 350 },
+        { "js",    1, 400 },
+        { "rf",    0, 200 },
+        { "input", 0, 15 },
+    };
+    memcpy(s_sim, tasks, sizeof(s_sim));
+    for (int i = 0; i < SIM_TASKS; i++) {
+        s_sim[i].counter = COUNTER_START;
+    }
+    s_idle_counter[0] = s_idle_counter[1] = COUNTER_START;
+    memset(s_idle_load, 0, sizeof(s_idle_load));
+    s_total = s_last_total = COUNTER_START;
+}
+
+// Run one second: each slice goes to a task with credit left, else idle
+static void sim_second(void)
+{
+    uint32_t credit[SIM_TASKS];
+    for (int i = 0; i < SIM_TASKS; i++) {
+        credit[i] = s_sim[i].duty;
+    }
+
+    for (int slice = 0; slice < 1000; slice++) {
+        for (int core = 0; core < 2; core++) {
+            sim_task_t *runner = NULL;
+            for (int i = 0; i < SIM_TASKS && !runner; i++) {
+                // Spread each task's slices over the second
+                if (s_sim[i].core == core && credit[i] &&
+                    (uint32_t)slice * s_sim[i].duty / 1000 >= s_sim[i].duty - credit[i]) {
+                    runner = &s_sim[i];
+                    credit[i]--;
+                }
+            }
+            if (runner) {
+                runner->counter += SLICE_US;
+            } else {
+                s_idle_counter[core] += SLICE_US;
+            }
+        }
+        s_total += SLICE_US;
+    }
+}
+
+static void sample(void)
+{
+    uint32_t window = s_total - s_last_total;
+    s_last_total = s_total;
+
+    for (int i = 0; i < SIM_TASKS; i++) {
+        task_load_update(&s_sim[i].load, s_sim[i].counter, window);
+    }
+    for (int core = 0; core < 2; core++) {
+        task_load_update(&s_idle_load[core], s_idle_counter[core], window);
+    }
+}
+
+void test_load_permille(void)
+{
+    TEST_ASSERT_EQUAL(0, task_load_permille(100, 100, 1000));
+    TEST_ASSERT_EQUAL(500, task_load_permille(0, 500, 1000));
+    TEST_ASSERT_EQUAL(1000, task_load_permille(0, 1000, 1000));
+    TEST_ASSERT_EQUAL(0, task_load_permille(0, 1000, 0));
+
+    // Run-time slightly ahead of the total on a busy core is clamped
+    TEST_ASSERT_EQUAL(TASK_LOAD_FULL, task_load_permille(0, 1010, 1000));
+
+    // A counter that wrapped within the window
+    TEST_ASSERT_EQUAL(250, task_load_permille(UINT32_MAX - 99, 150, 1000));
+}
+
+void test_first_sample_only_primes(void)
+{
+    task_load_t load = {0};
+
+    // What ran before the first sample is not a load over any window
+    task_load_update(&load, 900000, WINDOW_US);
+    TEST_ASSERT_EQUAL(0, load.load);
+    TEST_ASSERT_EQUAL(0, load.windows);
+
+    task_load_update(&load, 1200000, WINDOW_US);
+    TEST_ASSERT_EQUAL(300, load.load);
+    TEST_ASSERT_EQUAL(300, load.avg_load);
+}
+
+void test_simulated_loads_across_wrap(void)
+{
+    sim_reset();
+    sample();
+
+    for (int s = 0; s < 5; s++) {
+        sim_second();
+        sample();
+    }
+
+    for (int i = 0; i < SIM_TASKS; i++) {
+        printf("%-6s core %d  load %u.%u%%\n", s_sim[i].name, s_sim[i].core,
+               s_sim[i].load.load / 10, s_sim[i].load.load % 10);
+        TEST_ASSERT_EQUAL(s_sim[i].duty, s_sim[i].load.load);
+        TEST_ASSERT_EQUAL(s_sim[i].duty, s_sim[i].load.avg_load);
+    }
+
+    // Core load is whatever its idle task did not get
+    TEST_ASSERT_EQUAL(1000 - 215, s_idle_load[0].load);
+    TEST_ASSERT_EQUAL(1000 - 750, s_idle_load[1].load);
+
+    // Every counter crossed the 32-bit limit during the run
+    TEST_ASSERT_TRUE(s_total < COUNTER_START);
+}
+
+void test_average_follows_load_change(void)
+{
+    sim_reset();
+    sample();
+    for (int s = 0; s < 3; s++) {
+        sim_second();
+        sample();
+    }
+
+    // The JS task goes from 40% to 60% of its core
+    s_sim[1].duty = 600;
+    sim_second();
+    sample();
+    TEST_ASSERT_EQUAL(600, s_sim[1].load.load);
+    TEST_ASSERT_EQUAL((400 * 7 + 600 + 4) / 8, s_sim[1].load.avg_load);
+
+    for (int s = 0; s < 40; s++) {
+        sim_second();
+        sample();
+    }
+    TEST_ASSERT_TRUE(s_sim[1].load.avg_load >= 595);
+}
+
+void test_stack_recommendation(void)
+{
+    // 1 KB used of 4 KB: 1280 + 512
+    TEST_ASSERT_EQUAL(1792, task_stack_recommend(4096, 3072));
+
+    // Nearly full 2 KB stack asks for more
+    TEST_ASSERT_EQUAL(3072, task_stack_recommend(2048, 100));
+
+    // Recommendations are whole granules and always above the peak
+    for (uint32_t used = 0; used <= 8192; used += 100) {
+        uint32_t rec = task_stack_recommend(8192, 8192 - used);
+        TEST_ASSERT_EQUAL(0, rec % TASK_STACK_GRANULE);
+        TEST_ASSERT_TRUE(rec >= used + TASK_STACK_MARGIN);
+    }
+
+    // Never sampled: free equals size
+    TEST_ASSERT_EQUAL(TASK_STACK_MARGIN, task_stack_recommend(2048, 2048));
+}
+
+void app_main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_load_permille);
+    RUN_TEST(test_first_sample_only_primes);
+    RUN_TEST(test_simulated_loads_across_wrap);
+    RUN_TEST(test_average_follows_load_change);
+    RUN_TEST(test_stack_recommendation);
+
+    UNITY_END();
+}
@@ -0,0 +1,286 @@
+/**
+ * @file test_task_watchdog.c
+ * @brief Task watchdog on a simulated schedule with injected stalls
+ *
+ * Tasks are simulated in 1 ms steps: each beats, then sleeps its period
+ * plus whatever wake-up latency the test injects. A stalled task stops
+ * beating until a recovery (or the test) releases it. The supervisor
+ * checks every TASK_WATCHDOG_CHECK_MS like the main loop does. Time
+ * starts close to the 32-bit limit so every test also crosses a wrap.
+ */
+
+#include "task_watchdog.h"
+#include "metrics.h"
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+
+#define TIME_START      (UINT32_MAX - 2000000u)
+
+enum { SIM_UI, SIM_RF, SIM_JS, SIM_LOW, SIM_TASKS };
+
+typedef struct {
+    task_watchdog_config_t config;
+    int id;
+    uint32_t next_wake_ms;
+    uint32_t extra_latency_ms;      // Added to the next sleep only
+    bool stalled;
+    bool recovery_heals;            // A recovery clears the stall
+    uint32_t recoveries;
+} sim_task_t;
+
+static sim_task_t s_sim[SIM_TASKS];
+static uint32_t s_now_ms;
+static uint32_t s_escalations;
+static const char *s_escalated_name;
+
+static uint32_t sim_us(void)
+{
+    return TIME_START + s_now_ms * 1000u;
+}
+
+static esp_err_t sim_recover(int id, void *ctx)
+{
+    sim_task_t *task = ctx;
+    task->recoveries++;
+    if (!task->recovery_heals) {
+        return ESP_FAIL;
+    }
+
+    // A restarted task comes back after a short start-up
+    task->stalled = false;
+    task->next_wake_ms = s_now_ms + 5;
+    return ESP_OK;
+}
+
+static void sim_escalate(int id, const char *name)
+{
+    s_escalations++;
+    s_escalated_name = name;
+}
+
+static void sim_reset(void)
+{
+    static const task_watchdog_config_t configs[SIM_TASKS] = {
+        [SIM_UI]  = { .name = "ui",  .period_ms = 33,  .deadline_ms = 1000, .priority = 20, .core = 1 },
+        [SIM_RF]  = { .name = "rf",  .period_ms = 100, .deadline_ms = 1000, .priority = 20, .core = 0 },
+        [SIM_JS]  = { .name = "js",  .period_ms = 100, .deadline_ms = 2000, .priority = 15, .core = 1 },
+        [SIM_LOW] = { .name = "low", .period_ms = 10,  .deadline_ms = 2000, .priority = 5,  .core = 0 },
+    };
+
+    task_watchdog_reset();
+    metrics_reset();
+    task_watchdog_set_escalation(sim_escalate);
+    s_now_ms = 0;
+    s_escalations = 0;
+    s_escalated_name = NULL;
+
+    for (int i = 0; i < SIM_TASKS; i++) {
+        memset(&s_sim[i], 0, sizeof(s_sim[i]));
+        s_sim[i].config = configs[i];
+        s_sim[i].config.ctx = &s_sim[i];
+        s_sim[i].config.recover = sim_recover;
+        s_sim[i].recovery_heals = true;
+        s_sim[i].id = task_watchdog_register(&s_sim[i].config, sim_us());
+        TEST_ASSERT_EQUAL(i, s_sim[i].id);
+    }
+}
+
+static void sim_run(uint32_t ms)
+{
+    for (uint32_t end = s_now_ms + ms; s_now_ms < end; s_now_ms++) {
+        for (int i = 0; i < SIM_TASKS; i++) {
+            sim_task_t *task = &s_sim[i];
+            if (task->stalled || s_now_ms < task->next_wake_ms) {
+                continue;
+            }
+            task_watchdog_beat(task->id, sim_us());
+            task->next_wake_ms = s_now_ms + task->config.period_ms + task->extra_latency_ms;
+            task->extra_latency_ms = 0;
+        }
+        if (s_now_ms % TASK_WATCHDOG_CHECK_MS == 0) {
+            task_watchdog_check(sim_us());
+        }
+    }
+}
+
+static task_watchdog_stats_t stats_of(int sim)
+{
+    task_watchdog_stats_t stats;
+    TEST_ASSERT_EQUAL(ESP_OK, task_watchdog_get_stats(s_sim[sim].id, &stats));
+    return stats;
+}
+
+static uint64_t metric_count(const char *name)
+{
+    metric_value_t value;
+    metric_t *metric = metrics_find(name);
+    TEST_ASSERT_NOT_NULL(metric);
+    metrics_read(metric, &value);
+    return metric->type == METRIC_HISTOGRAM ? value.hist.count : value.count;
+}
+
+void test_healthy_schedule(void)
+{
+    sim_reset();
+    sim_run(10000);
+
+    for (int i = 0; i < SIM_TASKS; i++) {
+        task_watchdog_stats_t s = stats_of(i);
+        TEST_ASSERT_EQUAL(TASK_WATCHDOG_OK, s.state);
+        TEST_ASSERT_EQUAL(0, s.missed);
+        TEST_ASSERT_EQUAL(0, s.latency_outliers);
+        TEST_ASSERT_TRUE(s.beats >= 10000 / s_sim[i].config.period_ms - 1);
+    }
+    TEST_ASSERT_EQUAL(0, metric_count("wdt.missed"));
+}
+
+void test_hung_js_is_restarted(void)
+{
+    sim_reset();
+    sim_run(1000);
+
+    s_sim[SIM_JS].stalled = true;
+    sim_run(1850);
+    TEST_ASSERT_EQUAL(0, stats_of(SIM_JS).missed);
+
+    // Deadline passes: one miss, one recovery, and the task is back
+    sim_run(200);
+    task_watchdog_stats_t s = stats_of(SIM_JS);
+    TEST_ASSERT_EQUAL(1, s.missed);
+    TEST_ASSERT_EQUAL(1, s.recoveries);
+    TEST_ASSERT_EQUAL(1, s_sim[SIM_JS].recoveries);
+
+    sim_run(500);
+    TEST_ASSERT_EQUAL(TASK_WATCHDOG_OK, stats_of(SIM_JS).state);
+    TEST_ASSERT_EQUAL(1, metric_count("wdt.missed"));
+    TEST_ASSERT_EQUAL(1, metric_count("wdt.recoveries"));
+
+    // Nobody else was affected
+    TEST_ASSERT_EQUAL(0, stats_of(SIM_RF).missed);
+    TEST_ASSERT_EQUAL(0, s_escalations);
+}
+
+void test_unrecoverable_radio_escalates(void)
+{
+    sim_reset();
+    s_sim[SIM_RF].recovery_heals = false;
+    s_sim[SIM_RF].stalled = true;
+
+    // One recovery per deadline, then a single escalation
+    sim_run(10000);
+    task_watchdog_stats_t s = stats_of(SIM_RF);
+    TEST_ASSERT_EQUAL(TASK_WATCHDOG_MAX_RECOVERIES, s.recoveries);
+    TEST_ASSERT_EQUAL(TASK_WATCHDOG_ESCALATED, s.state);
+    TEST_ASSERT_EQUAL(1, s_escalations);
+    TEST_ASSERT_EQUAL(0, strcmp("rf", s_escalated_name));
+    TEST_ASSERT_TRUE(s.missed >= 9);
+    printf("rf: %u missed, %u recoveries, escalated once\n", (unsigned)s.missed,
+           (unsigned)s.recoveries);
+}
+
+void test_report_only_task(void)
+{
+    sim_reset();
+
+    // Without a policy a miss is reported again each deadline, never escalated
+    task_watchdog_config_t config = { .name = "net", .period_ms = 1000, .deadline_ms = 3000, .core = 0 };
+    int id = task_watchdog_register(&config, sim_us());
+    TEST_ASSERT_TRUE(id >= 0);
+    sim_run(10000);
+
+    task_watchdog_stats_t s;
+    task_watchdog_get_stats(id, &s);
+    TEST_ASSERT_EQUAL(3, s.missed);
+    TEST_ASSERT_EQUAL(0, s.recoveries);
+    TEST_ASSERT_EQUAL(TASK_WATCHDOG_MISSED, s.state);
+    TEST_ASSERT_EQUAL(0, s_escalations);
+}
+
+void test_scheduling_latency(void)
+{
+    sim_reset();
+    sim_run(500);
+
+    // Small jitter is recorded but is not an outlier; 40 ms late is
+    s_sim[SIM_UI].extra_latency_ms = 5;
+    sim_run(200);
+    s_sim[SIM_UI].extra_latency_ms = 40;
+    sim_run(200);
+
+    task_watchdog_stats_t s = stats_of(SIM_UI);
+    TEST_ASSERT_EQUAL(1, s.latency_outliers);
+    TEST_ASSERT_TRUE(s.max_latency_us >= 40000 && s.max_latency_us < 42000);
+    TEST_ASSERT_EQUAL(0, s.missed);
+    TEST_ASSERT_EQUAL(2, metric_count("wdt.sched_latency_us"));
+    TEST_ASSERT_EQUAL(1, metric_count("wdt.latency_outliers"));
+}
+
+void test_priority_inversion_suspect(void)
+{
+    sim_reset();
+    sim_run(500);
+
+    // rf blocks for 300 ms while the low-priority task on its core keeps
+    // running: rf was waiting on something, not short of CPU
+    s_sim[SIM_RF].stalled = true;
+    sim_run(300);
+    s_sim[SIM_RF].stalled = false;
+    sim_run(201);
+
+    task_watchdog_stats_t s = stats_of(SIM_RF);
+    TEST_ASSERT_EQUAL(1, s.latency_outliers);
+    TEST_ASSERT_EQUAL(1, s.inversion_suspects);
+
+    // Both starved together (a spinning higher priority task): not an
+    // inversion. rf and low both beat in the last tick, right before this
+    s_sim[SIM_RF].stalled = true;
+    s_sim[SIM_LOW].stalled = true;
+    sim_run(300);
+    s_sim[SIM_RF].stalled = false;
+    s_sim[SIM_LOW].stalled = false;
+    sim_run(200);
+
+    s = stats_of(SIM_RF);
+    TEST_ASSERT_EQUAL(2, s.latency_outliers);
+    TEST_ASSERT_EQUAL(1, s.inversion_suspects);
+
+    // A task on the other core says nothing about rf's core
+    TEST_ASSERT_EQUAL(0, stats_of(SIM_UI).inversion_suspects);
+    TEST_ASSERT_EQUAL(1, metric_count("wdt.inversion_suspects"));
+}
+
+void test_register_rules(void)
+{
+    task_watchdog_reset();
+
+    task_watchdog_config_t bad = { .name = "bad", .period_ms = 500, .deadline_ms = 100 };
+    TEST_ASSERT_EQUAL(-1, task_watchdog_register(&bad, 0));
+    TEST_ASSERT_EQUAL(-1, task_watchdog_register(NULL, 0));
+
+    task_watchdog_config_t ok = { .name = "ok", .period_ms = 10, .deadline_ms = 100 };
+    for (int i = 0; i < TASK_WATCHDOG_MAX_TASKS; i++) {
+        TEST_ASSERT_EQUAL(i, task_watchdog_register(&ok, 0));
+    }
+    TEST_ASSERT_EQUAL(-1, task_watchdog_register(&ok, 0));
+
+    // Unknown IDs are ignored
+    task_watchdog_beat(-1, 0);
+    task_watchdog_beat(TASK_WATCHDOG_MAX_TASKS, 0);
+    task_watchdog_stats_t s;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, task_watchdog_get_stats(-1, &s));
+}
+
+void app_main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_healthy_schedule);
+    RUN_TEST(test_hung_js_is_restarted);
+    RUN_TEST(test_unrecoverable_radio_escalates);
+    RUN_TEST(test_report_only_task);
+    RUN_TEST(test_scheduling_latency);
+    RUN_TEST(test_priority_inversion_suspect);
+    RUN_TEST(test_register_rules);
+
+    UNITY_END();
+}
@@ -0,0 +1,204 @@
+/**
+ * @file test_text_cache.c
+ * @brief Headless benchmark for cached value labels
+ *
+ * Updates an "RSSI: -NN dBm" readout once per frame, first through a plain
+ * lv_label and then through a cached label, and reports render time and
+ * flushed pixels per update. A cached label should only repaint the digits
+ * that changed and serve every glyph from the cache once warmed up.
+ */
+
+#include "lvgl_port.h"
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+
+#define FRAME_MS        16
+#define UPDATES         200
+
+typedef struct {
+    const char *name;
+    uint64_t total_us;
+    uint32_t max_us;
+    uint64_t total_px;
+} bench_result_t;
+
+static lv_obj_t* load_blank_screen(void)
+{
+    lvgl_port_lock();
+    lv_obj_t *screen = lv_obj_create(NULL);
+    lv_obj_set_style_bg_color(screen, lv_color_black(), 0);
+    lv_scr_load(screen);
+    lvgl_port_unlock();
+
+    lvgl_headless_render_frame(FRAME_MS, NULL);
+    return screen;
+}
+
+static void format_rssi(char *buf, size_t len, int update)
+{
+    // Wanders between -60 and -71 dBm like a real reading
+    snprintf(buf, len, "RSSI: %d dBm", -60 - (update * 7) % 12);
+}
+
+static bench_result_t bench_label(const char *name, bool cached)
+{
+    bench_result_t result = { .name = name };
+    lv_obj_t *screen = load_blank_screen();
+    char text[32];
+
+    lvgl_port_lock();
+    lv_obj_t *label = cached ? lvgl_create_cached_label(screen, NULL) : lv_label_create(screen);
+    TEST_ASSERT_NOT_NULL(label);
+    lv_obj_set_pos(label, 10, 40);
+    lvgl_port_set_label_text(label, "RSSI: --- dBm");
+    lvgl_port_unlock();
+    lvgl_headless_render_frame(FRAME_MS, NULL);
+
+    for (int i = 0; i < UPDATES; i++) {
+        format_rssi(text, sizeof(text), i);
+        lvgl_port_lock();
+        lvgl_port_set_label_text(label, text);
+        lvgl_port_unlock();
+
+        lvgl_headless_frame_t frame;
+        TEST_ASSERT_EQUAL(ESP_OK, lvgl_headless_render_frame(FRAME_MS, &frame));
+        result.total_us += frame.render_us;
+        result.total_px += frame.flushed_px;
+        if (frame.render_us > result.max_us) result.max_us = frame.render_us;
+    }
+
+    printf("%-8s avg %5llu us  max %5u us  avg %5llu px/update\n", result.name,
+           (unsigned long long)(result.total_us / UPDATES), result.max_us,
+           (unsigned long long)(result.total_px / UPDATES));
+
+    lvgl_port_lock();
+    lv_obj_del(screen);
+    lvgl_port_unlock();
+    return result;
+}
+
+void test_headless_init(void)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_init());
+}
+
+void test_cached_label_detection(void)
+{
+    lvgl_port_lock();
+    lv_obj_t *screen = lv_obj_create(NULL);
+    lv_obj_t *plain = lv_label_create(screen);
+    lv_obj_t *cached = lvgl_create_cached_label(screen, NULL);
+
+    TEST_ASSERT_FALSE(lvgl_is_cached_label(plain));
+    TEST_ASSERT_FALSE(lvgl_is_cached_label(screen));
+    TEST_ASSERT_TRUE(lvgl_is_cached_label(cached));
+
+    // Same text twice is not an update
+    TEST_ASSERT_TRUE(lvgl_cached_label_set_text(cached, "433.92 MHz"));
+    TEST_ASSERT_FALSE(lvgl_cached_label_set_text(cached, "433.92 MHz"));
+
+    lv_obj_del(screen);
+    lvgl_port_unlock();
+}
+
+void test_number_change_only_touches_changed_glyphs(void)
+{
+    lvgl_port_lock();
+    lv_obj_t *screen = lv_obj_create(NULL);
+    lv_obj_t *label = lvgl_create_cached_label(screen, NULL);
+    lvgl_cached_label_set_text(label, "RSSI: -67 dBm");
+
+    lvgl_port_reset_text_cache_stats();
+    lvgl_cached_label_set_text(label, "RSSI: -68 dBm");
+    lvgl_port_unlock();
+
+    lvgl_text_cache_stats_t stats;
+    lvgl_port_get_text_cache_stats(&stats);
+    TEST_ASSERT_EQUAL(1, stats.glyphs_changed);
+    TEST_ASSERT_EQUAL(strlen("RSSI: -68 dBm") - 1, stats.glyphs_unchanged);
+
+    lvgl_port_lock();
+    lv_obj_del(screen);
+    lvgl_port_unlock();
+}
+
+void test_text_past_the_limit_is_unchanged(void)
+{
+    char text[LVGL_CACHED_LABEL_MAX_CHARS + 10];
+    memset(text, '8', sizeof(text) - 1);
+    text[sizeof(text) - 1] = '\0';
+
+    lvgl_port_lock();
+    lv_obj_t *screen = lv_obj_create(NULL);
+    lv_obj_t *label = lvgl_create_cached_label(screen, NULL);
+    TEST_ASSERT_TRUE(lvgl_cached_label_set_text(label, text));
+    TEST_ASSERT_FALSE(lvgl_cached_label_set_text(label, text));
+
+    // Only glyphs that are shown make a change
+    text[sizeof(text) - 2] = '9';
+    TEST_ASSERT_FALSE(lvgl_cached_label_set_text(label, text));
+    lv_obj_del(screen);
+    lvgl_port_unlock();
+}
+
+void test_style_sets_font_spacing_and_colour(void)
+{
+    lvgl_port_lock();
+    lv_obj_t *screen = lv_obj_create(NULL);
+    lv_obj_set_style_text_color(screen, lv_color_make(0x12, 0x34, 0x56), 0);
+    lv_obj_t *label = lvgl_create_cached_label(screen, NULL);
+    lvgl_cached_label_set_text(label, "-67");
+    lv_coord_t width = lv_obj_get_width(label);
+
+    // Inherited like a label's, and a spacing change lays the text out again
+    TEST_ASSERT_EQUAL_HEX32(lv_color_make(0x12, 0x34, 0x56).full,
+                            lv_obj_get_style_text_color(label, LV_PART_MAIN).full);
+    lv_obj_set_style_text_letter_space(label, 4, 0);
+    TEST_ASSERT_EQUAL(width + 3 * 4, lv_obj_get_width(label));
+    TEST_ASSERT_FALSE(lvgl_cached_label_set_text(label, "-67"));
+
+    lv_obj_del(screen);
+    lvgl_port_unlock();
+}
+
+void test_bench_label_updates(void)
+{
+    bench_result_t plain = bench_label("lv_label", false);
+
+    lvgl_port_reset_text_cache_stats();
+    bench_result_t cached = bench_label("cached", true);
+
+    lvgl_text_cache_stats_t stats;
+    lvgl_port_get_text_cache_stats(&stats);
+    printf("glyphs: %u hits %u misses %u KB, layouts: %u hits %u misses, "
+           "%u changed / %u unchanged, %u drawn / %u clipped\n",
+           stats.glyph_hits, stats.glyph_misses, stats.glyph_bytes / 1024,
+           stats.layout_hits, stats.layout_misses, stats.glyphs_changed,
+           stats.glyphs_unchanged, stats.glyphs_drawn, stats.glyphs_clipped);
+
+    // Only the digits are repainted, and they come from the cache
+    TEST_ASSERT_TRUE(cached.total_px < plain.total_px);
+    TEST_ASSERT_TRUE(stats.glyphs_changed < stats.glyphs_unchanged);
+    TEST_ASSERT_TRUE(stats.glyph_hits > stats.glyph_misses * 10);
+    TEST_ASSERT_TRUE(stats.layout_hits > stats.layout_misses);
+}
+
+void test_headless_deinit(void)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_deinit());
+}
+
+void app_main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_headless_init);
+    RUN_TEST(test_cached_label_detection);
+    RUN_TEST(test_number_change_only_touches_changed_glyphs);
+    RUN_TEST(test_text_past_the_limit_is_unchanged);
+    RUN_TEST(test_style_sets_font_spacing_and_colour);
+    RUN_TEST(test_bench_label_updates);
+    RUN_TEST(test_headless_deinit);
+
+    UNITY_END();
+}
@@ -0,0 +1,174 @@
+/**
+ * @file test_trace.c
+ * @brief Trace rings, dump format and record cost (linux target)
+ *
+ * Set TRACE_DUMP_PATH to also save the dump, then convert it with
+ * `node sdk/tools/trace-decode.js <path>` to check the decoder end to end.
+ */
+
+#include "trace.h"
+#include "unity.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_ITERATIONS    10000000
+#define DUMP_MAX            (sizeof(trace_dump_header_t) + 8 + TRACE_RING_RECORDS * sizeof(trace_record_t))
+
+typedef struct {
+    uint8_t data[DUMP_MAX];
+    size_t len;
+} dump_buf_t;
+
+static dump_buf_t s_dump;
+
+static esp_err_t buf_write(const void *data, size_t len, void *ctx)
+{
+    dump_buf_t *buf = ctx;
+    if (buf->len + len > sizeof(buf->data)) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+    return ESP_OK;
+}
+
+// Records of core 0 in a dump taken from the host (no task table)
+static const trace_record_t *dump_records(const dump_buf_t *buf, uint32_t *count)
+{
+    const uint32_t *section = (const uint32_t *)(buf->data + sizeof(trace_dump_header_t));
+    *count = section[1];
+    return (const trace_record_t *)(section + 2);
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void test_catalogue(void)
+{
+    TEST_ASSERT_EQUAL(0, strcmp("RF_SET_FREQUENCY", trace_event_name(TRACE_RF_SET_FREQUENCY)));
+    TEST_ASSERT_EQUAL(0, strcmp("UI_FRAME_BEGIN", trace_event_name(TRACE_UI_FRAME_BEGIN)));
+    TEST_ASSERT_EQUAL(0, strcmp("?", trace_event_name(TRACE_EVENT_COUNT)));
+    TEST_ASSERT_EQUAL(TRACE_PH_BEGIN, trace_event_phase(TRACE_JS_EXEC_BEGIN));
+    TEST_ASSERT_EQUAL(TRACE_PH_END, trace_event_phase(TRACE_JS_EXEC_END));
+    TEST_ASSERT_EQUAL(TRACE_PH_COUNTER, trace_event_phase(TRACE_SYS_FREE_HEAP));
+}
+
+void test_dump_in_order(void)
+{
+    trace_clear();
+    trace_set_running(true);
+
+    TRACE(TRACE_UI_FRAME_BEGIN, 0, 0);
+    TRACE(TRACE_RF_SET_FREQUENCY, 433920000, 0);
+    TRACE(TRACE_RF_RX_PACKET, 12, -60);
+    TRACE(TRACE_UI_FRAME_END, 1, 0);
+
+    s_dump.len = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, trace_dump(buf_write, &s_dump));
+
+    const trace_dump_header_t *header = (const trace_dump_header_t *)s_dump.data;
+    TEST_ASSERT_EQUAL(TRACE_MAGIC, header->magic);
+    TEST_ASSERT_EQUAL(TRACE_FORMAT_VERSION, header->version);
+    TEST_ASSERT_EQUAL(sizeof(trace_record_t), header->record_size);
+    TEST_ASSERT_EQUAL(TRACE_CORES, header->cores);
+
+    uint32_t count;
+    const trace_record_t *rec = dump_records(&s_dump, &count);
+    TEST_ASSERT_EQUAL(4, count);
+    TEST_ASSERT_EQUAL(TRACE_UI_FRAME_BEGIN, rec[0].event);
+    TEST_ASSERT_EQUAL(TRACE_RF_SET_FREQUENCY, rec[1].event);
+    TEST_ASSERT_EQUAL(433920000, rec[1].arg0);
+    TEST_ASSERT_EQUAL(-60, (int32_t)rec[2].arg1);
+    TEST_ASSERT_EQUAL(TRACE_UI_FRAME_END, rec[3].event);
+    for (uint32_t i = 1; i < count; i++) {
+        TEST_ASSERT_TRUE((int32_t)(rec[i].timestamp_us - rec[i - 1].timestamp_us) >= 0);
+    }
+
+    // Dumping pauses recording only for its own duration
+    TEST_ASSERT_TRUE(trace_is_running());
+}
+
+void test_ring_keeps_latest(void)
+{
+    trace_clear();
+    for (uint32_t i = 0; i < TRACE_RING_RECORDS + 100; i++) {
+        TRACE(TRACE_INPUT_PUSH, i, 0);
+    }
+
+    trace_stats_t stats;
+    trace_get_stats(&stats);
+    TEST_ASSERT_EQUAL(TRACE_RING_RECORDS + 100, stats.recorded);
+    TEST_ASSERT_EQUAL(100, stats.overwritten);
+
+    s_dump.len = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, trace_dump(buf_write, &s_dump));
+
+    uint32_t count;
+    const trace_record_t *rec = dump_records(&s_dump, &count);
+    TEST_ASSERT_EQUAL(TRACE_RING_RECORDS, count);
+
+    // Oldest surviving record first, across the wrap point
+    for (uint32_t i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL(100 + i, rec[i].arg0);
+    }
+}
+
+void test_stopped_records_nothing(void)
+{
+    trace_clear();
+    trace_set_running(false);
+    TRACE(TRACE_RF_TX, 8, 0);
+    trace_set_running(true);
+
+    trace_stats_t stats;
+    trace_get_stats(&stats);
+    TEST_ASSERT_EQUAL(0, stats.recorded);
+}
+
+void test_record_cost(void)
+{
+    trace_clear();
+
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+        TRACE(TRACE_RF_SET_FREQUENCY, i, 0);
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    printf("TRACE(): %.2f ns per record (including the clock read)\n",
+           (double)elapsed / BENCH_ITERATIONS);
+
+    // Leave a realistic session in the rings for the optional dump below
+    trace_clear();
+    for (uint32_t frame = 0; frame < 20; frame++) {
+        TRACE(TRACE_UI_FRAME_BEGIN, 0, 0);
+        TRACE(TRACE_INPUT_PUSH, 1, frame);
+        TRACE(TRACE_UI_FLUSH_START, 320 * 20, 0);
+        TRACE(TRACE_UI_FLUSH_DONE, 0, 0);
+        TRACE(TRACE_UI_FRAME_END, 1, 0);
+        TRACE(TRACE_SYS_FREE_HEAP, 200000 - frame * 100, 0);
+    }
+
+    const char *path = getenv("TRACE_DUMP_PATH");
+    if (path) {
+        TEST_ASSERT_EQUAL(ESP_OK, trace_save(path));
+    }
+}
+
+void app_main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_catalogue);
+    RUN_TEST(test_dump_in_order);
+    RUN_TEST(test_ring_keeps_latest);
+    RUN_TEST(test_stopped_records_nothing);
+    RUN_TEST(test_record_cost);
+
+    UNITY_END();
+}
@@ -0,0 +1,186 @@
+/**
+ * @file test_ui_benchmark.c
+ * @brief Headless UI benchmark for the LVGL port (linux target)
+ *
+ * Runs the menu screen, notification popups and a typical app screen
+ * through the in-memory framebuffer backend with scripted input and reports
+ * per-frame render time and flushed area. Set LVGL_DUMP_DIR to also write a
+ * PNG of every frame that changed pixels.
+ */
+
+#include "lvgl_port.h"
+#include "unity.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define FRAME_MS        16      // ~60 Hz frame pacing
+#define SCREEN_PX       (LCD_WIDTH * LCD_HEIGHT)
+
+// Helpers from lvgl_helpers.c
+extern lv_obj_t* lvgl_create_list(lv_obj_t *parent);
+extern lv_obj_t* lvgl_create_list_button(lv_obj_t *list, const char *icon, const char *text);
+extern lv_obj_t* lvgl_create_progress_bar(lv_obj_t *parent, lv_coord_t width);
+extern void lvgl_format_rssi(int16_t rssi_dbm, char *buffer, size_t buffer_size);
+
+typedef struct {
+    const char *name;
+    uint32_t frames;
+    uint64_t total_us;
+    uint32_t max_us;
+    uint64_t total_px;
+    uint32_t max_px;
+} bench_result_t;
+
+static void bench_frame(bench_result_t *result, lvgl_headless_frame_t *frame)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_headless_render_frame(FRAME_MS, frame));
+
+    result->frames++;
+    result->total_us += frame->render_us;
+    result->total_px += frame->flushed_px;
+    if (frame->render_us > result->max_us) result->max_us = frame->render_us;
+    if (frame->flushed_px > result->max_px) result->max_px = frame->flushed_px;
+}
+
+static void bench_report(const bench_result_t *result)
+{
+    printf("%-14s %4u frames  avg %6llu us  max %6u us  avg %6llu px  max %6u px\n",
+           result->name, result->frames,
+           (unsigned long long)(result->total_us / result->frames), result->max_us,
+           (unsigned long long)(result->total_px / result->frames), result->max_px);
+}
+
+void test_headless_init(void)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_init());
+
+    lv_coord_t w, h;
+    TEST_ASSERT_NOT_NULL(lvgl_headless_get_framebuffer(&w, &h));
+    TEST_ASSERT_EQUAL(SCREEN_PX, w * h);
+
+    const char *dump_dir = getenv("LVGL_DUMP_DIR");
+    if (dump_dir) {
+        lvgl_headless_set_dump_dir(dump_dir);
+    }
+}
+
+void test_bench_menu_screen(void)
+{
+    bench_result_t result = { .name = "menu" };
+    lvgl_headless_frame_t frame;
+
+    lv_obj_t *screen = lvgl_port_create_menu_screen();
+    lvgl_port_lock();
+    lv_scr_load(screen);
+    lvgl_port_unlock();
+
+    // First frame paints the whole screen
+    bench_frame(&result, &frame);
+    TEST_ASSERT_EQUAL(SCREEN_PX, frame.flushed_px);
+
+    // Scroll down the list and back up
+    const lvgl_input_step_t script[] = {
+        {  50, INPUT_TYPE_ENCODER, INPUT_EVENT_ENCODER_CW, 0 },
+        { 150, INPUT_TYPE_ENCODER, INPUT_EVENT_ENCODER_CW, 0 },
+        { 250, INPUT_TYPE_ENCODER, INPUT_EVENT_ENCODER_CW, 0 },
+        { 350, INPUT_TYPE_ENCODER, INPUT_EVENT_ENCODER_CCW, 0 },
+        { 450, INPUT_TYPE_ENCODER, INPUT_EVENT_ENCODER_CCW, 0 },
+        { 550, INPUT_TYPE_ENCODER, INPUT_EVENT_ENCODER_CCW, 0 },
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_headless_play_input(script, sizeof(script) / sizeof(script[0])));
+
+    while (!lvgl_headless_input_done() || result.frames < 60) {
+        bench_frame(&result, &frame);
+    }
+
+    // Focus changes only repaint the affected rows
+    TEST_ASSERT_TRUE(result.total_px < (uint64_t)SCREEN_PX * 8);
+    bench_report(&result);
+}
+
+void test_bench_notification(void)
+{
+    bench_result_t result = { .name = "notification" };
+    lvgl_headless_frame_t frame;
+
+    for (int i = 0; i < 5; i++) {
+        lvgl_port_show_notification("Info", "Signal captured", 200);
+
+        // Popup appears, stays for its timeout, then is removed
+        for (int f = 0; f < 20; f++) {
+            bench_frame(&result, &frame);
+            TEST_ASSERT_TRUE(frame.flushed_px < SCREEN_PX);
+        }
+    }
+
+    bench_report(&result);
+}
+
+void test_bench_app_screen(void)
+{
+    bench_result_t result = { .name = "app screen" };
+    lvgl_headless_frame_t frame;
+    char text[32];
+
+    // RF scanner style layout built from the port helpers
+    lvgl_port_lock();
+    lv_obj_t *screen = lv_obj_create(NULL);
+    lv_obj_t *status_bar = lvgl_port_create_status_bar(screen);
+    lv_obj_t *rssi_label = lv_label_create(screen);
+    lv_obj_set_pos(rssi_label, 10, 40);
+    lv_obj_t *progress = lvgl_create_progress_bar(screen, 150);
+    lv_obj_set_pos(progress, 10, 70);
+    lv_obj_t *list = lvgl_create_list(screen);
+    lv_obj_set_size(list, 150, 80);
+    lv_obj_set_pos(list, 10, 100);
+    for (int i = 0; i < 8; i++) {
+        snprintf(text, sizeof(text), "433.%02u MHz", i * 10);
+        lvgl_create_list_button(list, LV_SYMBOL_WIFI, text);
+    }
+    lv_scr_load(screen);
+    lvgl_port_unlock();
+
+    bench_frame(&result, &frame);
+    uint32_t first_px = frame.flushed_px;
+
+    // Live updates: RSSI every frame, progress and clock every few frames,
+    // with apps re-sending identical text in between
+    for (int f = 0; f < 120; f++) {
+        lvgl_port_lock();
+        lvgl_format_rssi(-90 + (f % 30), text, sizeof(text));
+        lvgl_port_set_label_text(rssi_label, text);
+        if (f % 4 == 0) {
+            lv_bar_set_value(progress, (f / 4) % 100, LV_ANIM_OFF);
+        }
+        lvgl_port_unlock();
+
+        snprintf(text, sizeof(text), "12:%02d", f / 60);
+        lvgl_port_update_status_bar(status_bar, f % 2, 80, text);
+
+        bench_frame(&result, &frame);
+        TEST_ASSERT_TRUE(frame.flushed_px < first_px / 2);
+    }
+
+    lvgl_refresh_stats_t stats;
+    lvgl_port_get_refresh_stats(&stats);
+    TEST_ASSERT_TRUE(stats.updates_skipped > 0);
+
+    bench_report(&result);
+}
+
+void test_headless_deinit(void)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, lvgl_port_deinit());
+}
+
+void app_main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_headless_init);
+    RUN_TEST(test_bench_menu_screen);
+    RUN_TEST(test_bench_notification);
+    RUN_TEST(test_bench_app_screen);
+    RUN_TEST(test_headless_deinit);
+
+    UNITY_END();
+}